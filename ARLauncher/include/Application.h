@@ -106,6 +106,9 @@ private:
     glm::quat m_currentCameraRotation; // Текущая интерполированная ротация
     float m_lastIMUUpdateTime;
     bool m_positionInitialized;
+    
+    // Наложение глубины LiDAR (раскраска на GPU, переключается клавишей D)
+    bool m_depthOverlayEnabled = false;
 #endif
 };
 
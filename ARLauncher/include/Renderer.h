@@ -50,6 +50,10 @@ public:
 
     virtual void renderUIWindows() {}
     
+    // Карта глубины LiDAR: загрузка сырой глубины (метры) и раскраска на GPU
+    virtual void uploadDepthMap(const float* depth, uint32_t width, uint32_t height) {}
+    virtual void renderDepthOverlay(float minDepth, float maxDepth, float opacity) {}
+    
     // Получение размеров окна
     void getWindowSize(int& width, int& height) const;
     
@@ -205,6 +209,9 @@ public:
 
     void renderUIWindows() override;
 
+    void uploadDepthMap(const float* depth, uint32_t width, uint32_t height) override;
+    void renderDepthOverlay(float minDepth, float maxDepth, float opacity) override;
+
     uint32_t createUIWindow(const std::string& title,
                             const std::string& subtitle,
                             const glm::vec3& position,
@@ -239,6 +246,9 @@ private:
     uint32_t m_videoTexture;
     uint32_t m_videoTextureWidth;
     uint32_t m_videoTextureHeight;
+    uint32_t m_depthTexture;
+    uint32_t m_depthTextureWidth;
+    uint32_t m_depthTextureHeight;
     glm::mat4 m_viewMatrix;
     glm::mat4 m_projectionMatrix;
     float m_videoOpacity;
@@ -248,6 +258,7 @@ private:
     uint32_t m_videoShaderProgram;
     uint32_t m_glassmorphismShaderProgram;
     uint32_t m_uiShaderProgram;
+    uint32_t m_depthShaderProgram;
 
     uint32_t m_fullscreenQuadVAO;
     uint32_t m_fullscreenQuadVBO;
@@ -0,0 +1,41 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D depthTexture;  // Сырая глубина LiDAR в метрах (R32F)
+uniform float minDepth;
+uniform float maxDepth;
+uniform float maxRange;          // Глубина за пределами считается невалидной
+uniform float opacity;
+
+// Полиномиальная аппроксимация палитры Turbo
+vec3 turbo(float x)
+{
+    const vec4 kR4 = vec4(0.13572138, 4.61539260, -42.66032258, 132.13108234);
+    const vec4 kG4 = vec4(0.09140261, 2.19418839, 4.84296658, -14.18503333);
+    const vec4 kB4 = vec4(0.10667330, 12.64194608, -60.58204836, 110.36276771);
+    const vec2 kR2 = vec2(-152.94239396, 59.28637943);
+    const vec2 kG2 = vec2(4.27729857, 2.82956604);
+    const vec2 kB2 = vec2(-89.90310912, 27.34824973);
+
+    vec4 v4 = vec4(1.0, x, x * x, x * x * x);
+    vec2 v2 = v4.zw * v4.z;
+    return clamp(vec3(dot(v4, kR4) + dot(v2, kR2),
+                      dot(v4, kG4) + dot(v2, kG2),
+                      dot(v4, kB4) + dot(v2, kB2)), 0.0, 1.0);
+}
+
+void main()
+{
+    float depth = texture(depthTexture, TexCoord).r;
+
+    // NaN и пиксели без измерения не рисуем
+    if (isnan(depth) || depth <= 0.0 || depth >= maxRange) {
+        discard;
+    }
+
+    float t = clamp((depth - minDepth) / max(maxDepth - minDepth, 1e-6), 0.0, 1.0);
+    FragColor = vec4(turbo(t), opacity);
+}
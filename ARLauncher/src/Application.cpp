@@ -359,7 +359,7 @@ bool Application::initializeSensorConnector()
     
     // Подключаем сигналы для получения декодированных RGB кадров с камеры iPhone
     QObject::connect(m_sensorConnector.get(), &SensorConnector::SensorConnectorCore::frameDecoded,
-                     [this](const QImage& frame, quint64 sequenceNumber) {
+                     [this](const QImage& frame, quint64 sequenceNumber, quint64 receivedAt) {
                          if (m_renderer && !frame.isNull()) {
                             // Инициализируем splash start time при первом кадре
                             if (m_splashStartMs == 0) {
@@ -375,13 +375,16 @@ bool Application::initializeSensorConnector()
                                 uint32_t height = static_cast<uint32_t>(rgbFrame.height());
                                 const uint8_t* rgbData = rgbFrame.constBits();
                                 
-                                // Оптимизация: передаем данные в LensEngine напрямую
-                                // Это не блокирует обработку кадров
+                                // LensEngine разделяет пиксели QImage без копирования:
+                                // копия QImage в колбэке удерживает данные, пока кадр в обработке
                                 if (m_lensEngine) {
-                                    uint64_t timestamp = QDateTime::currentMSecsSinceEpoch();
-                                    size_t dataSize = width * height * 3; // RGB888
-                                    // Используем прямой вызов для максимальной скорости
-                                    m_lensEngine->processRGBData(rgbData, dataSize, width, height, timestamp);
+                                    // Время приема пакета, как у глубины и IMU: задержка
+                                    // декодирования не сдвигает кадр относительно них
+                                    uint64_t timestamp = receivedAt;
+                                    LensEngine::SharedBuffer image = LensEngine::SharedBuffer::wrap(
+                                        rgbData, static_cast<size_t>(rgbFrame.sizeInBytes()), [rgbFrame]() {});
+                                    m_lensEngine->processRGBData(image, width, height,
+                                                                 static_cast<uint32_t>(rgbFrame.bytesPerLine()), timestamp);
                                 }
                                 
                                 // Быстрое обновление текстуры видео (без рендеринга)
@@ -473,9 +476,9 @@ bool Application::initializeSensorConnector()
                              
                              LensEngine::RawIMUData imuData;
                              
-                             // Копируем и конвертируем endianness (Little Endian, как в NetworkServer)
-                             memcpy(&imuData.timestamp, rawData, 8);
-                             // timestamp уже в правильном формате (uint64_t)
+                             // Временная метка по часам хоста, как у RGB и LiDAR:
+                             // синхронизатор LensEngine сопоставляет потоки в одной шкале
+                             imuData.timestamp = data.timestamp;
                              
                              memcpy(&imuData.accelX, rawData + 8, 8);
                              imuData.accelX = qFromLittleEndian<double>(reinterpret_cast<const uchar*>(&imuData.accelX));
@@ -508,8 +511,33 @@ bool Application::initializeSensorConnector()
                              // Передаем в LensEngine для обработки
                              m_lensEngine->processIMUData(imuData);
                          }
+                         
+                         // LiDAR глубина и карта уверенности приходят отдельными пакетами.
+                         // Пару LensEngine ищет по номеру кадра из заголовка протокола
+                         // (общий у обоих пакетов), с RGB кадрами сопоставляет по времени
+                         if (data.type == SensorConnector::LIDAR_DEPTH && m_lensEngine) {
+                             const QByteArray payload = data.payload;
+                             m_lensEngine->processLidarData(
+                                 LensEngine::SharedBuffer::wrap(payload.constData(), static_cast<size_t>(payload.size()),
+                                                                [payload]() {}),
+                                 LensEngine::SharedBuffer(), data.timestamp, data.sequenceNumber);
+                             
+                             // Сырая глубина 256x192 float сразу в текстуру, без преобразований на CPU
+                             if (m_depthOverlayEnabled && m_renderer && data.payload.size() >= 256 * 192 * 4) {
+                                 m_renderer->uploadDepthMap(reinterpret_cast<const float*>(data.payload.constData()), 256, 192);
+                             }
+                         } else if (data.type == SensorConnector::LIDAR_CONFIDENCE && m_lensEngine) {
+                             const QByteArray payload = data.payload;
+                             m_lensEngine->processLidarConfidence(
+                                 LensEngine::SharedBuffer::wrap(payload.constData(), static_cast<size_t>(payload.size()),
+                                                                [payload]() {}),
+                                 data.timestamp, data.sequenceNumber);
+                         }
                      });
     
+    // CPU предпросмотр глубины нужен, только пока наложение на GPU выключено (клавиша D)
+    m_sensorConnector->setLidarPreviewEnabled(!m_depthOverlayEnabled);
+    
     // Запускаем серверы на порту 9000 (TCP и UDP)
     m_sensorConnector->startServers(9000, 9000);
     
@@ -612,6 +640,13 @@ void Application::render()
     // 1. Сначала рендерим видео фон с камеры iPhone
     m_renderer->renderStoredVideoBackground();
     
+#ifdef USE_SENSOR_CONNECTOR
+    // 1a. Наложение глубины LiDAR поверх видео (по желанию)
+    if (m_depthOverlayEnabled) {
+        m_renderer->renderDepthOverlay(0.2f, 5.0f, 0.6f);
+    }
+#endif
+    
     // 2. Затем рендерим 3D объекты поверх видео (AR наложение)
     // Применяем opacity для анимации
 #ifdef USE_SENSOR_CONNECTOR
@@ -688,6 +723,15 @@ void Application::onKeyPress(GLFWwindow* window, int key, int scancode, int acti
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
         app->requestExit();
     }
+    
+#ifdef USE_SENSOR_CONNECTOR
+    if (app && key == GLFW_KEY_D && action == GLFW_PRESS) {
+        app->m_depthOverlayEnabled = !app->m_depthOverlayEnabled;
+        if (app->m_sensorConnector) {
+            app->m_sensorConnector->setLidarPreviewEnabled(!app->m_depthOverlayEnabled);
+        }
+    }
+#endif
 }
 
 void Application::onMouseMove(GLFWwindow* window, double x, double y)
@@ -16,6 +16,11 @@
 #include <vector>
 #include <cctype>
 
+// Форматы текстур OpenGL 3.0+, которых нет в GL/gl.h 1.1
+#ifndef GL_R32F
+#define GL_R32F 0x822E
+#endif
+
 // Объявления типов функций OpenGL 3.3+
 #ifndef APIENTRY
 #define APIENTRY
@@ -318,12 +323,16 @@ OpenGLRenderer::OpenGLRenderer()
     : m_videoTexture(0)
     , m_videoTextureWidth(0)
     , m_videoTextureHeight(0)
+    , m_depthTexture(0)
+    , m_depthTextureWidth(0)
+    , m_depthTextureHeight(0)
     , m_videoOpacity(1.0f)
     , m_3dObjectsOpacity(1.0f)
     , m_basicShaderProgram(0)
     , m_videoShaderProgram(0)
     , m_glassmorphismShaderProgram(0)
     , m_uiShaderProgram(0)
+    , m_depthShaderProgram(0)
     , m_fullscreenQuadVAO(0)
     , m_fullscreenQuadVBO(0)
     , m_uiQuadVAO(0)
@@ -402,6 +411,8 @@ bool OpenGLRenderer::initialize(GLFWwindow* window)
     m_videoShaderProgram = loadShader("shaders/video.vert", "shaders/video.frag");
     m_glassmorphismShaderProgram = loadShader("shaders/glassmorphism.vert", "shaders/glassmorphism.frag");
     m_uiShaderProgram = loadShader("shaders/ui.vert", "shaders/ui.frag");
+    // Раскраска глубины LiDAR на GPU (тот же полноэкранный квад, что и у видео)
+    m_depthShaderProgram = loadShader("shaders/video.vert", "shaders/depth.frag");
 
     if (m_basicShaderProgram == 0 || m_videoShaderProgram == 0 || m_uiShaderProgram == 0) {
         std::cerr << "[WARN] Some shader programs failed to load. Fallback paths enabled." << std::endl;
@@ -449,6 +460,11 @@ void OpenGLRenderer::shutdown()
         m_videoTexture = 0;
     }
 
+    if (m_depthTexture != 0) {
+        glDeleteTextures(1, &m_depthTexture);
+        m_depthTexture = 0;
+    }
+
     if (m_fullscreenQuadVAO != 0) {
         glDeleteVertexArrays(1, &m_fullscreenQuadVAO);
         glDeleteBuffers(1, &m_fullscreenQuadVBO);
@@ -481,6 +497,10 @@ void OpenGLRenderer::shutdown()
         glDeleteProgram(m_uiShaderProgram);
         m_uiShaderProgram = 0;
     }
+    if (m_depthShaderProgram != 0) {
+        glDeleteProgram(m_depthShaderProgram);
+        m_depthShaderProgram = 0;
+    }
 
     if (m_simpleNVG) {
         nvgDeleteSimple(reinterpret_cast<NVGcontext*>(m_simpleNVG));
@@ -657,6 +677,85 @@ void OpenGLRenderer::renderStoredVideoBackground()
 #endif
 }
 
+void OpenGLRenderer::uploadDepthMap(const float* depth, uint32_t width, uint32_t height)
+{
+#ifdef USE_OPENGL
+    if (!depth || width == 0 || height == 0) {
+        return;
+    }
+
+    // Глубина уходит на GPU как есть (R32F), нормализация и палитра - в depth.frag
+    if (m_depthTexture == 0) {
+        glGenTextures(1, &m_depthTexture);
+        glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+        // NEAREST: не смешиваем валидную глубину с NaN/нулями на границах
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+    }
+
+    if (m_depthTextureWidth != width || m_depthTextureHeight != height) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, depth);
+        m_depthTextureWidth = width;
+        m_depthTextureHeight = height;
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED, GL_FLOAT, depth);
+    }
+#endif
+}
+
+void OpenGLRenderer::renderDepthOverlay(float minDepth, float maxDepth, float opacity)
+{
+#ifdef USE_OPENGL
+    if (m_depthTexture == 0 || m_depthShaderProgram == 0 || m_fullscreenQuadVAO == 0) {
+        return;
+    }
+
+    glDisable(GL_DEPTH_TEST);
+    glUseProgram(m_depthShaderProgram);
+
+    GLint texLoc = glGetUniformLocation(m_depthShaderProgram, "depthTexture");
+    GLint minLoc = glGetUniformLocation(m_depthShaderProgram, "minDepth");
+    GLint maxLoc = glGetUniformLocation(m_depthShaderProgram, "maxDepth");
+    GLint rangeLoc = glGetUniformLocation(m_depthShaderProgram, "maxRange");
+    GLint opacityLoc = glGetUniformLocation(m_depthShaderProgram, "opacity");
+    GLint aspectLoc = glGetUniformLocation(m_depthShaderProgram, "videoAspect");
+    GLint offsetLoc = glGetUniformLocation(m_depthShaderProgram, "videoOffset");
+
+    if (texLoc >= 0) glUniform1i(texLoc, 0);
+    if (minLoc >= 0) glUniform1f(minLoc, minDepth);
+    if (maxLoc >= 0) glUniform1f(maxLoc, maxDepth);
+    if (rangeLoc >= 0) glUniform1f(rangeLoc, 10.0f);
+    if (opacityLoc >= 0) glUniform1f(opacityLoc, opacity);
+
+    // Вписываем карту глубины так же, как видео фон
+    float windowAspect = static_cast<float>(m_width) / static_cast<float>(m_height);
+    float depthAspect = static_cast<float>(m_depthTextureWidth) / static_cast<float>(m_depthTextureHeight);
+    float offsetX = 0.0f;
+    float offsetY = 0.0f;
+    if (depthAspect > windowAspect) {
+        offsetY = (1.0f - windowAspect / depthAspect) * 0.5f;
+    } else {
+        offsetX = (1.0f - depthAspect / windowAspect) * 0.5f;
+    }
+    if (aspectLoc >= 0) glUniform2f(aspectLoc, depthAspect, windowAspect);
+    if (offsetLoc >= 0) glUniform2f(offsetLoc, offsetX, offsetY);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+
+    glBindVertexArray(m_fullscreenQuadVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+
+    glUseProgram(0);
+    glEnable(GL_DEPTH_TEST);
+#endif
+}
+
 void OpenGLRenderer::render3DObjects(const std::vector<glm::mat4>& transforms, 
                                      const std::vector<uint32_t>& meshIds)
 {
@@ -0,0 +1,208 @@
+#include "PlaneRansac.h"
+#include "DepthUnprojector.h"
+#include "SensorRecording.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Микробенчмарк поиска плоскости на записанных кадрах глубины
+ *
+ * Кадры глубины из записи распаковываются так же, как в обработке LiDAR
+ * (шаг 4, 0.15-5 м, уверенность не ниже medium), затем на каждом кадре
+ * замеряются: прежний RANSAC (100 итераций, копия inliers на итерацию),
+ * PlaneRansac в одном потоке и PlaneRansac с параллельной оценкой гипотез.
+ *
+ * Использование: lensengine_ransac_benchmark <запись> [--repeat N] [--size WxH]
+ */
+
+using namespace LensEngine;
+
+namespace {
+struct Timing {
+    std::vector<double> micros;
+    double scoreSum = 0.0;
+    double iterationSum = 0.0;
+};
+
+// Прежняя реализация Lidar3DProcessor::ransacPlaneDetection (точка отсчета)
+float legacyRansac(const std::vector<glm::vec3> &points, float threshold, int maxIterations)
+{
+    float bestConfidence = 0.0f;
+    if (points.size() < 3) {
+        return bestConfidence;
+    }
+
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<> dis(0, static_cast<int>(points.size()) - 1);
+
+    for (int i = 0; i < maxIterations; ++i) {
+        const int idx1 = dis(gen);
+        const int idx2 = dis(gen);
+        const int idx3 = dis(gen);
+        if (idx1 == idx2 || idx2 == idx3 || idx1 == idx3) {
+            continue;
+        }
+
+        const glm::vec3 normal = glm::normalize(glm::cross(points[idx2] - points[idx1], points[idx3] - points[idx1]));
+        if (std::isnan(normal.x) || std::isnan(normal.y) || std::isnan(normal.z)) {
+            continue;
+        }
+
+        std::vector<glm::vec3> inliers;
+        for (const glm::vec3 &point : points) {
+            if (std::abs(glm::dot(point - points[idx1], normal)) < threshold) {
+                inliers.push_back(point);
+            }
+        }
+        bestConfidence = std::max(bestConfidence, static_cast<float>(inliers.size()) / points.size());
+    }
+    return bestConfidence;
+}
+
+void measure(Timing &timing, const std::function<void(double &score, double &iterations)> &body)
+{
+    double score = 0.0;
+    double iterations = 0.0;
+    const auto start = std::chrono::steady_clock::now();
+    body(score, iterations);
+    timing.micros.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    timing.scoreSum += score;
+    timing.iterationSum += iterations;
+}
+
+void report(const char *name, Timing &timing)
+{
+    if (timing.micros.empty()) {
+        return;
+    }
+    std::sort(timing.micros.begin(), timing.micros.end());
+    double total = 0.0;
+    for (double value : timing.micros) {
+        total += value;
+    }
+    const size_t runs = timing.micros.size();
+    auto percentile = [&timing, runs](double p) {
+        return timing.micros[std::min(runs - 1, static_cast<size_t>(p * static_cast<double>(runs - 1) + 0.5))];
+    };
+    std::printf("%-22s mean %9.1f us  p50 %9.1f us  p99 %9.1f us  score %.3f  iterations %.1f\n",
+                name, total / runs, percentile(0.50), percentile(0.99),
+                timing.scoreSum / runs, timing.iterationSum / runs);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <recording> [--repeat N] [--size WxH]\n", argv[0]);
+        return 1;
+    }
+
+    int repeat = 5;
+    DepthIntrinsics intrinsics;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            unsigned width = 0;
+            unsigned height = 0;
+            if (std::sscanf(argv[++i], "%ux%u", &width, &height) == 2 && width > 0 && height > 0) {
+                // Та же оптика, другое разрешение
+                const float scale = static_cast<float>(width) / static_cast<float>(intrinsics.width);
+                intrinsics.width = width;
+                intrinsics.height = height;
+                intrinsics.focalLengthX *= scale;
+                intrinsics.focalLengthY *= scale;
+                intrinsics.principalPointX = width * 0.5f;
+                intrinsics.principalPointY = height * 0.5f;
+            }
+        }
+    }
+
+    SensorRecordReader reader;
+    if (!reader.open(argv[1])) {
+        std::fprintf(stderr, "%s\n", reader.errorString().c_str());
+        return 1;
+    }
+
+    DepthUnprojector unprojector;
+    unprojector.setIntrinsics(intrinsics);
+    DepthUnprojector::Options unprojectOptions;
+    unprojectOptions.step = 4;
+    unprojectOptions.minDepth = 0.15f;
+    unprojectOptions.maxDepth = 5.0f;
+    unprojectOptions.minConfidence = 1;
+
+    std::vector<PointCloudSoA> frames;
+    SensorRecording::Record record;
+    while (reader.next(record)) {
+        if (record.type != SensorRecording::RecordType::Depth) {
+            continue;
+        }
+        PointCloudSoA cloud;
+        if (unprojector.unproject(record.data, record.confidence, unprojectOptions, cloud) >= 3) {
+            frames.push_back(std::move(cloud));
+        }
+    }
+    if (!reader.errorString().empty()) {
+        std::fprintf(stderr, "%s\n", reader.errorString().c_str());
+        return 1;
+    }
+    if (frames.empty()) {
+        std::fprintf(stderr, "No depth frames of %ux%u in recording\n", intrinsics.width, intrinsics.height);
+        return 1;
+    }
+
+    size_t totalPoints = 0;
+    for (const PointCloudSoA &cloud : frames) {
+        totalPoints += cloud.count;
+    }
+    TaskScheduler scheduler;
+    std::printf("%zu depth frames, %.0f points/frame, %zu worker threads, %d repeats\n",
+                frames.size(), static_cast<double>(totalPoints) / frames.size(), scheduler.threadCount(), repeat);
+
+    PlaneRansac::Options ransacOptions;
+    ransacOptions.parallelMinPoints = 0;
+    PlaneRansac sequential(ransacOptions);
+    PlaneRansac parallel(ransacOptions);
+    parallel.setTaskScheduler(&scheduler);
+    sequential.seed(1);
+    parallel.seed(1);
+
+    Timing legacyTiming;
+    Timing sequentialTiming;
+    Timing parallelTiming;
+    for (int run = 0; run < repeat; ++run) {
+        for (const PointCloudSoA &cloud : frames) {
+            const std::vector<glm::vec3> points = cloud.toVec3();
+            measure(legacyTiming, [&](double &score, double &iterations) {
+                score = legacyRansac(points, ransacOptions.distanceThreshold, 100);
+                iterations = 100.0;
+            });
+            measure(sequentialTiming, [&](double &score, double &iterations) {
+                const PlaneRansac::Result result = sequential.fit(cloud);
+                score = result.score;
+                iterations = result.iterations;
+            });
+            measure(parallelTiming, [&](double &score, double &iterations) {
+                const PlaneRansac::Result result = parallel.fit(cloud);
+                score = result.score;
+                iterations = result.iterations;
+            });
+        }
+    }
+
+    report("legacy (100 iter)", legacyTiming);
+    report("PlaneRansac", sequentialTiming);
+    report("PlaneRansac parallel", parallelTiming);
+    return 0;
+}
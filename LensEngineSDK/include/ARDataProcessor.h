@@ -5,10 +5,10 @@
 #include "SensorFusionEKF.h"
 #include "Lidar3DProcessor.h"
 #include "CameraController.h"
+#include "TaskScheduler.h"
 #include <vector>
 #include <memory>
 #include <functional>
-#include <future>
 #include <string>
 
 #include "SpatialMappingSystem.h"
@@ -40,15 +40,28 @@ public:
     // Установка контроллера камеры
     void setCameraController(CameraController* controller);
 
-    // Асинхронная обработка полного кадра
-    void processFrameAsync(const ARFrame &frame);
+    // Пул задач движка (без него используется TaskScheduler::shared())
+    void setTaskScheduler(TaskScheduler* scheduler);
 
-    // Обновление Spatial Mapping
-    void updateSpatialMapping(const Lidar3DProcessor::SpatialAnalysisResult &analysis,
-                              const std::vector<glm::vec3> &points);
+    // Параметры карт глубины кадров (для меша окружения)
+    void setDepthIntrinsics(const DepthIntrinsics &intrinsics);
+
+    // Асинхронная обработка полного кадра. Карта глубины кадра идет в меш с позой
+    // frame.cameraPose (ее задает вызывающий; нулевой timestamp - поза неизвестна).
+    // Возвращает false, если кадр отброшен (предыдущий еще обрабатывается)
+    bool processFrameAsync(const ARFrame &frame);
+
+    // Виртуальные объекты в карте (окклюзия)
     void addVirtualObjectToScene(const glm::vec3 &position, const glm::vec3 &size);
     void updateVirtualObjectPosition(const std::string &id, const glm::vec3 &position);
 
+    // Версия меша окружения (растет с каждым обновлением кусков)
+    uint64_t getMeshVersion() const;
+
+    // Hit-test по мешу окружения
+    bool raycast(const MeshRaycaster::Ray &ray, MeshRaycaster::Hit &hit) const;
+    void raycast(const std::vector<MeshRaycaster::Ray> &rays, std::vector<MeshRaycaster::Hit> &hits) const;
+
     // Колбэки
     using FrameProcessedCallback = std::function<void(const ARFrame&)>;
     using FeaturePointsCallback = std::function<void(const std::vector<FeaturePoint>&)>;
@@ -70,9 +83,10 @@ private:
     RGBImage m_previousFrame;
     CameraPose m_previousPose;
 
-    // Асинхронная обработка
-    std::future<void> m_processingFuture;
-    void processFrameInternal(const ARFrame &frame);
+    // Асинхронная обработка (кадр переносится в задачу, буферы не копируются)
+    TaskScheduler* m_scheduler;
+    TaskScheduler::TaskHandle m_processingTask;
+    void processFrameInternal(ARFrame frame);
 
     std::unique_ptr<SpatialMappingSystem> m_spatialMapping;
 
@@ -0,0 +1,70 @@
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include "LensEngineTypes.h"
+#include "TaskScheduler.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace LensEngine {
+
+/**
+ * @brief Офлайн обработка записи сенсоров с максимальной скоростью
+ *
+ * Записи читаются в порядке поступления. Независимая работа кадра
+ * (распаковка глубины в точки, feature points, освещение) выполняется
+ * параллельно для нескольких кадров на пуле задач, а зависящие от
+ * порядка стадии (IMU фьюжн, LiDAR обновление EKF, картирование)
+ * выполняются последовательно в исходном порядке записей.
+ *
+ * Фьюжн использует метки времени записи, поэтому траектория не зависит
+ * от скорости воспроизведения. Компоненты создаются заново для каждого
+ * запуска и не затрагивают состояние работающего движка.
+ */
+class BatchProcessor {
+public:
+    struct Options {
+        std::string trajectoryPath;      // Файл траектории в формате TUM (пусто - не писать)
+        size_t maxFramesInFlight = 0;    // Окно параллельной обработки (0 - два кадра на поток)
+        uint64_t depthMatchTolerance = 20; // Макс. расхождение RGB и глубины (мс)
+        uint64_t confidenceMatchTolerance = 8; // Макс. расхождение глубины и ее уверенности (мс), как в движке
+        DepthIntrinsics depthIntrinsics;   // Параметры камеры глубины записи
+        uint8_t minConfidence = 1;         // Мин. уровень уверенности LiDAR (0 - low, 2 - high)
+    };
+
+    struct Result {
+        bool success = false;
+        std::string errorString;
+
+        uint64_t framesProcessed = 0;
+        uint64_t framesWithDepth = 0;
+        uint64_t imuSamples = 0;
+
+        double wallTimeSeconds = 0.0;
+        double recordingSeconds = 0.0;   // Длительность записи по меткам времени
+        double framesPerSecond = 0.0;
+        double speedup = 0.0;            // Во сколько раз быстрее реального времени
+
+        // Задержка кадра от чтения до завершения последовательных стадий
+        double meanFrameLatencyMs = 0.0;
+        double p50FrameLatencyMs = 0.0;
+        double p99FrameLatencyMs = 0.0;
+
+        std::vector<CameraPose> trajectory;
+    };
+
+    explicit BatchProcessor(TaskScheduler &scheduler);
+
+    Result run(const std::string &recordingPath, const Options &options);
+
+    // Строка траектории TUM: timestamp(с) tx ty tz qx qy qz qw
+    static bool writeTumTrajectory(const std::string &path, const std::vector<CameraPose> &trajectory);
+
+private:
+    TaskScheduler &m_scheduler;
+};
+
+} // namespace LensEngine
+
+#endif // BATCHPROCESSOR_H
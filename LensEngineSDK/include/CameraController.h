@@ -3,6 +3,7 @@
 
 #include "LensEngineTypes.h"
 #include <functional>
+#include <mutex>
 
 namespace LensEngine {
 
@@ -18,8 +19,8 @@ public:
     ~CameraController();
 
     // Основные свойства
-    glm::vec3 position() const { return m_position; }
-    glm::quat rotation() const { return m_rotation; }
+    glm::vec3 position() const;
+    glm::quat rotation() const;
     glm::vec3 forward() const;
     glm::vec3 up() const;
     glm::vec3 right() const;
@@ -50,6 +51,9 @@ private:
     bool m_initialCalibration;
     
     CameraUpdatedCallback m_cameraUpdatedCallback;
+
+    // Поза приходит и из потока IMU, и из задачи одометрии по глубине
+    mutable std::mutex m_mutex;
 };
 
 } // namespace LensEngine
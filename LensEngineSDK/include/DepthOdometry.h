@@ -0,0 +1,80 @@
+#ifndef DEPTHODOMETRY_H
+#define DEPTHODOMETRY_H
+
+#include "LensEngineTypes.h"
+#include "OrganizedPointCloud.h"
+#include "TaskScheduler.h"
+#include <vector>
+#include <cstdint>
+
+namespace LensEngine {
+
+/**
+ * @brief Одометрия по глубине: ICP точка-плоскость между соседними кадрами
+ *
+ * Соответствия ищутся проекцией: точка текущего кадра переносится текущей
+ * оценкой позы и проецируется в сетку предыдущего кадра, без поиска
+ * соседей. Пары с большим расстоянием или расходящимися нормалями
+ * отбрасываются, невязки взвешиваются по Хуберу и уверенности LiDAR.
+ *
+ * Нормальные уравнения 6x6 копятся блоками строк сетки параллельно
+ * (каждая точка - SIMD добавление строки [J, r, 1] во внешнее
+ * произведение), блоки складываются в фиксированном порядке, поэтому
+ * результат не зависит от числа потоков. Ковариация - sigma^2 * H^-1;
+ * если какое-то направление почти не ограничено (коридор, одна стена),
+ * мера отбрасывается, а не выдается с заниженной ковариацией.
+ * Экземпляр не потокобезопасен.
+ */
+class DepthOdometry {
+public:
+    struct Options {
+        bool enabled = true;
+        uint32_t maxIterations = 10;
+        float maxCorrespondenceDistance = 0.1f;    // м
+        float minNormalCos = 0.8f;                 // Мин. косинус угла между нормалями пары
+        float huberThreshold = 0.02f;              // м
+        uint32_t minCorrespondences = 150;
+        float convergenceThreshold = 1e-5f;        // Норма приращения (рад, м)
+        float maxRotation = 0.35f;                 // Больше за кадр - сбой (рад)
+        float maxTranslation = 0.3f;               // м
+        float minResidualSigma = 0.002f;           // Нижняя граница шума для ковариации (м)
+        float minConstraint = 0.01f;               // Мин. 1 / (N * diag(H^-1)): слабее - вырожденная сцена
+        uint32_t rowsPerBlock = 8;                 // Строк сетки на параллельную часть
+    };
+
+    DepthOdometry();
+    explicit DepthOdometry(const Options &options);
+
+    void setOptions(const Options &options) { m_options = options; }
+    const Options &options() const { return m_options; }
+
+    // nullptr - все в вызывающем потоке
+    void setTaskScheduler(TaskScheduler *scheduler);
+
+    // cloud - кадр с нормалями, gridIntrinsics - параметры камеры его сетки (ячейка = пиксель).
+    // Первый кадр и кадр после смены сетки только становятся опорными (valid = false)
+    RelativePoseMeasurement track(const OrganizedPointCloud &cloud, const DepthIntrinsics &gridIntrinsics);
+
+    void reset();
+
+private:
+    struct alignas(16) Accumulator {
+        float sums[8][8];           // Sum w * a * a^T, a = [J (6), r, 1]
+        uint32_t count;
+        float residualSquares;      // Sum r^2 без весов
+    };
+
+    void accumulateRows(const OrganizedPointCloud &source, const float rotation[9], const float translation[3],
+                        uint32_t rowBegin, uint32_t rowEnd, Accumulator &accumulator) const;
+
+    Options m_options;
+    TaskScheduler *m_scheduler;
+    OrganizedPointCloud m_reference;
+    DepthIntrinsics m_referenceIntrinsics;
+    bool m_hasReference;
+    std::vector<Accumulator> m_partials;
+};
+
+} // namespace LensEngine
+
+#endif // DEPTHODOMETRY_H
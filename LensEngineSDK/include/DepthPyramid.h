@@ -0,0 +1,85 @@
+#ifndef DEPTHPYRAMID_H
+#define DEPTHPYRAMID_H
+
+#include "LensEngineTypes.h"
+#include "DepthUnprojector.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace LensEngine {
+
+/**
+ * @brief Пирамида карты глубины с объединением только допустимых пикселей
+ *
+ * Уровень 0 - исходная карта, где пиксели вне диапазона и ниже порога
+ * уверенности обнулены. Каждый следующий уровень объединяет блоки 2x2
+ * предыдущего: минимум или медиана только по допустимым пикселям, поэтому
+ * тонкие структуры не теряются, как при прореживании с шагом, а ячейка
+ * пуста только если пуст весь ее блок (дыры заполняются с более мелких
+ * уровней). Уверенность ячейки - наименьшая среди допустимых пикселей блока.
+ *
+ * Объединение глубины - SSE2/NEON (сеть сортировки четырех значений).
+ * У каждого уровня свои параметры камеры и таблицы лучей, поэтому уровень
+ * распаковывается как обычная карта с шагом 1. Экземпляр не потокобезопасен.
+ */
+class DepthPyramid {
+public:
+    enum class Pooling : uint8_t {
+        Min,            // Ближайшая поверхность блока (препятствия)
+        MedianOfValid   // Нижняя медиана допустимых значений (устойчиво к выбросам)
+    };
+
+    struct Options {
+        uint32_t maxLevels = 5;         // Включая уровень 0
+        Pooling pooling = Pooling::MedianOfValid;
+        float minDepth = 0.1f;
+        float maxDepth = 10.0f;
+        uint8_t minConfidence = 0;
+    };
+
+    struct Level {
+        DepthIntrinsics intrinsics;     // Параметры камеры уровня (сетка 2^level пикселей)
+        std::vector<float> depth;       // 0 - пусто
+        std::vector<uint8_t> confidence; // Пусто, если карты уверенности не было
+        size_t validCount = 0;
+    };
+
+    DepthPyramid();
+    explicit DepthPyramid(const Options &options);
+
+    void setOptions(const Options &options) { m_options = options; }
+    const Options &options() const { return m_options; }
+
+    // Возвращает число уровней (0 - карта не подходит к параметрам камеры).
+    // confidence другого размера игнорируется
+    size_t build(const float *depth, size_t depthCount, const uint8_t *confidence, size_t confidenceCount,
+                 const DepthIntrinsics &intrinsics);
+    size_t build(const SharedBuffer &depth, const SharedBuffer &confidence, const DepthIntrinsics &intrinsics);
+
+    size_t levelCount() const { return m_levelCount; }
+    const Level &level(size_t index) const { return m_levels[index]; }
+
+    // Уровень с числом точек, ближайшим к бюджету (при равенстве - более детальный)
+    size_t levelForBudget(size_t pointBudget) const;
+
+    // Распаковка уровня целиком; options.step игнорируется
+    size_t unproject(size_t index, const DepthUnprojector::Options &options, PointCloudSoA &output) const;
+    // step организованного облака - размер ячейки уровня в пикселях исходной карты
+    size_t unprojectOrganized(size_t index, const DepthUnprojector::Options &options,
+                              OrganizedPointCloud &output) const;
+
+private:
+    void buildBase(const float *depth, const uint8_t *confidence, const DepthIntrinsics &intrinsics);
+    void downsample(const Level &fine, Level &coarse) const;
+    void setLevelIntrinsics(size_t index, const DepthIntrinsics &intrinsics);
+
+    Options m_options;
+    std::vector<Level> m_levels;
+    std::vector<DepthUnprojector> m_unprojectors;   // Таблицы лучей по уровням
+    size_t m_levelCount;
+};
+
+} // namespace LensEngine
+
+#endif // DEPTHPYRAMID_H
@@ -0,0 +1,64 @@
+#ifndef DEPTHTEMPORALFILTER_H
+#define DEPTHTEMPORALFILTER_H
+
+#include "LensEngineTypes.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace LensEngine {
+
+/**
+ * @brief Временной фильтр карты глубины между кадрами LiDAR
+ *
+ * Каждый пиксель - экспоненциальное скользящее среднее: новое измерение
+ * входит с долей alpha, умноженной на вес уровня уверенности. Скачок
+ * больше resetThreshold (доля глубины) считается сменой поверхности:
+ * доля нового измерения становится равной весу уверенности, поэтому
+ * уверенные пиксели сбрасываются сразу, а мерцание краев с низкой
+ * уверенностью гасится. Пиксели без нового измерения обнуляются.
+ *
+ * С позой камеры предыдущее состояние сначала переносится в текущий
+ * кадр (распаковка, перенос по относительной позе, проекция с z-буфером).
+ * Смешивание - один проход SSE2/NEON по сетке; буферы состояния живут
+ * между кадрами. Экземпляр не потокобезопасен.
+ */
+class DepthTemporalFilter {
+public:
+    static constexpr uint8_t kConfidenceLevels = 3;
+
+    struct Options {
+        bool enabled = false;
+        float alpha = 0.35f;                // Доля нового измерения у стабильного пикселя
+        float resetThreshold = 0.05f;       // Относительный скачок глубины для сброса
+        float confidenceWeights[kConfidenceLevels] = {0.25f, 0.6f, 1.0f};
+        bool compensatePose = true;         // Переносить состояние по позе камеры
+    };
+
+    DepthTemporalFilter();
+    explicit DepthTemporalFilter(const Options &options);
+
+    void setOptions(const Options &options) { m_options = options; }
+    const Options &options() const { return m_options; }
+
+    // Отфильтрованная карта того же размера (действительна до следующего вызова).
+    // confidence другого размера игнорируется; pose с нулевым timestamp - поза неизвестна
+    const float *apply(const float *depth, size_t depthCount, const uint8_t *confidence, size_t confidenceCount,
+                       const DepthIntrinsics &intrinsics, const CameraPose &pose);
+
+    void reset();
+
+private:
+    bool warpState(const DepthIntrinsics &intrinsics, const CameraPose &pose);
+
+    Options m_options;
+    std::vector<float> m_state;         // Отфильтрованная глубина прошлого кадра
+    std::vector<float> m_warped;        // Состояние, перенесенное в текущий кадр
+    DepthIntrinsics m_intrinsics;
+    CameraPose m_pose;                  // Поза кадра m_state
+    bool m_hasState;
+};
+
+} // namespace LensEngine
+
+#endif // DEPTHTEMPORALFILTER_H
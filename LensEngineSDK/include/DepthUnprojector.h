@@ -0,0 +1,110 @@
+#ifndef DEPTHUNPROJECTOR_H
+#define DEPTHUNPROJECTOR_H
+
+#include "LensEngineTypes.h"
+#include "SharedBuffer.h"
+#include "OrganizedPointCloud.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace LensEngine {
+
+/**
+ * @brief Облако точек в раскладке SoA (x, y, z и вес в отдельных массивах)
+ *
+ * Буфер переиспользуется между кадрами: емкость только растет, поэтому
+ * в установившемся режиме распаковка не выделяет память.
+ */
+struct PointCloudSoA {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> weight;      // Вес точки по уверенности LiDAR (1 без карты уверенности)
+    size_t count = 0;
+
+    // Емкость с запасом на одну SIMD запись за концом
+    void reserve(size_t points);
+    void clear() { count = 0; }
+    bool empty() const { return count == 0; }
+
+    glm::vec3 point(size_t index) const { return glm::vec3(x[index], y[index], z[index]); }
+    std::vector<glm::vec3> toVec3() const;
+    void toVec3(std::vector<glm::vec3> &output) const;  // Емкость output переиспользуется
+    // Из AoS точек; weights другого размера - все веса 1
+    void assign(const std::vector<glm::vec3> &points, const std::vector<float> &weights);
+    // Удалить точки по возрастающим индексам (порядок остальных сохраняется)
+    void erase(const std::vector<uint32_t> &sortedIndices);
+    std::vector<float> weights() const { return std::vector<float>(weight.begin(), weight.begin() + count); }
+};
+
+/**
+ * @brief Распаковка карты глубины в 3D точки камеры
+ *
+ * Для пинхол модели луч пикселя (u - cx) / fx, (v - cy) / fy, 1
+ * разделяется на таблицу по столбцам и таблицу по строкам, которые
+ * строятся один раз на смену параметров. Распаковка - только умножение
+ * глубины на луч (без делений); на полном разрешении - 4 пикселя за шаг
+ * SSE2/NEON с отбором допустимой глубины. Для 256x192 используется
+ * вариант с размерами на этапе компиляции.
+ *
+ * Карта уверенности (uint8 на пиксель, уровни ARKit 0-2) проверяется в
+ * том же проходе: пиксели ниже minConfidence не материализуются, а у
+ * остальных в буфер пишется вес уровня для подгонки плоскостей и фьюжна.
+ *
+ * Таблица публикуется атомарно: распаковку можно вызывать из нескольких
+ * потоков одновременно с разными выходными буферами.
+ */
+class DepthUnprojector {
+public:
+    static constexpr uint8_t kConfidenceLevels = 3;
+
+    struct Options {
+        uint32_t step = 1;          // Шаг прореживания по X и Y
+        float minDepth = 0.1f;
+        float maxDepth = 10.0f;
+        uint8_t minConfidence = 0;  // 0 - low, 1 - medium, 2 - high
+        float confidenceWeights[kConfidenceLevels] = {0.25f, 0.6f, 1.0f};
+    };
+
+    DepthUnprojector();
+
+    void setIntrinsics(const DepthIntrinsics &intrinsics);
+    DepthIntrinsics intrinsics() const;
+
+    // Параметры LiDAR из параметров RGB камеры (то же поле зрения, другое разрешение)
+    static DepthIntrinsics fromCameraIntrinsics(const CameraIntrinsics &camera,
+                                                uint32_t depthWidth, uint32_t depthHeight);
+
+    // Карта глубины float32 размера width x height из параметров.
+    // Возвращает число точек; при несовпадении размера - 0
+    size_t unproject(const SharedBuffer &depth, const Options &options, PointCloudSoA &output) const;
+    size_t unproject(const float *depth, size_t depthCount, const Options &options, PointCloudSoA &output) const;
+
+    // С картой уверенности того же разрешения (другая карта игнорируется)
+    size_t unproject(const SharedBuffer &depth, const SharedBuffer &confidence,
+                     const Options &options, PointCloudSoA &output) const;
+    size_t unproject(const float *depth, size_t depthCount, const uint8_t *confidence, size_t confidenceCount,
+                     const Options &options, PointCloudSoA &output) const;
+
+    // На сетку с шагом options.step без уплотнения (те же критерии отбора).
+    // Возвращает число допустимых ячеек
+    size_t unprojectOrganized(const SharedBuffer &depth, const SharedBuffer &confidence,
+                              const Options &options, OrganizedPointCloud &output) const;
+    size_t unprojectOrganized(const float *depth, size_t depthCount, const uint8_t *confidence,
+                              size_t confidenceCount, const Options &options, OrganizedPointCloud &output) const;
+
+private:
+    struct RayTable {
+        DepthIntrinsics intrinsics;
+        std::vector<float> rayX;    // По столбцам
+        std::vector<float> rayY;    // По строкам
+    };
+
+    std::shared_ptr<const RayTable> m_rayTable;
+};
+
+} // namespace LensEngine
+
+#endif // DEPTHUNPROJECTOR_H
@@ -7,9 +7,16 @@
 #include "ARDataProcessor.h"
 #include "Lidar3DProcessor.h"
 #include "CameraController.h"
+#include "SensorSynchronizer.h"
+#include "SnapshotStore.h"
+#include "TaskScheduler.h"
+#include "SensorRecording.h"
+#include "BatchProcessor.h"
 #include <memory>
-#include <mutex>
 #include <functional>
+#include <mutex>
+#include <deque>
+#include <atomic>
 
 namespace LensEngine {
 
@@ -21,58 +28,140 @@ namespace LensEngine {
 class LensEngineCore {
 public:
     LensEngineCore();
+    explicit LensEngineCore(const TaskScheduler::Config& schedulerConfig);
     ~LensEngineCore();
 
     bool initialize();
     void shutdown();
 
-    // Обработка данных
-    void processRGBData(const uint8_t* data, size_t size, uint32_t width, uint32_t height, uint64_t timestamp);
+    // Обработка данных (указатели: данные копируются один раз при приеме).
+    // processRGBData не ждет анализа и возвращает номер кадра; итог кадра
+    // приходит в колбэк завершения с этим номером
+    uint64_t processRGBData(const uint8_t* data, size_t size, uint32_t width, uint32_t height, uint64_t timestamp);
     void processLidarData(const uint8_t* depthData, size_t depthSize, 
                          const uint8_t* confidenceData, size_t confidenceSize, uint64_t timestamp);
+    void processLidarConfidence(const uint8_t* confidenceData, size_t confidenceSize, uint64_t timestamp);
+    
+    // Обработка данных без копирования (буфер разделяется всеми стадиями кадра).
+    // deviceFrame - номер кадра LiDAR на устройстве (одинаковый у глубины и ее
+    // уверенности); 0 - номера нет, пара ищется по времени
+    uint64_t processRGBData(const SharedBuffer& image, uint32_t width, uint32_t height, uint32_t stride, uint64_t timestamp);
+    void processLidarData(const SharedBuffer& depth, const SharedBuffer& confidence, uint64_t timestamp,
+                          uint64_t deviceFrame = 0);
+    void processLidarConfidence(const SharedBuffer& confidence, uint64_t timestamp, uint64_t deviceFrame = 0);
     void processIMUData(const RawIMUData& imuData);
 
-    // Получение результатов
+    // Получение результатов (без блокировок, не ждут обновлений от сенсоров)
     CameraPose getCurrentCameraPose() const;
     std::vector<FeaturePoint> getFeaturePoints() const;
     std::vector<glm::vec3> getLidarPoints() const;
     CameraIntrinsics getCameraIntrinsics() const;
     LightEstimation getLightEstimation() const;
+    
+    // Снимки результатов без копирования векторов
+    SnapshotStore<std::vector<FeaturePoint>>::Snapshot getFeaturePointsSnapshot() const;
+    SnapshotStore<std::vector<glm::vec3>>::Snapshot getLidarPointsSnapshot() const;
+
+    // Версия меша комнаты: 0 - меш еще не строился
+    uint64_t getMeshVersion() const;
+
+    // Hit-test по мешу комнаты (по последнему опубликованному мешу, без ожидания обновления)
+    bool raycast(const MeshRaycaster::Ray& ray, MeshRaycaster::Hit& hit) const;
+    void raycast(const std::vector<MeshRaycaster::Ray>& rays, std::vector<MeshRaycaster::Hit>& hits) const;
 
     // Настройки
     void setNoiseParameters(double gyroNoise, double accelNoise, double visualNoise, double lidarNoise);
     void setCameraParameters(float focalLengthX, float focalLengthY, float principalPointX, float principalPointY);
+    void setDepthIntrinsics(const DepthIntrinsics& intrinsics);
+    DepthIntrinsics getDepthIntrinsics() const;
+    void setLidarMinimumConfidence(uint8_t level);
+    void setLidarPointBudget(size_t points);
+    void setLidarFilterOptions(const VoxelGridFilter::Options& options);
+    VoxelGridFilter::Statistics getLidarFilterStatistics() const;
+    void setLidarTemporalFilterOptions(const DepthTemporalFilter::Options& options);
+    void setLidarOdometryOptions(const DepthOdometry::Options& options);
+    void setSynchronizerConfig(const SensorSynchronizer::Config& config);
+    SensorSynchronizer::Statistics getSynchronizerStatistics() const;
+
+    // Пул задач движка: на нем идут обработка кадров, LiDAR и картирование
+    TaskScheduler& taskScheduler();
+
+    // Запись входящих данных сенсоров для офлайн воспроизведения
+    bool startRecording(const std::string& path);
+    void stopRecording();
+    bool isRecording() const;
+
+    // Офлайн обработка записи на пуле движка (блокирует до конца записи)
+    BatchProcessor::Result runBatch(const std::string& recordingPath, const BatchProcessor::Options& options);
     
     // Установка колбэков
     void setPoseCallback(std::function<void(const CameraPose&)> callback);
     void setFeaturePointsCallback(std::function<void(const std::vector<FeaturePoint>&)> callback);
     void setLidarPointsCallback(std::function<void(const std::vector<glm::vec3>&)> callback);
+    void setFrameCompletedCallback(std::function<void(uint64_t, FrameStatus, const ARFrame&)> callback);
 
 private:
+    // Пул задач объявлен первым: компоненты дожидаются своих задач до его остановки
+    std::unique_ptr<TaskScheduler> m_scheduler;
+
     // Компоненты
     std::unique_ptr<SensorFusionEKF> m_sensorFusion;
     std::unique_ptr<ARDataProcessor> m_dataProcessor;
     std::unique_ptr<Lidar3DProcessor> m_lidarProcessor;
     std::unique_ptr<CameraController> m_cameraController;
+    std::unique_ptr<SensorSynchronizer> m_synchronizer;
+
+    // Данные: читатели не блокируют писателей (SeqLock для POD, RCU снимки для векторов)
+    SeqLock<CameraPose> m_currentPose;
+    SnapshotStore<std::vector<FeaturePoint>> m_featurePoints;
+    SnapshotStore<std::vector<glm::vec3>> m_lidarPoints;
+    SeqLock<CameraIntrinsics> m_intrinsics;
+    SeqLock<LightEstimation> m_lightEstimation;
 
-    // Данные
-    mutable std::mutex m_dataMutex;
-    CameraPose m_currentPose;
-    std::vector<FeaturePoint> m_featurePoints;
-    std::vector<glm::vec3> m_lidarPoints;
-    CameraIntrinsics m_intrinsics;
-    LightEstimation m_lightEstimation;
+    // Запись сенсоров (публикуется атомарно, приемники данных не блокируются)
+    std::shared_ptr<SensorRecordWriter> m_recorder;
 
     // Состояние
     bool m_initialized;
+    std::atomic<uint64_t> m_rgbSequence;      // Приемники данных вызываются из разных потоков
+    std::atomic<uint64_t> m_lidarSequence;
+
+    // Глубина без уверенности ждет отдельный пакет уверенности (0x09),
+    // чтобы распаковка LiDAR шла уже с маской. Пары ищутся по номеру кадра
+    // устройства, без него - по времени: пакеты одного кадра LiDAR могут прийти
+    // в любом порядке. Уверенность уходит в синхронизатор с номером своей
+    // глубины, когда пара найдена
+    struct PendingDepth {
+        LidarData lidar;
+        uint64_t deviceFrame = 0;
+    };
+    struct PendingConfidence {
+        SharedBuffer confidence;
+        uint64_t timestamp = 0;
+        uint64_t deviceFrame = 0;
+    };
+    static constexpr uint64_t kConfidenceMatchTolerance = 8;   // Меньше половины периода LiDAR (60 Гц)
+    static constexpr size_t kMaxPendingDepth = 4;
+    std::mutex m_pendingDepthMutex;
+    std::deque<PendingDepth> m_pendingDepth;
+    std::deque<PendingConfidence> m_pendingConfidence;
+    bool m_confidenceStreamSeen;
     
     // Колбэки
     std::function<void(const CameraPose&)> m_poseCallback;
     std::function<void(const std::vector<FeaturePoint>&)> m_featurePointsCallback;
     std::function<void(const std::vector<glm::vec3>&)> m_lidarPointsCallback;
+    std::function<void(uint64_t, FrameStatus, const ARFrame&)> m_frameCompletedCallback;
     
     // Внутренние методы
     void setupCallbacks();
+    void onSynchronizedFrame(const ARFrame& frame);
+    void completeFrame(uint64_t sequenceNumber, FrameStatus status, const ARFrame& frame);
+    void flushPendingDepth();
+    // Пакеты одного кадра LiDAR: номер устройства у обоих, иначе время
+    static bool isSameLidarFrame(uint64_t frameA, uint64_t timestampA, uint64_t frameB, uint64_t timestampB);
+    // Кадр A раньше B и уже не найдет пару среди пакетов не старше B
+    static bool isEarlierLidarFrame(uint64_t frameA, uint64_t timestampA, uint64_t frameB, uint64_t timestampB);
 };
 
 } // namespace LensEngine
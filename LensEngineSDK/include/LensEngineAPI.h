@@ -2,6 +2,15 @@
 #define LENSENGINEAPI_H
 
 #include "LensEngineTypes.h"
+#include "SensorSynchronizer.h"
+#include "SnapshotStore.h"
+#include "TaskScheduler.h"
+#include "Profiler.h"
+#include "BatchProcessor.h"
+#include "VoxelHashMap.h"
+#include "DepthTemporalFilter.h"
+#include "DepthOdometry.h"
+#include "MeshRaycaster.h"
 #include <memory>
 #include <functional>
 
@@ -19,6 +28,8 @@ class LensEngineCore;
 class LensEngineAPI {
 public:
     LensEngineAPI();
+    // Число потоков и привязка к ядрам для пула задач движка
+    explicit LensEngineAPI(const TaskScheduler::Config& schedulerConfig);
     ~LensEngineAPI();
     
     // Запрет копирования
@@ -29,11 +40,22 @@ public:
     bool initialize();
     void shutdown();
     
-    // Обработка данных
-    void processRGBData(const uint8_t* data, size_t size, uint32_t width, uint32_t height, uint64_t timestamp);
+    // Обработка данных. processRGBData возвращается сразу (анализ только асинхронный)
+    // и отдает номер кадра, с которым придет FrameCompletedCallback
+    uint64_t processRGBData(const uint8_t* data, size_t size, uint32_t width, uint32_t height, uint64_t timestamp);
     void processLidarData(const uint8_t* depthData, size_t depthSize, const uint8_t* confidenceData, size_t confidenceSize, uint64_t timestamp);
+    void processLidarConfidence(const uint8_t* confidenceData, size_t confidenceSize, uint64_t timestamp);
     void processIMUData(const RawIMUData& imuData);
     
+    // Прием без копирования: буфер вызывающего кода оборачивается через
+    // SharedBuffer::wrap(data, size, release) и возвращается ему вызовом release,
+    // когда кадр перестает использоваться всеми стадиями движка
+    uint64_t processRGBData(const SharedBuffer& image, uint32_t width, uint32_t height, uint32_t stride, uint64_t timestamp);
+    // deviceFrame - номер кадра LiDAR на устройстве, общий у глубины и уверенности (0 - нет)
+    void processLidarData(const SharedBuffer& depth, const SharedBuffer& confidence, uint64_t timestamp,
+                          uint64_t deviceFrame = 0);
+    void processLidarConfidence(const SharedBuffer& confidence, uint64_t timestamp, uint64_t deviceFrame = 0);
+    
     // Получение результатов
     CameraPose getCurrentCameraPose() const;
     std::vector<FeaturePoint> getFeaturePoints() const;
@@ -41,18 +63,77 @@ public:
     CameraIntrinsics getCameraIntrinsics() const;
     LightEstimation getLightEstimation() const;
     
+    // Снимки результатов без копирования (можно держать сколько угодно, не блокируют обновления)
+    using FeaturePointsSnapshot = SnapshotStore<std::vector<FeaturePoint>>::Snapshot;
+    using LidarPointsSnapshot = SnapshotStore<std::vector<glm::vec3>>::Snapshot;
+    FeaturePointsSnapshot getFeaturePointsSnapshot() const;
+    LidarPointsSnapshot getLidarPointsSnapshot() const;
+    
+    // Версия меша комнаты из LiDAR: растет с каждым обновлением (0 - меша еще нет)
+    uint64_t getMeshVersion() const;
+
+    // Hit-test по мешу комнаты, построенному из LiDAR (мировая система координат).
+    // Пакет лучей делится между потоками пула движка
+    using Ray = MeshRaycaster::Ray;
+    using RaycastHit = MeshRaycaster::Hit;
+    bool raycast(const Ray& ray, RaycastHit& hit) const;
+    void raycast(const std::vector<Ray>& rays, std::vector<RaycastHit>& hits) const;
+    
     // Колбэки для обработки результатов
     using PoseCallback = std::function<void(const CameraPose&)>;
     using FeaturePointsCallback = std::function<void(const std::vector<FeaturePoint>&)>;
     using LidarPointsCallback = std::function<void(const std::vector<glm::vec3>&)>;
+    // Один вызов на каждый RGB кадр: обработан или отброшен (с причиной)
+    using FrameCompletedCallback = std::function<void(uint64_t sequenceNumber, FrameStatus status, const ARFrame& frame)>;
     
     void setPoseCallback(PoseCallback callback);
     void setFeaturePointsCallback(FeaturePointsCallback callback);
     void setLidarPointsCallback(LidarPointsCallback callback);
+    void setFrameCompletedCallback(FrameCompletedCallback callback);
     
     // Настройки
     void setNoiseParameters(double gyroNoise, double accelNoise, double visualNoise, double lidarNoise);
     void setCameraParameters(float focalLengthX, float focalLengthY, float principalPointX, float principalPointY);
+    // Разрешение и параметры карты глубины (по умолчанию LiDAR 256x192)
+    void setDepthIntrinsics(const DepthIntrinsics& intrinsics);
+    DepthIntrinsics getDepthIntrinsics() const;
+    // Минимальная уверенность точек LiDAR: 0 - low, 1 - medium (по умолчанию), 2 - high
+    void setLidarMinimumConfidence(uint8_t level);
+    // Примерное число точек LiDAR на кадр (уровень пирамиды глубины), по умолчанию 3072
+    void setLidarPointBudget(size_t points);
+    // Прореживание точек LiDAR по вокселям и удаление выбросов; статистика - точки до и после
+    void setLidarFilterOptions(const VoxelGridFilter::Options& options);
+    VoxelGridFilter::Statistics getLidarFilterStatistics() const;
+    // Временное сглаживание глубины LiDAR с компенсацией движения камеры (по умолчанию выключено)
+    void setLidarTemporalFilterOptions(const DepthTemporalFilter::Options& options);
+    // Одометрия по глубине LiDAR (ICP между кадрами) как мера позы для фильтра, по умолчанию включена
+    void setLidarOdometryOptions(const DepthOdometry::Options& options);
+    
+    // Синхронизация потоков сенсоров (допуски и политики для опоздавших/отсутствующих данных)
+    void setSynchronizerConfig(const SensorSynchronizer::Config& config);
+    SensorSynchronizer::Statistics getSynchronizerStatistics() const;
+    
+    // Трассировка стадий (общая для всех экземпляров движка, по умолчанию выключена).
+    // Выгрузка открывается в chrome://tracing или ui.perfetto.dev
+    void setTracingEnabled(bool enabled);
+    bool isTracingEnabled() const;
+    std::string exportChromeTrace() const;
+    bool writeChromeTrace(const std::string& path) const;
+    // Перцентили длительности по стадиям за последние события каждого потока
+    std::vector<Profiler::StageSummary> getStageSummaries() const;
+    void clearTrace();
+    
+    // Запись входящих данных сенсоров в файл (формат SensorRecording)
+    bool startRecording(const std::string& path);
+    void stopRecording();
+    bool isRecording() const;
+    
+    // Офлайн режим: обработать запись так быстро, как позволяют ядра.
+    // Возвращает траекторию (и пишет TUM файл, если задан путь) и статистику времени.
+    // Блокирует вызывающий поток и не меняет состояние текущей сессии
+    using BatchOptions = BatchProcessor::Options;
+    using BatchResult = BatchProcessor::Result;
+    BatchResult runBatch(const std::string& recordingPath, const BatchOptions& options);
 
 private:
     std::unique_ptr<LensEngineCore> m_core;
@@ -61,6 +142,7 @@ private:
     PoseCallback m_poseCallback;
     FeaturePointsCallback m_featurePointsCallback;
     LidarPointsCallback m_lidarPointsCallback;
+    FrameCompletedCallback m_frameCompletedCallback;
 };
 
 } // namespace LensEngine
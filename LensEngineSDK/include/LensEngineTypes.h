@@ -3,6 +3,7 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
+#include "SharedBuffer.h"
 #include <vector>
 #include <cstdint>
 #include <cstddef>
@@ -56,6 +57,27 @@ struct CameraIntrinsics {
         principalPointX(0), principalPointY(0), isValid(false) {}
 };
 
+// Параметры камеры глубины (пинхол модель, глубина по оси Z)
+struct DepthIntrinsics {
+    uint32_t width;
+    uint32_t height;
+    float focalLengthX;
+    float focalLengthY;
+    float principalPointX;
+    float principalPointY;
+    
+    // По умолчанию - LiDAR iPhone/iPad 256x192
+    DepthIntrinsics() : width(256), height(192), focalLengthX(256.0f), focalLengthY(256.0f),
+        principalPointX(128.0f), principalPointY(96.0f) {}
+    
+    bool operator==(const DepthIntrinsics& other) const {
+        return width == other.width && height == other.height &&
+               focalLengthX == other.focalLengthX && focalLengthY == other.focalLengthY &&
+               principalPointX == other.principalPointX && principalPointY == other.principalPointY;
+    }
+    bool operator!=(const DepthIntrinsics& other) const { return !(*this == other); }
+};
+
 // Light Estimation
 struct LightEstimation {
     float ambientIntensity;      // Интенсивность окружающего света
@@ -81,33 +103,98 @@ struct CameraPose {
         viewMatrix(1.0f), projectionMatrix(1.0f), confidence(0), timestamp(0) {}
 };
 
-// LiDAR данные
+// Относительная поза между кадрами глубины (одометрия по LiDAR)
+struct RelativePoseMeasurement {
+    bool valid;                  // false - опора потеряна, следующая мера от нового кадра
+    glm::quat rotation;          // Текущий кадр камеры глубины в системе предыдущего
+    glm::vec3 translation;
+    double covariance[36];       // 6x6 по строкам: поворот (рад), перенос (м) в системе предыдущего кадра
+    uint32_t correspondences;
+    float rmse;                  // Невязка точка-плоскость (м)
+    uint64_t sequenceNumber;
+    
+    RelativePoseMeasurement() : valid(false), rotation(1.0f, 0.0f, 0.0f, 0.0f), translation(0.0f),
+        covariance(), correspondences(0), rmse(0.0f), sequenceNumber(0) {}
+};
+
+// LiDAR данные (сырые карты разделяются между кадрами без копирования)
 struct LidarData {
-    std::vector<uint8_t> depthMap;      // Карта глубины (сырая)
-    std::vector<uint8_t> confidenceMap; // Карта уверенности
-    std::vector<uint8_t> pointCloud;    // Облако точек (сырое)
+    SharedBuffer depthMap;              // Карта глубины (сырая)
+    SharedBuffer confidenceMap;         // Карта уверенности
+    SharedBuffer pointCloud;            // Облако точек (сырое)
     std::vector<glm::vec3> points3D;    // Обработанные 3D точки
+    std::vector<float> pointWeights;    // Вес каждой точки points3D по уверенности (пусто - равные)
+    std::vector<glm::vec3> pointNormals; // Нормаль каждой точки points3D (нулевая - не определена)
     uint64_t sequenceNumber;
     uint64_t timestamp;
     
     LidarData() : sequenceNumber(0), timestamp(0) {}
 };
 
+// Плоскость сцены по LiDAR (в системе координат камеры глубины)
+struct DetectedPlane {
+    enum class Orientation : uint8_t {
+        Horizontal,     // Пол, столы (нормаль против гравитации)
+        Vertical        // Стены
+    };
+    
+    Orientation orientation;
+    glm::vec3 normal;            // Единичная нормаль
+    float distance;              // dot(normal, p) для точек плоскости
+    glm::vec3 center;            // Центр прямоугольника, охватывающего inliers
+    glm::vec3 axisU;             // Оси прямоугольника в плоскости (у стен U горизонтальна)
+    glm::vec3 axisV;
+    glm::vec2 extent;            // Размер вдоль U и V (м)
+    uint32_t inlierCount;
+    float score;                 // Взвешенная доля точек кадра на плоскости
+    
+    DetectedPlane() : orientation(Orientation::Horizontal), normal(0.0f, 1.0f, 0.0f), distance(0.0f),
+        center(0.0f), axisU(1.0f, 0.0f, 0.0f), axisV(0.0f, 0.0f, 1.0f), extent(0.0f),
+        inlierCount(0), score(0.0f) {}
+};
+
+// Препятствие: кластер точек над полом в ориентированном по гравитации боксе
+struct DetectedObstacle {
+    uint32_t trackId;            // Постоянен, пока кластер сопоставляется между кадрами
+    glm::vec3 center;            // Центр бокса
+    glm::vec3 centroid;          // Центр масс точек
+    glm::vec3 axisU;             // Горизонтальные оси бокса (U - вдоль наибольшего разброса)
+    glm::vec3 axisV;
+    glm::vec3 up;                // Вертикальная ось бокса (против гравитации)
+    glm::vec3 halfExtent;        // Полуразмеры вдоль U, V и up (м)
+    uint32_t pointCount;
+    uint32_t age;                // Кадров с момента появления трека
+    
+    DetectedObstacle() : trackId(0), center(0.0f), centroid(0.0f), axisU(1.0f, 0.0f, 0.0f),
+        axisV(0.0f, 0.0f, 1.0f), up(0.0f, 1.0f, 0.0f), halfExtent(0.0f), pointCount(0), age(0) {}
+};
+
 // RGB изображение (для обработки)
 struct RGBImage {
-    std::vector<uint8_t> data;   // RGB данные
+    SharedBuffer data;           // RGB данные (неизменяемые, общие для всех копий кадра)
     uint32_t width;
     uint32_t height;
+    uint32_t stride;             // Байт на строку (0 - строки без выравнивания, width * 3)
     uint64_t timestamp;
     
-    RGBImage() : width(0), height(0), timestamp(0) {}
+    RGBImage() : width(0), height(0), stride(0), timestamp(0) {}
+    
+    uint32_t bytesPerLine() const { return stride ? stride : width * 3; }
+};
+
+// Итог обработки RGB кадра (для сопоставления по номеру из processRGBData)
+enum class FrameStatus : uint8_t {
+    Processed,              // Кадр прошел анализ, результаты опубликованы
+    DroppedBusy,            // Анализ предыдущего кадра еще шел
+    DroppedUnsynchronized   // Синхронизатор отбросил кадр без парных данных
 };
 
 // Полный AR кадр
 struct ARFrame {
     RGBImage rgbImage;                    // RGB кадр
     std::vector<FeaturePoint> featurePoints; // Feature points из RGB
-    RawIMUData imu;                       // IMU данные
+    RawIMUData imu;                       // IMU данные (последний сэмпл)
+    std::vector<RawIMUData> imuSamples;   // IMU сэмплы с предыдущего кадра
     LidarData lidar;                      // LiDAR данные
     CameraIntrinsics intrinsics;          // Параметры камеры
     LightEstimation light;                // Освещение
@@ -2,6 +2,16 @@
 #define LIDAR3DPROCESSOR_H
 
 #include "LensEngineTypes.h"
+#include "TaskScheduler.h"
+#include "Profiler.h"
+#include "DepthUnprojector.h"
+#include "PlaneRansac.h"
+#include "VoxelHashMap.h"
+#include "ObstacleClusterer.h"
+#include "DepthTemporalFilter.h"
+#include "DepthPyramid.h"
+#include "DepthOdometry.h"
+#include "SnapshotStore.h"
 #include <vector>
 #include <mutex>
 #include <atomic>
@@ -19,24 +29,108 @@ public:
         bool hasFloor = false;
         float floorHeight = 0.0f;
         glm::vec3 floorNormal = glm::vec3(0, 1, 0);
-        glm::vec3 gravityDirection = glm::vec3(0, -1, 0);
-        std::vector<glm::vec3> planes;
-        std::vector<glm::vec3> obstacles;
-        std::vector<glm::vec3> walls;
+        glm::vec3 gravityDirection = glm::vec3(0, 1, 0);       // Оси камеры глубины (y вниз)
+        std::vector<DetectedPlane> planes;      // Все плоскости кадра: пол, столы, стены
+        std::vector<DetectedObstacle> obstacles; // Кластеры над полом с треками между кадрами
+        std::vector<DetectedPlane> walls;       // Вертикальные плоскости из planes
+        size_t rawPointCount = 0;               // Точек после распаковки
+        size_t filteredPointCount = 0;          // После вокселей и удаления выбросов
     };
 
+    // Результат кадра целиком: публикуется одним неизменяемым снимком,
+    // буферы снимков переиспользуются между кадрами
+    struct FrameResult {
+        uint64_t sequenceNumber = 0;
+        std::vector<glm::vec3> points;          // После фильтра (центры вокселей)
+        std::vector<glm::vec3> normals;         // Параллельно points
+        SpatialAnalysisResult analysis;
+        OrganizedPointCloud organizedCloud;     // Сетка уровня пирамиды с нормалями
+    };
+    using FrameSnapshot = std::shared_ptr<const FrameResult>;
+
     Lidar3DProcessor();
     ~Lidar3DProcessor();
 
-    // Основные методы
-    std::vector<glm::vec3> processDepthData(const std::vector<uint8_t> &depthData);
-    std::vector<glm::vec3> processDepthDataFast(const std::vector<uint8_t> &depthData);
-    void processLidarDataAsync(const std::vector<uint8_t> &depthData, 
-                               const std::vector<uint8_t> &confidenceData = std::vector<uint8_t>());
+    // Пул задач движка (без него используется TaskScheduler::shared())
+    void setTaskScheduler(TaskScheduler* scheduler);
+
+    // Параметры камеры глубины (разрешение карты и фокусные расстояния)
+    void setDepthIntrinsics(const DepthIntrinsics &intrinsics);
+    DepthIntrinsics getDepthIntrinsics() const;
+
+    // Направление гравитации в системе координат камеры глубины (от IMU).
+    // Ограничивает гипотезы плоскостей горизонтальными и вертикальными
+    void setGravityDirection(const glm::vec3 &gravity);
+    glm::vec3 getGravityDirection() const;
+
+    // Минимальный уровень уверенности LiDAR (0 - low, 1 - medium, 2 - high).
+    // Пиксели ниже уровня отбрасываются еще при распаковке глубины
+    void setMinimumConfidence(uint8_t level);
+    uint8_t getMinimumConfidence() const;
+
+    // Примерное число точек кадра: уровень пирамиды глубины выбирается под него
+    // (по умолчанию 3072 - как сетка 64x48 карты 256x192)
+    void setPointBudget(size_t points);
+    size_t getPointBudget() const;
+
+    // Поза камеры от фьюжна: компенсирует движение во временном фильтре глубины
+    void setCameraPose(const CameraPose &pose);
+
+    // Временное сглаживание карты глубины перед распаковкой (по умолчанию выключено)
+    void setTemporalFilterOptions(const DepthTemporalFilter::Options &options);
+    DepthTemporalFilter::Options getTemporalFilterOptions() const;
+
+    // ICP между соседними кадрами на сетке пирамиды (по умолчанию включено);
+    // результат уходит в OdometryCallback
+    void setOdometryOptions(const DepthOdometry::Options &options);
+    DepthOdometry::Options getOdometryOptions() const;
+
+    // Прореживание по вокселям и удаление выбросов перед анализом кадра
+    void setVoxelFilterOptions(const VoxelGridFilter::Options &options);
+    VoxelGridFilter::Options getVoxelFilterOptions() const;
+    // Число точек до и после фильтра в последнем кадре
+    VoxelGridFilter::Statistics getLastFilterStatistics() const;
+
+    // Кластеризация препятствий (размер вокселя связности, сопоставление треков)
+    void setObstacleOptions(const ObstacleClusterer::Options &options);
+    ObstacleClusterer::Options getObstacleOptions() const;
 
-    // Получение результатов
+    // Основные методы: точки из уровня пирамиды глубины (четверть пикселей
+    // карты; бюджет точек), а не каждый N-й пиксель
+    std::vector<glm::vec3> processDepthData(const SharedBuffer &depthData);
+    std::vector<glm::vec3> processDepthDataFast(const SharedBuffer &depthData);
+    // С картой уверенности: weights (если задан) получает вес каждой точки,
+    // normals - нормаль каждой точки (нулевая, если не определена),
+    // grid и gridIntrinsics - сетка уровня с нормалями для DepthOdometry::track
+    std::vector<glm::vec3> processDepthDataFast(const SharedBuffer &depthData, const SharedBuffer &confidenceData,
+                                                std::vector<float> *weights = nullptr,
+                                                std::vector<glm::vec3> *normals = nullptr,
+                                                OrganizedPointCloud *grid = nullptr,
+                                                DepthIntrinsics *gridIntrinsics = nullptr);
+    // Около pointBudget точек (уровень пирамиды с ближайшим числом точек)
+    std::vector<glm::vec3> processDepthData(const SharedBuffer &depthData, const SharedBuffer &confidenceData,
+                                            size_t pointBudget, std::vector<float> *weights = nullptr,
+                                            std::vector<glm::vec3> *normals = nullptr,
+                                            OrganizedPointCloud *grid = nullptr,
+                                            DepthIntrinsics *gridIntrinsics = nullptr);
+    // Последний кадр побеждает: если предыдущая карта еще обрабатывается, она
+    // прерывается (ее результат не публикуется), а новая ждет своей очереди,
+    // вытесняя ожидавшую раньше. После kMaxCancelledInRow прерываний подряд идущая
+    // карта доводится до результата. Возвращает false, если карта вытеснила другую.
+    // sequenceNumber попадает в трассировку стадий
+    bool processLidarDataAsync(const SharedBuffer &depthData, 
+                               const SharedBuffer &confidenceData = SharedBuffer(),
+                               uint64_t sequenceNumber = 0);
+
+    // Получение результатов: снимок последнего завершенного кадра без копирования,
+    // остальные методы копируют части снимка
+    FrameSnapshot getLastFrame() const;
     SpatialAnalysisResult getLastAnalysis() const;
     std::vector<glm::vec3> getLastProcessedPoints() const;
+    // Нормали параллельно getLastProcessedPoints (усреднены по вокселям)
+    std::vector<glm::vec3> getLastProcessedNormals() const;
+    // Последний кадр на сетке глубины с нормалями (соседи без KD-дерева); держит снимок кадра
+    std::shared_ptr<const OrganizedPointCloud> getLastOrganizedCloud() const;
 
     // Управление
     void stopProcessing();
@@ -45,60 +139,122 @@ public:
     using AnalysisCallback = std::function<void(const SpatialAnalysisResult&)>;
     using PointsCallback = std::function<void(const std::vector<glm::vec3>&)>;
     using FloorCallback = std::function<void(const glm::vec3&, float, float)>;
-    using ObstaclesCallback = std::function<void(const std::vector<glm::vec3>&)>;
+    using ObstaclesCallback = std::function<void(const std::vector<DetectedObstacle>&)>;
+    using OdometryCallback = std::function<void(const RelativePoseMeasurement&)>;
     
     void setAnalysisCallback(AnalysisCallback callback);
     void setPointsCallback(PointsCallback callback);
     void setFloorCallback(FloorCallback callback);
     void setObstaclesCallback(ObstaclesCallback callback);
+    void setOdometryCallback(OdometryCallback callback);
 
 private:
+    // Карта, ожидающая обработки, со своим токеном отмены
+    struct PendingFrame {
+        SharedBuffer depth;
+        SharedBuffer confidence;
+        uint64_t sequenceNumber = 0;
+        TaskScheduler::CancellationToken token;
+    };
+
     // Внутренние методы обработки
-    void processLidarInternal(const std::vector<uint8_t> &depthData, const std::vector<uint8_t> &confidenceData);
+    void runFrames(PendingFrame frame);
+    void processLidarInternal(const SharedBuffer &depthData, const SharedBuffer &confidenceData,
+                              uint64_t sequenceNumber, const TaskScheduler::CancellationToken &token);
     SpatialAnalysisResult analyzeSpatialEnvironment(const std::vector<glm::vec3> &points);
-    SpatialAnalysisResult analyzeSpatialEnvironmentFast(const std::vector<glm::vec3> &points);
-
-    // Методы обнаружения
-    struct PlaneResult {
-        glm::vec3 normal;
-        glm::vec3 center;
-        float distance;
-        float confidence;
-        std::vector<glm::vec3> inliers;
-    };
+    // cloud - те же точки в SoA с весами уверенности (для поиска плоскостей)
+    SpatialAnalysisResult analyzeSpatialEnvironmentFast(const std::vector<glm::vec3> &points,
+                                                        const PointCloudSoA &cloud,
+                                                        const std::atomic<bool> *cancel = nullptr);
+    DepthUnprojector::Options fastUnprojectOptions() const;
+    // Строит пирамиду и распаковывает уровень под бюджет; возвращает номер уровня
+    size_t unprojectWithBudget(DepthPyramid &pyramid, const float *depth, size_t depthCount,
+                               const uint8_t *confidence, size_t confidenceCount,
+                               const DepthUnprojector::Options &options, size_t pointBudget,
+                               PointCloudSoA &points) const;
 
-    PlaneResult detectFloorPlane(const std::vector<glm::vec3> &points);
-    std::vector<PlaneResult> detectWallPlanes(const std::vector<glm::vec3> &points);
-    std::vector<glm::vec3> detectObstacles(const std::vector<glm::vec3> &points, const glm::vec3 &cameraPosition);
-    PlaneResult ransacPlaneDetection(const std::vector<glm::vec3> &points, int maxIterations);
+    // Методы обнаружения: плоскости извлекаются по очереди (лучшая из
+    // горизонтальной и вертикальной гипотез), inliers убираются из облака
+    std::vector<DetectedPlane> detectPlanes(const PointCloudSoA &cloud, const glm::vec3 &up,
+                                            const std::atomic<bool> *cancel);
+    DetectedPlane makeDetectedPlane(const PointCloudSoA &cloud, const PlaneRansac::Result &fit,
+                                    DetectedPlane::Orientation orientation, const glm::vec3 &up, float totalWeight) const;
+    std::vector<DetectedObstacle> detectObstacles(const PointCloudSoA &cloud, const glm::vec3 &up,
+                                                  const DetectedPlane *floor, const std::vector<DetectedPlane> &walls);
 
     // Утилиты
     std::vector<glm::vec3> filterValidPoints(const std::vector<glm::vec3> &points);
     std::vector<glm::vec3> removeOutliers(const std::vector<glm::vec3> &points);
-    glm::vec3 depthToWorldSpace(int x, int y, float depth);
+    VoxelGridFilter::Statistics filterCloud(const PointCloudSoA &input, const std::vector<glm::vec3> &normals,
+                                            PointCloudSoA &output, std::vector<glm::vec3> &outputNormals);
     float pointToPlaneDistance(const glm::vec3 &point, const glm::vec3 &planeNormal, const glm::vec3 &planePoint);
 
-    // Данные
-    mutable std::mutex m_dataLock;
-    std::vector<glm::vec3> m_lastProcessedPoints;
-    SpatialAnalysisResult m_lastAnalysis;
+    // Распаковка глубины (SoA буфер и пирамида переиспользуются задачами обработки по очереди)
+    DepthUnprojector m_unprojector;
+    DepthPyramid m_pyramid;
+    PointCloudSoA m_unprojectedPoints;
+
+    // Поиск плоскостей (используется только задачей обработки)
+    PlaneRansac m_planeRansac;
+    PointCloudSoA m_planeCloud;     // Точки, еще не отнесенные к плоскостям
+    std::vector<glm::vec3> m_rawNormals;    // Нормали сетки до фильтра
+    IntegralNormalEstimator m_normalEstimator;
+    SeqLock<glm::vec3> m_gravity;
+
+    // Временной фильтр глубины (используется только задачей обработки)
+    DepthTemporalFilter m_temporalFilter;
+    SeqLock<DepthTemporalFilter::Options> m_temporalOptions;
+    SeqLock<CameraPose> m_cameraPose;
+
+    // Одометрия по глубине (используется только задачей обработки)
+    DepthOdometry m_odometry;
+    SeqLock<DepthOdometry::Options> m_odometryOptions;
+
+    // Фильтр точек кадра (используется только задачей обработки)
+    VoxelGridFilter m_voxelFilter;
+    PointCloudSoA m_filteredPoints;
+    SeqLock<VoxelGridFilter::Options> m_filterOptions;
+    SeqLock<VoxelGridFilter::Statistics> m_filterStatistics;
+
+    // Препятствия с треками (используется только задачей обработки)
+    ObstacleClusterer m_obstacleClusterer;
+    SeqLock<ObstacleClusterer::Options> m_obstacleOptions;
+
+    // Результаты кадров (пишет только задача обработки)
+    SnapshotPool<FrameResult> m_frames;
 
     // Параметры обработки
     float m_minDepth = 0.1f;
     float m_maxDepth = 10.0f;
     float m_floorDetectionThreshold = 0.1f;
     float m_planeDistanceThreshold = 0.05f;
+    int m_maxPlanes = 6;
+    size_t m_minPlaneInliers = 60;
+    float m_minPlaneInlierRatio = 0.03f;    // Доля точек кадра
     float m_horizontalFov = 60.0f;
     float m_verticalFov = 45.0f;
 
-    // Асинхронная обработка
-    std::atomic<bool> m_cancelProcessing;
+    // Асинхронная обработка: одна задача обрабатывает кадры по очереди
+    std::atomic<uint8_t> m_minConfidence;
+    std::atomic<size_t> m_pointBudget;
+    TaskScheduler* m_scheduler;
+    std::mutex m_jobMutex;
+    TaskScheduler::TaskHandle m_processingTask;         // Под m_jobMutex
+    TaskScheduler::CancellationToken m_activeToken;     // Токен кадра в обработке
+    PendingFrame m_pendingFrame;
+    bool m_hasPendingFrame;
+    bool m_jobRunning;
+    // Кадры, прерванные подряд. После kMaxCancelledInRow идущий кадр доводится
+    // до конца: иначе при анализе дольше периода LiDAR результатов не будет вовсе
+    static constexpr uint32_t kMaxCancelledInRow = 2;
+    uint32_t m_cancelledInRow;
     
     // Колбэки
     AnalysisCallback m_analysisCallback;
     PointsCallback m_pointsCallback;
     FloorCallback m_floorCallback;
     ObstaclesCallback m_obstaclesCallback;
+    OdometryCallback m_odometryCallback;
 };
 
 } // namespace LensEngine
@@ -0,0 +1,161 @@
+#ifndef MESHRAYCASTER_H
+#define MESHRAYCASTER_H
+
+#include "LensEngineTypes.h"
+#include "TaskScheduler.h"
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+namespace LensEngine {
+
+/**
+ * @brief BVH по треугольникам одного куска меша (нижний уровень)
+ *
+ * Разбиение по медиане центров вдоль наибольшей оси, в листе до 4
+ * треугольников. Треугольники листа хранятся пачкой SoA (вершина и два
+ * ребра по 4 дорожки), луч проверяется сразу против всей пачки
+ * Möller-Trumbore на SSE2/NEON. Перестраивается целиком: кусок меша
+ * меняется только вместе со всеми вершинами.
+ */
+class TriangleBvh {
+public:
+    struct Hit {
+        float distance = 0.0f;
+        uint32_t triangle = 0;          // Номер треугольника в indices / 3
+    };
+
+    void build(const std::vector<glm::vec3> &vertices, const std::vector<uint32_t> &indices);
+    void clear();
+
+    bool empty() const { return m_nodes.empty(); }
+    size_t triangleCount() const { return m_normals.size(); }
+    const glm::vec3 &boundsMin() const { return m_boundsMin; }
+    const glm::vec3 &boundsMax() const { return m_boundsMax; }
+    // Единичная нормаль треугольника (против часовой стрелки - наружу)
+    const glm::vec3 &normal(uint32_t triangle) const { return m_normals[triangle]; }
+
+    // Ближайшее пересечение на (0, maxDistance); maxDistance сокращается до найденного.
+    // direction единичный, inverseDirection - 1 / direction по осям
+    bool intersect(const glm::vec3 &origin, const glm::vec3 &direction, const glm::vec3 &inverseDirection,
+                   float &maxDistance, Hit &hit) const;
+    // Любое пересечение на (0, maxDistance)
+    bool occluded(const glm::vec3 &origin, const glm::vec3 &direction, const glm::vec3 &inverseDirection,
+                  float maxDistance) const;
+
+private:
+    struct Node {
+        glm::vec3 min;
+        uint32_t offset;                // Лист - пачка треугольников, иначе правый потомок (левый - следующий узел)
+        glm::vec3 max;
+        uint32_t count;                 // Треугольников в листе, 0 - внутренний узел
+    };
+
+    struct TrianglePack {
+        float v0[3][4];
+        float edge1[3][4];
+        float edge2[3][4];
+        uint32_t triangle[4];
+    };
+
+    uint32_t buildNode(uint32_t begin, uint32_t end, const std::vector<glm::vec3> &vertices,
+                       const std::vector<uint32_t> &indices, std::vector<uint32_t> &order,
+                       const std::vector<glm::vec3> &centroids);
+
+    std::vector<Node> m_nodes;
+    std::vector<TrianglePack> m_packs;
+    std::vector<glm::vec3> m_normals;
+    glm::vec3 m_boundsMin = glm::vec3(0.0f);
+    glm::vec3 m_boundsMax = glm::vec3(0.0f);
+};
+
+/**
+ * @brief Запросы лучей к мешу окружения: BVH верхнего уровня по кускам
+ *
+ * Каждый кусок меша (блок TSDF) держит свой TriangleBvh, верхний уровень -
+ * BVH по их границам. Кусок перестраивается только при новой версии;
+ * commit() подгоняет границы верхнего уровня (refit), если набор кусков
+ * не менялся, и перестраивает его при добавлении или удалении кусков.
+ *
+ * Пакеты лучей делятся между потоками пула. Запросы константные и могут
+ * идти из нескольких потоков; изменения кусков видны запросам после
+ * commit() и не должны идти одновременно с ними. BVH кусков неизменяемы
+ * и разделяются копиями: копия после commit() - дешевый снимок для
+ * запросов, пока оригинал обновляется дальше.
+ */
+class MeshRaycaster {
+public:
+    struct Ray {
+        glm::vec3 origin = glm::vec3(0.0f);
+        glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);    // Нормируется при запросе
+        float maxDistance = std::numeric_limits<float>::max();  // м
+    };
+
+    struct Hit {
+        bool hit = false;
+        float distance = 0.0f;          // м вдоль луча
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec3 normal = glm::vec3(0.0f);     // Нормаль треугольника
+        uint64_t chunkKey = 0;          // Ключ куска меша (блока TSDF)
+        uint32_t triangle = 0;
+    };
+
+    MeshRaycaster();
+
+    // Пул задач для пакетов (без него используется TaskScheduler::shared())
+    void setTaskScheduler(TaskScheduler *scheduler) { m_scheduler = scheduler; }
+
+    // Кусок той же версии не перестраивается; пустой кусок удаляется.
+    // Возвращает true, если нижний уровень куска изменился
+    bool updateChunk(uint64_t key, uint64_t version, const std::vector<glm::vec3> &vertices,
+                     const std::vector<uint32_t> &indices);
+    void removeChunk(uint64_t key);
+    // Применяет изменения кусков к верхнему уровню
+    void commit();
+    void clear();
+
+    size_t chunkCount() const { return m_chunks.size(); }
+
+    bool raycast(const Ray &ray, Hit &hit) const;
+    void raycast(const Ray *rays, size_t count, Hit *hits) const;
+    // Есть ли геометрия на луче до maxDistance (без поиска ближайшей)
+    bool occluded(const Ray &ray) const;
+    void occluded(const Ray *rays, size_t count, uint8_t *results) const;
+    // Луч против одного куска
+    bool raycastChunk(uint64_t key, const Ray &ray, Hit &hit) const;
+
+private:
+    struct Chunk {
+        uint64_t key = 0;
+        uint64_t version = 0;
+        std::shared_ptr<const TriangleBvh> bvh;    // Общий с копиями raycaster
+    };
+
+    struct Node {
+        glm::vec3 min;
+        uint32_t offset;                // Лист - начало в m_order, иначе правый потомок
+        glm::vec3 max;
+        uint32_t count;                 // Кусков в листе, 0 - внутренний узел
+    };
+
+    uint32_t buildNode(uint32_t begin, uint32_t end);
+    void refit();
+    template<bool AnyHit>
+    bool traverse(const Ray &ray, Hit &hit) const;
+
+    TaskScheduler *m_scheduler;
+    std::vector<Chunk> m_chunks;
+    std::unordered_map<uint64_t, uint32_t> m_chunkIndex;    // Ключ -> индекс в m_chunks
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_order;      // Куски в порядке листьев
+    std::vector<glm::vec3> m_centers;   // Центры кусков при построении
+    bool m_structureChanged;
+    bool m_boundsChanged;
+};
+
+} // namespace LensEngine
+
+#endif // MESHRAYCASTER_H
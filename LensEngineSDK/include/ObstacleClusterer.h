@@ -0,0 +1,79 @@
+#ifndef OBSTACLECLUSTERER_H
+#define OBSTACLECLUSTERER_H
+
+#include "LensEngineTypes.h"
+#include "DepthUnprojector.h"
+#include "VoxelHashMap.h"
+#include <vector>
+#include <cstdint>
+
+namespace LensEngine {
+
+/**
+ * @brief Кластеризация препятствий по связности вокселей
+ *
+ * Точки пола (и ниже него) и стен отбрасываются, остальные раскладываются
+ * по вокселям размера cellSize. Компоненты связности по 26 соседям
+ * (объединение-поиск по вокселям, O(n)) с числом точек не меньше
+ * minPoints становятся препятствиями. Бокс ориентирован по гравитации,
+ * поворот вокруг вертикали - главная ось разброса точек в горизонтальной
+ * плоскости.
+ *
+ * Треки сопоставляются жадно по расстоянию между центрами масс (в системе
+ * координат точек); трек без пары живет maxMissedFrames кадров.
+ * Экземпляр не потокобезопасен.
+ */
+class ObstacleClusterer {
+public:
+    struct Options {
+        float cellSize = 0.1f;              // Размер вокселя связности (м)
+        uint32_t minPoints = 15;            // Мин. точек в кластере
+        uint32_t maxObstacles = 64;         // Самые крупные кластеры кадра
+        float minHeightAboveFloor = 0.05f;  // Точки ниже - пол
+        float planeMargin = 0.05f;          // Расстояние до стены, считающееся стеной (м)
+        float matchDistance = 0.5f;         // Макс. смещение центра трека за кадр (м)
+        uint32_t maxMissedFrames = 5;
+    };
+
+    ObstacleClusterer();
+    explicit ObstacleClusterer(const Options &options);
+
+    void setOptions(const Options &options);
+    const Options &options() const { return m_options; }
+
+    // up - единичный вектор против гравитации; floor/walls - плоскости этого кадра
+    std::vector<DetectedObstacle> cluster(const PointCloudSoA &points, const glm::vec3 &up,
+                                          const DetectedPlane *floor, const std::vector<DetectedPlane> &walls);
+
+    // Сброс треков (новая сессия, скачок позы)
+    void resetTracks();
+
+private:
+    struct Track {
+        uint32_t id;
+        glm::vec3 centroid;
+        uint32_t age;
+        uint32_t missed;
+    };
+
+    bool isBackground(const glm::vec3 &point, const glm::vec3 &up, const DetectedPlane *floor,
+                      const std::vector<DetectedPlane> &walls) const;
+    uint32_t findRoot(uint32_t voxel);
+    void unite(uint32_t a, uint32_t b);
+    DetectedObstacle makeObstacle(const std::vector<glm::vec3> &points, const glm::vec3 &up) const;
+    void associate(std::vector<DetectedObstacle> &obstacles);
+
+    Options m_options;
+    VoxelHashMap m_map;
+    std::vector<uint32_t> m_pointVoxel;     // Воксель каждой принятой точки
+    std::vector<glm::vec3> m_points;        // Принятые точки
+    std::vector<uint32_t> m_parent;         // Лес объединения-поиска по вокселям
+    std::vector<uint32_t> m_component;      // Корень вокселя -> номер компоненты
+    std::vector<std::vector<glm::vec3>> m_clusters;
+    std::vector<Track> m_tracks;
+    uint32_t m_nextTrackId;
+};
+
+} // namespace LensEngine
+
+#endif // OBSTACLECLUSTERER_H
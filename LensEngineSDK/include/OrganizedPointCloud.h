@@ -0,0 +1,82 @@
+#ifndef ORGANIZEDPOINTCLOUD_H
+#define ORGANIZEDPOINTCLOUD_H
+
+#include "LensEngineTypes.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace LensEngine {
+
+/**
+ * @brief Облако точек на сетке карты глубины
+ *
+ * Ячейка (u, v) соответствует пикселю (u * step, v * step) карты глубины,
+ * поэтому соседи точки - соседние ячейки, без KD-дерева. Недопустимые
+ * пиксели (вне диапазона глубины, низкая уверенность) помечены в valid.
+ * Допустимые ячейки в порядке строк совпадают по порядку с точками
+ * PointCloudSoA той же распаковки.
+ */
+struct OrganizedPointCloud {
+    uint32_t width = 0;             // Размер сетки (после прореживания)
+    uint32_t height = 0;
+    uint32_t step = 1;              // Шаг сетки в пикселях карты глубины
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> weight;      // Вес по уверенности LiDAR
+    std::vector<uint8_t> valid;     // 1 - в ячейке есть точка
+    size_t validCount = 0;
+
+    // Заполняются IntegralNormalEstimator; нулевая нормаль - не определена
+    std::vector<glm::vec3> normals;
+    std::vector<float> curvature;   // lambda_min / (l1 + l2 + l3): 0 - плоско, 1/3 - изотропно
+
+    void resize(uint32_t gridWidth, uint32_t gridHeight);
+
+    size_t index(uint32_t u, uint32_t v) const { return static_cast<size_t>(v) * width + u; }
+    bool isValid(size_t i) const { return valid[i] != 0; }
+    glm::vec3 point(size_t i) const { return glm::vec3(x[i], y[i], z[i]); }
+    bool hasNormals() const { return normals.size() == valid.size() && !valid.empty(); }
+
+    // Нормали допустимых ячеек в порядке строк (параллельно PointCloudSoA той же распаковки)
+    void gatherNormals(std::vector<glm::vec3> &output) const;
+};
+
+/**
+ * @brief Нормали организованного облака по интегральным изображениям
+ *
+ * Строятся интегральные изображения (double) числа точек, координат и их
+ * попарных произведений, поэтому ковариация окна любого размера считается
+ * за O(1). Нормаль - собственный вектор ковариации с наименьшим собственным
+ * числом (аналитическое решение 3x3), ориентированный к камере.
+ *
+ * Разрывы глубины тоже копятся в интегральном изображении: если окно
+ * пересекает разрыв, радиус уменьшается, пока окно не станет гладким,
+ * поэтому нормали на краях объектов не смешивают разные поверхности.
+ */
+class IntegralNormalEstimator {
+public:
+    struct Options {
+        uint32_t radius = 2;                // Полуразмер окна в ячейках сетки
+        float maxDepthChange = 0.05f;       // Разрыв: скачок глубины на пиксель карты больше доли глубины
+        float minValidFraction = 0.5f;      // Мин. доля допустимых ячеек окна
+    };
+
+    IntegralNormalEstimator();
+    explicit IntegralNormalEstimator(const Options &options);
+
+    void setOptions(const Options &options) { m_options = options; }
+    const Options &options() const { return m_options; }
+
+    // Заполняет cloud.normals и cloud.curvature; возвращает число найденных нормалей
+    size_t compute(OrganizedPointCloud &cloud);
+
+private:
+    Options m_options;
+    std::vector<double> m_integral;     // kChannels значений на узел (width + 1) x (height + 1)
+};
+
+} // namespace LensEngine
+
+#endif // ORGANIZEDPOINTCLOUD_H
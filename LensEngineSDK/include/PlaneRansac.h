@@ -0,0 +1,102 @@
+#ifndef PLANERANSAC_H
+#define PLANERANSAC_H
+
+#include "LensEngineTypes.h"
+#include "DepthUnprojector.h"
+#include "TaskScheduler.h"
+#include <vector>
+#include <atomic>
+#include <random>
+#include <cstdint>
+
+namespace LensEngine {
+
+/**
+ * @brief RANSAC поиск плоскости в облаке точек SoA
+ *
+ * Гипотезы (плоскость по 3 случайным точкам) оцениваются пачками: для
+ * каждой SIMD ядро считает число и суммарный вес точек ближе порога,
+ * без копирования самих точек. Число итераций подстраивается под
+ * найденную долю inliers (вероятность успеха successProbability).
+ * Лучшая модель уточняется МНК по inliers (нормаль - собственный вектор
+ * ковариации с наименьшим собственным числом).
+ *
+ * При известной гравитации модель ограничивается: горизонтальная
+ * плоскость (нормаль = вверх) или вертикальная (нормаль перпендикулярна
+ * вверх) строится по 2 точкам, поэтому нужно заметно меньше итераций.
+ *
+ * С пулом задач гипотезы пачки оцениваются параллельно; выборка точек
+ * идет в вызывающем потоке, поэтому результат не зависит от числа потоков.
+ * Экземпляр не потокобезопасен: один fit за раз.
+ */
+class PlaneRansac {
+public:
+    enum class Model : uint8_t {
+        Free,           // Любая ориентация, 3 точки
+        Horizontal,     // Нормаль вдоль up, 2 точки на одной высоте
+        Vertical        // Нормаль перпендикулярна up, 2 точки
+    };
+
+    struct Options {
+        float distanceThreshold = 0.05f;   // Макс. расстояние inlier до плоскости (м)
+        float successProbability = 0.99f;  // Для адаптивного числа итераций
+        uint32_t minIterations = 16;
+        uint32_t maxIterations = 256;
+        uint32_t batchSize = 16;           // Гипотез в пачке (единица параллельной оценки)
+        uint32_t refineIterations = 2;     // Проходов МНК уточнения (0 - без уточнения)
+        size_t parallelMinPoints = 8192;   // Меньше точек - оценка в вызывающем потоке
+    };
+
+    struct Result {
+        bool valid = false;
+        glm::vec3 normal = glm::vec3(0, 1, 0);
+        glm::vec3 centroid = glm::vec3(0.0f);  // Взвешенный центр inliers
+        float distance = 0.0f;                 // dot(normal, p) для точек плоскости
+        float score = 0.0f;                    // Взвешенная доля inliers [0, 1]
+        uint32_t iterations = 0;               // Оценено гипотез
+        std::vector<uint32_t> inliers;         // Индексы точек облака
+    };
+
+    PlaneRansac();
+    explicit PlaneRansac(const Options &options);
+
+    void setOptions(const Options &options);
+    const Options &options() const { return m_options; }
+
+    // nullptr - все гипотезы оцениваются в вызывающем потоке
+    void setTaskScheduler(TaskScheduler *scheduler);
+    void seed(uint32_t value);
+
+    // Веса берутся из points.weight (если его меньше count - все точки равны).
+    // cancel прерывает поиск между пачками, результат тогда невалиден
+    Result fit(const PointCloudSoA &points, const std::atomic<bool> *cancel = nullptr);
+    // up - единичный вектор против гравитации (в системе координат точек)
+    Result fit(const PointCloudSoA &points, Model model, const glm::vec3 &up,
+               const std::atomic<bool> *cancel = nullptr);
+
+private:
+    struct Hypothesis {
+        glm::vec3 normal;
+        float distance;
+        size_t count;
+        float weight;
+    };
+
+    bool sample(const PointCloudSoA &points, Model model, const glm::vec3 &up,
+                std::uniform_int_distribution<uint32_t> &pick, Hypothesis &hypothesis);
+    void evaluate(const PointCloudSoA &points, size_t count, bool weighted, std::vector<Hypothesis> &batch);
+    bool refine(const PointCloudSoA &points, size_t count, bool weighted, Model model, const glm::vec3 &up,
+                Hypothesis &hypothesis);
+    void collectInliers(const PointCloudSoA &points, size_t count, const glm::vec3 &normal, float distance,
+                        std::vector<uint32_t> &inliers) const;
+
+    Options m_options;
+    TaskScheduler *m_scheduler;
+    std::mt19937 m_random;
+    std::vector<Hypothesis> m_batch;
+    std::vector<uint32_t> m_inliers;
+};
+
+} // namespace LensEngine
+
+#endif // PLANERANSAC_H
@@ -0,0 +1,149 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace LensEngine {
+
+/**
+ * @brief Трассировка стадий движка
+ *
+ * Каждый поток пишет события в свой кольцевой буфер без блокировок,
+ * при выключенной трассировке маркер стоит одну relaxed-загрузку флага.
+ * События привязаны к номеру кадра: LENSENGINE_TRACE_FRAME задает кадр
+ * для всех вложенных маркеров этого потока. Накопленные события
+ * выгружаются в формате Chrome trace (chrome://tracing, ui.perfetto.dev)
+ * и сводятся в перцентили по стадиям за последнее окно событий.
+ *
+ * Сборка с LENSENGINE_DISABLE_TRACING убирает маркеры полностью.
+ */
+class Profiler {
+public:
+    struct Event {
+        const char* name = nullptr;   // Строковый литерал, хранится по указателю
+        uint64_t frame = 0;           // Номер кадра (0 - вне кадра)
+        uint64_t startNs = 0;
+        uint64_t durationNs = 0;
+        uint32_t threadId = 0;
+    };
+
+    struct StageSummary {
+        std::string name;
+        uint64_t count = 0;
+        double meanMs = 0.0;
+        double p50Ms = 0.0;
+        double p90Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+    };
+
+    // Число событий в буфере одного потока (старые перезаписываются)
+    static constexpr size_t kEventsPerThread = 16384;
+
+    static Profiler& instance();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    static uint64_t nowNs();
+
+    void record(const char* name, uint64_t frame, uint64_t startNs, uint64_t endNs);
+
+    // Кадр, к которому относятся маркеры текущего потока
+    static uint64_t currentFrame();
+    static void setCurrentFrame(uint64_t frame);
+
+    std::vector<Event> collectEvents() const;
+    std::string exportChromeTrace() const;
+    bool writeChromeTrace(const std::string& path) const;
+    std::vector<StageSummary> getStageSummaries() const;
+    void clear();
+
+    // Маркер области: длительность от конструктора до деструктора
+    class Scope {
+    public:
+        explicit Scope(const char* name)
+            : m_name(name)
+            , m_frame(0)
+            , m_startNs(0)
+            , m_active(instance().isEnabled())
+        {
+            if (m_active) {
+                m_frame = currentFrame();
+                m_startNs = nowNs();
+            }
+        }
+
+        ~Scope()
+        {
+            if (m_active) {
+                instance().record(m_name, m_frame, m_startNs, nowNs());
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* m_name;
+        uint64_t m_frame;
+        uint64_t m_startNs;
+        bool m_active;
+    };
+
+    // Маркер обработки кадра: вложенные маркеры потока получают его номер
+    class FrameScope {
+    public:
+        FrameScope(const char* name, uint64_t frame)
+            : m_previousFrame(currentFrame())
+            , m_scope((setCurrentFrame(frame), name))
+        {
+        }
+
+        // Номер кадра Scope запомнил при создании, поэтому восстанавливаем сразу
+        ~FrameScope()
+        {
+            setCurrentFrame(m_previousFrame);
+        }
+
+        FrameScope(const FrameScope&) = delete;
+        FrameScope& operator=(const FrameScope&) = delete;
+
+    private:
+        uint64_t m_previousFrame;
+        Scope m_scope;
+    };
+
+private:
+    struct ThreadBuffer;
+
+    Profiler();
+    ThreadBuffer& threadBuffer();
+
+    std::atomic<bool> m_enabled;
+    mutable std::mutex m_buffersMutex;   // Только регистрация буферов и чтение списка
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+    uint64_t m_originNs;
+};
+
+} // namespace LensEngine
+
+#define LENSENGINE_TRACE_CONCAT_INNER(a, b) a##b
+#define LENSENGINE_TRACE_CONCAT(a, b) LENSENGINE_TRACE_CONCAT_INNER(a, b)
+
+#ifndef LENSENGINE_DISABLE_TRACING
+#define LENSENGINE_TRACE_SCOPE(name) \
+    ::LensEngine::Profiler::Scope LENSENGINE_TRACE_CONCAT(lensTraceScope_, __LINE__)(name)
+#define LENSENGINE_TRACE_FRAME(name, frame) \
+    ::LensEngine::Profiler::FrameScope LENSENGINE_TRACE_CONCAT(lensTraceFrame_, __LINE__)(name, frame)
+#else
+#define LENSENGINE_TRACE_SCOPE(name) ((void)0)
+#define LENSENGINE_TRACE_FRAME(name, frame) ((void)(frame))
+#endif
+
+#endif // PROFILER_H
@@ -2,6 +2,7 @@
 #define SENSORFUSIONEKF_H
 
 #include "LensEngineTypes.h"
+#include "SnapshotStore.h"
 #include <vector>
 #include <mutex>
 #include <chrono>
@@ -28,10 +29,17 @@ public:
     // Обновление данных
     void updateIMU(const RawIMUData &imu);
     void updateFeaturePoints(const std::vector<FeaturePoint> &features);
+    // Устарело: эвристический сдвиг z к точкам LiDAR не является мерой позы и
+    // спорит с updateOdometry. Конвейеры движка его не вызывают.
+    [[deprecated("use updateOdometry with DepthOdometry measurements")]]
     void updateLidar(const std::vector<glm::vec3> &lidarPoints);
     void updateVisualOdometry(const glm::vec3 &visualPosition, const glm::quat &visualRotation);
+    // Относительная поза от DepthOdometry: поза якоря (состояние после прошлой меры),
+    // умноженная на меру, сливается с текущим состоянием с ковариацией меры.
+    // Недействительная мера только переставляет якорь
+    void updateOdometry(const RelativePoseMeasurement &measurement);
 
-    // Получение результата
+    // Получение результата (поза читается без блокировки фильтра)
     CameraPose getCurrentPose() const;
     float getStability() const;
     glm::vec3 getVelocity() const;
@@ -41,6 +49,10 @@ public:
                             double gyroBiasNoise = 0.001, double accelBiasNoise = 0.01,
                             double visualNoise = 0.05, double lidarNoise = 0.02);
 
+    // Шаг интегрирования по меткам времени IMU (мс) вместо часов процесса.
+    // Нужен при воспроизведении записи быстрее реального времени
+    void setUseSensorTimestamps(bool enabled);
+
     // Колбэки
     using PoseCallback = std::function<void(const CameraPose&)>;
     using StabilityCallback = std::function<void(float)>;
@@ -62,6 +74,8 @@ private:
     void updateIMUStep(const RawIMUData &imu, double dt);
     void updateVisualStep(const glm::vec3 &visualPosition, const glm::quat &visualRotation);
     void updateLidarStep(const std::vector<glm::vec3> &lidarPoints);
+    void updateOdometryStep(const RelativePoseMeasurement &measurement);
+    void setOdometryAnchor();
     void predictSimple(double dt, const RawIMUData &imu);
 
     // Математические функции
@@ -92,7 +106,9 @@ private:
     // Время и история
     std::chrono::steady_clock::time_point m_startTime;
     uint64_t m_lastUpdateTime;
+    bool m_useSensorTimestamps;
     CameraPose m_currentPose;
+    SeqLock<CameraPose> m_publishedPose;    // Последняя поза для читателей
 
     // Стабилизация
     std::vector<CameraPose> m_poseHistory;
@@ -103,6 +119,11 @@ private:
 
     // Флаги
     bool m_initialized;
+
+    // Поза кадра, от которого отсчитана следующая мера одометрии
+    bool m_hasOdometryAnchor;
+    glm::vec3 m_anchorPosition;
+    glm::quat m_anchorRotation;
     
     // Колбэки
     PoseCallback m_poseCallback;
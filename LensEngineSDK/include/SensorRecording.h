@@ -0,0 +1,100 @@
+#ifndef SENSORRECORDING_H
+#define SENSORRECORDING_H
+
+#include "LensEngineTypes.h"
+#include "SharedBuffer.h"
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <cstdint>
+
+namespace LensEngine {
+
+/**
+ * @brief Формат записи сырых данных сенсоров
+ *
+ * Файл: заголовок "LENSREC1" + uint32 версия, затем записи в порядке
+ * поступления данных в движок. Запись: uint8 тип, uint64 метка времени
+ * (мс), uint32 размер полезной нагрузки, нагрузка. Числа в порядке
+ * байтов платформы записи (little-endian на всех целевых устройствах).
+ *
+ *   RGB        - uint32 width, height, stride, пиксели RGB888
+ *   Depth      - uint32 размер глубины, глубина float32, затем confidence
+ *   Confidence - карта уверенности uint8
+ *   IMU        - 12 double: accel, gyro, gravity, mag
+ */
+class SensorRecording {
+public:
+    enum class RecordType : uint8_t {
+        RGB = 1,
+        Depth = 2,
+        Confidence = 3,
+        IMU = 4
+    };
+
+    struct Record {
+        RecordType type = RecordType::RGB;
+        uint64_t timestamp = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t stride = 0;
+        SharedBuffer data;          // RGB пиксели, глубина или уверенность
+        SharedBuffer confidence;    // Уверенность, записанная вместе с глубиной
+        RawIMUData imu;
+    };
+
+    static constexpr uint32_t kVersion = 1;
+};
+
+/**
+ * @brief Запись потоков сенсоров в файл (потокобезопасна)
+ */
+class SensorRecordWriter {
+public:
+    SensorRecordWriter() = default;
+    ~SensorRecordWriter();
+
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const;
+
+    void writeRGB(const SharedBuffer &image, uint32_t width, uint32_t height, uint32_t stride, uint64_t timestamp);
+    void writeDepth(const SharedBuffer &depth, const SharedBuffer &confidence, uint64_t timestamp);
+    void writeConfidence(const SharedBuffer &confidence, uint64_t timestamp);
+    void writeIMU(const RawIMUData &imu);
+
+    uint64_t recordCount() const;
+
+private:
+    void writeHeader(SensorRecording::RecordType type, uint64_t timestamp, uint32_t payloadSize);
+    void writeBytes(const void *data, size_t size);
+
+    mutable std::mutex m_mutex;
+    std::ofstream m_file;
+    uint64_t m_recordCount = 0;
+};
+
+/**
+ * @brief Последовательное чтение записи сенсоров
+ */
+class SensorRecordReader {
+public:
+    bool open(const std::string &path);
+    void close();
+
+    // false - конец файла или ошибка (см. errorString)
+    bool next(SensorRecording::Record &record);
+
+    const std::string &errorString() const { return m_error; }
+
+private:
+    bool readBytes(void *data, size_t size);
+    bool fail(const std::string &error);
+
+    std::ifstream m_file;
+    std::string m_error;
+};
+
+} // namespace LensEngine
+
+#endif // SENSORRECORDING_H
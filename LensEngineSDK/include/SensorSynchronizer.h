@@ -0,0 +1,147 @@
+#ifndef SENSORSYNCHRONIZER_H
+#define SENSORSYNCHRONIZER_H
+
+#include "LensEngineTypes.h"
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+namespace LensEngine {
+
+/**
+ * @brief Синхронизатор потоков сенсоров по времени захвата
+ *
+ * Буферизует RGB, карты глубины, карты уверенности и IMU по временным
+ * меткам и выдает ровно один ARFrame на каждый RGB кадр: с ближайшими
+ * картами глубины/уверенности и всеми IMU сэмплами с предыдущего кадра.
+ *
+ * Все временные метки и интервалы задаются в одних единицах
+ * (значения по умолчанию рассчитаны на миллисекунды).
+ */
+class SensorSynchronizer {
+public:
+    // Что делать, если для RGB кадра не нашлось парных данных
+    enum class MissingDataPolicy {
+        EmitWithout,   // Выдать кадр без этих данных
+        ReuseLast,     // Подставить последние сопоставленные данные
+        DropFrame      // Отбросить RGB кадр целиком
+    };
+
+    // Что делать с данными, пришедшими после выдачи своего кадра
+    enum class LateDataPolicy {
+        Discard,       // Отбросить
+        UseAsFallback  // Использовать в следующем кадре, если ему не хватит своих данных
+    };
+
+    struct Config {
+        uint64_t matchTolerance = 20;       // Максимальное расхождение RGB и глубины
+        uint64_t maxWait = 50;              // Сколько RGB кадр ждет парные данные
+        uint64_t streamTimeout = 500;       // Поток без данных дольше этого считается отключенным
+        size_t maxBufferedFrames = 8;       // Емкость буфера каждого потока
+        size_t maxBufferedImuSamples = 512;
+        MissingDataPolicy missingDepthPolicy = MissingDataPolicy::EmitWithout;
+        MissingDataPolicy missingConfidencePolicy = MissingDataPolicy::EmitWithout;
+        LateDataPolicy lateDataPolicy = LateDataPolicy::Discard;
+    };
+
+    struct Statistics {
+        uint64_t framesEmitted = 0;
+        uint64_t framesWithDepth = 0;
+        uint64_t framesWithConfidence = 0;
+        uint64_t framesDropped = 0;
+        uint64_t lateSamples = 0;
+        uint64_t overflowedSamples = 0;
+    };
+
+    using FrameCallback = std::function<void(const ARFrame&)>;
+    // RGB кадр отброшен политикой DropFrame (номер и время кадра)
+    using DropCallback = std::function<void(uint64_t sequenceNumber, uint64_t timestamp)>;
+
+    SensorSynchronizer();
+    explicit SensorSynchronizer(const Config &config);
+    ~SensorSynchronizer();
+
+    // Входные потоки
+    void pushRGB(const ARFrame &frame);
+    void pushDepth(const LidarData &lidar);
+    void pushConfidence(const SharedBuffer &confidenceMap, uint64_t sequenceNumber, uint64_t timestamp);
+    void pushIMU(const RawIMUData &imu);
+
+    // Выдать все ожидающие кадры с тем, что уже есть в буферах
+    void flush();
+    void reset();
+
+    void setConfig(const Config &config);
+    Config getConfig() const;
+    Statistics getStatistics() const;
+
+    void setFrameCallback(FrameCallback callback);
+    void setDropCallback(DropCallback callback);
+
+private:
+    struct DroppedFrame {
+        uint64_t sequenceNumber;
+        uint64_t timestamp;
+    };
+
+    struct MapSample {
+        SharedBuffer data;
+        uint64_t sequenceNumber = 0;
+        uint64_t timestamp = 0;
+    };
+
+    // Внутренние методы (вызываются под m_mutex)
+    void collectReadyFrames(std::vector<ARFrame> &ready, bool force);
+    bool isResolvable(const ARFrame &frame, bool force) const;
+    bool isStreamActive(uint64_t lastTimestamp, bool seen, uint64_t frameTimestamp) const;
+    bool resolveFrame(ARFrame &frame);
+    bool attachMap(const std::deque<MapSample> &buffer, uint64_t timestamp,
+                   MissingDataPolicy policy, MapSample &lastMatched, MapSample &lateFallback,
+                   bool &hasLateFallback, SharedBuffer &target, uint64_t &targetSequence);
+    void attachIMU(ARFrame &frame);
+    void insertSorted(std::deque<MapSample> &buffer, MapSample &&sample);
+    void pruneBuffers();
+    void updateClock(uint64_t timestamp);
+    bool isLate(uint64_t timestamp) const;
+
+    static std::deque<MapSample>::const_iterator findNearest(const std::deque<MapSample> &buffer, uint64_t timestamp);
+    static uint64_t timeDistance(uint64_t a, uint64_t b);
+
+    Config m_config;
+    Statistics m_stats;
+    mutable std::mutex m_mutex;
+
+    // Буферы потоков (отсортированы по времени)
+    std::deque<ARFrame> m_pendingFrames;
+    std::vector<DroppedFrame> m_droppedFrames;   // Отброшенные, ожидают колбэка вне блокировки
+    std::deque<MapSample> m_depthBuffer;
+    std::deque<MapSample> m_confidenceBuffer;
+    std::deque<RawIMUData> m_imuBuffer;
+
+    // Данные для политик
+    MapSample m_lastDepth;
+    MapSample m_lastConfidence;
+    MapSample m_lateDepth;
+    MapSample m_lateConfidence;
+    bool m_hasLateDepth;
+    bool m_hasLateConfidence;
+    std::vector<RawIMUData> m_lateImu;
+
+    // Состояние потоков
+    uint64_t m_latestTimestamp;
+    uint64_t m_lastEmittedTimestamp;
+    uint64_t m_lastDepthTimestamp;
+    uint64_t m_lastConfidenceTimestamp;
+    bool m_hasEmitted;
+    bool m_depthSeen;
+    bool m_confidenceSeen;
+
+    FrameCallback m_frameCallback;
+    DropCallback m_dropCallback;
+};
+
+} // namespace LensEngine
+
+#endif // SENSORSYNCHRONIZER_H
@@ -0,0 +1,72 @@
+#ifndef SHAREDBUFFER_H
+#define SHAREDBUFFER_H
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+namespace LensEngine {
+
+/**
+ * @brief Неизменяемый буфер данных с подсчетом ссылок
+ *
+ * Копирование буфера не копирует данные: все копии и срезы (slice)
+ * ссылаются на одно хранилище, которое освобождается вместе с последней
+ * ссылкой. Хранилище может принадлежать буферу (copy/adopt) или
+ * вызывающему коду (wrap) - тогда по освобождении вызывается release.
+ *
+ * Данные не изменяются после создания, поэтому буфер можно свободно
+ * передавать между потоками без синхронизации.
+ */
+class SharedBuffer {
+public:
+    using ReleaseCallback = std::function<void()>;
+
+    SharedBuffer();
+
+    // Копия данных (единственная копия на пути кадра, когда владелец не может отдать память)
+    static SharedBuffer copy(const void* data, size_t size);
+
+    // Забрать вектор без копирования
+    static SharedBuffer adopt(std::vector<uint8_t>&& data);
+
+    // Чужая память: data должна жить до вызова release
+    static SharedBuffer wrap(const void* data, size_t size, ReleaseCallback release);
+
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    const uint8_t* begin() const { return m_data; }
+    const uint8_t* end() const { return m_data + m_size; }
+    uint8_t operator[](size_t index) const { return m_data[index]; }
+
+    // Типизированный доступ (данные должны быть выровнены под T)
+    template<typename T>
+    const T* as() const { return reinterpret_cast<const T*>(m_data); }
+
+    template<typename T>
+    size_t count() const { return m_size / sizeof(T); }
+
+    // Вид на часть буфера, разделяющий то же хранилище
+    SharedBuffer slice(size_t offset, size_t length) const;
+
+    // Явная копия в вектор (для кода, которому нужны изменяемые данные)
+    std::vector<uint8_t> toVector() const;
+
+    // Число ссылок на хранилище (0 для пустого буфера)
+    long useCount() const { return m_owner.use_count(); }
+
+private:
+    SharedBuffer(std::shared_ptr<const void> owner, const uint8_t* data, size_t size);
+
+    std::shared_ptr<const void> m_owner;
+    const uint8_t* m_data;
+    size_t m_size;
+};
+
+} // namespace LensEngine
+
+#endif // SHAREDBUFFER_H
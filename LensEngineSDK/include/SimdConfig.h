@@ -0,0 +1,20 @@
+#ifndef SIMDCONFIG_H
+#define SIMDCONFIG_H
+
+/**
+ * @brief Выбор набора SIMD инструкций для ядер движка
+ *
+ * Определяет LENSENGINE_SIMD_SSE2 (x86/x64 с SSE2) или LENSENGINE_SIMD_NEON
+ * (ARM) и подключает соответствующие intrinsics. Без них ядра используют
+ * скалярный путь.
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LENSENGINE_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LENSENGINE_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#endif // SIMDCONFIG_H
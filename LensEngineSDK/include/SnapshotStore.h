@@ -0,0 +1,229 @@
+#ifndef SNAPSHOTSTORE_H
+#define SNAPSHOTSTORE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace LensEngine {
+
+/**
+ * @brief Версионированное хранилище неизменяемых снимков (RCU)
+ *
+ * Писатель публикует новый снимок целиком, читатель атомарно получает
+ * shared_ptr на текущий. Читатель не ждет писателя и может держать снимок
+ * сколько угодно - писатель в это время публикует следующие версии.
+ * Подходит для векторов результатов (feature points, LiDAR точки).
+ */
+template<typename T>
+class SnapshotStore {
+public:
+    using Snapshot = std::shared_ptr<const T>;
+
+    SnapshotStore()
+        : m_snapshot(std::make_shared<const T>())
+        , m_version(0)
+    {
+    }
+
+    // Текущий снимок (без копирования данных)
+    Snapshot load() const
+    {
+        return std::atomic_load_explicit(&m_snapshot, std::memory_order_acquire);
+    }
+
+    // Копия текущего значения
+    T get() const
+    {
+        return *load();
+    }
+
+    void store(T value)
+    {
+        Snapshot snapshot = std::make_shared<const T>(std::move(value));
+        std::atomic_store_explicit(&m_snapshot, std::move(snapshot), std::memory_order_release);
+        m_version.fetch_add(1, std::memory_order_release);
+    }
+
+    // Номер версии растет с каждой публикацией
+    uint64_t version() const
+    {
+        return m_version.load(std::memory_order_acquire);
+    }
+
+private:
+    Snapshot m_snapshot;
+    std::atomic<uint64_t> m_version;
+};
+
+/**
+ * @brief Снимки с переиспользованием буферов (двойная/тройная буферизация)
+ *
+ * Как SnapshotStore, но писатель не создает объект на каждую публикацию:
+ * acquire() отдает буфер из пула, который не опубликован и не удерживается
+ * читателями (вектора внутри сохраняют емкость), писатель заполняет его и
+ * публикует. Если все буферы заняты читателями, выделяется новый, пул
+ * растет до capacity. Писатель должен быть один.
+ */
+template<typename T>
+class SnapshotPool {
+public:
+    using Snapshot = std::shared_ptr<const T>;
+
+    explicit SnapshotPool(size_t capacity = 3)
+        : m_capacity(capacity < 2 ? 2 : capacity)
+        , m_snapshot(std::make_shared<const T>())
+        , m_version(0)
+    {
+    }
+
+    // Буфер для записи; содержит данные одной из прошлых публикаций
+    std::shared_ptr<T> acquire()
+    {
+        for (const std::shared_ptr<T> &buffer : m_buffers) {
+            // Единственный владелец - пул: опубликованный буфер держит еще и m_snapshot
+            if (buffer.use_count() == 1) {
+                // Чтения последнего читателя видны до записи в буфер
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return buffer;
+            }
+        }
+        std::shared_ptr<T> buffer = std::make_shared<T>();
+        if (m_buffers.size() < m_capacity) {
+            m_buffers.push_back(buffer);
+        }
+        return buffer;
+    }
+
+    void publish(std::shared_ptr<T> buffer)
+    {
+        Snapshot snapshot = std::move(buffer);
+        std::atomic_store_explicit(&m_snapshot, std::move(snapshot), std::memory_order_release);
+        m_version.fetch_add(1, std::memory_order_release);
+    }
+
+    // Текущий снимок (без копирования данных)
+    Snapshot load() const
+    {
+        return std::atomic_load_explicit(&m_snapshot, std::memory_order_acquire);
+    }
+
+    uint64_t version() const
+    {
+        return m_version.load(std::memory_order_acquire);
+    }
+
+private:
+    const size_t m_capacity;
+    std::vector<std::shared_ptr<T>> m_buffers;  // Только поток писателя
+    Snapshot m_snapshot;
+    std::atomic<uint64_t> m_version;
+};
+
+/**
+ * @brief SeqLock для небольших POD структур (CameraPose, CameraIntrinsics)
+ *
+ * Читатель копирует значение без блокировок и повторяет чтение, если во
+ * время копирования шла запись. Писатели сериализуются между собой
+ * мьютексом, читателей он не касается. Значение хранится атомарными
+ * словами, поэтому одновременные чтение и запись не являются гонкой данных.
+ */
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+public:
+    SeqLock()
+        : m_sequence(0)
+    {
+        storeWords(T());
+    }
+
+    explicit SeqLock(const T &value)
+        : m_sequence(0)
+    {
+        storeWords(value);
+    }
+
+    T load() const
+    {
+        T value;
+        uint64_t before;
+        uint64_t after;
+        do {
+            before = m_sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue; // Идет запись
+            }
+            loadWords(value);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return value;
+    }
+
+    void store(const T &value)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        write(value);
+    }
+
+    // Чтение-изменение-запись (писатели сериализованы, читатели не блокируются)
+    template<typename Function>
+    void update(Function &&function)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        T value;
+        loadWords(value);
+        function(value);
+        write(value);
+    }
+
+    // Номер версии растет с каждой записью
+    uint64_t version() const
+    {
+        return m_sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr size_t kWordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    void write(const T &value)
+    {
+        const uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        storeWords(value);
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void storeWords(const T &value)
+    {
+        uint64_t words[kWordCount] = {};
+        std::memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < kWordCount; ++i) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    void loadWords(T &value) const
+    {
+        uint64_t words[kWordCount];
+        for (size_t i = 0; i < kWordCount; ++i) {
+            words[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+        std::memcpy(&value, words, sizeof(T));
+    }
+
+    std::atomic<uint64_t> m_sequence;
+    std::atomic<uint64_t> m_words[kWordCount];
+    std::mutex m_writeMutex;
+};
+
+} // namespace LensEngine
+
+#endif // SNAPSHOTSTORE_H
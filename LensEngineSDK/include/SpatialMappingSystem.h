@@ -3,11 +3,18 @@
 
 #include "LensEngineTypes.h"
 #include "Lidar3DProcessor.h"
+#include "WorldVoxelMap.h"
+#include "TsdfVolume.h"
+#include "MeshRaycaster.h"
+#include "SnapshotStore.h"
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <mutex>
 #include <memory>
+#include <deque>
+#include <atomic>
 
 namespace LensEngine {
 
@@ -15,6 +22,17 @@ namespace LensEngine {
  * @brief Система пространственного маппирования
  * 
  * Создает 3D карту окружения и управляет виртуальными объектами.
+ * Точки LiDAR копятся в мировой карте вокселей (WorldVoxelMap), а не
+ * списком всех кадров: память ограничена снятым объемом.
+ * Меш окружения - из объема TSDF по картам глубины с позой кадра, кусками
+ * по блокам объема; перестраиваются только изменившиеся блоки. Лучи
+ * (видимость, окклюзия объектов, hit-test) идут через BVH по кускам.
+ *
+ * Интеграция TSDF и marching cubes идут вне блокировки данных: кадры
+ * встают в короткую очередь, ее разбирает поток, заставший ее свободной.
+ * Блокировка берется только на подмену готовых кусков меша. Лучи идут
+ * по опубликованному снимку BVH, тоже без блокировки: пакеты делятся
+ * между потоками пула, а ожидающий поток может выполнять чужие задачи.
  */
 class SpatialMappingSystem {
 public:
@@ -26,6 +44,8 @@ public:
         glm::vec3 boundsMax;
         float confidence;
         uint64_t timestamp;
+        uint64_t blockKey;           // Блок объема TSDF, к которому относится кусок
+        uint64_t version;            // Растет при каждом перестроении (пустой кусок - меш блока удален)
     };
 
     struct VirtualObject {
@@ -43,8 +63,12 @@ public:
     ~SpatialMappingSystem();
 
     void initialize();
+    // Точки, нормали и веса кадра LiDAR (в системе камеры глубины) с позой этого кадра
+    // (нулевой timestamp - поза неизвестна, карта не пополняется).
+    // Карта глубины кадра дополняет объем TSDF для меша; поза кадра становится позой
+    // камеры для окклюзии, окклюзия объектов пересчитывается
     void updateFromLiDAR(const Lidar3DProcessor::SpatialAnalysisResult &analysis,
-                         const std::vector<glm::vec3> &points);
+                         const LidarData &lidar, const CameraPose &pose);
     void updateCameraPose(const glm::vec3 &position, const glm::quat &rotation);
 
     // Управление виртуальными объектами
@@ -53,36 +77,95 @@ public:
     void removeVirtualObject(const std::string &id);
     void updateVirtualObjectPosition(const std::string &id, const glm::vec3 &position);
 
-    // Окклюзия и видимость
+    // Окклюзия и видимость (лучи от камеры к точке через меш окружения).
+    // Объект сэмплируется центром и углами бокса, occlusionFactor - доля закрытых лучей
     void calculateOcclusion();
     bool isPointVisible(const glm::vec3 &point) const;
     bool isObjectVisible(const VirtualObject &object) const;
 
     // Получение данных
     std::vector<SpatialMesh> getSpatialMeshes() const;
+    // Куски с версией новее sinceVersion, включая пустые (меш блока удален).
+    // Потребитель хранит getMeshVersion() и перезагружает только их
+    std::vector<SpatialMesh> getSpatialMeshUpdates(uint64_t sinceVersion) const;
+    uint64_t getMeshVersion() const;
+
+    // Hit-test по мешу окружения (мировая система). Пакет делится между потоками пула
+    bool raycast(const MeshRaycaster::Ray &ray, MeshRaycaster::Hit &hit) const;
+    void raycast(const std::vector<MeshRaycaster::Ray> &rays, std::vector<MeshRaycaster::Hit> &hits) const;
     std::vector<VirtualObject> getVirtualObjects() const;
     std::vector<glm::vec3> getFloorPoints() const;
     std::vector<glm::vec3> getWallPoints() const;
+    // Границы подтвержденных вокселей карты; false - карта пуста
+    bool getRoomBounds(glm::vec3 &boundsMin, glm::vec3 &boundsMax) const;
+    size_t getMapVoxelCount() const;
 
     // Настройки
     void setOcclusionEnabled(bool enabled);
     void setMeshGenerationEnabled(bool enabled);
+    // Размер вокселя карты и окно усреднения (смена размера очищает карту)
+    void setMapOptions(const WorldVoxelMap::Options &options);
+    // Объем TSDF для меша (смена размера вокселя или усечения очищает объем)
+    void setMeshOptions(const TsdfVolume::Options &options);
+    // Параметры карт глубины, которые приходят в updateFromLiDAR
+    void setDepthIntrinsics(const DepthIntrinsics &intrinsics);
+    // Пул задач для интеграции и меша (без него используется TaskScheduler::shared())
+    void setTaskScheduler(TaskScheduler *scheduler);
 
 private:
-    void generateSpatialMesh(const std::vector<glm::vec3> &points);
+    // Кадр глубины для объема TSDF
+    struct MeshFrame {
+        SharedBuffer depth;
+        SharedBuffer confidence;
+        DepthIntrinsics intrinsics;
+        CameraPose pose;
+        uint64_t timestamp = 0;
+    };
+    static constexpr size_t kMaxPendingMeshFrames = 4;
+
+    void submitMeshFrame(MeshFrame frame);
+    void startMeshJobs(uint64_t generation);
+    void runMeshJobs();
+    void generateSpatialMesh(uint64_t timestamp);
     void updateVirtualObjectMatrices();
     void detectRoomBounds();
-    void fuseSpatialData(const std::vector<glm::vec3> &newPoints);
+    void fuseSpatialData(const std::vector<glm::vec3> &newPoints, const std::vector<glm::vec3> &normals,
+                         const std::vector<float> &weights, const CameraPose &pose);
+    void updateAnalysis(const Lidar3DProcessor::SpatialAnalysisResult &analysis);
+    void updateOcclusion();
 
     // Математические методы
     bool rayIntersectsMesh(const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection,
                            const SpatialMesh &mesh) const;
     float calculateOcclusionForObject(const VirtualObject &object) const;
+    void appendOcclusionRays(const VirtualObject &object, std::vector<MeshRaycaster::Ray> &rays) const;
     glm::vec3 projectPointToFloor(const glm::vec3 &point) const;
 
     // Данные
-    std::vector<glm::vec3> m_spatialPoints;
-    std::vector<SpatialMesh> m_spatialMeshes;
+    WorldVoxelMap m_worldMap;
+    DepthIntrinsics m_depthIntrinsics;
+    std::vector<SpatialMesh> m_spatialMeshes;       // Куски по блокам, включая пустые
+    std::unordered_map<uint64_t, size_t> m_meshIndex; // Ключ блока -> индекс в m_spatialMeshes
+    uint64_t m_meshVersion;
+
+    // Только задача, разбирающая очередь кадров (m_meshBusy)
+    TsdfVolume m_tsdf;
+    std::vector<TsdfVolume::MeshBlock> m_meshUpdates;
+    MeshRaycaster m_raycaster;
+
+    // BVH меша после последнего обновления (запросы лучей без блокировки)
+    SnapshotStore<MeshRaycaster> m_raycasts;
+
+    // Очередь кадров для объема и смена его параметров
+    std::mutex m_meshMutex;
+    std::deque<MeshFrame> m_meshFrames;
+    TsdfVolume::Options m_pendingMeshOptions;
+    bool m_hasPendingMeshOptions;
+    bool m_meshBusy;
+    uint64_t m_meshJobGeneration;               // Номер запуска задачи разбора
+    TaskScheduler::TaskHandle m_meshTask;       // Задача последнего запуска
+    std::atomic<TaskScheduler*> m_scheduler;
+
     std::map<std::string, VirtualObject> m_virtualObjects;
 
     // Пространственная информация
@@ -95,10 +178,11 @@ private:
     // Текущая поза камеры
     glm::vec3 m_cameraPosition;
     glm::quat m_cameraRotation;
+    bool m_hasCameraPose;
 
-    // Настройки
-    bool m_occlusionEnabled;
-    bool m_meshGenerationEnabled;
+    // Настройки (сеттеры пишут без блокировки)
+    std::atomic<bool> m_occlusionEnabled;
+    std::atomic<bool> m_meshGenerationEnabled;
 
     // Потокобезопасность
     mutable std::mutex m_dataLock;
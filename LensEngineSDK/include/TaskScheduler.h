@@ -0,0 +1,154 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+
+namespace LensEngine {
+
+/**
+ * @brief Общий пул потоков движка с перехватом задач (work stealing)
+ *
+ * У каждого рабочего потока свои очереди по приоритетам: поток берет
+ * свои задачи с конца (LIFO, горячий кэш), а простаивающие потоки
+ * перехватывают чужие с начала. Задачи поддерживают продолжения (then),
+ * отмену через CancellationToken и ожидание завершения. parallelFor
+ * делит диапазон на части, вызывающий поток участвует в обработке.
+ */
+class TaskScheduler {
+public:
+    enum class Priority {
+        High = 0,    // Кадры и все, что задерживает отображение
+        Normal = 1,  // LiDAR анализ
+        Low = 2      // Фоновое картирование
+    };
+
+    struct Config {
+        size_t threadCount = 0;          // 0 - число ядер минус один (минимум 1)
+        std::vector<int> coreAffinity;   // Ядро для каждого потока по кругу (пусто - без привязки)
+    };
+
+    struct Statistics {
+        uint64_t tasksExecuted = 0;
+        uint64_t tasksStolen = 0;
+        uint64_t tasksCancelled = 0;
+    };
+
+    // Отмена группы задач: копии токена разделяют одно состояние
+    class CancellationToken {
+    public:
+        CancellationToken();
+        void cancel();
+        bool isCancelled() const;
+        // Флаг для циклов, принимающих const std::atomic<bool>* (PlaneRansac)
+        const std::atomic<bool> *flag() const { return m_cancelled.get(); }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> m_cancelled;
+    };
+
+private:
+    struct TaskState;
+
+public:
+    // Ссылка на поставленную задачу
+    class TaskHandle {
+    public:
+        TaskHandle() = default;
+
+        bool isValid() const { return m_state != nullptr; }
+        bool isDone() const;            // Выполнена или отменена
+        bool isCancelled() const;
+        // Ждет завершения; исключение задачи пробрасывается вызывающему
+        void wait() const;
+        // Ждет завершения без проброса исключения (деструкторы, смена пула)
+        void join() const;
+        void cancel();
+
+        // Продолжение запускается после завершения задачи (с тем же токеном отмены)
+        TaskHandle then(std::function<void()> continuation, Priority priority = Priority::Normal);
+
+    private:
+        friend class TaskScheduler;
+        TaskHandle(TaskScheduler *scheduler, std::shared_ptr<TaskState> state)
+            : m_scheduler(scheduler), m_state(std::move(state)) {}
+
+        TaskScheduler *m_scheduler = nullptr;
+        std::shared_ptr<TaskState> m_state;
+    };
+
+    TaskScheduler();
+    explicit TaskScheduler(const Config &config);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // После начала остановки пула задача выполняется сразу в вызывающем потоке
+    TaskHandle submit(std::function<void()> task, Priority priority = Priority::Normal,
+                      const CancellationToken &token = CancellationToken());
+
+    // Обработать [begin, end) частями не меньше grain; возвращается после всех частей.
+    // Первое исключение из body пробрасывается вызывающему (оставшиеся части пропускаются)
+    void parallelFor(size_t begin, size_t end, size_t grain,
+                     const std::function<void(size_t, size_t)> &body,
+                     Priority priority = Priority::High);
+
+    // Дождаться выполнения всех поставленных задач
+    void waitIdle();
+
+    size_t threadCount() const { return m_workers.size(); }
+    Statistics getStatistics() const;
+
+    // Пул по умолчанию для компонентов, которым не передан пул движка
+    static TaskScheduler &shared();
+
+private:
+    static constexpr int kPriorityCount = 3;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<TaskState>> queues[kPriorityCount];
+        std::thread thread;
+    };
+
+    void enqueue(const std::shared_ptr<TaskState> &task);
+    void workerLoop(size_t index);
+    bool tryRunOne(int workerIndex);
+    std::shared_ptr<TaskState> popLocal(size_t index);
+    std::shared_ptr<TaskState> steal(int thiefIndex);
+    void execute(const std::shared_ptr<TaskState> &task);
+    void addContinuation(const std::shared_ptr<TaskState> &parent, const std::shared_ptr<TaskState> &child);
+    static void applyAffinity(std::thread &thread, int core);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<size_t> m_nextWorker;
+    std::atomic<bool> m_stopping;
+
+    // Пробуждение простаивающих потоков
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+    std::atomic<size_t> m_queuedTasks;
+
+    // Ожидание простоя
+    std::mutex m_idleMutex;
+    std::condition_variable m_idleCondition;
+    std::atomic<size_t> m_activeTasks;     // Поставлены и еще не завершены
+
+    std::atomic<uint64_t> m_tasksExecuted;
+    std::atomic<uint64_t> m_tasksStolen;
+    std::atomic<uint64_t> m_tasksCancelled;
+};
+
+} // namespace LensEngine
+
+#endif // TASKSCHEDULER_H
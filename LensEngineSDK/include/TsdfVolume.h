@@ -0,0 +1,113 @@
+#ifndef TSDFVOLUME_H
+#define TSDFVOLUME_H
+
+#include "LensEngineTypes.h"
+#include "VoxelHashMap.h"
+#include "TaskScheduler.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace LensEngine {
+
+/**
+ * @brief Усеченное знаковое расстояние (TSDF) в разреженных блоках 8x8x8
+ *
+ * Блоки выделяются только вдоль поверхностей кадра (полоса усечения вокруг
+ * точек глубины) и ищутся по хешу координат блока. Интеграция кадра
+ * проецирует воксели видимых блоков в карту глубины: строка из 8 вокселей
+ * считается двумя шагами SSE2/NEON, блоки делятся между потоками пула.
+ * SDF - проективное расстояние вдоль луча, нормированное на усечение,
+ * вес вокселя ограничен maxWeight (поверхность следует за изменениями).
+ *
+ * Меш строится marching cubes только для блоков, изменившихся с прошлого
+ * извлечения (и соседей, чьи ячейки на границе читают их воксели). Кусок
+ * меша на блок несет номер версии: потребитель перезагружает только куски
+ * с версией новее своей. Экземпляр не потокобезопасен.
+ */
+class TsdfVolume {
+public:
+    static constexpr int32_t kBlockSide = 8;
+    static constexpr size_t kBlockVoxels = 512;
+
+    struct Options {
+        float voxelSize = 0.04f;            // м
+        float truncationDistance = 0.12f;   // Полуширина полосы SDF (м)
+        float maxWeight = 32.0f;            // Предел веса вокселя (окно усреднения)
+        float minDepth = 0.1f;
+        float maxDepth = 4.0f;              // Дальше глубина LiDAR слишком шумная для поверхности
+        uint8_t minConfidence = 1;          // 0 - low, 1 - medium, 2 - high
+        uint32_t allocationStep = 2;        // Шаг пикселей при выделении блоков
+        float minMeshWeight = 2.0f;         // Воксели с меньшим весом не дают поверхности
+    };
+
+    // Кусок меша одного блока в мировой системе
+    struct MeshBlock {
+        uint64_t key = 0;                   // Координаты блока (упакованы как в VoxelHashMap)
+        uint64_t version = 0;               // Номер извлечения, в котором кусок обновлен
+        std::vector<glm::vec3> vertices;
+        std::vector<glm::vec3> normals;     // По градиенту SDF, наружу от поверхности
+        std::vector<uint32_t> indices;      // Треугольники против часовой стрелки снаружи
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+        float confidence = 0.0f;            // Средний вес вершин / maxWeight
+    };
+
+    TsdfVolume();
+    explicit TsdfVolume(const Options &options);
+
+    // Смена размера вокселя или усечения очищает объем
+    void setOptions(const Options &options);
+    const Options &options() const { return m_options; }
+
+    // Пул задач (без него используется TaskScheduler::shared())
+    void setTaskScheduler(TaskScheduler *scheduler) { m_scheduler = scheduler; }
+
+    // depth - float32 width x height из intrinsics, confidence - uint8 того же размера
+    // (пустая - все пиксели допустимы). pose - поза устройства этого кадра.
+    // Возвращает число обновленных блоков; при несовпадении размера - 0
+    size_t integrate(const SharedBuffer &depth, const SharedBuffer &confidence,
+                     const DepthIntrinsics &intrinsics, const CameraPose &pose);
+
+    // Меши блоков, изменившихся с прошлого вызова. Блок, у которого поверхность
+    // пропала (или объем очищен), приходит пустым куском; куски одного ключа
+    // применяются по порядку. Возвращает число кусков в output
+    size_t extractChangedMeshes(std::vector<MeshBlock> &output);
+
+    // Версия последнего извлечения с изменениями (0 - мешей еще не было)
+    uint64_t meshVersion() const { return m_meshVersion; }
+
+    void clear();
+    size_t blockCount() const { return m_blocks.size(); }
+    float blockSize() const { return m_options.voxelSize * kBlockSide; }
+
+private:
+    struct Block {
+        float sdf[kBlockVoxels];            // Индекс (z * 8 + y) * 8 + x, в долях усечения
+        float weight[kBlockVoxels];
+        uint64_t frame = 0;                 // Последний кадр, где блок попал в список видимых
+        bool meshDirty = false;
+        bool hasMesh = false;
+    };
+
+    void allocateBlocks(const DepthIntrinsics &intrinsics, const CameraPose &pose);
+    bool integrateBlock(Block &block, uint64_t key, const DepthIntrinsics &intrinsics,
+                        const CameraPose &pose) const;
+    void meshBlock(uint32_t index, std::vector<float> &grid, std::vector<float> &gridWeight,
+                   std::vector<int32_t> &vertexCache, MeshBlock &mesh) const;
+
+    Options m_options;
+    TaskScheduler *m_scheduler;
+    VoxelHashMap m_index;                   // Ключ блока -> индекс в m_blocks
+    std::vector<Block> m_blocks;
+    std::vector<uint32_t> m_visible;        // Блоки текущего кадра
+    std::vector<uint8_t> m_updated;         // Параллельно m_visible: блок изменен
+    std::vector<float> m_depth;             // Глубина кадра после отбора (0 - недопустима)
+    std::vector<uint64_t> m_removed;        // Ключи блоков с мешем, удаленных clear()
+    uint64_t m_frame;
+    uint64_t m_meshVersion;
+};
+
+} // namespace LensEngine
+
+#endif // TSDFVOLUME_H
@@ -0,0 +1,122 @@
+#ifndef VOXELHASHMAP_H
+#define VOXELHASHMAP_H
+
+#include "LensEngineTypes.h"
+#include "DepthUnprojector.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace LensEngine {
+
+/**
+ * @brief Хеш-таблица вокселей с открытой адресацией
+ *
+ * Ключ - упакованные целые координаты вокселя (по 21 бит на ось). Слоты
+ * хранят ключ рядом с индексом, линейное пробирование идет по соседним
+ * слотам одной кэш-линии. Сами воксели лежат плотным массивом в порядке
+ * вставки; clear() сохраняет выделенную память для следующего кадра.
+ */
+class VoxelHashMap {
+public:
+    struct Voxel {
+        uint64_t key = 0;
+        uint32_t count = 0;             // Точек в вокселе
+        glm::vec3 sum = glm::vec3(0.0f);
+        glm::vec3 normalSum = glm::vec3(0.0f);
+        float weightSum = 0.0f;
+    };
+
+    static constexpr uint32_t kNotFound = 0xFFFFFFFFu;
+
+    explicit VoxelHashMap(float voxelSize = 0.05f);
+
+    void setVoxelSize(float voxelSize);
+    float voxelSize() const { return m_voxelSize; }
+
+    void clear();
+    void reserve(size_t voxels);
+    size_t size() const { return m_voxels.size(); }
+
+    // Воксель точки (создается при отсутствии); возвращает индекс в voxels()
+    uint32_t insert(const glm::vec3 &point);
+    uint32_t find(int32_t x, int32_t y, int32_t z) const;
+
+    void cellOf(const glm::vec3 &point, int32_t &x, int32_t &y, int32_t &z) const;
+    static void unpackKey(uint64_t key, int32_t &x, int32_t &y, int32_t &z);
+
+    std::vector<Voxel> &voxels() { return m_voxels; }
+    const std::vector<Voxel> &voxels() const { return m_voxels; }
+
+private:
+    struct Slot {
+        uint64_t key;
+        uint32_t index;                 // kNotFound - пустой слот
+    };
+
+    static uint64_t packKey(int32_t x, int32_t y, int32_t z);
+    size_t slotOf(uint64_t key) const;
+    void rehash(size_t slotCount);
+
+    float m_voxelSize;
+    float m_inverseVoxelSize;
+    std::vector<Slot> m_slots;          // Размер - степень двойки
+    std::vector<Voxel> m_voxels;
+    unsigned m_shift;                   // 64 - log2(числа слотов)
+};
+
+/**
+ * @brief Прореживание облака по вокселям и удаление выбросов за один проход
+ *
+ * Точки раскладываются по вокселям (O(n)), затем для каждого вокселя
+ * считается опора - число точек в нем и 26 соседних (O(числа вокселей)).
+ * Radius отбрасывает воксели с опорой меньше minNeighbors (аналог поиска
+ * соседей в радиусе размера вокселя), Statistical - с опорой ниже
+ * mean - stddevMultiplier * stddev по кадру. Выход - взвешенные центры
+ * оставшихся вокселей, средний вес и усредненная нормаль.
+ */
+class VoxelGridFilter {
+public:
+    enum class OutlierMode : uint8_t {
+        None,
+        Radius,
+        Statistical
+    };
+
+    struct Options {
+        bool enabled = true;
+        float voxelSize = 0.03f;            // Размер вокселя (м)
+        OutlierMode outlierMode = OutlierMode::Radius;
+        uint32_t minNeighbors = 3;          // Radius: мин. точек в вокселе и соседях
+        float stddevMultiplier = 1.0f;      // Statistical: порог mean - k * stddev
+    };
+
+    struct Statistics {
+        size_t inputPoints = 0;
+        size_t outputPoints = 0;
+        size_t voxels = 0;
+        size_t outlierVoxels = 0;
+        size_t outlierPoints = 0;
+    };
+
+    VoxelGridFilter();
+    explicit VoxelGridFilter(const Options &options);
+
+    void setOptions(const Options &options);
+    const Options &options() const { return m_options; }
+
+    // normals (если задан) - нормали точек input, outputNormals получает нормали вокселей.
+    // Без options.enabled вход копируется как есть
+    Statistics filter(const PointCloudSoA &input, PointCloudSoA &output,
+                      const std::vector<glm::vec3> *normals = nullptr,
+                      std::vector<glm::vec3> *outputNormals = nullptr);
+
+private:
+    Options m_options;
+    VoxelHashMap m_map;
+    std::vector<uint32_t> m_support;
+};
+
+} // namespace LensEngine
+
+#endif // VOXELHASHMAP_H
@@ -0,0 +1,67 @@
+#ifndef WORLDVOXELMAP_H
+#define WORLDVOXELMAP_H
+
+#include "LensEngineTypes.h"
+#include "VoxelHashMap.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace LensEngine {
+
+/**
+ * @brief Карта поверхностей в мировой системе на хеше вокселей
+ *
+ * Точки LiDAR переводятся позой камеры в мир и сливаются по вокселям:
+ * взвешенная сумма координат и нормалей, вес и число наблюдений.
+ * Вес ограничен maxWeight (старые наблюдения затухают), поэтому среднее
+ * следует за сдвинутыми предметами. Память растет с объемом снятого
+ * пространства, а не с длительностью сессии: повторный кадр той же
+ * комнаты не добавляет вокселей.
+ *
+ * Воксель подтвержден, когда набрал minObservations наблюдений; границы
+ * комнаты расширяются в этот момент, без прохода по всей карте.
+ * Экземпляр не потокобезопасен.
+ */
+class WorldVoxelMap {
+public:
+    struct Options {
+        float voxelSize = 0.05f;        // м
+        float maxWeight = 64.0f;        // Предел веса вокселя (окно усреднения)
+        uint32_t minObservations = 3;   // Меньше - возможный выброс, в выдачу не идет
+    };
+
+    WorldVoxelMap();
+    explicit WorldVoxelMap(const Options &options);
+
+    // Смена размера вокселя или minObservations очищает карту
+    void setOptions(const Options &options);
+    const Options &options() const { return m_options; }
+
+    // points - в системе камеры глубины (y вниз, z вперед), pose - поза устройства.
+    // normals и weights другого размера игнорируются
+    void integrate(const std::vector<glm::vec3> &points, const std::vector<glm::vec3> &normals,
+                   const std::vector<float> &weights, const CameraPose &pose);
+
+    void clear();
+
+    size_t voxelCount() const { return m_map.size(); }
+    size_t confirmedCount() const { return m_confirmed; }
+
+    // Средние точки и нормали подтвержденных вокселей
+    void extractPoints(std::vector<glm::vec3> &points, std::vector<glm::vec3> *normals = nullptr) const;
+
+    // false - подтвержденных вокселей еще нет
+    bool bounds(glm::vec3 &min, glm::vec3 &max) const;
+
+private:
+    Options m_options;
+    VoxelHashMap m_map;
+    size_t m_confirmed;
+    glm::vec3 m_boundsMin;
+    glm::vec3 m_boundsMax;
+};
+
+} // namespace LensEngine
+
+#endif // WORLDVOXELMAP_H
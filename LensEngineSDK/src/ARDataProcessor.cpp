@@ -1,6 +1,6 @@
 #include "ARDataProcessor.h"
+#include "Profiler.h"
 #include <algorithm>
-#include <future>
 
 #ifdef LENSENGINE_USE_OPENCV
 #include <opencv2/opencv.hpp>
@@ -10,7 +10,8 @@
 namespace LensEngine {
 
 ARDataProcessor::ARDataProcessor()
-    : m_cameraController(nullptr)
+    : m_scheduler(nullptr)
+    , m_cameraController(nullptr)
 {
     m_sensorFusion = std::make_unique<SensorFusionEKF>();
     m_spatialMapping = std::make_unique<SpatialMappingSystem>();
@@ -28,9 +29,7 @@ ARDataProcessor::ARDataProcessor()
 
 ARDataProcessor::~ARDataProcessor()
 {
-    if (m_processingFuture.valid()) {
-        m_processingFuture.wait();
-    }
+    m_processingTask.join();
 }
 
 std::vector<FeaturePoint> ARDataProcessor::extractFeaturePoints(const RGBImage &rgbImage)
@@ -85,23 +84,31 @@ void ARDataProcessor::setCameraController(CameraController* controller)
     m_cameraController = controller;
 }
 
-void ARDataProcessor::processFrameAsync(const ARFrame &frame)
+void ARDataProcessor::setTaskScheduler(TaskScheduler* scheduler)
 {
-    if (m_processingFuture.valid() && m_processingFuture.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
-        return; // Предыдущая обработка еще идет
-    }
-    
-    m_processingFuture = std::async(std::launch::async, [this, frame]() {
-        processFrameInternal(frame);
-    });
+    m_processingTask.join();
+    m_scheduler = scheduler;
+    m_spatialMapping->setTaskScheduler(scheduler);
 }
 
-void ARDataProcessor::updateSpatialMapping(const Lidar3DProcessor::SpatialAnalysisResult &analysis,
-                                          const std::vector<glm::vec3> &points)
+void ARDataProcessor::setDepthIntrinsics(const DepthIntrinsics &intrinsics)
 {
-    if (m_spatialMapping) {
-        m_spatialMapping->updateFromLiDAR(analysis, points);
+    m_spatialMapping->setDepthIntrinsics(intrinsics);
+}
+
+bool ARDataProcessor::processFrameAsync(const ARFrame &frame)
+{
+    if (!m_processingTask.isDone()) {
+        return false; // Предыдущая обработка еще идет
     }
+    
+    // Копия ARFrame разделяет буферы изображения и глубины с исходным кадром.
+    // Кадр задерживает отображение, поэтому идет с высоким приоритетом
+    TaskScheduler &scheduler = m_scheduler ? *m_scheduler : TaskScheduler::shared();
+    m_processingTask = scheduler.submit([this, frame]() mutable {
+        processFrameInternal(std::move(frame));
+    }, TaskScheduler::Priority::High);
+    return true;
 }
 
 void ARDataProcessor::addVirtualObjectToScene(const glm::vec3 &position, const glm::vec3 &size)
@@ -118,6 +125,21 @@ void ARDataProcessor::updateVirtualObjectPosition(const std::string &id, const g
     }
 }
 
+uint64_t ARDataProcessor::getMeshVersion() const
+{
+    return m_spatialMapping->getMeshVersion();
+}
+
+bool ARDataProcessor::raycast(const MeshRaycaster::Ray &ray, MeshRaycaster::Hit &hit) const
+{
+    return m_spatialMapping->raycast(ray, hit);
+}
+
+void ARDataProcessor::raycast(const std::vector<MeshRaycaster::Ray> &rays, std::vector<MeshRaycaster::Hit> &hits) const
+{
+    m_spatialMapping->raycast(rays, hits);
+}
+
 void ARDataProcessor::setFrameProcessedCallback(FrameProcessedCallback callback)
 {
     m_frameProcessedCallback = callback;
@@ -154,7 +176,9 @@ std::vector<FeaturePoint> ARDataProcessor::extractFeaturePointsFast(const RGBIma
     
 #ifdef LENSENGINE_USE_OPENCV
     // Преобразуем RGBImage в cv::Mat
-    cv::Mat image(rgbImage.height, rgbImage.width, CV_8UC3, const_cast<uint8_t*>(rgbImage.data.data()));
+    // Обертка над общим буфером кадра без копирования (данные только читаются)
+    cv::Mat image(rgbImage.height, rgbImage.width, CV_8UC3,
+                  const_cast<uint8_t*>(rgbImage.data.data()), rgbImage.bytesPerLine());
     cv::Mat gray;
     cv::cvtColor(image, gray, cv::COLOR_RGB2GRAY);
     
@@ -188,13 +212,14 @@ LightEstimation ARDataProcessor::estimateLightFast(const RGBImage &rgbImage)
     // Простая оценка освещения на основе среднего значения яркости
     uint64_t sum = 0;
     size_t pixelCount = rgbImage.width * rgbImage.height;
+    const size_t bytesPerLine = rgbImage.bytesPerLine();
     
-    for (size_t i = 0; i < pixelCount * 3; i += 3) {
-        // RGB -> Luminance
-        uint8_t r = rgbImage.data[i];
-        uint8_t g = rgbImage.data[i + 1];
-        uint8_t b = rgbImage.data[i + 2];
-        sum += static_cast<uint64_t>(0.299f * r + 0.587f * g + 0.114f * b);
+    for (uint32_t y = 0; y < rgbImage.height; ++y) {
+        const uint8_t* row = rgbImage.data.data() + y * bytesPerLine;
+        for (uint32_t x = 0; x < rgbImage.width; ++x, row += 3) {
+            // RGB -> Luminance
+            sum += static_cast<uint64_t>(0.299f * row[0] + 0.587f * row[1] + 0.114f * row[2]);
+        }
     }
     
     float avgLuminance = static_cast<float>(sum) / pixelCount / 255.0f;
@@ -207,40 +232,35 @@ LightEstimation ARDataProcessor::estimateLightFast(const RGBImage &rgbImage)
     return light;
 }
 
-void ARDataProcessor::processFrameInternal(const ARFrame &frame)
+void ARDataProcessor::processFrameInternal(ARFrame processedFrame)
 {
-    ARFrame processedFrame = frame;
-
-    // Всегда получаем актуальную позу от IMU
-    processedFrame.cameraPose = m_sensorFusion->getCurrentPose();
+    LENSENGINE_TRACE_FRAME("AR::processFrame", processedFrame.sequenceNumber);
 
     // Визуальный анализ (только если есть RGB)
-    if (!frame.rgbImage.data.empty()) {
-        processedFrame.featurePoints = extractFeaturePointsFast(frame.rgbImage);
-        processedFrame.light = estimateLightFast(frame.rgbImage);
-        processedFrame.intrinsics = estimateCameraIntrinsics(frame.rgbImage);
+    if (!processedFrame.rgbImage.data.empty()) {
+        {
+            LENSENGINE_TRACE_SCOPE("AR::featurePoints");
+            processedFrame.featurePoints = extractFeaturePointsFast(processedFrame.rgbImage);
+        }
+        {
+            LENSENGINE_TRACE_SCOPE("AR::lightEstimation");
+            processedFrame.light = estimateLightFast(processedFrame.rgbImage);
+        }
+        processedFrame.intrinsics = estimateCameraIntrinsics(processedFrame.rgbImage);
     }
 
-    // Обновление Spatial Mapping (только если есть LiDAR точки)
-    if (!frame.lidar.points3D.empty() && m_spatialMapping) {
+    // Обновление Spatial Mapping по карте глубины кадра (точки есть не всегда: синхронизатор
+    // движка прикладывает только карты). Поза - поза фьюжна движка на момент выдачи кадра
+    if (!processedFrame.lidar.depthMap.empty() && m_spatialMapping) {
         Lidar3DProcessor::SpatialAnalysisResult analysis;
         analysis.hasFloor = true;
         analysis.floorHeight = 0.0f;
         analysis.floorNormal = glm::vec3(0, 1, 0);
 
-        m_spatialMapping->updateFromLiDAR(analysis, frame.lidar.points3D);
-
-        // Помощь позиционированию от LiDAR в EKF
-        if (m_sensorFusion) {
-            m_sensorFusion->updateLidar(frame.lidar.points3D);
-        }
-    }
-
-    // Вызываем колбэки
-    if (m_frameProcessedCallback) {
-        m_frameProcessedCallback(processedFrame);
+        m_spatialMapping->updateFromLiDAR(analysis, processedFrame.lidar, processedFrame.cameraPose);
     }
 
+    // Вызываем колбэки (результаты публикуются до события завершения кадра)
     if (!processedFrame.featurePoints.empty() && m_featurePointsCallback) {
         m_featurePointsCallback(processedFrame.featurePoints);
     }
@@ -252,6 +272,10 @@ void ARDataProcessor::processFrameInternal(const ARFrame &frame)
     if (processedFrame.intrinsics.isValid && m_intrinsicsCallback) {
         m_intrinsicsCallback(processedFrame.intrinsics);
     }
+
+    if (m_frameProcessedCallback) {
+        m_frameProcessedCallback(processedFrame);
+    }
 }
 
 } // namespace LensEngine
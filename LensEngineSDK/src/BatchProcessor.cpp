@@ -0,0 +1,328 @@
+#include "BatchProcessor.h"
+#include "SensorRecording.h"
+#include "SensorFusionEKF.h"
+#include "ARDataProcessor.h"
+#include "Lidar3DProcessor.h"
+#include "SpatialMappingSystem.h"
+#include "DepthOdometry.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <string>
+
+namespace LensEngine {
+
+namespace {
+struct BatchFrame {
+    ARFrame frame;
+    OrganizedPointCloud grid;           // Сетка глубины с нормалями для одометрии
+    DepthIntrinsics gridIntrinsics;
+    std::chrono::steady_clock::time_point readTime;
+    TaskScheduler::TaskHandle task;
+};
+
+// Элемент последовательной стадии: IMU сэмпл или кадр в исходном порядке записи
+struct OrderedItem {
+    bool isFrame = false;
+    RawIMUData imu;
+    std::shared_ptr<BatchFrame> frame;
+};
+
+uint64_t absoluteDifference(uint64_t a, uint64_t b)
+{
+    return a > b ? a - b : b - a;
+}
+}
+
+BatchProcessor::BatchProcessor(TaskScheduler &scheduler)
+    : m_scheduler(scheduler)
+{
+}
+
+BatchProcessor::Result BatchProcessor::run(const std::string &recordingPath, const Options &options)
+{
+    Result result;
+
+    SensorRecordReader reader;
+    if (!reader.open(recordingPath)) {
+        result.errorString = reader.errorString();
+        return result;
+    }
+
+    // Свои экземпляры компонентов: запуск не влияет на работающий движок
+    SensorFusionEKF fusion;
+    fusion.initialize();
+    fusion.setUseSensorTimestamps(true);
+    SpatialMappingSystem mapping;
+    mapping.initialize();
+    mapping.setDepthIntrinsics(options.depthIntrinsics);
+    mapping.setTaskScheduler(&m_scheduler);
+    ARDataProcessor frameAnalyzer;
+    Lidar3DProcessor lidarProcessor;
+    lidarProcessor.setDepthIntrinsics(options.depthIntrinsics);
+    lidarProcessor.setMinimumConfidence(options.minConfidence);
+    DepthOdometry odometry(lidarProcessor.getOdometryOptions());
+    odometry.setTaskScheduler(&m_scheduler);
+    uint64_t trackedDepthSequence = 0;
+
+    const size_t window = options.maxFramesInFlight > 0
+        ? options.maxFramesInFlight
+        : std::max<size_t>(2, m_scheduler.threadCount() * 2);
+
+    std::deque<OrderedItem> ordered;
+    size_t framesInFlight = 0;
+    std::vector<double> latenciesMs;
+    std::string taskError;
+
+    // Последовательные стадии: всегда в порядке записи
+    auto completeFront = [&]() {
+        OrderedItem item = std::move(ordered.front());
+        ordered.pop_front();
+
+        if (!item.isFrame) {
+            fusion.updateIMU(item.imu);
+            return;
+        }
+
+        BatchFrame &batchFrame = *item.frame;
+        // Ошибка кадра не прерывает цикл: остальные задачи ссылаются на локальные компоненты
+        bool frameFailed = false;
+        try {
+            batchFrame.task.wait();
+        } catch (const std::exception &e) {
+            frameFailed = true;
+            if (taskError.empty()) {
+                taskError = std::string("Frame task failed: ") + e.what();
+            }
+        } catch (...) {
+            frameFailed = true;
+            if (taskError.empty()) {
+                taskError = "Frame task failed";
+            }
+        }
+        --framesInFlight;
+        if (frameFailed) {
+            return;
+        }
+
+        LENSENGINE_TRACE_FRAME("Batch::sequentialStages", batchFrame.frame.sequenceNumber);
+
+        // Одометрия по глубине - в порядке записи, как в движке: мера относительно
+        // прошлой карты. Кадры с той же картой глубины ее не повторяют
+        const LidarData &lidar = batchFrame.frame.lidar;
+        if (batchFrame.grid.validCount > 0 && lidar.sequenceNumber != trackedDepthSequence) {
+            trackedDepthSequence = lidar.sequenceNumber;
+            if (odometry.options().enabled) {
+                RelativePoseMeasurement measurement = odometry.track(batchFrame.grid, batchFrame.gridIntrinsics);
+                measurement.sequenceNumber = lidar.sequenceNumber;
+                fusion.updateOdometry(measurement);
+            }
+        }
+
+        const std::vector<glm::vec3> &points = lidar.points3D;
+        if (!points.empty()) {
+            Lidar3DProcessor::SpatialAnalysisResult analysis;
+            analysis.hasFloor = true;
+            analysis.floorHeight = 0.0f;
+            analysis.floorNormal = glm::vec3(0, 1, 0);
+
+            mapping.updateFromLiDAR(analysis, lidar, fusion.getCurrentPose());
+            ++result.framesWithDepth;
+        }
+
+        CameraPose pose = fusion.getCurrentPose();
+        pose.timestamp = batchFrame.frame.timestamp;
+        result.trajectory.push_back(pose);
+        ++result.framesProcessed;
+
+        latenciesMs.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - batchFrame.readTime).count());
+    };
+
+    LidarData latestDepth;
+    bool hasDepth = false;
+    // Уверенность, пришедшая раньше своей глубины
+    SharedBuffer pendingConfidence;
+    uint64_t pendingConfidenceTimestamp = 0;
+    uint64_t depthSequence = 0;
+    uint64_t frameSequence = 0;
+    uint64_t firstTimestamp = 0;
+    uint64_t lastTimestamp = 0;
+    bool hasTimestamp = false;
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    SensorRecording::Record record;
+    while (reader.next(record)) {
+        if (!hasTimestamp) {
+            firstTimestamp = record.timestamp;
+            hasTimestamp = true;
+        }
+        lastTimestamp = std::max(lastTimestamp, record.timestamp);
+
+        switch (record.type) {
+        case SensorRecording::RecordType::Depth:
+            latestDepth = LidarData();
+            latestDepth.depthMap = record.data;
+            latestDepth.confidenceMap = record.confidence;
+            latestDepth.timestamp = record.timestamp;
+            latestDepth.sequenceNumber = ++depthSequence;
+            hasDepth = true;
+            if (latestDepth.confidenceMap.empty() && !pendingConfidence.empty() &&
+                absoluteDifference(pendingConfidenceTimestamp, record.timestamp) <= options.confidenceMatchTolerance) {
+                latestDepth.confidenceMap = pendingConfidence;
+            }
+            pendingConfidence = SharedBuffer();
+            break;
+
+        case SensorRecording::RecordType::Confidence:
+            // Уверенность пишется отдельно и в любом порядке с глубиной: пара по времени, как в движке
+            if (hasDepth && latestDepth.confidenceMap.empty() &&
+                absoluteDifference(latestDepth.timestamp, record.timestamp) <= options.confidenceMatchTolerance) {
+                latestDepth.confidenceMap = record.data;
+            } else {
+                pendingConfidence = record.data;
+                pendingConfidenceTimestamp = record.timestamp;
+            }
+            break;
+
+        case SensorRecording::RecordType::IMU:
+            ++result.imuSamples;
+            if (ordered.empty()) {
+                fusion.updateIMU(record.imu);
+            } else {
+                OrderedItem item;
+                item.imu = record.imu;
+                ordered.push_back(std::move(item));
+            }
+            break;
+
+        case SensorRecording::RecordType::RGB: {
+            while (framesInFlight >= window) {
+                completeFront();
+            }
+
+            auto batchFrame = std::make_shared<BatchFrame>();
+            ARFrame &frame = batchFrame->frame;
+            frame.rgbImage.data = record.data;
+            frame.rgbImage.width = record.width;
+            frame.rgbImage.height = record.height;
+            frame.rgbImage.stride = record.stride;
+            frame.rgbImage.timestamp = record.timestamp;
+            frame.timestamp = record.timestamp;
+            frame.sequenceNumber = ++frameSequence;
+            if (hasDepth && absoluteDifference(latestDepth.timestamp, record.timestamp) <= options.depthMatchTolerance) {
+                frame.lidar = latestDepth;
+            }
+            batchFrame->readTime = std::chrono::steady_clock::now();
+
+            // Независимая работа кадра идет параллельно с соседними кадрами
+            BatchFrame *framePtr = batchFrame.get();
+            batchFrame->task = m_scheduler.submit([framePtr, &frameAnalyzer, &lidarProcessor]() {
+                ARFrame &target = framePtr->frame;
+                LENSENGINE_TRACE_FRAME("Batch::frameStages", target.sequenceNumber);
+
+                if (!target.lidar.depthMap.empty()) {
+                    LENSENGINE_TRACE_SCOPE("Lidar::unproject");
+                    target.lidar.points3D = lidarProcessor.processDepthDataFast(target.lidar.depthMap,
+                                                                                target.lidar.confidenceMap,
+                                                                                &target.lidar.pointWeights,
+                                                                                &target.lidar.pointNormals,
+                                                                                &framePtr->grid,
+                                                                                &framePtr->gridIntrinsics);
+                }
+                if (!target.rgbImage.data.empty()) {
+                    {
+                        LENSENGINE_TRACE_SCOPE("AR::featurePoints");
+                        target.featurePoints = frameAnalyzer.extractFeaturePoints(target.rgbImage);
+                    }
+                    {
+                        LENSENGINE_TRACE_SCOPE("AR::lightEstimation");
+                        target.light = frameAnalyzer.estimateLight(target.rgbImage);
+                    }
+                    target.intrinsics = frameAnalyzer.estimateCameraIntrinsics(target.rgbImage);
+                }
+            }, TaskScheduler::Priority::High);
+
+            OrderedItem item;
+            item.isFrame = true;
+            item.frame = std::move(batchFrame);
+            ordered.push_back(std::move(item));
+            ++framesInFlight;
+            break;
+        }
+        }
+    }
+
+    // Задачи ссылаются на локальные компоненты: дожидаемся всех до выхода
+    while (!ordered.empty()) {
+        completeFront();
+    }
+
+    result.wallTimeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    result.recordingSeconds = static_cast<double>(lastTimestamp - firstTimestamp) / 1000.0;
+    if (result.wallTimeSeconds > 0.0) {
+        result.framesPerSecond = static_cast<double>(result.framesProcessed) / result.wallTimeSeconds;
+        result.speedup = result.recordingSeconds / result.wallTimeSeconds;
+    }
+
+    if (!latenciesMs.empty()) {
+        double total = 0.0;
+        for (double latency : latenciesMs) {
+            total += latency;
+        }
+        result.meanFrameLatencyMs = total / static_cast<double>(latenciesMs.size());
+
+        std::sort(latenciesMs.begin(), latenciesMs.end());
+        auto percentile = [&latenciesMs](double p) {
+            const size_t rank = static_cast<size_t>(p * static_cast<double>(latenciesMs.size() - 1) + 0.5);
+            return latenciesMs[std::min(rank, latenciesMs.size() - 1)];
+        };
+        result.p50FrameLatencyMs = percentile(0.50);
+        result.p99FrameLatencyMs = percentile(0.99);
+    }
+
+    if (!reader.errorString().empty()) {
+        result.errorString = reader.errorString();
+        return result;
+    }
+
+    if (!taskError.empty()) {
+        result.errorString = taskError;
+        return result;
+    }
+
+    if (!options.trajectoryPath.empty() && !writeTumTrajectory(options.trajectoryPath, result.trajectory)) {
+        result.errorString = "Cannot write trajectory: " + options.trajectoryPath;
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
+
+bool BatchProcessor::writeTumTrajectory(const std::string &path, const std::vector<CameraPose> &trajectory)
+{
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+
+    std::fprintf(file, "# timestamp tx ty tz qx qy qz qw\n");
+    for (const CameraPose &pose : trajectory) {
+        std::fprintf(file, "%.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f\n",
+                     static_cast<double>(pose.timestamp) / 1000.0,
+                     pose.position.x, pose.position.y, pose.position.z,
+                     pose.rotation.x, pose.rotation.y, pose.rotation.z, pose.rotation.w);
+    }
+
+    const bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
+
+} // namespace LensEngine
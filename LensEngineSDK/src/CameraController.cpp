@@ -18,49 +18,73 @@ CameraController::~CameraController()
 {
 }
 
+glm::vec3 CameraController::position() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_position;
+}
+
+glm::quat CameraController::rotation() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_rotation;
+}
+
 glm::vec3 CameraController::forward() const
 {
-    return m_rotation * glm::vec3(0.0f, 0.0f, -1.0f);
+    return rotation() * glm::vec3(0.0f, 0.0f, -1.0f);
 }
 
 glm::vec3 CameraController::up() const
 {
-    return m_rotation * glm::vec3(0.0f, 1.0f, 0.0f);
+    return rotation() * glm::vec3(0.0f, 1.0f, 0.0f);
 }
 
 glm::vec3 CameraController::right() const
 {
-    return m_rotation * glm::vec3(1.0f, 0.0f, 0.0f);
+    return rotation() * glm::vec3(1.0f, 0.0f, 0.0f);
 }
 
 void CameraController::updateFromSensorFusion(const glm::vec3 &position, const glm::quat &rotation)
 {
-    if (!m_initialCalibration) {
-        m_initialPosition = position;
-        m_initialCalibration = true;
+    glm::vec3 newPosition;
+    glm::quat newRotation;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_initialCalibration) {
+            m_initialPosition = position;
+            m_initialCalibration = true;
+        }
+
+        glm::vec3 worldPosition = position - m_initialPosition;
+        m_position = worldPosition * m_worldScale;
+        m_rotation = glm::normalize(rotation);
+        newPosition = m_position;
+        newRotation = m_rotation;
     }
 
-    glm::vec3 worldPosition = position - m_initialPosition;
-    m_position = worldPosition * m_worldScale;
-    m_rotation = glm::normalize(rotation);
-
+    // Колбэк вызывается вне блокировки
     if (m_cameraUpdatedCallback) {
-        m_cameraUpdatedCallback(m_position, m_rotation);
+        m_cameraUpdatedCallback(newPosition, newRotation);
     }
 }
 
 void CameraController::updateFromCameraPose(const CameraPose &cameraPose)
 {
-    m_position = cameraPose.position;
-    m_rotation = cameraPose.rotation;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_position = cameraPose.position;
+        m_rotation = cameraPose.rotation;
+    }
 
     if (m_cameraUpdatedCallback) {
-        m_cameraUpdatedCallback(m_position, m_rotation);
+        m_cameraUpdatedCallback(cameraPose.position, cameraPose.rotation);
     }
 }
 
 glm::mat4 CameraController::viewMatrix() const
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
     glm::mat4 rotation = glm::mat4_cast(glm::conjugate(m_rotation));
     glm::mat4 translation = glm::translate(glm::mat4(1.0f), -m_position);
     return rotation * translation;
@@ -73,6 +97,7 @@ glm::mat4 CameraController::projectionMatrix(float fov, float aspect, float near
 
 void CameraController::resetCamera()
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
     m_position = glm::vec3(0.0f);
     m_rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
     m_initialPosition = glm::vec3(0.0f);
@@ -81,12 +106,14 @@ void CameraController::resetCamera()
 
 void CameraController::recalibrate()
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
     m_initialPosition = m_position;
     m_initialCalibration = true;
 }
 
 void CameraController::setWorldScale(float scale)
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
     m_worldScale = scale;
 }
 
@@ -0,0 +1,366 @@
+#include "DepthOdometry.h"
+#include "Profiler.h"
+#include "SimdConfig.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace LensEngine {
+
+namespace {
+constexpr int kParameters = 6;
+
+// Матрица поворота по строкам из единичного кватерниона
+void rotationMatrix(const glm::quat &q, float m[9])
+{
+    const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    m[0] = 1.0f - 2.0f * (yy + zz); m[1] = 2.0f * (xy - wz);        m[2] = 2.0f * (xz + wy);
+    m[3] = 2.0f * (xy + wz);        m[4] = 1.0f - 2.0f * (xx + zz); m[5] = 2.0f * (yz - wx);
+    m[6] = 2.0f * (xz - wy);        m[7] = 2.0f * (yz + wx);        m[8] = 1.0f - 2.0f * (xx + yy);
+}
+
+// Кватернион поворота на вектор omega (ось * угол)
+glm::quat rotationFromVector(const double omega[3])
+{
+    const double angle = std::sqrt(omega[0] * omega[0] + omega[1] * omega[1] + omega[2] * omega[2]);
+    if (angle < 1e-12) {
+        return glm::quat(1.0f, 0.5f * static_cast<float>(omega[0]), 0.5f * static_cast<float>(omega[1]),
+                         0.5f * static_cast<float>(omega[2]));
+    }
+    const double s = std::sin(0.5 * angle) / angle;
+    return glm::quat(static_cast<float>(std::cos(0.5 * angle)), static_cast<float>(omega[0] * s),
+                     static_cast<float>(omega[1] * s), static_cast<float>(omega[2] * s));
+}
+
+// Разложение Холецкого 6x6 на месте (нижний треугольник); false - не положительно определена
+bool choleskyDecompose(double a[kParameters][kParameters])
+{
+    for (int j = 0; j < kParameters; ++j) {
+        double diagonal = a[j][j];
+        for (int k = 0; k < j; ++k) {
+            diagonal -= a[j][k] * a[j][k];
+        }
+        if (diagonal <= 0.0) {
+            return false;
+        }
+        a[j][j] = std::sqrt(diagonal);
+        for (int i = j + 1; i < kParameters; ++i) {
+            double value = a[i][j];
+            for (int k = 0; k < j; ++k) {
+                value -= a[i][k] * a[j][k];
+            }
+            a[i][j] = value / a[j][j];
+        }
+    }
+    return true;
+}
+
+void choleskySolve(const double l[kParameters][kParameters], const double b[kParameters], double x[kParameters])
+{
+    double y[kParameters];
+    for (int i = 0; i < kParameters; ++i) {
+        double value = b[i];
+        for (int k = 0; k < i; ++k) {
+            value -= l[i][k] * y[k];
+        }
+        y[i] = value / l[i][i];
+    }
+    for (int i = kParameters - 1; i >= 0; --i) {
+        double value = y[i];
+        for (int k = i + 1; k < kParameters; ++k) {
+            value -= l[k][i] * x[k];
+        }
+        x[i] = value / l[i][i];
+    }
+}
+}
+
+DepthOdometry::DepthOdometry()
+    : DepthOdometry(Options())
+{
+}
+
+DepthOdometry::DepthOdometry(const Options &options)
+    : m_options(options)
+    , m_scheduler(nullptr)
+    , m_hasReference(false)
+{
+}
+
+void DepthOdometry::setTaskScheduler(TaskScheduler *scheduler)
+{
+    m_scheduler = scheduler;
+}
+
+void DepthOdometry::reset()
+{
+    m_hasReference = false;
+}
+
+void DepthOdometry::accumulateRows(const OrganizedPointCloud &source, const float rotation[9],
+                                   const float translation[3], uint32_t rowBegin, uint32_t rowEnd,
+                                   Accumulator &accumulator) const
+{
+    std::memset(&accumulator, 0, sizeof(accumulator));
+
+    const OrganizedPointCloud &reference = m_reference;
+    const DepthIntrinsics &intrinsics = m_referenceIntrinsics;
+    const int width = static_cast<int>(reference.width);
+    const int height = static_cast<int>(reference.height);
+    const float maxDistanceSquared = m_options.maxCorrespondenceDistance * m_options.maxCorrespondenceDistance;
+    const float huber = m_options.huberThreshold;
+
+#if defined(LENSENGINE_SIMD_SSE2)
+    __m128 sums[8][2];
+    for (int k = 0; k < 8; ++k) {
+        sums[k][0] = _mm_setzero_ps();
+        sums[k][1] = _mm_setzero_ps();
+    }
+#elif defined(LENSENGINE_SIMD_NEON)
+    float32x4_t sums[8][2];
+    for (int k = 0; k < 8; ++k) {
+        sums[k][0] = vdupq_n_f32(0.0f);
+        sums[k][1] = vdupq_n_f32(0.0f);
+    }
+#endif
+
+    for (uint32_t v = rowBegin; v < rowEnd; ++v) {
+        for (uint32_t u = 0; u < source.width; ++u) {
+            const size_t i = source.index(u, v);
+            const glm::vec3 &sourceNormal = source.normals[i];
+            if (!source.valid[i] || (sourceNormal.x == 0.0f && sourceNormal.y == 0.0f && sourceNormal.z == 0.0f)) {
+                continue;
+            }
+
+            // Точка в системе опорного кадра и ее ячейка в опорной сетке
+            const float px = source.x[i], py = source.y[i], pz = source.z[i];
+            const float qx = rotation[0] * px + rotation[1] * py + rotation[2] * pz + translation[0];
+            const float qy = rotation[3] * px + rotation[4] * py + rotation[5] * pz + translation[1];
+            const float qz = rotation[6] * px + rotation[7] * py + rotation[8] * pz + translation[2];
+            if (qz <= 1e-3f) {
+                continue;
+            }
+            const float inverseZ = 1.0f / qz;
+            const int tu = static_cast<int>(std::lround(intrinsics.focalLengthX * qx * inverseZ + intrinsics.principalPointX));
+            const int tv = static_cast<int>(std::lround(intrinsics.focalLengthY * qy * inverseZ + intrinsics.principalPointY));
+            if (tu < 0 || tv < 0 || tu >= width || tv >= height) {
+                continue;
+            }
+            const size_t j = reference.index(static_cast<uint32_t>(tu), static_cast<uint32_t>(tv));
+            const glm::vec3 &n = reference.normals[j];
+            if (!reference.valid[j] || (n.x == 0.0f && n.y == 0.0f && n.z == 0.0f)) {
+                continue;
+            }
+
+            const float dx = qx - reference.x[j];
+            const float dy = qy - reference.y[j];
+            const float dz = qz - reference.z[j];
+            if (dx * dx + dy * dy + dz * dz > maxDistanceSquared) {
+                continue;
+            }
+            const float rotatedDot =
+                (rotation[0] * sourceNormal.x + rotation[1] * sourceNormal.y + rotation[2] * sourceNormal.z) * n.x +
+                (rotation[3] * sourceNormal.x + rotation[4] * sourceNormal.y + rotation[5] * sourceNormal.z) * n.y +
+                (rotation[6] * sourceNormal.x + rotation[7] * sourceNormal.y + rotation[8] * sourceNormal.z) * n.z;
+            if (rotatedDot < m_options.minNormalCos) {
+                continue;
+            }
+
+            // r = n . (q - m), dr/d(omega) = q x n, dr/dt = n
+            const float r = n.x * dx + n.y * dy + n.z * dz;
+            const float absR = std::abs(r);
+            const float weight = (absR <= huber ? 1.0f : huber / absR) * source.weight[i] * reference.weight[j];
+            const float a[8] = {
+                qy * n.z - qz * n.y, qz * n.x - qx * n.z, qx * n.y - qy * n.x,
+                n.x, n.y, n.z, r, 1.0f
+            };
+            ++accumulator.count;
+            accumulator.residualSquares += r * r;
+
+#if defined(LENSENGINE_SIMD_SSE2)
+            const __m128 low = _mm_loadu_ps(a);
+            const __m128 high = _mm_loadu_ps(a + 4);
+            for (int k = 0; k < 8; ++k) {
+                const __m128 scale = _mm_set1_ps(weight * a[k]);
+                sums[k][0] = _mm_add_ps(sums[k][0], _mm_mul_ps(scale, low));
+                sums[k][1] = _mm_add_ps(sums[k][1], _mm_mul_ps(scale, high));
+            }
+#elif defined(LENSENGINE_SIMD_NEON)
+            const float32x4_t low = vld1q_f32(a);
+            const float32x4_t high = vld1q_f32(a + 4);
+            for (int k = 0; k < 8; ++k) {
+                const float scale = weight * a[k];
+                sums[k][0] = vmlaq_n_f32(sums[k][0], low, scale);
+                sums[k][1] = vmlaq_n_f32(sums[k][1], high, scale);
+            }
+#else
+            for (int k = 0; k < 8; ++k) {
+                const float scale = weight * a[k];
+                for (int c = 0; c < 8; ++c) {
+                    accumulator.sums[k][c] += scale * a[c];
+                }
+            }
+#endif
+        }
+    }
+
+#if defined(LENSENGINE_SIMD_SSE2)
+    for (int k = 0; k < 8; ++k) {
+        _mm_storeu_ps(accumulator.sums[k], sums[k][0]);
+        _mm_storeu_ps(accumulator.sums[k] + 4, sums[k][1]);
+    }
+#elif defined(LENSENGINE_SIMD_NEON)
+    for (int k = 0; k < 8; ++k) {
+        vst1q_f32(accumulator.sums[k], sums[k][0]);
+        vst1q_f32(accumulator.sums[k] + 4, sums[k][1]);
+    }
+#endif
+}
+
+RelativePoseMeasurement DepthOdometry::track(const OrganizedPointCloud &cloud, const DepthIntrinsics &gridIntrinsics)
+{
+    LENSENGINE_TRACE_SCOPE("Odometry::track");
+
+    RelativePoseMeasurement result;
+    const bool comparable = m_hasReference && cloud.hasNormals() &&
+                            cloud.width == m_reference.width && cloud.height == m_reference.height &&
+                            gridIntrinsics == m_referenceIntrinsics;
+    if (!comparable) {
+        if (cloud.hasNormals()) {
+            m_reference = cloud;
+            m_referenceIntrinsics = gridIntrinsics;
+            m_hasReference = true;
+        }
+        return result;
+    }
+
+    const uint32_t rowsPerBlock = std::max<uint32_t>(1, m_options.rowsPerBlock);
+    const size_t blocks = (cloud.height + rowsPerBlock - 1) / rowsPerBlock;
+    m_partials.resize(blocks);
+
+    glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 translation(0.0f);
+    double hessian[kParameters][kParameters] = {};
+    double residualSquares = 0.0;
+    uint32_t count = 0;
+    bool solved = false;
+
+    for (uint32_t iteration = 0; iteration < m_options.maxIterations; ++iteration) {
+        float r[9];
+        rotationMatrix(rotation, r);
+        const float t[3] = {translation.x, translation.y, translation.z};
+
+        auto accumulateBlocks = [this, &cloud, &r, &t, rowsPerBlock](size_t begin, size_t end) {
+            for (size_t block = begin; block < end; ++block) {
+                const uint32_t rowBegin = static_cast<uint32_t>(block) * rowsPerBlock;
+                const uint32_t rowEnd = std::min(cloud.height, rowBegin + rowsPerBlock);
+                accumulateRows(cloud, r, t, rowBegin, rowEnd, m_partials[block]);
+            }
+        };
+        if (m_scheduler && blocks > 1) {
+            m_scheduler->parallelFor(0, blocks, 1, accumulateBlocks, TaskScheduler::Priority::Normal);
+        } else {
+            accumulateBlocks(0, blocks);
+        }
+
+        // Сумма блоков в фиксированном порядке (в double)
+        double sums[8][8] = {};
+        count = 0;
+        residualSquares = 0.0;
+        for (const Accumulator &partial : m_partials) {
+            for (int k = 0; k < 8; ++k) {
+                for (int c = 0; c < 8; ++c) {
+                    sums[k][c] += partial.sums[k][c];
+                }
+            }
+            count += partial.count;
+            residualSquares += partial.residualSquares;
+        }
+        if (count < m_options.minCorrespondences) {
+            solved = false;
+            break;
+        }
+
+        // (H + lambda I) x = -g; малое затухание держит вырожденные направления (один план) конечными
+        double trace = 0.0;
+        double gradient[kParameters];
+        for (int k = 0; k < kParameters; ++k) {
+            for (int c = 0; c < kParameters; ++c) {
+                hessian[k][c] = sums[k][c];
+            }
+            gradient[k] = -sums[k][6];
+            trace += sums[k][k];
+        }
+        double factor[kParameters][kParameters];
+        std::memcpy(factor, hessian, sizeof(factor));
+        for (int k = 0; k < kParameters; ++k) {
+            factor[k][k] += 1e-6 * trace + 1e-12;
+        }
+        if (!choleskyDecompose(factor)) {
+            solved = false;
+            break;
+        }
+        double step[kParameters];
+        choleskySolve(factor, gradient, step);
+        std::memcpy(hessian, factor, sizeof(hessian));  // Дальше нужен множитель для ковариации
+        solved = true;
+
+        // Левое приращение: T <- exp(step) * T
+        const glm::quat delta = glm::normalize(rotationFromVector(step));
+        rotation = glm::normalize(delta * rotation);
+        translation = delta * translation + glm::vec3(static_cast<float>(step[3]), static_cast<float>(step[4]),
+                                                      static_cast<float>(step[5]));
+
+        double norm = 0.0;
+        for (double value : step) {
+            norm += value * value;
+        }
+        if (std::sqrt(norm) < m_options.convergenceThreshold) {
+            break;
+        }
+    }
+
+    // Опорным всегда становится текущий кадр: следующая мера - от него
+    m_reference = cloud;
+
+    const float angle = 2.0f * std::acos(std::min(1.0f, std::abs(rotation.w)));
+    if (!solved || angle > m_options.maxRotation || glm::length(translation) > m_options.maxTranslation) {
+        return result;
+    }
+
+    // H^-1 по множителю Холецкого (по столбцам). Большой диагональный элемент -
+    // параметр держится на доле соответствий, и ICP дрейфует вдоль него
+    double inverse[kParameters][kParameters];
+    const double maxInverse = 1.0 / (static_cast<double>(m_options.minConstraint) * count);
+    for (int c = 0; c < kParameters; ++c) {
+        double unit[kParameters] = {};
+        unit[c] = 1.0;
+        double column[kParameters];
+        choleskySolve(hessian, unit, column);
+        if (column[c] > maxInverse) {
+            return result;
+        }
+        for (int k = 0; k < kParameters; ++k) {
+            inverse[k][c] = column[k];
+        }
+    }
+
+    const double sigmaSquared = std::max(residualSquares / std::max<double>(1.0, static_cast<double>(count) - kParameters),
+                                         static_cast<double>(m_options.minResidualSigma) * m_options.minResidualSigma);
+    for (int k = 0; k < kParameters; ++k) {
+        for (int c = 0; c < kParameters; ++c) {
+            result.covariance[k * kParameters + c] = sigmaSquared * inverse[k][c];
+        }
+    }
+
+    result.valid = true;
+    result.rotation = rotation;
+    result.translation = translation;
+    result.correspondences = count;
+    result.rmse = static_cast<float>(std::sqrt(residualSquares / std::max<uint32_t>(1, count)));
+    return result;
+}
+
+} // namespace LensEngine
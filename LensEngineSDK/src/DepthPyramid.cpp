@@ -0,0 +1,312 @@
+#include "DepthPyramid.h"
+#include "Profiler.h"
+#include "SimdConfig.h"
+#include <algorithm>
+#include <limits>
+
+namespace LensEngine {
+
+namespace {
+constexpr float kEmpty = std::numeric_limits<float>::infinity();
+
+// Объединение до четырех значений; пустые заменены на +inf
+inline float poolScalar(float a, float b, float c, float d, DepthPyramid::Pooling pooling)
+{
+    const int valid = (a < kEmpty) + (b < kEmpty) + (c < kEmpty) + (d < kEmpty);
+    if (valid == 0) {
+        return 0.0f;
+    }
+    const float lowAB = std::min(a, b);
+    const float lowCD = std::min(c, d);
+    const float smallest = std::min(lowAB, lowCD);
+    if (pooling == DepthPyramid::Pooling::Min || valid < 3) {
+        return smallest;
+    }
+    // Второе по величине из четырех
+    return std::min(std::max(lowAB, lowCD), std::min(std::max(a, b), std::max(c, d)));
+}
+
+inline float emptyIfInvalid(float depth)
+{
+    return depth > 0.0f ? depth : kEmpty;
+}
+
+// Число установленных битов 4-битной маски
+constexpr uint8_t kMaskBits[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+}
+
+DepthPyramid::DepthPyramid()
+    : DepthPyramid(Options())
+{
+}
+
+DepthPyramid::DepthPyramid(const Options &options)
+    : m_options(options)
+    , m_levelCount(0)
+{
+}
+
+size_t DepthPyramid::build(const SharedBuffer &depth, const SharedBuffer &confidence,
+                           const DepthIntrinsics &intrinsics)
+{
+    return build(depth.as<float>(), depth.count<float>(), confidence.data(), confidence.size(), intrinsics);
+}
+
+size_t DepthPyramid::build(const float *depth, size_t depthCount, const uint8_t *confidence,
+                           size_t confidenceCount, const DepthIntrinsics &intrinsics)
+{
+    LENSENGINE_TRACE_SCOPE("Depth::pyramid");
+
+    const size_t pixels = static_cast<size_t>(intrinsics.width) * intrinsics.height;
+    m_levelCount = 0;
+    if (!depth || pixels == 0 || depthCount != pixels) {
+        return 0;
+    }
+
+    const size_t maxLevels = std::max<uint32_t>(1, m_options.maxLevels);
+    if (m_levels.size() < maxLevels) {
+        m_levels.resize(maxLevels);
+        m_unprojectors.resize(maxLevels);
+    }
+
+    buildBase(depth, confidenceCount == pixels ? confidence : nullptr, intrinsics);
+    setLevelIntrinsics(0, intrinsics);
+    m_levelCount = 1;
+
+    // Уровни до сетки меньше 2x2
+    while (m_levelCount < maxLevels) {
+        const DepthIntrinsics &fine = m_levels[m_levelCount - 1].intrinsics;
+        if (fine.width < 2 || fine.height < 2) {
+            break;
+        }
+
+        const float inverseScale = 1.0f / static_cast<float>(1u << m_levelCount);
+        DepthIntrinsics coarse;
+        coarse.width = (fine.width + 1) / 2;
+        coarse.height = (fine.height + 1) / 2;
+        // Центр ячейки уровня - центр ее блока пикселей исходной карты
+        coarse.focalLengthX = intrinsics.focalLengthX * inverseScale;
+        coarse.focalLengthY = intrinsics.focalLengthY * inverseScale;
+        coarse.principalPointX = (intrinsics.principalPointX + 0.5f) * inverseScale - 0.5f;
+        coarse.principalPointY = (intrinsics.principalPointY + 0.5f) * inverseScale - 0.5f;
+        setLevelIntrinsics(m_levelCount, coarse);
+
+        downsample(m_levels[m_levelCount - 1], m_levels[m_levelCount]);
+        ++m_levelCount;
+    }
+    return m_levelCount;
+}
+
+void DepthPyramid::setLevelIntrinsics(size_t index, const DepthIntrinsics &intrinsics)
+{
+    Level &level = m_levels[index];
+    level.intrinsics = intrinsics;
+    const size_t cells = static_cast<size_t>(intrinsics.width) * intrinsics.height;
+    level.depth.resize(cells);
+    m_unprojectors[index].setIntrinsics(intrinsics);
+}
+
+void DepthPyramid::buildBase(const float *depth, const uint8_t *confidence, const DepthIntrinsics &intrinsics)
+{
+    Level &base = m_levels[0];
+    const size_t pixels = static_cast<size_t>(intrinsics.width) * intrinsics.height;
+    base.depth.resize(pixels);
+    if (confidence) {
+        base.confidence.assign(confidence, confidence + pixels);
+    } else {
+        base.confidence.clear();
+    }
+
+    // Недопустимые пиксели обнуляются: дальше в объединение идут только измерения
+    size_t validCount = 0;
+    for (size_t i = 0; i < pixels; ++i) {
+        const float d = depth[i];
+        const bool valid = d >= m_options.minDepth && d <= m_options.maxDepth &&
+                           (!confidence || confidence[i] >= m_options.minConfidence);
+        base.depth[i] = valid ? d : 0.0f;
+        validCount += valid ? 1 : 0;
+    }
+    base.validCount = validCount;
+}
+
+void DepthPyramid::downsample(const Level &fine, Level &coarse) const
+{
+    const uint32_t fineWidth = fine.intrinsics.width;
+    const uint32_t fineHeight = fine.intrinsics.height;
+    const uint32_t width = coarse.intrinsics.width;
+    const uint32_t height = coarse.intrinsics.height;
+    const bool hasConfidence = !fine.confidence.empty();
+    coarse.confidence.resize(hasConfidence ? static_cast<size_t>(width) * height : 0);
+    const Pooling pooling = m_options.pooling;
+
+    size_t validCount = 0;
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint32_t y0 = 2 * y;
+        const uint32_t y1 = std::min(y0 + 1, fineHeight - 1);
+        const bool hasRow1 = y0 + 1 < fineHeight;
+        const float *row0 = &fine.depth[static_cast<size_t>(y0) * fineWidth];
+        const float *row1 = &fine.depth[static_cast<size_t>(y1) * fineWidth];
+        float *out = &coarse.depth[static_cast<size_t>(y) * width];
+
+        uint32_t x = 0;
+        // Полные блоки 2x2 по 4 ячейки за шаг (нечетная последняя строка - скалярно)
+#if defined(LENSENGINE_SIMD_SSE2)
+        if (hasRow1) {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 empty = _mm_set1_ps(kEmpty);
+            const __m128i three = _mm_set1_epi32(3);
+            const bool median = pooling == Pooling::MedianOfValid;
+            for (; 2 * x + 8 <= fineWidth; x += 4) {
+                const __m128 r0a = _mm_loadu_ps(row0 + 2 * x);
+                const __m128 r0b = _mm_loadu_ps(row0 + 2 * x + 4);
+                const __m128 r1a = _mm_loadu_ps(row1 + 2 * x);
+                const __m128 r1b = _mm_loadu_ps(row1 + 2 * x + 4);
+                __m128 a = _mm_shuffle_ps(r0a, r0b, _MM_SHUFFLE(2, 0, 2, 0));
+                __m128 b = _mm_shuffle_ps(r0a, r0b, _MM_SHUFFLE(3, 1, 3, 1));
+                __m128 c = _mm_shuffle_ps(r1a, r1b, _MM_SHUFFLE(2, 0, 2, 0));
+                __m128 d = _mm_shuffle_ps(r1a, r1b, _MM_SHUFFLE(3, 1, 3, 1));
+
+                const __m128 va = _mm_cmpgt_ps(a, zero);
+                const __m128 vb = _mm_cmpgt_ps(b, zero);
+                const __m128 vc = _mm_cmpgt_ps(c, zero);
+                const __m128 vd = _mm_cmpgt_ps(d, zero);
+                a = _mm_or_ps(_mm_and_ps(va, a), _mm_andnot_ps(va, empty));
+                b = _mm_or_ps(_mm_and_ps(vb, b), _mm_andnot_ps(vb, empty));
+                c = _mm_or_ps(_mm_and_ps(vc, c), _mm_andnot_ps(vc, empty));
+                d = _mm_or_ps(_mm_and_ps(vd, d), _mm_andnot_ps(vd, empty));
+
+                const __m128 lowAB = _mm_min_ps(a, b);
+                const __m128 lowCD = _mm_min_ps(c, d);
+                __m128 result = _mm_min_ps(lowAB, lowCD);
+                if (median) {
+                    // Маски -1: сумма с обратным знаком - число допустимых
+                    const __m128i count = _mm_sub_epi32(_mm_setzero_si128(),
+                        _mm_add_epi32(_mm_add_epi32(_mm_castps_si128(va), _mm_castps_si128(vb)),
+                                      _mm_add_epi32(_mm_castps_si128(vc), _mm_castps_si128(vd))));
+                    const __m128 second = _mm_min_ps(_mm_max_ps(lowAB, lowCD),
+                                                     _mm_min_ps(_mm_max_ps(a, b), _mm_max_ps(c, d)));
+                    // Меньше трех допустимых - наименьшее, иначе второе по величине
+                    const __m128 fewValid = _mm_castsi128_ps(_mm_cmplt_epi32(count, three));
+                    result = _mm_or_ps(_mm_andnot_ps(fewValid, second), _mm_and_ps(fewValid, result));
+                }
+                const __m128 found = _mm_cmplt_ps(result, empty);
+                result = _mm_and_ps(found, result);
+                _mm_storeu_ps(out + x, result);
+                validCount += kMaskBits[_mm_movemask_ps(found)];
+            }
+        }
+#elif defined(LENSENGINE_SIMD_NEON)
+        if (hasRow1) {
+            const float32x4_t zero = vdupq_n_f32(0.0f);
+            const float32x4_t empty = vdupq_n_f32(kEmpty);
+            const uint32x4_t one = vdupq_n_u32(1);
+            const bool median = pooling == Pooling::MedianOfValid;
+            for (; 2 * x + 8 <= fineWidth; x += 4) {
+                const float32x4x2_t r0 = vld2q_f32(row0 + 2 * x);
+                const float32x4x2_t r1 = vld2q_f32(row1 + 2 * x);
+                const uint32x4_t va = vcgtq_f32(r0.val[0], zero);
+                const uint32x4_t vb = vcgtq_f32(r0.val[1], zero);
+                const uint32x4_t vc = vcgtq_f32(r1.val[0], zero);
+                const uint32x4_t vd = vcgtq_f32(r1.val[1], zero);
+                const float32x4_t a = vbslq_f32(va, r0.val[0], empty);
+                const float32x4_t b = vbslq_f32(vb, r0.val[1], empty);
+                const float32x4_t c = vbslq_f32(vc, r1.val[0], empty);
+                const float32x4_t d = vbslq_f32(vd, r1.val[1], empty);
+
+                const float32x4_t lowAB = vminq_f32(a, b);
+                const float32x4_t lowCD = vminq_f32(c, d);
+                float32x4_t result = vminq_f32(lowAB, lowCD);
+                if (median) {
+                    const uint32x4_t count = vaddq_u32(vaddq_u32(vandq_u32(va, one), vandq_u32(vb, one)),
+                                                       vaddq_u32(vandq_u32(vc, one), vandq_u32(vd, one)));
+                    const float32x4_t second = vminq_f32(vmaxq_f32(lowAB, lowCD),
+                                                         vminq_f32(vmaxq_f32(a, b), vmaxq_f32(c, d)));
+                    result = vbslq_f32(vcgeq_u32(count, vdupq_n_u32(3)), second, result);
+                }
+                const uint32x4_t found = vcltq_f32(result, empty);
+                result = vbslq_f32(found, result, zero);
+                vst1q_f32(out + x, result);
+                const uint32x4_t foundCount = vandq_u32(found, one);
+                validCount += vgetq_lane_u32(foundCount, 0) + vgetq_lane_u32(foundCount, 1) +
+                              vgetq_lane_u32(foundCount, 2) + vgetq_lane_u32(foundCount, 3);
+            }
+        }
+#endif
+        for (; x < width; ++x) {
+            const uint32_t x0 = 2 * x;
+            const bool hasColumn1 = x0 + 1 < fineWidth;
+            const float a = emptyIfInvalid(row0[x0]);
+            const float b = hasColumn1 ? emptyIfInvalid(row0[x0 + 1]) : kEmpty;
+            const float c = hasRow1 ? emptyIfInvalid(row1[x0]) : kEmpty;
+            const float d = hasRow1 && hasColumn1 ? emptyIfInvalid(row1[x0 + 1]) : kEmpty;
+            out[x] = poolScalar(a, b, c, d, pooling);
+            validCount += out[x] > 0.0f ? 1 : 0;
+        }
+
+        // Уверенность: наименьшая среди допустимых пикселей блока
+        if (hasConfidence) {
+            const uint8_t *confidence0 = &fine.confidence[static_cast<size_t>(y0) * fineWidth];
+            const uint8_t *confidence1 = &fine.confidence[static_cast<size_t>(y1) * fineWidth];
+            uint8_t *confidenceOut = &coarse.confidence[static_cast<size_t>(y) * width];
+            for (uint32_t cx = 0; cx < width; ++cx) {
+                const uint32_t x0 = 2 * cx;
+                const uint32_t x1 = std::min(x0 + 1, fineWidth - 1);
+                uint8_t level = std::numeric_limits<uint8_t>::max();
+                if (row0[x0] > 0.0f) level = std::min(level, confidence0[x0]);
+                if (row0[x1] > 0.0f) level = std::min(level, confidence0[x1]);
+                if (row1[x0] > 0.0f) level = std::min(level, confidence1[x0]);
+                if (row1[x1] > 0.0f) level = std::min(level, confidence1[x1]);
+                confidenceOut[cx] = level == std::numeric_limits<uint8_t>::max() ? 0 : level;
+            }
+        }
+    }
+    coarse.validCount = validCount;
+}
+
+size_t DepthPyramid::levelForBudget(size_t pointBudget) const
+{
+    size_t best = 0;
+    size_t bestError = std::numeric_limits<size_t>::max();
+    for (size_t i = 0; i < m_levelCount; ++i) {
+        const size_t count = m_levels[i].validCount;
+        const size_t error = count > pointBudget ? count - pointBudget : pointBudget - count;
+        if (error < bestError) {
+            best = i;
+            bestError = error;
+        }
+    }
+    return best;
+}
+
+size_t DepthPyramid::unproject(size_t index, const DepthUnprojector::Options &options, PointCloudSoA &output) const
+{
+    if (index >= m_levelCount) {
+        output.clear();
+        return 0;
+    }
+    const Level &level = m_levels[index];
+    DepthUnprojector::Options levelOptions = options;
+    levelOptions.step = 1;
+    return m_unprojectors[index].unproject(level.depth.data(), level.depth.size(),
+                                           level.confidence.data(), level.confidence.size(),
+                                           levelOptions, output);
+}
+
+size_t DepthPyramid::unprojectOrganized(size_t index, const DepthUnprojector::Options &options,
+                                        OrganizedPointCloud &output) const
+{
+    if (index >= m_levelCount) {
+        output.resize(0, 0);
+        return 0;
+    }
+    const Level &level = m_levels[index];
+    DepthUnprojector::Options levelOptions = options;
+    levelOptions.step = 1;
+    const size_t valid = m_unprojectors[index].unprojectOrganized(level.depth.data(), level.depth.size(),
+                                                                  level.confidence.data(), level.confidence.size(),
+                                                                  levelOptions, output);
+    output.step = 1u << index;
+    return valid;
+}
+
+} // namespace LensEngine
@@ -0,0 +1,200 @@
+#include "DepthTemporalFilter.h"
+#include "Profiler.h"
+#include "SimdConfig.h"
+#include <algorithm>
+#include <cmath>
+
+namespace LensEngine {
+
+namespace {
+// Меньше этого движения перенос состояния не нужен
+constexpr float kMinTranslation = 0.001f;       // м
+constexpr float kMinRotationCos = 0.9999996f;   // cos(половины угла ~0.1 градуса)
+
+inline float confidenceWeight(const float *weights, const uint8_t *confidence, size_t index)
+{
+    if (!confidence) {
+        return 1.0f;
+    }
+    return weights[std::min<uint8_t>(confidence[index], DepthTemporalFilter::kConfidenceLevels - 1)];
+}
+
+inline float blendPixel(float depth, float previous, float weight, float alpha, float threshold)
+{
+    if (!(depth > 0.0f)) {
+        return 0.0f;
+    }
+    if (!(previous > 0.0f)) {
+        return depth;
+    }
+    const float difference = depth - previous;
+    const float share = (std::abs(difference) > threshold * previous ? 1.0f : alpha) * weight;
+    return previous + share * difference;
+}
+}
+
+DepthTemporalFilter::DepthTemporalFilter()
+    : DepthTemporalFilter(Options())
+{
+}
+
+DepthTemporalFilter::DepthTemporalFilter(const Options &options)
+    : m_options(options)
+    , m_hasState(false)
+{
+}
+
+void DepthTemporalFilter::reset()
+{
+    m_hasState = false;
+}
+
+bool DepthTemporalFilter::warpState(const DepthIntrinsics &intrinsics, const CameraPose &pose)
+{
+    // Относительная поза в системе устройства: p_cur = R * p_prev + t
+    const glm::quat inverseCurrent = glm::conjugate(pose.rotation);
+    const glm::quat relative = inverseCurrent * m_pose.rotation;
+    const glm::vec3 translation = inverseCurrent * (m_pose.position - pose.position);
+    if (std::abs(relative.w) >= kMinRotationCos && glm::length(translation) < kMinTranslation) {
+        return false;
+    }
+
+    // Камера глубины: y вниз, z вперед; устройство: y вверх, z назад (S = diag(1, -1, -1))
+    const glm::vec3 ex = relative * glm::vec3(1, 0, 0);
+    const glm::vec3 ey = relative * glm::vec3(0, 1, 0);
+    const glm::vec3 ez = relative * glm::vec3(0, 0, 1);
+    const glm::vec3 columnX(ex.x, -ex.y, -ex.z);
+    const glm::vec3 columnY(-ey.x, ey.y, ey.z);
+    const glm::vec3 columnZ(-ez.x, ez.y, ez.z);
+    const glm::vec3 offset(translation.x, -translation.y, -translation.z);
+
+    const uint32_t width = intrinsics.width;
+    const uint32_t height = intrinsics.height;
+    const float inverseFx = 1.0f / intrinsics.focalLengthX;
+    const float inverseFy = 1.0f / intrinsics.focalLengthY;
+    m_warped.assign(m_state.size(), 0.0f);
+
+    // Прямой перенос с z-буфером: ближняя поверхность перекрывает дальнюю
+    for (uint32_t v = 0; v < height; ++v) {
+        const float rayY = (static_cast<float>(v) - intrinsics.principalPointY) * inverseFy;
+        const float *row = &m_state[static_cast<size_t>(v) * width];
+        for (uint32_t u = 0; u < width; ++u) {
+            const float depth = row[u];
+            if (!(depth > 0.0f)) {
+                continue;
+            }
+            const float rayX = (static_cast<float>(u) - intrinsics.principalPointX) * inverseFx;
+            const glm::vec3 point = columnX * (depth * rayX) + columnY * (depth * rayY) + columnZ * depth + offset;
+            if (point.z <= 1e-3f) {
+                continue;
+            }
+            const float inverseZ = 1.0f / point.z;
+            const int tu = static_cast<int>(std::lround(intrinsics.focalLengthX * point.x * inverseZ + intrinsics.principalPointX));
+            const int tv = static_cast<int>(std::lround(intrinsics.focalLengthY * point.y * inverseZ + intrinsics.principalPointY));
+            if (tu < 0 || tv < 0 || tu >= static_cast<int>(width) || tv >= static_cast<int>(height)) {
+                continue;
+            }
+            float &target = m_warped[static_cast<size_t>(tv) * width + static_cast<size_t>(tu)];
+            if (target == 0.0f || point.z < target) {
+                target = point.z;
+            }
+        }
+    }
+    return true;
+}
+
+const float *DepthTemporalFilter::apply(const float *depth, size_t depthCount, const uint8_t *confidence,
+                                        size_t confidenceCount, const DepthIntrinsics &intrinsics,
+                                        const CameraPose &pose)
+{
+    LENSENGINE_TRACE_SCOPE("Depth::temporal");
+
+    const size_t pixels = static_cast<size_t>(intrinsics.width) * intrinsics.height;
+    if (!depth || depthCount != pixels || pixels == 0) {
+        return depth;
+    }
+    if (confidenceCount != pixels) {
+        confidence = nullptr;
+    }
+
+    // Новое разрешение или параметры - прошлое состояние не сопоставимо
+    if (!m_hasState || m_state.size() != pixels || !(m_intrinsics == intrinsics)) {
+        m_state.assign(depth, depth + pixels);
+        for (float &value : m_state) {
+            if (!(value > 0.0f)) {
+                value = 0.0f;
+            }
+        }
+        m_intrinsics = intrinsics;
+        m_pose = pose;
+        m_hasState = true;
+        return m_state.data();
+    }
+
+    const bool posed = m_options.compensatePose && pose.timestamp != 0 && m_pose.timestamp != 0;
+    const float *previous = posed && warpState(intrinsics, pose) ? m_warped.data() : m_state.data();
+    float *output = m_state.data();
+    const float alpha = m_options.alpha;
+    const float threshold = m_options.resetThreshold;
+    const float *weights = m_options.confidenceWeights;
+
+    size_t i = 0;
+#if defined(LENSENGINE_SIMD_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 alphaValue = _mm_set1_ps(alpha);
+    const __m128 thresholdValue = _mm_set1_ps(threshold);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    for (; i + 4 <= pixels; i += 4) {
+        const __m128 d = _mm_loadu_ps(depth + i);
+        const __m128 p = _mm_loadu_ps(previous + i);
+        const __m128 weight = confidence
+            ? _mm_set_ps(weights[std::min<uint8_t>(confidence[i + 3], kConfidenceLevels - 1)],
+                         weights[std::min<uint8_t>(confidence[i + 2], kConfidenceLevels - 1)],
+                         weights[std::min<uint8_t>(confidence[i + 1], kConfidenceLevels - 1)],
+                         weights[std::min<uint8_t>(confidence[i], kConfidenceLevels - 1)])
+            : one;
+        const __m128 currentValid = _mm_cmpgt_ps(d, zero);   // NaN тоже отбрасывается
+        const __m128 previousValid = _mm_cmpgt_ps(p, zero);
+        const __m128 difference = _mm_sub_ps(d, p);
+        const __m128 jump = _mm_cmpgt_ps(_mm_and_ps(difference, absMask), _mm_mul_ps(thresholdValue, p));
+        const __m128 share = _mm_mul_ps(_mm_or_ps(_mm_and_ps(jump, one), _mm_andnot_ps(jump, alphaValue)), weight);
+        const __m128 blended = _mm_add_ps(p, _mm_mul_ps(share, difference));
+        const __m128 result = _mm_or_ps(_mm_and_ps(previousValid, blended), _mm_andnot_ps(previousValid, d));
+        _mm_storeu_ps(output + i, _mm_and_ps(currentValid, result));
+    }
+#elif defined(LENSENGINE_SIMD_NEON)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t alphaValue = vdupq_n_f32(alpha);
+    const float32x4_t thresholdValue = vdupq_n_f32(threshold);
+    for (; i + 4 <= pixels; i += 4) {
+        const float32x4_t d = vld1q_f32(depth + i);
+        const float32x4_t p = vld1q_f32(previous + i);
+        float32x4_t weight = one;
+        if (confidence) {
+            const float lanes[4] = {
+                confidenceWeight(weights, confidence, i), confidenceWeight(weights, confidence, i + 1),
+                confidenceWeight(weights, confidence, i + 2), confidenceWeight(weights, confidence, i + 3)
+            };
+            weight = vld1q_f32(lanes);
+        }
+        const uint32x4_t currentValid = vcgtq_f32(d, zero);
+        const uint32x4_t previousValid = vcgtq_f32(p, zero);
+        const float32x4_t difference = vsubq_f32(d, p);
+        const uint32x4_t jump = vcgtq_f32(vabsq_f32(difference), vmulq_f32(thresholdValue, p));
+        const float32x4_t share = vmulq_f32(vbslq_f32(jump, one, alphaValue), weight);
+        const float32x4_t blended = vmlaq_f32(p, share, difference);
+        const float32x4_t result = vbslq_f32(previousValid, blended, d);
+        vst1q_f32(output + i, vbslq_f32(currentValid, result, zero));
+    }
+#endif
+    for (; i < pixels; ++i) {
+        output[i] = blendPixel(depth[i], previous[i], confidenceWeight(weights, confidence, i), alpha, threshold);
+    }
+
+    m_pose = pose;
+    return output;
+}
+
+} // namespace LensEngine
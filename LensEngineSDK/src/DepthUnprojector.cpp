@@ -0,0 +1,433 @@
+#include "DepthUnprojector.h"
+#include "SimdConfig.h"
+#include <algorithm>
+#include <cstring>
+
+namespace LensEngine {
+
+namespace {
+constexpr size_t kSimdWidth = 4;
+
+struct KernelInput {
+    const float *depth;
+    const uint8_t *confidence;      // nullptr - без карты уверенности
+    const float *rayX;
+    const float *rayY;
+    uint32_t width;
+    uint32_t height;
+    uint32_t step;
+    float minDepth;
+    float maxDepth;
+    uint8_t minConfidence;
+    const float *confidenceWeights; // По уровням ARKit: low, medium, high
+};
+
+struct KernelOutput {
+    float *x;
+    float *y;
+    float *z;
+    float *weight;
+};
+
+inline float confidenceWeight(const float *weights, uint8_t level)
+{
+    return weights[level < DepthUnprojector::kConfidenceLevels ? level : DepthUnprojector::kConfidenceLevels - 1];
+}
+
+// Записать точки из 4 дорожек по маске допустимых пикселей
+inline size_t storeMaskedLanes(const float *lanesX, const float *lanesY, const float *lanesZ,
+                               const float *lanesWeight, unsigned mask, const KernelOutput &out, size_t count)
+{
+    for (size_t lane = 0; lane < kSimdWidth; ++lane) {
+        out.x[count] = lanesX[lane];
+        out.y[count] = lanesY[lane];
+        out.z[count] = lanesZ[lane];
+        out.weight[count] = lanesWeight[lane];
+        count += (mask >> lane) & 1u;
+    }
+    return count;
+}
+
+/**
+ * Ядро распаковки. Width/Height != 0 фиксируют размеры на этапе компиляции
+ * (компилятор разворачивает циклы), 0 - размеры берутся из аргументов.
+ * HasConfidence добавляет маску по карте уверенности и вес точки; без
+ * карты вес равен 1 и проверка не компилируется.
+ * Запись без ветвлений: точка пишется всегда, счетчик растет только для
+ * допустимого пикселя (NaN не проходит сравнения), поэтому отброшенные
+ * точки не попадают в выходной буфер.
+ */
+template<uint32_t Width, uint32_t Height, bool HasConfidence>
+size_t unprojectKernel(const KernelInput &in, const KernelOutput &out)
+{
+    const uint32_t width = Width ? Width : in.width;
+    const uint32_t height = Height ? Height : in.height;
+    const uint32_t step = in.step;
+
+    size_t count = 0;
+    for (uint32_t y = 0; y < height; y += step) {
+        const size_t rowOffset = static_cast<size_t>(y) * width;
+        const float *row = in.depth + rowOffset;
+        const uint8_t *confidenceRow = HasConfidence ? in.confidence + rowOffset : nullptr;
+        const float ray = in.rayY[y];
+        uint32_t x = 0;
+
+        if (step == 1) {
+#if defined(LENSENGINE_SIMD_SSE2)
+            const __m128 minValue = _mm_set1_ps(in.minDepth);
+            const __m128 maxValue = _mm_set1_ps(in.maxDepth);
+            const __m128 rayRow = _mm_set1_ps(ray);
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i confidenceThreshold = _mm_set1_epi32(static_cast<int>(in.minConfidence) - 1);
+            for (; x + kSimdWidth <= width; x += kSimdWidth) {
+                const __m128 d = _mm_loadu_ps(row + x);
+                const __m128 px = _mm_mul_ps(d, _mm_loadu_ps(in.rayX + x));
+                const __m128 py = _mm_mul_ps(d, rayRow);
+                __m128 valid = _mm_and_ps(_mm_cmpge_ps(d, minValue), _mm_cmple_ps(d, maxValue));
+                __m128 weight = _mm_set1_ps(1.0f);
+
+                if (HasConfidence) {
+                    // 4 байта уверенности -> 4 дорожки int32
+                    int32_t packed;
+                    std::memcpy(&packed, confidenceRow + x, sizeof(packed));
+                    const __m128i levels = _mm_unpacklo_epi16(
+                        _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+                    valid = _mm_and_ps(valid, _mm_castsi128_ps(_mm_cmpgt_epi32(levels, confidenceThreshold)));
+                    weight = _mm_set_ps(confidenceWeight(in.confidenceWeights, confidenceRow[x + 3]),
+                                        confidenceWeight(in.confidenceWeights, confidenceRow[x + 2]),
+                                        confidenceWeight(in.confidenceWeights, confidenceRow[x + 1]),
+                                        confidenceWeight(in.confidenceWeights, confidenceRow[x]));
+                }
+
+                const unsigned mask = static_cast<unsigned>(_mm_movemask_ps(valid));
+                if (mask == 0xFu) {
+                    _mm_storeu_ps(out.x + count, px);
+                    _mm_storeu_ps(out.y + count, py);
+                    _mm_storeu_ps(out.z + count, d);
+                    _mm_storeu_ps(out.weight + count, weight);
+                    count += kSimdWidth;
+                } else if (mask != 0) {
+                    alignas(16) float lanesX[kSimdWidth];
+                    alignas(16) float lanesY[kSimdWidth];
+                    alignas(16) float lanesZ[kSimdWidth];
+                    alignas(16) float lanesWeight[kSimdWidth];
+                    _mm_store_ps(lanesX, px);
+                    _mm_store_ps(lanesY, py);
+                    _mm_store_ps(lanesZ, d);
+                    _mm_store_ps(lanesWeight, weight);
+                    count = storeMaskedLanes(lanesX, lanesY, lanesZ, lanesWeight, mask, out, count);
+                }
+            }
+#elif defined(LENSENGINE_SIMD_NEON)
+            const float32x4_t minValue = vdupq_n_f32(in.minDepth);
+            const float32x4_t maxValue = vdupq_n_f32(in.maxDepth);
+            const float32x4_t rayRow = vdupq_n_f32(ray);
+            const uint32x4_t confidenceThreshold = vdupq_n_u32(in.minConfidence);
+            for (; x + kSimdWidth <= width; x += kSimdWidth) {
+                const float32x4_t d = vld1q_f32(row + x);
+                const float32x4_t px = vmulq_f32(d, vld1q_f32(in.rayX + x));
+                const float32x4_t py = vmulq_f32(d, rayRow);
+                uint32x4_t valid = vandq_u32(vcgeq_f32(d, minValue), vcleq_f32(d, maxValue));
+                float lanesWeight[kSimdWidth] = {1.0f, 1.0f, 1.0f, 1.0f};
+
+                if (HasConfidence) {
+                    const uint32_t levelValues[kSimdWidth] = {confidenceRow[x], confidenceRow[x + 1],
+                                                              confidenceRow[x + 2], confidenceRow[x + 3]};
+                    valid = vandq_u32(valid, vcgeq_u32(vld1q_u32(levelValues), confidenceThreshold));
+                    for (size_t lane = 0; lane < kSimdWidth; ++lane) {
+                        lanesWeight[lane] = confidenceWeight(in.confidenceWeights, confidenceRow[x + lane]);
+                    }
+                }
+
+                uint32_t lanesMask[kSimdWidth];
+                vst1q_u32(lanesMask, valid);
+                const unsigned mask = (lanesMask[0] & 1u) | ((lanesMask[1] & 1u) << 1) |
+                                      ((lanesMask[2] & 1u) << 2) | ((lanesMask[3] & 1u) << 3);
+
+                if (mask == 0xFu) {
+                    vst1q_f32(out.x + count, px);
+                    vst1q_f32(out.y + count, py);
+                    vst1q_f32(out.z + count, d);
+                    vst1q_f32(out.weight + count, vld1q_f32(lanesWeight));
+                    count += kSimdWidth;
+                } else if (mask != 0) {
+                    float lanesX[kSimdWidth];
+                    float lanesY[kSimdWidth];
+                    float lanesZ[kSimdWidth];
+                    vst1q_f32(lanesX, px);
+                    vst1q_f32(lanesY, py);
+                    vst1q_f32(lanesZ, d);
+                    count = storeMaskedLanes(lanesX, lanesY, lanesZ, lanesWeight, mask, out, count);
+                }
+            }
+#endif
+        }
+
+        // Хвост строки и прореженная распаковка
+        for (; x < width; x += step) {
+            const float d = row[x];
+            bool valid = d >= in.minDepth && d <= in.maxDepth;
+            float weight = 1.0f;
+            if (HasConfidence) {
+                const uint8_t level = confidenceRow[x];
+                valid = valid && level >= in.minConfidence;
+                weight = confidenceWeight(in.confidenceWeights, level);
+            }
+
+            out.x[count] = d * in.rayX[x];
+            out.y[count] = d * ray;
+            out.z[count] = d;
+            out.weight[count] = weight;
+            count += valid ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+template<uint32_t Width, uint32_t Height>
+size_t dispatchConfidence(const KernelInput &in, const KernelOutput &out)
+{
+    return in.confidence ? unprojectKernel<Width, Height, true>(in, out)
+                         : unprojectKernel<Width, Height, false>(in, out);
+}
+}
+
+// ============================================================================
+// PointCloudSoA
+// ============================================================================
+
+void PointCloudSoA::reserve(size_t points)
+{
+    const size_t capacity = points + kSimdWidth;
+    if (x.size() < capacity) {
+        x.resize(capacity);
+        y.resize(capacity);
+        z.resize(capacity);
+        weight.resize(capacity);
+    }
+}
+
+std::vector<glm::vec3> PointCloudSoA::toVec3() const
+{
+    std::vector<glm::vec3> points;
+    toVec3(points);
+    return points;
+}
+
+void PointCloudSoA::toVec3(std::vector<glm::vec3> &output) const
+{
+    output.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        output[i] = glm::vec3(x[i], y[i], z[i]);
+    }
+}
+
+void PointCloudSoA::assign(const std::vector<glm::vec3> &points, const std::vector<float> &weights)
+{
+    reserve(points.size());
+    const bool hasWeights = weights.size() == points.size();
+    for (size_t i = 0; i < points.size(); ++i) {
+        x[i] = points[i].x;
+        y[i] = points[i].y;
+        z[i] = points[i].z;
+        weight[i] = hasWeights ? weights[i] : 1.0f;
+    }
+    count = points.size();
+}
+
+void PointCloudSoA::erase(const std::vector<uint32_t> &sortedIndices)
+{
+    const bool hasWeights = weight.size() >= count;
+    size_t write = 0;
+    size_t next = 0;
+    for (size_t read = 0; read < count; ++read) {
+        if (next < sortedIndices.size() && sortedIndices[next] == read) {
+            ++next;
+            continue;
+        }
+        x[write] = x[read];
+        y[write] = y[read];
+        z[write] = z[read];
+        if (hasWeights) {
+            weight[write] = weight[read];
+        }
+        ++write;
+    }
+    count = write;
+}
+
+// ============================================================================
+// DepthUnprojector
+// ============================================================================
+
+DepthUnprojector::DepthUnprojector()
+{
+    setIntrinsics(DepthIntrinsics());
+}
+
+void DepthUnprojector::setIntrinsics(const DepthIntrinsics &intrinsics)
+{
+    auto current = std::atomic_load(&m_rayTable);
+    if (current && current->intrinsics == intrinsics) {
+        return;
+    }
+
+    auto table = std::make_shared<RayTable>();
+    table->intrinsics = intrinsics;
+    table->rayX.resize(intrinsics.width + kSimdWidth, 0.0f);
+    table->rayY.resize(intrinsics.height, 0.0f);
+
+    const float inverseFx = intrinsics.focalLengthX != 0.0f ? 1.0f / intrinsics.focalLengthX : 0.0f;
+    const float inverseFy = intrinsics.focalLengthY != 0.0f ? 1.0f / intrinsics.focalLengthY : 0.0f;
+    for (uint32_t x = 0; x < intrinsics.width; ++x) {
+        table->rayX[x] = (static_cast<float>(x) - intrinsics.principalPointX) * inverseFx;
+    }
+    for (uint32_t y = 0; y < intrinsics.height; ++y) {
+        table->rayY[y] = (static_cast<float>(y) - intrinsics.principalPointY) * inverseFy;
+    }
+
+    std::atomic_store(&m_rayTable, std::shared_ptr<const RayTable>(std::move(table)));
+}
+
+DepthIntrinsics DepthUnprojector::intrinsics() const
+{
+    return std::atomic_load(&m_rayTable)->intrinsics;
+}
+
+DepthIntrinsics DepthUnprojector::fromCameraIntrinsics(const CameraIntrinsics &camera,
+                                                       uint32_t depthWidth, uint32_t depthHeight)
+{
+    DepthIntrinsics intrinsics;
+    intrinsics.width = depthWidth;
+    intrinsics.height = depthHeight;
+    if (!camera.isValid || camera.resolution.x <= 0.0f || camera.resolution.y <= 0.0f) {
+        return intrinsics;
+    }
+
+    const float scaleX = static_cast<float>(depthWidth) / camera.resolution.x;
+    const float scaleY = static_cast<float>(depthHeight) / camera.resolution.y;
+    intrinsics.focalLengthX = camera.focalLengthX * scaleX;
+    intrinsics.focalLengthY = camera.focalLengthY * scaleY;
+    intrinsics.principalPointX = camera.principalPointX * scaleX;
+    intrinsics.principalPointY = camera.principalPointY * scaleY;
+    return intrinsics;
+}
+
+size_t DepthUnprojector::unproject(const SharedBuffer &depth, const Options &options, PointCloudSoA &output) const
+{
+    return unproject(depth.as<float>(), depth.count<float>(), nullptr, 0, options, output);
+}
+
+size_t DepthUnprojector::unproject(const SharedBuffer &depth, const SharedBuffer &confidence,
+                                   const Options &options, PointCloudSoA &output) const
+{
+    return unproject(depth.as<float>(), depth.count<float>(), confidence.data(), confidence.size(),
+                     options, output);
+}
+
+size_t DepthUnprojector::unproject(const float *depth, size_t depthCount, const Options &options,
+                                   PointCloudSoA &output) const
+{
+    return unproject(depth, depthCount, nullptr, 0, options, output);
+}
+
+size_t DepthUnprojector::unproject(const float *depth, size_t depthCount,
+                                   const uint8_t *confidence, size_t confidenceCount,
+                                   const Options &options, PointCloudSoA &output) const
+{
+    output.clear();
+
+    const std::shared_ptr<const RayTable> table = std::atomic_load(&m_rayTable);
+    const DepthIntrinsics &intrinsics = table->intrinsics;
+    const size_t pixelCount = static_cast<size_t>(intrinsics.width) * intrinsics.height;
+    if (!depth || pixelCount == 0 || depthCount != pixelCount) {
+        return 0;
+    }
+
+    const uint32_t step = std::max<uint32_t>(1, options.step);
+    const size_t columns = (intrinsics.width + step - 1) / step;
+    const size_t rows = (intrinsics.height + step - 1) / step;
+    output.reserve(columns * rows);
+
+    KernelInput in;
+    in.depth = depth;
+    // Карта другого разрешения не сопоставима попиксельно - распаковываем без нее
+    in.confidence = (confidence && confidenceCount == pixelCount) ? confidence : nullptr;
+    in.rayX = table->rayX.data();
+    in.rayY = table->rayY.data();
+    in.width = intrinsics.width;
+    in.height = intrinsics.height;
+    in.step = step;
+    in.minDepth = options.minDepth;
+    in.maxDepth = options.maxDepth;
+    in.minConfidence = options.minConfidence;
+    in.confidenceWeights = options.confidenceWeights;
+
+    const KernelOutput out = {output.x.data(), output.y.data(), output.z.data(), output.weight.data()};
+    if (intrinsics.width == 256 && intrinsics.height == 192) {
+        output.count = dispatchConfidence<256, 192>(in, out);
+    } else {
+        output.count = dispatchConfidence<0, 0>(in, out);
+    }
+    return output.count;
+}
+
+size_t DepthUnprojector::unprojectOrganized(const SharedBuffer &depth, const SharedBuffer &confidence,
+                                            const Options &options, OrganizedPointCloud &output) const
+{
+    return unprojectOrganized(depth.as<float>(), depth.count<float>(), confidence.data(), confidence.size(),
+                              options, output);
+}
+
+size_t DepthUnprojector::unprojectOrganized(const float *depth, size_t depthCount, const uint8_t *confidence,
+                                            size_t confidenceCount, const Options &options,
+                                            OrganizedPointCloud &output) const
+{
+    const std::shared_ptr<const RayTable> table = std::atomic_load(&m_rayTable);
+    const DepthIntrinsics &intrinsics = table->intrinsics;
+    const size_t pixelCount = static_cast<size_t>(intrinsics.width) * intrinsics.height;
+    if (!depth || pixelCount == 0 || depthCount != pixelCount) {
+        output.resize(0, 0);
+        return 0;
+    }
+
+    const uint32_t step = std::max<uint32_t>(1, options.step);
+    const uint32_t columns = (intrinsics.width + step - 1) / step;
+    const uint32_t rows = (intrinsics.height + step - 1) / step;
+    output.resize(columns, rows);
+    output.step = step;
+
+    const uint8_t *confidenceMap = (confidence && confidenceCount == pixelCount) ? confidence : nullptr;
+    size_t validCount = 0;
+    for (uint32_t v = 0; v < rows; ++v) {
+        const uint32_t y = v * step;
+        const float *row = depth + static_cast<size_t>(y) * intrinsics.width;
+        const uint8_t *confidenceRow = confidenceMap ? confidenceMap + static_cast<size_t>(y) * intrinsics.width : nullptr;
+        const float ray = table->rayY[y];
+        const size_t cellRow = static_cast<size_t>(v) * columns;
+
+        for (uint32_t u = 0; u < columns; ++u) {
+            const uint32_t x = u * step;
+            const float d = row[x];
+            bool valid = d >= options.minDepth && d <= options.maxDepth;
+            float weight = 1.0f;
+            if (confidenceRow) {
+                valid = valid && confidenceRow[x] >= options.minConfidence;
+                weight = confidenceWeight(options.confidenceWeights, confidenceRow[x]);
+            }
+
+            const size_t i = cellRow + u;
+            output.x[i] = d * table->rayX[x];
+            output.y[i] = d * ray;
+            output.z[i] = d;
+            output.weight[i] = weight;
+            output.valid[i] = valid ? 1 : 0;
+            validCount += valid ? 1 : 0;
+        }
+    }
+
+    output.validCount = validCount;
+    return validCount;
+}
+
+} // namespace LensEngine
@@ -1,17 +1,31 @@
 #include "LensEngine.h"
 #include "SpatialMappingSystem.h"
+#include "Profiler.h"
 #include <algorithm>
 #include <stdexcept>
 
 namespace LensEngine {
 
 LensEngineCore::LensEngineCore()
-    : m_initialized(false)
+    : LensEngineCore(TaskScheduler::Config())
+{
+}
+
+LensEngineCore::LensEngineCore(const TaskScheduler::Config& schedulerConfig)
+    : m_scheduler(std::make_unique<TaskScheduler>(schedulerConfig))
+    , m_initialized(false)
+    , m_rgbSequence(0)
+    , m_lidarSequence(0)
+    , m_confidenceStreamSeen(false)
 {
     m_sensorFusion = std::make_unique<SensorFusionEKF>();
     m_dataProcessor = std::make_unique<ARDataProcessor>();
     m_lidarProcessor = std::make_unique<Lidar3DProcessor>();
     m_cameraController = std::make_unique<CameraController>();
+    m_synchronizer = std::make_unique<SensorSynchronizer>();
+    
+    m_dataProcessor->setTaskScheduler(m_scheduler.get());
+    m_lidarProcessor->setTaskScheduler(m_scheduler.get());
 }
 
 LensEngineCore::~LensEngineCore()
@@ -40,77 +54,295 @@ void LensEngineCore::shutdown()
         return;
     }
     
+    stopRecording();
+    
+    // Выдаем кадры, ожидающие парные данные
+    m_synchronizer->flush();
+    flushPendingDepth();
+    
+    // Задачи пишут результаты в ядро, поэтому дожидаемся их до остановки
+    m_scheduler->waitIdle();
+    
     m_initialized = false;
 }
 
-void LensEngineCore::processRGBData(const uint8_t* data, size_t size, uint32_t width, uint32_t height, uint64_t timestamp)
+uint64_t LensEngineCore::processRGBData(const uint8_t* data, size_t size, uint32_t width, uint32_t height, uint64_t timestamp)
 {
-    RGBImage rgbImage;
-    rgbImage.data.assign(data, data + size);
-    rgbImage.width = width;
-    rgbImage.height = height;
-    rgbImage.timestamp = timestamp;
-    
-    // Обработка через ARDataProcessor
+    return processRGBData(SharedBuffer::copy(data, size), width, height, 0, timestamp);
+}
+
+uint64_t LensEngineCore::processRGBData(const SharedBuffer& image, uint32_t width, uint32_t height, uint32_t stride, uint64_t timestamp)
+{
+    // Кадр уходит в синхронизатор, который дополнит его глубиной и IMU
     ARFrame frame;
-    frame.rgbImage = rgbImage;
+    frame.rgbImage.data = image;
+    frame.rgbImage.width = width;
+    frame.rgbImage.height = height;
+    frame.rgbImage.stride = stride;
+    frame.rgbImage.timestamp = timestamp;
     frame.timestamp = timestamp;
+    frame.sequenceNumber = ++m_rgbSequence;
+    LENSENGINE_TRACE_FRAME("Core::ingestRGB", frame.sequenceNumber);
     
-    // Получаем текущую позу от IMU
-    frame.cameraPose = m_sensorFusion->getCurrentPose();
-    
-    // Обрабатываем кадр асинхронно
-    m_dataProcessor->processFrameAsync(frame);
+    if (auto recorder = std::atomic_load(&m_recorder)) {
+        recorder->writeRGB(image, width, height, stride, timestamp);
+    }
     
-    // Обновляем данные
-    std::lock_guard<std::mutex> lock(m_dataMutex);
-    m_featurePoints = m_dataProcessor->extractFeaturePoints(rgbImage);
-    m_intrinsics = m_dataProcessor->estimateCameraIntrinsics(rgbImage);
-    m_lightEstimation = m_dataProcessor->estimateLight(rgbImage);
+    // Анализ кадра выполняется только асинхронно, результаты приходят через колбэки
+    const uint64_t sequenceNumber = frame.sequenceNumber;
+    m_synchronizer->pushRGB(frame);
+    return sequenceNumber;
 }
 
 void LensEngineCore::processLidarData(const uint8_t* depthData, size_t depthSize, 
                                        const uint8_t* confidenceData, size_t confidenceSize, uint64_t timestamp)
 {
-    std::vector<uint8_t> depthVec(depthData, depthData + depthSize);
-    std::vector<uint8_t> confidenceVec(confidenceData, confidenceData + confidenceSize);
+    processLidarData(SharedBuffer::copy(depthData, depthSize),
+                     SharedBuffer::copy(confidenceData, confidenceSize), timestamp);
+}
+
+void LensEngineCore::processLidarData(const SharedBuffer& depth, const SharedBuffer& confidence, uint64_t timestamp,
+                                      uint64_t deviceFrame)
+{
+    if (auto recorder = std::atomic_load(&m_recorder)) {
+        recorder->writeDepth(depth, confidence, timestamp);
+    }
+    
+    LidarData lidar;
+    lidar.depthMap = depth;
+    lidar.confidenceMap = confidence;
+    lidar.sequenceNumber = ++m_lidarSequence;
+    lidar.timestamp = timestamp;
+    m_synchronizer->pushDepth(lidar);
     
-    m_lidarProcessor->processLidarDataAsync(depthVec, confidenceVec);
+    // Уверенность пришла вместе с глубиной или отдельного потока нет - обрабатываем сразу
+    if (!confidence.empty()) {
+        m_lidarProcessor->processLidarDataAsync(depth, confidence, lidar.sequenceNumber);
+        return;
+    }
+    
+    PendingConfidence matched;
+    bool hasMatched = false;
+    std::vector<PendingConfidence> orphaned;
+    LidarData stale;
+    bool hasStale = false;
+    bool deferred = false;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingDepthMutex);
+        if (m_confidenceStreamSeen) {
+            // Уверенность этого кадра могла прийти раньше глубины. Более старая
+            // уже не найдет пару (номера и время в потоке LiDAR растут)
+            while (!m_pendingConfidence.empty() &&
+                   isEarlierLidarFrame(m_pendingConfidence.front().deviceFrame, m_pendingConfidence.front().timestamp,
+                                       deviceFrame, timestamp)) {
+                orphaned.push_back(std::move(m_pendingConfidence.front()));
+                m_pendingConfidence.pop_front();
+            }
+            if (!m_pendingConfidence.empty() &&
+                isSameLidarFrame(m_pendingConfidence.front().deviceFrame, m_pendingConfidence.front().timestamp,
+                                 deviceFrame, timestamp)) {
+                matched = std::move(m_pendingConfidence.front());
+                m_pendingConfidence.pop_front();
+                hasMatched = true;
+            } else {
+                // Самая старая глубина так и не получила уверенность - отдаем ее без маски
+                if (m_pendingDepth.size() >= kMaxPendingDepth) {
+                    stale = std::move(m_pendingDepth.front().lidar);
+                    m_pendingDepth.pop_front();
+                    hasStale = true;
+                }
+                m_pendingDepth.push_back(PendingDepth{lidar, deviceFrame});
+                deferred = true;
+            }
+        }
+    }
+    
+    // Уверенность без своей глубины идет в синхронизатор без номера кадра
+    for (const PendingConfidence &confidence : orphaned) {
+        m_synchronizer->pushConfidence(confidence.confidence, 0, confidence.timestamp);
+    }
+    if (hasMatched) {
+        m_synchronizer->pushConfidence(matched.confidence, lidar.sequenceNumber, matched.timestamp);
+    }
+    if (hasStale) {
+        m_lidarProcessor->processLidarDataAsync(stale.depthMap, SharedBuffer(), stale.sequenceNumber);
+    }
+    if (!deferred) {
+        m_lidarProcessor->processLidarDataAsync(depth, matched.confidence, lidar.sequenceNumber);
+    }
+}
+
+void LensEngineCore::processLidarConfidence(const uint8_t* confidenceData, size_t confidenceSize, uint64_t timestamp)
+{
+    processLidarConfidence(SharedBuffer::copy(confidenceData, confidenceSize), timestamp);
+}
+
+void LensEngineCore::processLidarConfidence(const SharedBuffer& confidence, uint64_t timestamp, uint64_t deviceFrame)
+{
+    if (auto recorder = std::atomic_load(&m_recorder)) {
+        recorder->writeConfidence(confidence, timestamp);
+    }
+    
+    // Уверенность относится к глубине того же кадра: распаковываем их вместе.
+    // Более старая ожидающая глубина уже не получит пару и уходит без маски
+    std::vector<LidarData> unmatched;
+    LidarData pending;
+    bool hasPending = false;
+    PendingConfidence evicted;
+    bool hasEvicted = false;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingDepthMutex);
+        m_confidenceStreamSeen = true;
+        while (!m_pendingDepth.empty() &&
+               isEarlierLidarFrame(m_pendingDepth.front().deviceFrame, m_pendingDepth.front().lidar.timestamp,
+                                   deviceFrame, timestamp)) {
+            unmatched.push_back(std::move(m_pendingDepth.front().lidar));
+            m_pendingDepth.pop_front();
+        }
+        if (!m_pendingDepth.empty() &&
+            isSameLidarFrame(m_pendingDepth.front().deviceFrame, m_pendingDepth.front().lidar.timestamp,
+                             deviceFrame, timestamp)) {
+            pending = std::move(m_pendingDepth.front().lidar);
+            m_pendingDepth.pop_front();
+            hasPending = true;
+        } else {
+            // Глубина этого кадра еще не пришла: номер кадра будет известен с ней
+            if (m_pendingConfidence.size() >= kMaxPendingDepth) {
+                evicted = std::move(m_pendingConfidence.front());
+                m_pendingConfidence.pop_front();
+                hasEvicted = true;
+            }
+            m_pendingConfidence.push_back(PendingConfidence{confidence, timestamp, deviceFrame});
+        }
+    }
+    
+    if (hasEvicted) {
+        m_synchronizer->pushConfidence(evicted.confidence, 0, evicted.timestamp);
+    }
+    if (hasPending) {
+        m_synchronizer->pushConfidence(confidence, pending.sequenceNumber, timestamp);
+    }
+    for (const LidarData &lidar : unmatched) {
+        m_lidarProcessor->processLidarDataAsync(lidar.depthMap, SharedBuffer(), lidar.sequenceNumber);
+    }
+    if (hasPending) {
+        m_lidarProcessor->processLidarDataAsync(pending.depthMap, confidence, pending.sequenceNumber);
+    }
+}
+
+void LensEngineCore::flushPendingDepth()
+{
+    std::deque<PendingDepth> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingDepthMutex);
+        pending.swap(m_pendingDepth);
+        m_pendingConfidence.clear();
+    }
+    for (const PendingDepth &entry : pending) {
+        m_lidarProcessor->processLidarDataAsync(entry.lidar.depthMap, SharedBuffer(), entry.lidar.sequenceNumber);
+    }
+}
+
+bool LensEngineCore::isSameLidarFrame(uint64_t frameA, uint64_t timestampA, uint64_t frameB, uint64_t timestampB)
+{
+    if (frameA != 0 && frameB != 0) {
+        return frameA == frameB;
+    }
+    return (timestampA > timestampB ? timestampA - timestampB : timestampB - timestampA) <= kConfidenceMatchTolerance;
+}
+
+bool LensEngineCore::isEarlierLidarFrame(uint64_t frameA, uint64_t timestampA, uint64_t frameB, uint64_t timestampB)
+{
+    if (frameA != 0 && frameB != 0) {
+        return frameA < frameB;
+    }
+    return timestampA + kConfidenceMatchTolerance < timestampB;
 }
 
 void LensEngineCore::processIMUData(const RawIMUData& imuData)
 {
+    if (auto recorder = std::atomic_load(&m_recorder)) {
+        recorder->writeIMU(imuData);
+    }
     m_sensorFusion->updateIMU(imuData);
+    m_synchronizer->pushIMU(imuData);
+    
+    // Гравитация в осях устройства (x вправо, y вверх, z к пользователю) в осях
+    // камеры глубины (x вправо, y вниз, z вперед)
+    m_lidarProcessor->setGravityDirection(glm::vec3(static_cast<float>(imuData.gravityX),
+                                                    static_cast<float>(-imuData.gravityY),
+                                                    static_cast<float>(-imuData.gravityZ)));
+}
+
+void LensEngineCore::onSynchronizedFrame(const ARFrame& frame)
+{
+    LENSENGINE_TRACE_FRAME("Core::dispatchFrame", frame.sequenceNumber);
+    ARFrame synchronizedFrame = frame;
+    
+    // Поза на момент выдачи кадра (IMU сэмплы до кадра уже учтены фьюжном)
+    synchronizedFrame.cameraPose = m_currentPose.load();
+    
+    // Обрабатываем кадр асинхронно
+    if (!m_dataProcessor->processFrameAsync(synchronizedFrame)) {
+        completeFrame(synchronizedFrame.sequenceNumber, FrameStatus::DroppedBusy, synchronizedFrame);
+    }
+}
+
+void LensEngineCore::completeFrame(uint64_t sequenceNumber, FrameStatus status, const ARFrame& frame)
+{
+    if (m_frameCompletedCallback) {
+        m_frameCompletedCallback(sequenceNumber, status, frame);
+    }
 }
 
 CameraPose LensEngineCore::getCurrentCameraPose() const
 {
-    std::lock_guard<std::mutex> lock(m_dataMutex);
-    return m_currentPose;
+    return m_currentPose.load();
 }
 
 std::vector<FeaturePoint> LensEngineCore::getFeaturePoints() const
 {
-    std::lock_guard<std::mutex> lock(m_dataMutex);
-    return m_featurePoints;
+    return m_featurePoints.get();
 }
 
 std::vector<glm::vec3> LensEngineCore::getLidarPoints() const
 {
-    std::lock_guard<std::mutex> lock(m_dataMutex);
-    return m_lidarPoints;
+    return m_lidarPoints.get();
 }
 
 CameraIntrinsics LensEngineCore::getCameraIntrinsics() const
 {
-    std::lock_guard<std::mutex> lock(m_dataMutex);
-    return m_intrinsics;
+    return m_intrinsics.load();
 }
 
 LightEstimation LensEngineCore::getLightEstimation() const
 {
-    std::lock_guard<std::mutex> lock(m_dataMutex);
-    return m_lightEstimation;
+    return m_lightEstimation.load();
+}
+
+SnapshotStore<std::vector<FeaturePoint>>::Snapshot LensEngineCore::getFeaturePointsSnapshot() const
+{
+    return m_featurePoints.load();
+}
+
+SnapshotStore<std::vector<glm::vec3>>::Snapshot LensEngineCore::getLidarPointsSnapshot() const
+{
+    return m_lidarPoints.load();
+}
+
+uint64_t LensEngineCore::getMeshVersion() const
+{
+    return m_dataProcessor->getMeshVersion();
+}
+
+bool LensEngineCore::raycast(const MeshRaycaster::Ray& ray, MeshRaycaster::Hit& hit) const
+{
+    return m_dataProcessor->raycast(ray, hit);
+}
+
+void LensEngineCore::raycast(const std::vector<MeshRaycaster::Ray>& rays, std::vector<MeshRaycaster::Hit>& hits) const
+{
+    m_dataProcessor->raycast(rays, hits);
 }
 
 void LensEngineCore::setNoiseParameters(double gyroNoise, double accelNoise, double visualNoise, double lidarNoise)
@@ -120,20 +352,117 @@ void LensEngineCore::setNoiseParameters(double gyroNoise, double accelNoise, dou
 
 void LensEngineCore::setCameraParameters(float focalLengthX, float focalLengthY, float principalPointX, float principalPointY)
 {
-    std::lock_guard<std::mutex> lock(m_dataMutex);
-    m_intrinsics.focalLengthX = focalLengthX;
-    m_intrinsics.focalLengthY = focalLengthY;
-    m_intrinsics.principalPointX = principalPointX;
-    m_intrinsics.principalPointY = principalPointY;
-    m_intrinsics.isValid = true;
+    m_intrinsics.update([&](CameraIntrinsics& intrinsics) {
+        intrinsics.focalLengthX = focalLengthX;
+        intrinsics.focalLengthY = focalLengthY;
+        intrinsics.principalPointX = principalPointX;
+        intrinsics.principalPointY = principalPointY;
+        intrinsics.isValid = true;
+    });
+}
+
+void LensEngineCore::setDepthIntrinsics(const DepthIntrinsics& intrinsics)
+{
+    m_lidarProcessor->setDepthIntrinsics(intrinsics);
+    m_dataProcessor->setDepthIntrinsics(intrinsics);
+}
+
+DepthIntrinsics LensEngineCore::getDepthIntrinsics() const
+{
+    return m_lidarProcessor->getDepthIntrinsics();
+}
+
+void LensEngineCore::setLidarMinimumConfidence(uint8_t level)
+{
+    m_lidarProcessor->setMinimumConfidence(level);
+}
+
+void LensEngineCore::setLidarPointBudget(size_t points)
+{
+    m_lidarProcessor->setPointBudget(points);
+}
+
+void LensEngineCore::setLidarFilterOptions(const VoxelGridFilter::Options& options)
+{
+    m_lidarProcessor->setVoxelFilterOptions(options);
+}
+
+VoxelGridFilter::Statistics LensEngineCore::getLidarFilterStatistics() const
+{
+    return m_lidarProcessor->getLastFilterStatistics();
+}
+
+void LensEngineCore::setLidarTemporalFilterOptions(const DepthTemporalFilter::Options& options)
+{
+    m_lidarProcessor->setTemporalFilterOptions(options);
+}
+
+void LensEngineCore::setLidarOdometryOptions(const DepthOdometry::Options& options)
+{
+    m_lidarProcessor->setOdometryOptions(options);
+}
+
+void LensEngineCore::setSynchronizerConfig(const SensorSynchronizer::Config& config)
+{
+    m_synchronizer->setConfig(config);
+}
+
+SensorSynchronizer::Statistics LensEngineCore::getSynchronizerStatistics() const
+{
+    return m_synchronizer->getStatistics();
+}
+
+TaskScheduler& LensEngineCore::taskScheduler()
+{
+    return *m_scheduler;
+}
+
+bool LensEngineCore::startRecording(const std::string& path)
+{
+    auto recorder = std::make_shared<SensorRecordWriter>();
+    if (!recorder->open(path)) {
+        return false;
+    }
+    
+    // Предыдущая запись закрывается, когда ее отпустит последний приемник данных
+    std::atomic_store(&m_recorder, std::move(recorder));
+    return true;
+}
+
+void LensEngineCore::stopRecording()
+{
+    std::atomic_store(&m_recorder, std::shared_ptr<SensorRecordWriter>());
+}
+
+bool LensEngineCore::isRecording() const
+{
+    return std::atomic_load(&m_recorder) != nullptr;
+}
+
+BatchProcessor::Result LensEngineCore::runBatch(const std::string& recordingPath, const BatchProcessor::Options& options)
+{
+    BatchProcessor processor(*m_scheduler);
+    return processor.run(recordingPath, options);
 }
 
 void LensEngineCore::setupCallbacks()
 {
-    // Настройка колбэков для обновления данных
+    // Синхронизированные кадры (RGB + ближайшая глубина + IMU)
+    m_synchronizer->setFrameCallback([this](const ARFrame& frame) {
+        onSynchronizedFrame(frame);
+    });
+    m_synchronizer->setDropCallback([this](uint64_t sequenceNumber, uint64_t timestamp) {
+        ARFrame dropped;
+        dropped.sequenceNumber = sequenceNumber;
+        dropped.timestamp = timestamp;
+        completeFrame(sequenceNumber, FrameStatus::DroppedUnsynchronized, dropped);
+    });
+    
+    // Настройка колбэков для обновления данных: сначала публикуем снимок,
+    // внешние колбэки вызываются вне блокировок
     m_sensorFusion->setPoseCallback([this](const CameraPose& pose) {
-        std::lock_guard<std::mutex> lock(m_dataMutex);
-        m_currentPose = pose;
+        m_currentPose.store(pose);
+        m_lidarProcessor->setCameraPose(pose);
         
         // Обновляем контроллер камеры
         if (m_cameraController) {
@@ -147,19 +476,26 @@ void LensEngineCore::setupCallbacks()
     });
     
     m_lidarProcessor->setPointsCallback([this](const std::vector<glm::vec3>& points) {
-        std::lock_guard<std::mutex> lock(m_dataMutex);
-        m_lidarPoints = points;
+        m_lidarPoints.store(points);
         
         // Вызываем внешний колбэк
         if (m_lidarPointsCallback) {
             m_lidarPointsCallback(points);
         }
     });
+
+    // Относительная поза по глубине - мера для фильтра (якорь переставляется и при сбое ICP)
+    m_lidarProcessor->setOdometryCallback([this](const RelativePoseMeasurement& measurement) {
+        m_sensorFusion->updateOdometry(measurement);
+    });
+    
+    // Настройка колбэков от ARDataProcessor (результаты публикуются до события завершения кадра)
+    m_dataProcessor->setFrameProcessedCallback([this](const ARFrame& frame) {
+        completeFrame(frame.sequenceNumber, FrameStatus::Processed, frame);
+    });
     
-    // Настройка колбэков от ARDataProcessor
     m_dataProcessor->setFeaturePointsCallback([this](const std::vector<FeaturePoint>& points) {
-        std::lock_guard<std::mutex> lock(m_dataMutex);
-        m_featurePoints = points;
+        m_featurePoints.store(points);
         
         // Вызываем внешний колбэк
         if (m_featurePointsCallback) {
@@ -168,13 +504,11 @@ void LensEngineCore::setupCallbacks()
     });
     
     m_dataProcessor->setIntrinsicsCallback([this](const CameraIntrinsics& intrinsics) {
-        std::lock_guard<std::mutex> lock(m_dataMutex);
-        m_intrinsics = intrinsics;
+        m_intrinsics.store(intrinsics);
     });
     
     m_dataProcessor->setLightCallback([this](const LightEstimation& light) {
-        std::lock_guard<std::mutex> lock(m_dataMutex);
-        m_lightEstimation = light;
+        m_lightEstimation.store(light);
     });
 }
 
@@ -193,5 +527,10 @@ void LensEngineCore::setLidarPointsCallback(std::function<void(const std::vector
     m_lidarPointsCallback = callback;
 }
 
+void LensEngineCore::setFrameCompletedCallback(std::function<void(uint64_t, FrameStatus, const ARFrame&)> callback)
+{
+    m_frameCompletedCallback = callback;
+}
+
 } // namespace LensEngine
 
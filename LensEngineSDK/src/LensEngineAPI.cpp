@@ -9,6 +9,11 @@ LensEngineAPI::LensEngineAPI()
 {
 }
 
+LensEngineAPI::LensEngineAPI(const TaskScheduler::Config& schedulerConfig)
+    : m_core(std::make_unique<LensEngineCore>(schedulerConfig))
+{
+}
+
 LensEngineAPI::~LensEngineAPI()
 {
     shutdown();
@@ -24,9 +29,9 @@ void LensEngineAPI::shutdown()
     m_core->shutdown();
 }
 
-void LensEngineAPI::processRGBData(const uint8_t* data, size_t size, uint32_t width, uint32_t height, uint64_t timestamp)
+uint64_t LensEngineAPI::processRGBData(const uint8_t* data, size_t size, uint32_t width, uint32_t height, uint64_t timestamp)
 {
-    m_core->processRGBData(data, size, width, height, timestamp);
+    return m_core->processRGBData(data, size, width, height, timestamp);
 }
 
 void LensEngineAPI::processLidarData(const uint8_t* depthData, size_t depthSize, 
@@ -35,11 +40,32 @@ void LensEngineAPI::processLidarData(const uint8_t* depthData, size_t depthSize,
     m_core->processLidarData(depthData, depthSize, confidenceData, confidenceSize, timestamp);
 }
 
+void LensEngineAPI::processLidarConfidence(const uint8_t* confidenceData, size_t confidenceSize, uint64_t timestamp)
+{
+    m_core->processLidarConfidence(confidenceData, confidenceSize, timestamp);
+}
+
 void LensEngineAPI::processIMUData(const RawIMUData& imuData)
 {
     m_core->processIMUData(imuData);
 }
 
+uint64_t LensEngineAPI::processRGBData(const SharedBuffer& image, uint32_t width, uint32_t height, uint32_t stride, uint64_t timestamp)
+{
+    return m_core->processRGBData(image, width, height, stride, timestamp);
+}
+
+void LensEngineAPI::processLidarData(const SharedBuffer& depth, const SharedBuffer& confidence, uint64_t timestamp,
+                                     uint64_t deviceFrame)
+{
+    m_core->processLidarData(depth, confidence, timestamp, deviceFrame);
+}
+
+void LensEngineAPI::processLidarConfidence(const SharedBuffer& confidence, uint64_t timestamp, uint64_t deviceFrame)
+{
+    m_core->processLidarConfidence(confidence, timestamp, deviceFrame);
+}
+
 CameraPose LensEngineAPI::getCurrentCameraPose() const
 {
     return m_core->getCurrentCameraPose();
@@ -65,6 +91,31 @@ LightEstimation LensEngineAPI::getLightEstimation() const
     return m_core->getLightEstimation();
 }
 
+LensEngineAPI::FeaturePointsSnapshot LensEngineAPI::getFeaturePointsSnapshot() const
+{
+    return m_core->getFeaturePointsSnapshot();
+}
+
+LensEngineAPI::LidarPointsSnapshot LensEngineAPI::getLidarPointsSnapshot() const
+{
+    return m_core->getLidarPointsSnapshot();
+}
+
+uint64_t LensEngineAPI::getMeshVersion() const
+{
+    return m_core->getMeshVersion();
+}
+
+bool LensEngineAPI::raycast(const Ray& ray, RaycastHit& hit) const
+{
+    return m_core->raycast(ray, hit);
+}
+
+void LensEngineAPI::raycast(const std::vector<Ray>& rays, std::vector<RaycastHit>& hits) const
+{
+    m_core->raycast(rays, hits);
+}
+
 void LensEngineAPI::setPoseCallback(PoseCallback callback)
 {
     m_poseCallback = callback;
@@ -83,6 +134,12 @@ void LensEngineAPI::setLidarPointsCallback(LidarPointsCallback callback)
     m_core->setLidarPointsCallback(callback);
 }
 
+void LensEngineAPI::setFrameCompletedCallback(FrameCompletedCallback callback)
+{
+    m_frameCompletedCallback = callback;
+    m_core->setFrameCompletedCallback(callback);
+}
+
 void LensEngineAPI::setNoiseParameters(double gyroNoise, double accelNoise, double visualNoise, double lidarNoise)
 {
     m_core->setNoiseParameters(gyroNoise, accelNoise, visualNoise, lidarNoise);
@@ -93,5 +150,105 @@ void LensEngineAPI::setCameraParameters(float focalLengthX, float focalLengthY,
     m_core->setCameraParameters(focalLengthX, focalLengthY, principalPointX, principalPointY);
 }
 
+void LensEngineAPI::setDepthIntrinsics(const DepthIntrinsics& intrinsics)
+{
+    m_core->setDepthIntrinsics(intrinsics);
+}
+
+DepthIntrinsics LensEngineAPI::getDepthIntrinsics() const
+{
+    return m_core->getDepthIntrinsics();
+}
+
+void LensEngineAPI::setLidarMinimumConfidence(uint8_t level)
+{
+    m_core->setLidarMinimumConfidence(level);
+}
+
+void LensEngineAPI::setLidarPointBudget(size_t points)
+{
+    m_core->setLidarPointBudget(points);
+}
+
+void LensEngineAPI::setLidarFilterOptions(const VoxelGridFilter::Options& options)
+{
+    m_core->setLidarFilterOptions(options);
+}
+
+VoxelGridFilter::Statistics LensEngineAPI::getLidarFilterStatistics() const
+{
+    return m_core->getLidarFilterStatistics();
+}
+
+void LensEngineAPI::setLidarTemporalFilterOptions(const DepthTemporalFilter::Options& options)
+{
+    m_core->setLidarTemporalFilterOptions(options);
+}
+
+void LensEngineAPI::setLidarOdometryOptions(const DepthOdometry::Options& options)
+{
+    m_core->setLidarOdometryOptions(options);
+}
+
+void LensEngineAPI::setSynchronizerConfig(const SensorSynchronizer::Config& config)
+{
+    m_core->setSynchronizerConfig(config);
+}
+
+SensorSynchronizer::Statistics LensEngineAPI::getSynchronizerStatistics() const
+{
+    return m_core->getSynchronizerStatistics();
+}
+
+void LensEngineAPI::setTracingEnabled(bool enabled)
+{
+    Profiler::instance().setEnabled(enabled);
+}
+
+bool LensEngineAPI::isTracingEnabled() const
+{
+    return Profiler::instance().isEnabled();
+}
+
+std::string LensEngineAPI::exportChromeTrace() const
+{
+    return Profiler::instance().exportChromeTrace();
+}
+
+bool LensEngineAPI::writeChromeTrace(const std::string& path) const
+{
+    return Profiler::instance().writeChromeTrace(path);
+}
+
+std::vector<Profiler::StageSummary> LensEngineAPI::getStageSummaries() const
+{
+    return Profiler::instance().getStageSummaries();
+}
+
+void LensEngineAPI::clearTrace()
+{
+    Profiler::instance().clear();
+}
+
+bool LensEngineAPI::startRecording(const std::string& path)
+{
+    return m_core->startRecording(path);
+}
+
+void LensEngineAPI::stopRecording()
+{
+    m_core->stopRecording();
+}
+
+bool LensEngineAPI::isRecording() const
+{
+    return m_core->isRecording();
+}
+
+LensEngineAPI::BatchResult LensEngineAPI::runBatch(const std::string& recordingPath, const BatchOptions& options)
+{
+    return m_core->runBatch(recordingPath, options);
+}
+
 } // namespace LensEngine
 
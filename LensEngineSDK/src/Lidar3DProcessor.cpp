@@ -1,106 +1,314 @@
 #include "Lidar3DProcessor.h"
 #include <algorithm>
 #include <cmath>
-#include <random>
-#include <future>
+#include <limits>
 
 namespace LensEngine {
 
 Lidar3DProcessor::Lidar3DProcessor()
-    : m_cancelProcessing(false)
+    : m_gravity(glm::vec3(0, 1, 0))      // Оси камеры глубины: y вниз, устройство вертикально
+    , m_frames(3)
+    , m_minConfidence(1)
+    , m_pointBudget(3072)
+    , m_scheduler(nullptr)
+    , m_hasPendingFrame(false)
+    , m_jobRunning(false)
+    , m_cancelledInRow(0)
 {
 }
 
 Lidar3DProcessor::~Lidar3DProcessor()
 {
     stopProcessing();
+    TaskScheduler::TaskHandle task;
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        task = m_processingTask;
+    }
+    task.join();
+}
+
+void Lidar3DProcessor::setTaskScheduler(TaskScheduler* scheduler)
+{
+    TaskScheduler::TaskHandle task;
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        task = m_processingTask;
+    }
+    task.join();
+    m_scheduler = scheduler;
 }
 
 void Lidar3DProcessor::stopProcessing()
 {
-    m_cancelProcessing = true;
+    // Ожидающая карта отбрасывается, идущая прервется по своему токену
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    m_activeToken.cancel();
+    m_pendingFrame = PendingFrame();
+    m_hasPendingFrame = false;
 }
 
-std::vector<glm::vec3> Lidar3DProcessor::processDepthData(const std::vector<uint8_t> &depthData)
+void Lidar3DProcessor::setDepthIntrinsics(const DepthIntrinsics &intrinsics)
 {
-    if (depthData.size() != 256 * 192 * sizeof(float)) {
-        return std::vector<glm::vec3>();
-    }
+    m_unprojector.setIntrinsics(intrinsics);
+}
 
-    const float* depthValues = reinterpret_cast<const float*>(depthData.data());
-    const int width = 256;
-    const int height = 192;
+DepthIntrinsics Lidar3DProcessor::getDepthIntrinsics() const
+{
+    return m_unprojector.intrinsics();
+}
 
-    std::vector<glm::vec3> points;
-    points.reserve((width * height) / 4);
+void Lidar3DProcessor::setMinimumConfidence(uint8_t level)
+{
+    m_minConfidence = level;
+}
 
-    // Оптимизированная обработка каждого 2-го пикселя
-    for (int y = 0; y < height; y += 2) {
-        for (int x = 0; x < width; x += 2) {
-            int index = y * width + x;
-            float depth = depthValues[index];
+uint8_t Lidar3DProcessor::getMinimumConfidence() const
+{
+    return m_minConfidence;
+}
 
-            if (depth >= m_minDepth && depth <= m_maxDepth && !std::isnan(depth)) {
-                glm::vec3 point = depthToWorldSpace(x, y, depth);
-                points.push_back(point);
-            }
-        }
-    }
+void Lidar3DProcessor::setPointBudget(size_t points)
+{
+    m_pointBudget = std::max<size_t>(1, points);
+}
 
-    return points;
+size_t Lidar3DProcessor::getPointBudget() const
+{
+    return m_pointBudget;
 }
 
-std::vector<glm::vec3> Lidar3DProcessor::processDepthDataFast(const std::vector<uint8_t> &depthData)
+void Lidar3DProcessor::setGravityDirection(const glm::vec3 &gravity)
 {
-    if (depthData.size() != 256 * 192 * sizeof(float)) {
-        return std::vector<glm::vec3>();
+    // Нулевой вектор - IMU без оценки гравитации, оставляем прежнее направление
+    const float length = glm::length(gravity);
+    if (length > 1e-3f) {
+        m_gravity.store(gravity / length);
     }
+}
 
-    const float* depthValues = reinterpret_cast<const float*>(depthData.data());
-    const int width = 256;
-    const int height = 192;
+glm::vec3 Lidar3DProcessor::getGravityDirection() const
+{
+    return m_gravity.load();
+}
+
+void Lidar3DProcessor::setCameraPose(const CameraPose &pose)
+{
+    m_cameraPose.store(pose);
+}
 
-    std::vector<glm::vec3> points;
-    points.reserve((width * height) / 16);
+void Lidar3DProcessor::setTemporalFilterOptions(const DepthTemporalFilter::Options &options)
+{
+    m_temporalOptions.store(options);
+}
+
+DepthTemporalFilter::Options Lidar3DProcessor::getTemporalFilterOptions() const
+{
+    return m_temporalOptions.load();
+}
+
+void Lidar3DProcessor::setOdometryOptions(const DepthOdometry::Options &options)
+{
+    m_odometryOptions.store(options);
+}
+
+DepthOdometry::Options Lidar3DProcessor::getOdometryOptions() const
+{
+    return m_odometryOptions.load();
+}
+
+void Lidar3DProcessor::setVoxelFilterOptions(const VoxelGridFilter::Options &options)
+{
+    m_filterOptions.store(options);
+}
+
+VoxelGridFilter::Options Lidar3DProcessor::getVoxelFilterOptions() const
+{
+    return m_filterOptions.load();
+}
+
+VoxelGridFilter::Statistics Lidar3DProcessor::getLastFilterStatistics() const
+{
+    return m_filterStatistics.load();
+}
+
+void Lidar3DProcessor::setObstacleOptions(const ObstacleClusterer::Options &options)
+{
+    m_obstacleOptions.store(options);
+}
+
+ObstacleClusterer::Options Lidar3DProcessor::getObstacleOptions() const
+{
+    return m_obstacleOptions.load();
+}
+
+DepthUnprojector::Options Lidar3DProcessor::fastUnprojectOptions() const
+{
+    // Рабочий диапазон LiDAR; плотность задает бюджет точек
+    DepthUnprojector::Options options;
+    options.minDepth = 0.15f;
+    options.maxDepth = 5.0f;
+    options.minConfidence = m_minConfidence;
+    return options;
+}
+
+size_t Lidar3DProcessor::unprojectWithBudget(DepthPyramid &pyramid, const float *depth, size_t depthCount,
+                                             const uint8_t *confidence, size_t confidenceCount,
+                                             const DepthUnprojector::Options &options, size_t pointBudget,
+                                             PointCloudSoA &points) const
+{
+    DepthPyramid::Options pyramidOptions = pyramid.options();
+    pyramidOptions.minDepth = options.minDepth;
+    pyramidOptions.maxDepth = options.maxDepth;
+    pyramidOptions.minConfidence = options.minConfidence;
+    pyramid.setOptions(pyramidOptions);
+    pyramid.build(depth, depthCount, confidence, confidenceCount, m_unprojector.intrinsics());
+
+    const size_t level = pyramid.levelForBudget(pointBudget);
+    pyramid.unproject(level, options, points);
+    return level;
+}
+
+std::vector<glm::vec3> Lidar3DProcessor::processDepthData(const SharedBuffer &depthData)
+{
+    // Четверть пикселей карты; буферы свои у каждого потока, вызывать можно параллельно
+    thread_local DepthPyramid pyramid;
+    thread_local PointCloudSoA points;
+    DepthUnprojector::Options options;
+    options.minDepth = m_minDepth;
+    options.maxDepth = m_maxDepth;
+    unprojectWithBudget(pyramid, depthData.as<float>(), depthData.count<float>(), nullptr, 0, options,
+                        depthData.count<float>() / 4, points);
+    return points.toVec3();
+}
+
+std::vector<glm::vec3> Lidar3DProcessor::processDepthDataFast(const SharedBuffer &depthData)
+{
+    return processDepthDataFast(depthData, SharedBuffer());
+}
+
+std::vector<glm::vec3> Lidar3DProcessor::processDepthDataFast(const SharedBuffer &depthData,
+                                                              const SharedBuffer &confidenceData,
+                                                              std::vector<float> *weights,
+                                                              std::vector<glm::vec3> *normals,
+                                                              OrganizedPointCloud *grid,
+                                                              DepthIntrinsics *gridIntrinsics)
+{
+    return processDepthData(depthData, confidenceData, m_pointBudget, weights, normals, grid, gridIntrinsics);
+}
 
-    for (int y = 0; y < height; y += 4) {
-        for (int x = 0; x < width; x += 4) {
-            int index = y * width + x;
-            float depth = depthValues[index];
+std::vector<glm::vec3> Lidar3DProcessor::processDepthData(const SharedBuffer &depthData,
+                                                          const SharedBuffer &confidenceData,
+                                                          size_t pointBudget,
+                                                          std::vector<float> *weights,
+                                                          std::vector<glm::vec3> *normals,
+                                                          OrganizedPointCloud *grid,
+                                                          DepthIntrinsics *gridIntrinsics)
+{
+    const DepthUnprojector::Options options = fastUnprojectOptions();
+    thread_local DepthPyramid pyramid;
+    thread_local PointCloudSoA points;
+    const size_t level = unprojectWithBudget(pyramid, depthData.as<float>(), depthData.count<float>(),
+                                             confidenceData.data(), confidenceData.size(), options,
+                                             pointBudget, points);
+    if (weights) {
+        *weights = points.weights();
+    }
+    if (normals || grid) {
+        // Ячейки уровня в порядке строк совпадают с точками плоской распаковки
+        thread_local OrganizedPointCloud localGrid;
+        thread_local IntegralNormalEstimator estimator;
+        OrganizedPointCloud &target = grid ? *grid : localGrid;
+        pyramid.unprojectOrganized(level, options, target);
+        estimator.compute(target);
+        if (normals) {
+            target.gatherNormals(*normals);
+        }
+    }
+    if (gridIntrinsics && level < pyramid.levelCount()) {
+        *gridIntrinsics = pyramid.level(level).intrinsics;
+    }
+    return points.toVec3();
+}
 
-            if (depth >= 0.15f && depth <= 5.0f && !std::isnan(depth)) {
-                glm::vec3 point = depthToWorldSpace(x, y, depth);
-                points.push_back(point);
-            }
+bool Lidar3DProcessor::processLidarDataAsync(const SharedBuffer &depthData, 
+                                              const SharedBuffer &confidenceData,
+                                              uint64_t sequenceNumber)
+{
+    PendingFrame frame;
+    frame.depth = depthData;
+    frame.confidence = confidenceData;
+    frame.sequenceNumber = sequenceNumber;
+
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    if (m_jobRunning) {
+        // Идущий кадр устарел; новый подхватит та же задача, когда прерванный выйдет.
+        // Если подряд прерваны уже несколько кадров, текущий дорабатывает
+        if (m_cancelledInRow < kMaxCancelledInRow && !m_activeToken.isCancelled()) {
+            m_activeToken.cancel();
+            ++m_cancelledInRow;
         }
+        m_pendingFrame = std::move(frame);
+        m_hasPendingFrame = true;
+        return false;
     }
 
-    return points;
+    // Токен не передается в submit: задача должна запуститься, чтобы снять m_jobRunning
+    m_jobRunning = true;
+    m_activeToken = frame.token;
+    TaskScheduler &scheduler = m_scheduler ? *m_scheduler : TaskScheduler::shared();
+    m_processingTask = scheduler.submit([this, frame]() {
+        runFrames(frame);
+    }, TaskScheduler::Priority::Normal);
+    return true;
 }
 
-void Lidar3DProcessor::processLidarDataAsync(const std::vector<uint8_t> &depthData, 
-                                              const std::vector<uint8_t> &confidenceData)
+void Lidar3DProcessor::runFrames(PendingFrame frame)
 {
-    m_cancelProcessing = false;
-    
-    // Сохраняем future, чтобы избежать предупреждения
-    auto future = std::async(std::launch::async, [this, depthData, confidenceData]() {
-        processLidarInternal(depthData, confidenceData);
-    });
-    // Сохраняем future в член класса или игнорируем (если не нужен результат)
-    (void)future; // Подавляем предупреждение о неиспользуемой переменной
+    for (;;) {
+        if (!frame.token.isCancelled()) {
+            processLidarInternal(frame.depth, frame.confidence, frame.sequenceNumber, frame.token);
+        }
+
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        if (!frame.token.isCancelled()) {
+            m_cancelledInRow = 0;
+        }
+        if (!m_hasPendingFrame) {
+            m_jobRunning = false;
+            return;
+        }
+        frame = std::move(m_pendingFrame);
+        m_pendingFrame = PendingFrame();
+        m_hasPendingFrame = false;
+        m_activeToken = frame.token;
+    }
+}
+
+Lidar3DProcessor::FrameSnapshot Lidar3DProcessor::getLastFrame() const
+{
+    return m_frames.load();
 }
 
 Lidar3DProcessor::SpatialAnalysisResult Lidar3DProcessor::getLastAnalysis() const
 {
-    std::lock_guard<std::mutex> lock(m_dataLock);
-    return m_lastAnalysis;
+    return m_frames.load()->analysis;
 }
 
 std::vector<glm::vec3> Lidar3DProcessor::getLastProcessedPoints() const
 {
-    std::lock_guard<std::mutex> lock(m_dataLock);
-    return m_lastProcessedPoints;
+    return m_frames.load()->points;
+}
+
+std::vector<glm::vec3> Lidar3DProcessor::getLastProcessedNormals() const
+{
+    return m_frames.load()->normals;
+}
+
+std::shared_ptr<const OrganizedPointCloud> Lidar3DProcessor::getLastOrganizedCloud() const
+{
+    const FrameSnapshot frame = m_frames.load();
+    return std::shared_ptr<const OrganizedPointCloud>(frame, &frame->organizedCloud);
 }
 
 void Lidar3DProcessor::setAnalysisCallback(AnalysisCallback callback)
@@ -123,58 +331,127 @@ void Lidar3DProcessor::setObstaclesCallback(ObstaclesCallback callback)
     m_obstaclesCallback = callback;
 }
 
-void Lidar3DProcessor::processLidarInternal(const std::vector<uint8_t> &depthData, 
-                                            const std::vector<uint8_t> &confidenceData)
+void Lidar3DProcessor::setOdometryCallback(OdometryCallback callback)
 {
-    if (m_cancelProcessing) {
+    m_odometryCallback = callback;
+}
+
+void Lidar3DProcessor::processLidarInternal(const SharedBuffer &depthData, 
+                                            const SharedBuffer &confidenceData,
+                                            uint64_t sequenceNumber,
+                                            const TaskScheduler::CancellationToken &token)
+{
+    LENSENGINE_TRACE_FRAME("Lidar::process", sequenceNumber);
+
+    if (token.isCancelled()) {
         return;
     }
 
-    std::vector<glm::vec3> points = processDepthDataFast(depthData);
+    // Буфер снимка, который никто не читает: вектора прошлых кадров сохраняют емкость
+    std::shared_ptr<FrameResult> frame = m_frames.acquire();
+    frame->sequenceNumber = sequenceNumber;
+
+    // Сглаживание по прошлым кадрам; поза - последняя опубликованная фьюжном
+    const float *depth = depthData.as<float>();
+    const size_t depthCount = depthData.count<float>();
+    const DepthTemporalFilter::Options temporalOptions = m_temporalOptions.load();
+    if (temporalOptions.enabled) {
+        m_temporalFilter.setOptions(temporalOptions);
+        depth = m_temporalFilter.apply(depth, depthCount, confidenceData.data(), confidenceData.size(),
+                                       m_unprojector.intrinsics(), m_cameraPose.load());
+    } else {
+        m_temporalFilter.reset();
+    }
+
+    // Уровень пирамиды под бюджет точек; пиксели ниже порога уверенности
+    // отбрасываются еще в основании пирамиды
+    const DepthUnprojector::Options options = fastUnprojectOptions();
+    size_t level = 0;
+    {
+        LENSENGINE_TRACE_SCOPE("Lidar::unproject");
+        level = unprojectWithBudget(m_pyramid, depth, depthCount, confidenceData.data(), confidenceData.size(),
+                                    options, m_pointBudget, m_unprojectedPoints);
+    }
     
-    if (m_cancelProcessing) {
+    if (token.isCancelled()) {
         return;
     }
 
+    // Та же распаковка на сетке: нормали по соседним ячейкам
+    OrganizedPointCloud &grid = frame->organizedCloud;
     {
-        std::lock_guard<std::mutex> lock(m_dataLock);
-        m_lastProcessedPoints = points;
+        LENSENGINE_TRACE_SCOPE("Lidar::normals");
+        m_pyramid.unprojectOrganized(level, options, grid);
+        m_normalEstimator.compute(grid);
+        grid.gatherNormals(m_rawNormals);
     }
 
-    if (m_pointsCallback) {
-        m_pointsCallback(points);
+    // Движение относительно прошлого кадра (та же сетка уровня пирамиды)
+    const DepthOdometry::Options odometryOptions = m_odometryOptions.load();
+    if (odometryOptions.enabled && level < m_pyramid.levelCount()) {
+        m_odometry.setOptions(odometryOptions);
+        m_odometry.setTaskScheduler(m_scheduler ? m_scheduler : &TaskScheduler::shared());
+        RelativePoseMeasurement measurement = m_odometry.track(grid, m_pyramid.level(level).intrinsics);
+        measurement.sequenceNumber = sequenceNumber;
+        if (m_odometryCallback) {
+            m_odometryCallback(measurement);
+        }
+    } else if (!odometryOptions.enabled) {
+        m_odometry.reset();
     }
 
-    if (m_cancelProcessing) {
+    // Прореживание и выбросы: дальше идут центры вокселей с усредненными нормалями
+    const VoxelGridFilter::Statistics filterStatistics =
+        filterCloud(m_unprojectedPoints, m_rawNormals, m_filteredPoints, frame->normals);
+    m_filteredPoints.toVec3(frame->points);
+
+    if (token.isCancelled()) {
         return;
     }
 
-    SpatialAnalysisResult analysis = analyzeSpatialEnvironmentFast(points);
-    
+    SpatialAnalysisResult &analysis = frame->analysis;
     {
-        std::lock_guard<std::mutex> lock(m_dataLock);
-        m_lastAnalysis = analysis;
+        LENSENGINE_TRACE_SCOPE("Lidar::spatialAnalysis");
+        analysis = analyzeSpatialEnvironmentFast(frame->points, m_filteredPoints, token.flag());
+    }
+    analysis.rawPointCount = filterStatistics.inputPoints;
+    analysis.filteredPointCount = filterStatistics.outputPoints;
+
+    // Прерванный поиск плоскостей дал неполный анализ - такой кадр не публикуется
+    if (token.isCancelled()) {
+        return;
+    }
+    const FrameSnapshot published = frame;
+    m_frames.publish(std::move(frame));
+
+    // Точки отдаются вместе со снимком: getLastProcessedPoints и колбэк видят один кадр
+    if (m_pointsCallback) {
+        m_pointsCallback(published->points);
     }
 
     if (m_analysisCallback) {
-        m_analysisCallback(analysis);
+        m_analysisCallback(published->analysis);
     }
 
-    if (analysis.hasFloor && m_floorCallback) {
-        m_floorCallback(analysis.floorNormal, analysis.floorHeight, 1.0f);
+    if (published->analysis.hasFloor && m_floorCallback) {
+        m_floorCallback(published->analysis.floorNormal, published->analysis.floorHeight, 1.0f);
     }
 
-    if (!analysis.obstacles.empty() && m_obstaclesCallback) {
-        m_obstaclesCallback(analysis.obstacles);
+    if (!published->analysis.obstacles.empty() && m_obstaclesCallback) {
+        m_obstaclesCallback(published->analysis.obstacles);
     }
 }
 
 Lidar3DProcessor::SpatialAnalysisResult Lidar3DProcessor::analyzeSpatialEnvironment(const std::vector<glm::vec3> &points)
 {
-    return analyzeSpatialEnvironmentFast(points);
+    PointCloudSoA cloud;
+    cloud.assign(points, std::vector<float>());
+    return analyzeSpatialEnvironmentFast(points, cloud);
 }
 
-Lidar3DProcessor::SpatialAnalysisResult Lidar3DProcessor::analyzeSpatialEnvironmentFast(const std::vector<glm::vec3> &points)
+Lidar3DProcessor::SpatialAnalysisResult Lidar3DProcessor::analyzeSpatialEnvironmentFast(const std::vector<glm::vec3> &points,
+                                                                                      const PointCloudSoA &cloud,
+                                                                                      const std::atomic<bool> *cancel)
 {
     SpatialAnalysisResult result;
     
@@ -182,99 +459,138 @@ Lidar3DProcessor::SpatialAnalysisResult Lidar3DProcessor::analyzeSpatialEnvironm
         return result;
     }
 
-    // Простое обнаружение пола
-    PlaneResult floor = detectFloorPlane(points);
-    if (floor.confidence > 0.7f) {
+    // Плоскости с гипотезами, ограниченными гравитацией
+    const glm::vec3 gravity = m_gravity.load();
+    const glm::vec3 up = -gravity;
+    result.gravityDirection = gravity;
+    result.planes = detectPlanes(cloud, up, cancel);
+
+    // Пол - самая нижняя горизонтальная плоскость, остальные горизонтальные - столы
+    const DetectedPlane *floor = nullptr;
+    for (const DetectedPlane &plane : result.planes) {
+        if (plane.orientation == DetectedPlane::Orientation::Vertical) {
+            result.walls.push_back(plane);
+        } else if (!floor || plane.distance < floor->distance) {
+            floor = &plane;
+        }
+    }
+    if (floor) {
         result.hasFloor = true;
-        result.floorHeight = floor.distance;
-        result.floorNormal = floor.normal;
+        result.floorHeight = floor->distance;
+        result.floorNormal = floor->normal;
     }
 
-    // Обнаружение препятствий
-    result.obstacles = detectObstacles(points, glm::vec3(0.0f));
+    // Препятствия - кластеры точек вне пола и стен
+    result.obstacles = detectObstacles(cloud, up, floor, result.walls);
 
     return result;
 }
 
-Lidar3DProcessor::PlaneResult Lidar3DProcessor::detectFloorPlane(const std::vector<glm::vec3> &points)
+std::vector<DetectedPlane> Lidar3DProcessor::detectPlanes(const PointCloudSoA &cloud, const glm::vec3 &up,
+                                                         const std::atomic<bool> *cancel)
 {
-    return ransacPlaneDetection(points, 100);
-}
+    LENSENGINE_TRACE_SCOPE("Lidar::planes");
 
-std::vector<Lidar3DProcessor::PlaneResult> Lidar3DProcessor::detectWallPlanes(const std::vector<glm::vec3> &points)
-{
-    // TODO: Реализовать обнаружение стен
-    return std::vector<PlaneResult>();
-}
+    std::vector<DetectedPlane> planes;
+    if (cloud.count < 3) {
+        return planes;
+    }
 
-std::vector<glm::vec3> Lidar3DProcessor::detectObstacles(const std::vector<glm::vec3> &points, const glm::vec3 &cameraPosition)
-{
-    std::vector<glm::vec3> obstacles;
-    
-    // Простой метод: точки выше определенной высоты
-    for (const auto& point : points) {
-        if (point.y > 0.3f) { // Выше 30 см
-            obstacles.push_back(point);
+    PlaneRansac::Options options = m_planeRansac.options();
+    options.distanceThreshold = m_planeDistanceThreshold;
+    m_planeRansac.setOptions(options);
+    // Гипотезы оцениваются параллельно на том же пуле, что и обработка LiDAR
+    m_planeRansac.setTaskScheduler(m_scheduler ? m_scheduler : &TaskScheduler::shared());
+
+    float totalWeight = static_cast<float>(cloud.count);
+    if (cloud.weight.size() >= cloud.count) {
+        totalWeight = 0.0f;
+        for (size_t i = 0; i < cloud.count; ++i) {
+            totalWeight += cloud.weight[i];
         }
     }
-    
-    return obstacles;
-}
 
-Lidar3DProcessor::PlaneResult Lidar3DProcessor::ransacPlaneDetection(const std::vector<glm::vec3> &points, int maxIterations)
-{
-    PlaneResult bestResult;
-    bestResult.confidence = 0.0f;
+    const size_t minInliers = std::max(m_minPlaneInliers,
+                                       static_cast<size_t>(m_minPlaneInlierRatio * static_cast<float>(cloud.count)));
+    m_planeCloud = cloud;
 
-    if (points.size() < 3) {
-        return bestResult;
-    }
+    for (int i = 0; i < m_maxPlanes && m_planeCloud.count >= minInliers && !(cancel && *cancel); ++i) {
+        PlaneRansac::Result horizontal = m_planeRansac.fit(m_planeCloud, PlaneRansac::Model::Horizontal, up, cancel);
+        PlaneRansac::Result vertical = m_planeRansac.fit(m_planeCloud, PlaneRansac::Model::Vertical, up, cancel);
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, points.size() - 1);
-
-    for (int i = 0; i < maxIterations && !m_cancelProcessing; ++i) {
-        // Выбираем 3 случайные точки
-        int idx1 = dis(gen);
-        int idx2 = dis(gen);
-        int idx3 = dis(gen);
-        
-        if (idx1 == idx2 || idx2 == idx3 || idx1 == idx3) {
-            continue;
+        const bool useHorizontal = horizontal.valid && (!vertical.valid || horizontal.score >= vertical.score);
+        const PlaneRansac::Result &best = useHorizontal ? horizontal : vertical;
+        if (!best.valid || best.inliers.size() < minInliers) {
+            break;
         }
 
-        glm::vec3 v1 = points[idx2] - points[idx1];
-        glm::vec3 v2 = points[idx3] - points[idx1];
-        glm::vec3 normal = glm::normalize(glm::cross(v1, v2));
-        
-        if (std::isnan(normal.x) || std::isnan(normal.y) || std::isnan(normal.z)) {
-            continue;
-        }
+        planes.push_back(makeDetectedPlane(m_planeCloud, best,
+                                           useHorizontal ? DetectedPlane::Orientation::Horizontal
+                                                         : DetectedPlane::Orientation::Vertical,
+                                           up, totalWeight));
+        m_planeCloud.erase(best.inliers);
+    }
 
-        float distance = glm::dot(normal, points[idx1]);
-        
-        // Подсчитываем inliers
-        std::vector<glm::vec3> inliers;
-        for (const auto& point : points) {
-            float dist = pointToPlaneDistance(point, normal, points[idx1]);
-            if (std::abs(dist) < m_planeDistanceThreshold) {
-                inliers.push_back(point);
-            }
-        }
+    return planes;
+}
 
-        float confidence = static_cast<float>(inliers.size()) / points.size();
-        
-        if (confidence > bestResult.confidence) {
-            bestResult.normal = normal;
-            bestResult.center = points[idx1];
-            bestResult.distance = distance;
-            bestResult.confidence = confidence;
-            bestResult.inliers = inliers;
+DetectedPlane Lidar3DProcessor::makeDetectedPlane(const PointCloudSoA &cloud, const PlaneRansac::Result &fit,
+                                                  DetectedPlane::Orientation orientation, const glm::vec3 &up,
+                                                  float totalWeight) const
+{
+    DetectedPlane plane;
+    plane.orientation = orientation;
+    plane.normal = fit.normal;
+    plane.distance = fit.distance;
+    plane.inlierCount = static_cast<uint32_t>(fit.inliers.size());
+
+    // Оси прямоугольника: у стен U горизонтальна, V вверх; у горизонтальных U - ось X камеры
+    if (orientation == DetectedPlane::Orientation::Vertical) {
+        plane.axisU = glm::normalize(glm::cross(up, plane.normal));
+    } else {
+        glm::vec3 axis = glm::vec3(1, 0, 0) - plane.normal * plane.normal.x;
+        if (glm::dot(axis, axis) < 1e-6f) {
+            axis = glm::vec3(0, 0, 1) - plane.normal * plane.normal.z;
         }
+        plane.axisU = glm::normalize(axis);
+    }
+    plane.axisV = glm::cross(plane.normal, plane.axisU);
+
+    const bool weighted = cloud.weight.size() >= cloud.count;
+    float minU = std::numeric_limits<float>::max();
+    float minV = std::numeric_limits<float>::max();
+    float maxU = std::numeric_limits<float>::lowest();
+    float maxV = std::numeric_limits<float>::lowest();
+    float inlierWeight = 0.0f;
+    for (uint32_t index : fit.inliers) {
+        const glm::vec3 point = cloud.point(index);
+        const float u = glm::dot(point, plane.axisU);
+        const float v = glm::dot(point, plane.axisV);
+        minU = std::min(minU, u);
+        maxU = std::max(maxU, u);
+        minV = std::min(minV, v);
+        maxV = std::max(maxV, v);
+        inlierWeight += weighted ? cloud.weight[index] : 1.0f;
     }
 
-    return bestResult;
+    if (!fit.inliers.empty()) {
+        plane.extent = glm::vec2(maxU - minU, maxV - minV);
+        plane.center = plane.normal * plane.distance
+                     + plane.axisU * (0.5f * (minU + maxU))
+                     + plane.axisV * (0.5f * (minV + maxV));
+    }
+    plane.score = totalWeight > 0.0f ? inlierWeight / totalWeight : 0.0f;
+    return plane;
+}
+
+std::vector<DetectedObstacle> Lidar3DProcessor::detectObstacles(const PointCloudSoA &cloud, const glm::vec3 &up,
+                                                                const DetectedPlane *floor,
+                                                                const std::vector<DetectedPlane> &walls)
+{
+    LENSENGINE_TRACE_SCOPE("Lidar::obstacles");
+
+    m_obstacleClusterer.setOptions(m_obstacleOptions.load());
+    return m_obstacleClusterer.cluster(cloud, up, floor, walls);
 }
 
 std::vector<glm::vec3> Lidar3DProcessor::filterValidPoints(const std::vector<glm::vec3> &points)
@@ -282,11 +598,13 @@ std::vector<glm::vec3> Lidar3DProcessor::filterValidPoints(const std::vector<glm
     std::vector<glm::vec3> validPoints;
     validPoints.reserve(points.size());
     
+    // Квадраты границ: без sqrt на точку; NaN не проходит ни одно сравнение
+    const float minSquared = m_minDepth * m_minDepth;
+    const float maxSquared = m_maxDepth * m_maxDepth;
     for (const auto& point : points) {
-        if (!std::isnan(point.x) && !std::isnan(point.y) && !std::isnan(point.z)) {
-            if (glm::length(point) >= m_minDepth && glm::length(point) <= m_maxDepth) {
-                validPoints.push_back(point);
-            }
+        const float squared = glm::dot(point, point);
+        if (squared >= minSquared && squared <= maxSquared) {
+            validPoints.push_back(point);
         }
     }
     
@@ -295,27 +613,25 @@ std::vector<glm::vec3> Lidar3DProcessor::filterValidPoints(const std::vector<glm
 
 std::vector<glm::vec3> Lidar3DProcessor::removeOutliers(const std::vector<glm::vec3> &points)
 {
-    // TODO: Реализовать удаление выбросов
-    return points;
+    // Для произвольных AoS точек: свой фильтр на поток, без общих буферов задачи обработки
+    thread_local VoxelGridFilter filter;
+    thread_local PointCloudSoA input;
+    thread_local PointCloudSoA output;
+    filter.setOptions(m_filterOptions.load());
+    input.assign(points, std::vector<float>());
+    filter.filter(input, output);
+    return output.toVec3();
 }
 
-glm::vec3 Lidar3DProcessor::depthToWorldSpace(int x, int y, float depth)
+VoxelGridFilter::Statistics Lidar3DProcessor::filterCloud(const PointCloudSoA &input,
+                                                          const std::vector<glm::vec3> &normals,
+                                                          PointCloudSoA &output,
+                                                          std::vector<glm::vec3> &outputNormals)
 {
-    // Преобразование из координат пикселя в мировые координаты
-    float fx = 256.0f; // Фокусное расстояние (примерное)
-    float fy = 256.0f;
-    float cx = 128.0f; // Центр изображения
-    float cy = 96.0f;
-
-    float u = static_cast<float>(x) - cx;
-    float v = static_cast<float>(y) - cy;
-
-    glm::vec3 point;
-    point.x = (u * depth) / fx;
-    point.y = (v * depth) / fy;
-    point.z = depth;
-
-    return point;
+    m_voxelFilter.setOptions(m_filterOptions.load());
+    const VoxelGridFilter::Statistics statistics = m_voxelFilter.filter(input, output, &normals, &outputNormals);
+    m_filterStatistics.store(statistics);
+    return statistics;
 }
 
 float Lidar3DProcessor::pointToPlaneDistance(const glm::vec3 &point, const glm::vec3 &planeNormal, const glm::vec3 &planePoint)
@@ -0,0 +1,638 @@
+#include "MeshRaycaster.h"
+#include "Profiler.h"
+#include "SimdConfig.h"
+#include <algorithm>
+#include <cmath>
+
+namespace LensEngine {
+
+namespace {
+constexpr uint32_t kLeafTriangles = 4;      // Одна пачка SIMD на лист
+constexpr uint32_t kLeafChunks = 2;
+constexpr size_t kStackSize = 64;
+constexpr size_t kRaysPerTask = 64;
+constexpr float kMinDistance = 1e-5f;       // Отсечение самопересечения у начала луча
+constexpr float kMinDeterminant = 1e-12f;   // Луч параллелен треугольнику (и пустые дорожки пачки)
+
+inline float safeInverse(float value)
+{
+    return std::fabs(value) > 1e-20f ? 1.0f / value : std::copysign(1e30f, value);
+}
+
+// Вход луча в бокс на [0, maxDistance]
+inline bool hitBounds(const glm::vec3 &min, const glm::vec3 &max, const glm::vec3 &origin,
+                      const glm::vec3 &inverseDirection, float maxDistance, float &entry)
+{
+    const float x1 = (min.x - origin.x) * inverseDirection.x;
+    const float x2 = (max.x - origin.x) * inverseDirection.x;
+    const float y1 = (min.y - origin.y) * inverseDirection.y;
+    const float y2 = (max.y - origin.y) * inverseDirection.y;
+    const float z1 = (min.z - origin.z) * inverseDirection.z;
+    const float z2 = (max.z - origin.z) * inverseDirection.z;
+    const float near = std::max(std::max(std::min(x1, x2), std::min(y1, y2)), std::max(std::min(z1, z2), 0.0f));
+    const float far = std::min(std::min(std::max(x1, x2), std::max(y1, y2)), std::min(std::max(z1, z2), maxDistance));
+    entry = near;
+    return near <= far;
+}
+
+#if defined(LENSENGINE_SIMD_NEON)
+// 1 / x: оценка и два шага Ньютона (vdivq_f32 есть только на AArch64)
+inline float32x4_t reciprocal(float32x4_t x)
+{
+    float32x4_t estimate = vrecpeq_f32(x);
+    estimate = vmulq_f32(vrecpsq_f32(x, estimate), estimate);
+    return vmulq_f32(vrecpsq_f32(x, estimate), estimate);
+}
+#endif
+} // namespace
+
+// ============================================================================
+// TriangleBvh
+// ============================================================================
+
+namespace {
+// Möller-Trumbore для 4 треугольников пачки. Возвращает маску дорожек с попаданием
+// на (kMinDistance, maxDistance), расстояния - в distances
+template<typename Pack>
+inline unsigned intersectPack(const Pack &pack, const glm::vec3 &origin, const glm::vec3 &direction,
+                              float maxDistance, float *distances)
+{
+#if defined(LENSENGINE_SIMD_SSE2)
+    const __m128 dx = _mm_set1_ps(direction.x);
+    const __m128 dy = _mm_set1_ps(direction.y);
+    const __m128 dz = _mm_set1_ps(direction.z);
+    const __m128 e1x = _mm_loadu_ps(pack.edge1[0]);
+    const __m128 e1y = _mm_loadu_ps(pack.edge1[1]);
+    const __m128 e1z = _mm_loadu_ps(pack.edge1[2]);
+    const __m128 e2x = _mm_loadu_ps(pack.edge2[0]);
+    const __m128 e2y = _mm_loadu_ps(pack.edge2[1]);
+    const __m128 e2z = _mm_loadu_ps(pack.edge2[2]);
+
+    const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+    const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+    const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+    const __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 valid = _mm_cmpgt_ps(_mm_and_ps(determinant, absMask), _mm_set1_ps(kMinDeterminant));
+    // Пустые дорожки дают деление на 0; их отсекает valid
+    const __m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), _mm_or_ps(_mm_and_ps(valid, determinant),
+                                                                   _mm_andnot_ps(valid, _mm_set1_ps(1.0f))));
+
+    const __m128 tx = _mm_sub_ps(_mm_set1_ps(origin.x), _mm_loadu_ps(pack.v0[0]));
+    const __m128 ty = _mm_sub_ps(_mm_set1_ps(origin.y), _mm_loadu_ps(pack.v0[1]));
+    const __m128 tz = _mm_sub_ps(_mm_set1_ps(origin.z), _mm_loadu_ps(pack.v0[2]));
+    const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inverse);
+
+    const __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+    const __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+    const __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+    const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverse);
+    const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverse);
+
+    const __m128 zero = _mm_setzero_ps();
+    __m128 hit = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero)));
+    hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+    hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpgt_ps(t, _mm_set1_ps(kMinDistance)), _mm_cmplt_ps(t, _mm_set1_ps(maxDistance))));
+    _mm_storeu_ps(distances, t);
+    return static_cast<unsigned>(_mm_movemask_ps(hit));
+#elif defined(LENSENGINE_SIMD_NEON)
+    const float32x4_t dx = vdupq_n_f32(direction.x);
+    const float32x4_t dy = vdupq_n_f32(direction.y);
+    const float32x4_t dz = vdupq_n_f32(direction.z);
+    const float32x4_t e1x = vld1q_f32(pack.edge1[0]);
+    const float32x4_t e1y = vld1q_f32(pack.edge1[1]);
+    const float32x4_t e1z = vld1q_f32(pack.edge1[2]);
+    const float32x4_t e2x = vld1q_f32(pack.edge2[0]);
+    const float32x4_t e2y = vld1q_f32(pack.edge2[1]);
+    const float32x4_t e2z = vld1q_f32(pack.edge2[2]);
+
+    const float32x4_t px = vmlsq_f32(vmulq_f32(dy, e2z), dz, e2y);
+    const float32x4_t py = vmlsq_f32(vmulq_f32(dz, e2x), dx, e2z);
+    const float32x4_t pz = vmlsq_f32(vmulq_f32(dx, e2y), dy, e2x);
+    const float32x4_t determinant = vmlaq_f32(vmlaq_f32(vmulq_f32(e1x, px), e1y, py), e1z, pz);
+    const uint32x4_t valid = vcgtq_f32(vabsq_f32(determinant), vdupq_n_f32(kMinDeterminant));
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t inverse = reciprocal(vbslq_f32(valid, determinant, one));
+
+    const float32x4_t tx = vsubq_f32(vdupq_n_f32(origin.x), vld1q_f32(pack.v0[0]));
+    const float32x4_t ty = vsubq_f32(vdupq_n_f32(origin.y), vld1q_f32(pack.v0[1]));
+    const float32x4_t tz = vsubq_f32(vdupq_n_f32(origin.z), vld1q_f32(pack.v0[2]));
+    const float32x4_t u = vmulq_f32(vmlaq_f32(vmlaq_f32(vmulq_f32(tx, px), ty, py), tz, pz), inverse);
+
+    const float32x4_t qx = vmlsq_f32(vmulq_f32(ty, e1z), tz, e1y);
+    const float32x4_t qy = vmlsq_f32(vmulq_f32(tz, e1x), tx, e1z);
+    const float32x4_t qz = vmlsq_f32(vmulq_f32(tx, e1y), ty, e1x);
+    const float32x4_t v = vmulq_f32(vmlaq_f32(vmlaq_f32(vmulq_f32(dx, qx), dy, qy), dz, qz), inverse);
+    const float32x4_t t = vmulq_f32(vmlaq_f32(vmlaq_f32(vmulq_f32(e2x, qx), e2y, qy), e2z, qz), inverse);
+
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    uint32x4_t hit = vandq_u32(valid, vandq_u32(vcgeq_f32(u, zero), vcgeq_f32(v, zero)));
+    hit = vandq_u32(hit, vcleq_f32(vaddq_f32(u, v), one));
+    hit = vandq_u32(hit, vandq_u32(vcgtq_f32(t, vdupq_n_f32(kMinDistance)), vcltq_f32(t, vdupq_n_f32(maxDistance))));
+    vst1q_f32(distances, t);
+    uint32_t lanes[4];
+    vst1q_u32(lanes, hit);
+    return (lanes[0] & 1u) | (lanes[1] & 2u) | (lanes[2] & 4u) | (lanes[3] & 8u);
+#else
+    unsigned mask = 0;
+    for (int lane = 0; lane < 4; ++lane) {
+        const glm::vec3 edge1(pack.edge1[0][lane], pack.edge1[1][lane], pack.edge1[2][lane]);
+        const glm::vec3 edge2(pack.edge2[0][lane], pack.edge2[1][lane], pack.edge2[2][lane]);
+        const glm::vec3 p = glm::cross(direction, edge2);
+        const float determinant = glm::dot(edge1, p);
+        if (!(std::fabs(determinant) > kMinDeterminant)) {
+            continue;
+        }
+        const float inverse = 1.0f / determinant;
+        const glm::vec3 offset = origin - glm::vec3(pack.v0[0][lane], pack.v0[1][lane], pack.v0[2][lane]);
+        const float u = glm::dot(offset, p) * inverse;
+        const glm::vec3 q = glm::cross(offset, edge1);
+        const float v = glm::dot(direction, q) * inverse;
+        const float t = glm::dot(edge2, q) * inverse;
+        distances[lane] = t;
+        if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > kMinDistance && t < maxDistance) {
+            mask |= 1u << lane;
+        }
+    }
+    return mask;
+#endif
+}
+} // namespace
+
+void TriangleBvh::clear()
+{
+    m_nodes.clear();
+    m_packs.clear();
+    m_normals.clear();
+    m_boundsMin = m_boundsMax = glm::vec3(0.0f);
+}
+
+void TriangleBvh::build(const std::vector<glm::vec3> &vertices, const std::vector<uint32_t> &indices)
+{
+    clear();
+
+    const uint32_t triangles = static_cast<uint32_t>(indices.size() / 3);
+    std::vector<uint32_t> order;
+    std::vector<glm::vec3> centroids(triangles);
+    order.reserve(triangles);
+    m_normals.assign(triangles, glm::vec3(0.0f));
+    for (uint32_t i = 0; i < triangles; ++i) {
+        const uint32_t a = indices[i * 3];
+        const uint32_t b = indices[i * 3 + 1];
+        const uint32_t c = indices[i * 3 + 2];
+        if (a >= vertices.size() || b >= vertices.size() || c >= vertices.size()) {
+            continue;
+        }
+        const glm::vec3 normal = glm::cross(vertices[b] - vertices[a], vertices[c] - vertices[a]);
+        const float length = glm::length(normal);
+        m_normals[i] = length > 1e-12f ? normal / length : glm::vec3(0.0f);
+        centroids[i] = (vertices[a] + vertices[b] + vertices[c]) * (1.0f / 3.0f);
+        order.push_back(i);
+    }
+    if (order.empty()) {
+        m_normals.clear();
+        return;
+    }
+
+    m_nodes.reserve(order.size() / kLeafTriangles * 2 + 1);
+    m_packs.reserve(order.size() / kLeafTriangles + 1);
+    buildNode(0, static_cast<uint32_t>(order.size()), vertices, indices, order, centroids);
+    m_boundsMin = m_nodes.front().min;
+    m_boundsMax = m_nodes.front().max;
+}
+
+uint32_t TriangleBvh::buildNode(uint32_t begin, uint32_t end, const std::vector<glm::vec3> &vertices,
+                                const std::vector<uint32_t> &indices, std::vector<uint32_t> &order,
+                                const std::vector<glm::vec3> &centroids)
+{
+    const uint32_t index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(-std::numeric_limits<float>::max());
+    glm::vec3 centroidMin = min;
+    glm::vec3 centroidMax = max;
+    for (uint32_t i = begin; i < end; ++i) {
+        const uint32_t triangle = order[i];
+        for (uint32_t corner = 0; corner < 3; ++corner) {
+            const glm::vec3 &vertex = vertices[indices[triangle * 3 + corner]];
+            min = glm::min(min, vertex);
+            max = glm::max(max, vertex);
+        }
+        centroidMin = glm::min(centroidMin, centroids[triangle]);
+        centroidMax = glm::max(centroidMax, centroids[triangle]);
+    }
+    m_nodes[index].min = min;
+    m_nodes[index].max = max;
+
+    if (end - begin <= kLeafTriangles) {
+        // Пустые дорожки пачки - вырожденные треугольники (нулевой определитель)
+        TrianglePack pack = {};
+        for (uint32_t lane = 0; lane < end - begin; ++lane) {
+            const uint32_t triangle = order[begin + lane];
+            const glm::vec3 &a = vertices[indices[triangle * 3]];
+            const glm::vec3 edge1 = vertices[indices[triangle * 3 + 1]] - a;
+            const glm::vec3 edge2 = vertices[indices[triangle * 3 + 2]] - a;
+            for (int axis = 0; axis < 3; ++axis) {
+                pack.v0[axis][lane] = a[axis];
+                pack.edge1[axis][lane] = edge1[axis];
+                pack.edge2[axis][lane] = edge2[axis];
+            }
+            pack.triangle[lane] = triangle;
+        }
+        m_nodes[index].offset = static_cast<uint32_t>(m_packs.size());
+        m_nodes[index].count = end - begin;
+        m_packs.push_back(pack);
+        return index;
+    }
+
+    // Медиана центров по наибольшей оси
+    const glm::vec3 extent = centroidMax - centroidMin;
+    const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+    const uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                     [&centroids, axis](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+    buildNode(begin, middle, vertices, indices, order, centroids);
+    const uint32_t right = buildNode(middle, end, vertices, indices, order, centroids);
+    m_nodes[index].offset = right;
+    m_nodes[index].count = 0;
+    return index;
+}
+
+bool TriangleBvh::intersect(const glm::vec3 &origin, const glm::vec3 &direction, const glm::vec3 &inverseDirection,
+                            float &maxDistance, Hit &hit) const
+{
+    float entry;
+    if (m_nodes.empty() || !hitBounds(m_nodes[0].min, m_nodes[0].max, origin, inverseDirection, maxDistance, entry)) {
+        return false;
+    }
+
+    uint32_t stack[kStackSize];
+    float stackEntry[kStackSize];
+    size_t top = 0;
+    stack[top] = 0;
+    stackEntry[top++] = entry;
+    bool found = false;
+    while (top > 0) {
+        --top;
+        if (stackEntry[top] > maxDistance) {
+            continue;
+        }
+        const uint32_t index = stack[top];
+        const Node &node = m_nodes[index];
+        if (node.count > 0) {
+            const TrianglePack &pack = m_packs[node.offset];
+            float distances[4];
+            const unsigned mask = intersectPack(pack, origin, direction, maxDistance, distances);
+            for (uint32_t lane = 0; lane < node.count; ++lane) {
+                if ((mask >> lane) & 1u && distances[lane] < maxDistance) {
+                    maxDistance = distances[lane];
+                    hit.distance = distances[lane];
+                    hit.triangle = pack.triangle[lane];
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // Ближний потомок снимается со стека первым
+        float leftEntry;
+        float rightEntry;
+        const bool left = hitBounds(m_nodes[index + 1].min, m_nodes[index + 1].max, origin, inverseDirection,
+                                    maxDistance, leftEntry);
+        const bool right = hitBounds(m_nodes[node.offset].min, m_nodes[node.offset].max, origin, inverseDirection,
+                                     maxDistance, rightEntry);
+        if (left && right && top + 2 <= kStackSize) {
+            const bool leftFirst = leftEntry <= rightEntry;
+            stack[top] = leftFirst ? node.offset : index + 1;
+            stackEntry[top++] = leftFirst ? rightEntry : leftEntry;
+            stack[top] = leftFirst ? index + 1 : node.offset;
+            stackEntry[top++] = leftFirst ? leftEntry : rightEntry;
+        } else if ((left || right) && top < kStackSize) {
+            stack[top] = left ? index + 1 : node.offset;
+            stackEntry[top++] = left ? leftEntry : rightEntry;
+        }
+    }
+    return found;
+}
+
+bool TriangleBvh::occluded(const glm::vec3 &origin, const glm::vec3 &direction, const glm::vec3 &inverseDirection,
+                           float maxDistance) const
+{
+    float entry;
+    if (m_nodes.empty() || !hitBounds(m_nodes[0].min, m_nodes[0].max, origin, inverseDirection, maxDistance, entry)) {
+        return false;
+    }
+
+    uint32_t stack[kStackSize];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const uint32_t index = stack[--top];
+        const Node &node = m_nodes[index];
+        if (node.count > 0) {
+            float distances[4];
+            if (intersectPack(m_packs[node.offset], origin, direction, maxDistance, distances) != 0) {
+                return true;
+            }
+            continue;
+        }
+        if (hitBounds(m_nodes[node.offset].min, m_nodes[node.offset].max, origin, inverseDirection, maxDistance, entry) &&
+            top < kStackSize) {
+            stack[top++] = node.offset;
+        }
+        if (hitBounds(m_nodes[index + 1].min, m_nodes[index + 1].max, origin, inverseDirection, maxDistance, entry) &&
+            top < kStackSize) {
+            stack[top++] = index + 1;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// MeshRaycaster
+// ============================================================================
+
+MeshRaycaster::MeshRaycaster()
+    : m_scheduler(nullptr)
+    , m_structureChanged(false)
+    , m_boundsChanged(false)
+{
+}
+
+bool MeshRaycaster::updateChunk(uint64_t key, uint64_t version, const std::vector<glm::vec3> &vertices,
+                                const std::vector<uint32_t> &indices)
+{
+    auto it = m_chunkIndex.find(key);
+    if (it != m_chunkIndex.end() && m_chunks[it->second].version == version && indices.size() >= 3) {
+        return false;
+    }
+    // Новый BVH вместо перестроения на месте: копии raycaster держат старый
+    std::shared_ptr<TriangleBvh> bvh;
+    if (indices.size() >= 3) {
+        bvh = std::make_shared<TriangleBvh>();
+        bvh->build(vertices, indices);
+    }
+    if (!bvh || bvh->empty()) {
+        if (it == m_chunkIndex.end()) {
+            return false;
+        }
+        removeChunk(key);
+        return true;
+    }
+
+    uint32_t index;
+    if (it == m_chunkIndex.end()) {
+        index = static_cast<uint32_t>(m_chunks.size());
+        m_chunks.emplace_back();
+        m_chunkIndex.emplace(key, index);
+        m_structureChanged = true;
+    } else {
+        index = it->second;
+        m_boundsChanged = true;
+    }
+    Chunk &chunk = m_chunks[index];
+    chunk.key = key;
+    chunk.version = version;
+    chunk.bvh = std::move(bvh);
+    return true;
+}
+
+void MeshRaycaster::removeChunk(uint64_t key)
+{
+    auto it = m_chunkIndex.find(key);
+    if (it == m_chunkIndex.end()) {
+        return;
+    }
+    const uint32_t index = it->second;
+    m_chunkIndex.erase(it);
+    if (index + 1 != m_chunks.size()) {
+        m_chunks[index] = std::move(m_chunks.back());
+        m_chunkIndex[m_chunks[index].key] = index;
+    }
+    m_chunks.pop_back();
+    m_structureChanged = true;
+}
+
+void MeshRaycaster::clear()
+{
+    m_chunks.clear();
+    m_chunkIndex.clear();
+    m_nodes.clear();
+    m_order.clear();
+    m_structureChanged = false;
+    m_boundsChanged = false;
+}
+
+void MeshRaycaster::commit()
+{
+    LENSENGINE_TRACE_SCOPE("Raycast::commit");
+    if (m_structureChanged) {
+        m_nodes.clear();
+        m_order.resize(m_chunks.size());
+        m_centers.resize(m_chunks.size());
+        for (uint32_t i = 0; i < m_chunks.size(); ++i) {
+            m_order[i] = i;
+            m_centers[i] = (m_chunks[i].bvh->boundsMin() + m_chunks[i].bvh->boundsMax()) * 0.5f;
+        }
+        if (!m_chunks.empty()) {
+            buildNode(0, static_cast<uint32_t>(m_chunks.size()));
+        }
+    } else if (m_boundsChanged) {
+        refit();
+    }
+    m_structureChanged = false;
+    m_boundsChanged = false;
+}
+
+uint32_t MeshRaycaster::buildNode(uint32_t begin, uint32_t end)
+{
+    const uint32_t index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(-std::numeric_limits<float>::max());
+    glm::vec3 centerMin = min;
+    glm::vec3 centerMax = max;
+    for (uint32_t i = begin; i < end; ++i) {
+        const TriangleBvh &bvh = *m_chunks[m_order[i]].bvh;
+        min = glm::min(min, bvh.boundsMin());
+        max = glm::max(max, bvh.boundsMax());
+        centerMin = glm::min(centerMin, m_centers[m_order[i]]);
+        centerMax = glm::max(centerMax, m_centers[m_order[i]]);
+    }
+    m_nodes[index].min = min;
+    m_nodes[index].max = max;
+
+    if (end - begin <= kLeafChunks) {
+        m_nodes[index].offset = begin;
+        m_nodes[index].count = end - begin;
+        return index;
+    }
+
+    const glm::vec3 extent = centerMax - centerMin;
+    const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+    const uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(m_order.begin() + begin, m_order.begin() + middle, m_order.begin() + end,
+                     [this, axis](uint32_t a, uint32_t b) { return m_centers[a][axis] < m_centers[b][axis]; });
+
+    buildNode(begin, middle);
+    const uint32_t right = buildNode(middle, end);
+    m_nodes[index].offset = right;
+    m_nodes[index].count = 0;
+    return index;
+}
+
+void MeshRaycaster::refit()
+{
+    // Потомки всегда правее родителя: обратный проход собирает границы снизу вверх
+    for (size_t i = m_nodes.size(); i-- > 0;) {
+        Node &node = m_nodes[i];
+        if (node.count > 0) {
+            node.min = glm::vec3(std::numeric_limits<float>::max());
+            node.max = glm::vec3(-std::numeric_limits<float>::max());
+            for (uint32_t j = node.offset; j < node.offset + node.count; ++j) {
+                node.min = glm::min(node.min, m_chunks[m_order[j]].bvh->boundsMin());
+                node.max = glm::max(node.max, m_chunks[m_order[j]].bvh->boundsMax());
+            }
+        } else {
+            node.min = glm::min(m_nodes[i + 1].min, m_nodes[node.offset].min);
+            node.max = glm::max(m_nodes[i + 1].max, m_nodes[node.offset].max);
+        }
+    }
+}
+
+template<bool AnyHit>
+bool MeshRaycaster::traverse(const Ray &ray, Hit &hit) const
+{
+    hit = Hit();
+    const float length = glm::length(ray.direction);
+    if (m_nodes.empty() || !(length > 1e-12f) || !(ray.maxDistance > 0.0f)) {
+        return false;
+    }
+    const glm::vec3 direction = ray.direction / length;
+    const glm::vec3 inverse(safeInverse(direction.x), safeInverse(direction.y), safeInverse(direction.z));
+    float maxDistance = ray.maxDistance;
+
+    float entry;
+    if (!hitBounds(m_nodes[0].min, m_nodes[0].max, ray.origin, inverse, maxDistance, entry)) {
+        return false;
+    }
+    uint32_t stack[kStackSize];
+    float stackEntry[kStackSize];
+    size_t top = 0;
+    stack[top] = 0;
+    stackEntry[top++] = entry;
+    while (top > 0) {
+        --top;
+        if (stackEntry[top] > maxDistance) {
+            continue;
+        }
+        const uint32_t index = stack[top];
+        const Node &node = m_nodes[index];
+        if (node.count > 0) {
+            for (uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+                const Chunk &chunk = m_chunks[m_order[i]];
+                if (AnyHit) {
+                    if (chunk.bvh->occluded(ray.origin, direction, inverse, maxDistance)) {
+                        hit.hit = true;
+                        return true;
+                    }
+                    continue;
+                }
+                TriangleBvh::Hit chunkHit;
+                if (chunk.bvh->intersect(ray.origin, direction, inverse, maxDistance, chunkHit)) {
+                    hit.hit = true;
+                    hit.distance = chunkHit.distance;
+                    hit.triangle = chunkHit.triangle;
+                    hit.chunkKey = chunk.key;
+                    hit.normal = chunk.bvh->normal(chunkHit.triangle);
+                }
+            }
+            continue;
+        }
+
+        float leftEntry;
+        float rightEntry;
+        const bool left = hitBounds(m_nodes[index + 1].min, m_nodes[index + 1].max, ray.origin, inverse,
+                                    maxDistance, leftEntry);
+        const bool right = hitBounds(m_nodes[node.offset].min, m_nodes[node.offset].max, ray.origin, inverse,
+                                     maxDistance, rightEntry);
+        if (left && right && top + 2 <= kStackSize) {
+            const bool leftFirst = leftEntry <= rightEntry;
+            stack[top] = leftFirst ? node.offset : index + 1;
+            stackEntry[top++] = leftFirst ? rightEntry : leftEntry;
+            stack[top] = leftFirst ? index + 1 : node.offset;
+            stackEntry[top++] = leftFirst ? leftEntry : rightEntry;
+        } else if ((left || right) && top < kStackSize) {
+            stack[top] = left ? index + 1 : node.offset;
+            stackEntry[top++] = left ? leftEntry : rightEntry;
+        }
+    }
+    if (hit.hit) {
+        hit.position = ray.origin + direction * hit.distance;
+    }
+    return hit.hit;
+}
+
+bool MeshRaycaster::raycast(const Ray &ray, Hit &hit) const
+{
+    return traverse<false>(ray, hit);
+}
+
+bool MeshRaycaster::occluded(const Ray &ray) const
+{
+    Hit hit;
+    return traverse<true>(ray, hit);
+}
+
+void MeshRaycaster::raycast(const Ray *rays, size_t count, Hit *hits) const
+{
+    LENSENGINE_TRACE_SCOPE("Raycast::batch");
+    TaskScheduler &scheduler = m_scheduler ? *m_scheduler : TaskScheduler::shared();
+    scheduler.parallelFor(0, count, kRaysPerTask, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            traverse<false>(rays[i], hits[i]);
+        }
+    });
+}
+
+void MeshRaycaster::occluded(const Ray *rays, size_t count, uint8_t *results) const
+{
+    LENSENGINE_TRACE_SCOPE("Raycast::occlusion");
+    TaskScheduler &scheduler = m_scheduler ? *m_scheduler : TaskScheduler::shared();
+    scheduler.parallelFor(0, count, kRaysPerTask, [&](size_t begin, size_t end) {
+        Hit hit;
+        for (size_t i = begin; i < end; ++i) {
+            results[i] = traverse<true>(rays[i], hit) ? 1 : 0;
+        }
+    });
+}
+
+bool MeshRaycaster::raycastChunk(uint64_t key, const Ray &ray, Hit &hit) const
+{
+    hit = Hit();
+    auto it = m_chunkIndex.find(key);
+    const float length = glm::length(ray.direction);
+    if (it == m_chunkIndex.end() || !(length > 1e-12f)) {
+        return false;
+    }
+    const Chunk &chunk = m_chunks[it->second];
+    const glm::vec3 direction = ray.direction / length;
+    const glm::vec3 inverse(safeInverse(direction.x), safeInverse(direction.y), safeInverse(direction.z));
+    float maxDistance = ray.maxDistance;
+    TriangleBvh::Hit chunkHit;
+    if (!chunk.bvh->intersect(ray.origin, direction, inverse, maxDistance, chunkHit)) {
+        return false;
+    }
+    hit.hit = true;
+    hit.distance = chunkHit.distance;
+    hit.triangle = chunkHit.triangle;
+    hit.chunkKey = chunk.key;
+    hit.normal = chunk.bvh->normal(chunkHit.triangle);
+    hit.position = ray.origin + direction * chunkHit.distance;
+    return true;
+}
+
+} // namespace LensEngine
@@ -0,0 +1,272 @@
+#include "ObstacleClusterer.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace LensEngine {
+
+ObstacleClusterer::ObstacleClusterer()
+    : ObstacleClusterer(Options())
+{
+}
+
+ObstacleClusterer::ObstacleClusterer(const Options &options)
+    : m_options(options)
+    , m_map(options.cellSize)
+    , m_nextTrackId(1)
+{
+}
+
+void ObstacleClusterer::setOptions(const Options &options)
+{
+    m_options = options;
+    m_map.setVoxelSize(options.cellSize);
+}
+
+void ObstacleClusterer::resetTracks()
+{
+    m_tracks.clear();
+}
+
+bool ObstacleClusterer::isBackground(const glm::vec3 &point, const glm::vec3 &up, const DetectedPlane *floor,
+                                     const std::vector<DetectedPlane> &walls) const
+{
+    // Пол и все, что ниже (шум под полом)
+    if (floor && glm::dot(up, point) - floor->distance < m_options.minHeightAboveFloor) {
+        return true;
+    }
+
+    // Стена: у плоскости и в пределах ее прямоугольника
+    for (const DetectedPlane &wall : walls) {
+        if (std::abs(glm::dot(wall.normal, point) - wall.distance) > m_options.planeMargin) {
+            continue;
+        }
+        const glm::vec3 offset = point - wall.center;
+        if (std::abs(glm::dot(offset, wall.axisU)) <= 0.5f * wall.extent.x + m_options.planeMargin &&
+            std::abs(glm::dot(offset, wall.axisV)) <= 0.5f * wall.extent.y + m_options.planeMargin) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t ObstacleClusterer::findRoot(uint32_t voxel)
+{
+    // Сжатие пути делением пополам
+    while (m_parent[voxel] != voxel) {
+        m_parent[voxel] = m_parent[m_parent[voxel]];
+        voxel = m_parent[voxel];
+    }
+    return voxel;
+}
+
+void ObstacleClusterer::unite(uint32_t a, uint32_t b)
+{
+    a = findRoot(a);
+    b = findRoot(b);
+    if (a != b) {
+        m_parent[std::max(a, b)] = std::min(a, b);
+    }
+}
+
+std::vector<DetectedObstacle> ObstacleClusterer::cluster(const PointCloudSoA &points, const glm::vec3 &up,
+                                                         const DetectedPlane *floor,
+                                                         const std::vector<DetectedPlane> &walls)
+{
+    LENSENGINE_TRACE_SCOPE("Obstacles::cluster");
+
+    // Раскладка точек препятствий по вокселям
+    m_map.clear();
+    m_map.reserve(points.count / 4);
+    m_points.clear();
+    m_pointVoxel.clear();
+    for (size_t i = 0; i < points.count; ++i) {
+        const glm::vec3 point = points.point(i);
+        if (isBackground(point, up, floor, walls)) {
+            continue;
+        }
+        m_pointVoxel.push_back(m_map.insert(point));
+        m_points.push_back(point);
+    }
+
+    // Связность вокселей: половина 26-окрестности, вторую половину проверят соседи
+    const std::vector<VoxelHashMap::Voxel> &voxels = m_map.voxels();
+    m_parent.resize(voxels.size());
+    for (uint32_t v = 0; v < voxels.size(); ++v) {
+        m_parent[v] = v;
+    }
+    for (uint32_t v = 0; v < voxels.size(); ++v) {
+        int32_t cx;
+        int32_t cy;
+        int32_t cz;
+        VoxelHashMap::unpackKey(voxels[v].key, cx, cy, cz);
+        for (int32_t dz = 0; dz <= 1; ++dz) {
+            for (int32_t dy = -1; dy <= 1; ++dy) {
+                for (int32_t dx = -1; dx <= 1; ++dx) {
+                    if (dz == 0 && (dy < 0 || (dy == 0 && dx <= 0))) {
+                        continue;
+                    }
+                    const uint32_t neighbor = m_map.find(cx + dx, cy + dy, cz + dz);
+                    if (neighbor != VoxelHashMap::kNotFound) {
+                        unite(v, neighbor);
+                    }
+                }
+            }
+        }
+    }
+
+    // Точки по компонентам (внутренние векторы переиспользуются между кадрами)
+    constexpr uint32_t kNoComponent = std::numeric_limits<uint32_t>::max();
+    m_component.assign(voxels.size(), kNoComponent);
+    size_t componentCount = 0;
+    for (size_t i = 0; i < m_points.size(); ++i) {
+        const uint32_t root = findRoot(m_pointVoxel[i]);
+        if (m_component[root] == kNoComponent) {
+            m_component[root] = static_cast<uint32_t>(componentCount++);
+            if (m_clusters.size() < componentCount) {
+                m_clusters.emplace_back();
+            }
+            m_clusters[componentCount - 1].clear();
+        }
+        m_clusters[m_component[root]].push_back(m_points[i]);
+    }
+
+    std::vector<uint32_t> order;
+    order.reserve(componentCount);
+    for (uint32_t c = 0; c < componentCount; ++c) {
+        if (m_clusters[c].size() >= m_options.minPoints) {
+            order.push_back(c);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return m_clusters[a].size() > m_clusters[b].size();
+    });
+    if (order.size() > m_options.maxObstacles) {
+        order.resize(m_options.maxObstacles);
+    }
+
+    std::vector<DetectedObstacle> obstacles;
+    obstacles.reserve(order.size());
+    for (uint32_t c : order) {
+        obstacles.push_back(makeObstacle(m_clusters[c], up));
+    }
+    associate(obstacles);
+    return obstacles;
+}
+
+DetectedObstacle ObstacleClusterer::makeObstacle(const std::vector<glm::vec3> &points, const glm::vec3 &up) const
+{
+    DetectedObstacle obstacle;
+    obstacle.up = up;
+    obstacle.pointCount = static_cast<uint32_t>(points.size());
+
+    // Базис горизонтальной плоскости
+    glm::vec3 reference = std::abs(up.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 0, 1);
+    const glm::vec3 e1 = glm::normalize(reference - up * glm::dot(reference, up));
+    const glm::vec3 e2 = glm::cross(up, e1);
+
+    glm::vec3 centroid(0.0f);
+    for (const glm::vec3 &point : points) {
+        centroid += point;
+    }
+    centroid /= static_cast<float>(points.size());
+    obstacle.centroid = centroid;
+
+    // Главная ось разброса в горизонтальной плоскости (ковариация 2x2)
+    float saa = 0.0f;
+    float sab = 0.0f;
+    float sbb = 0.0f;
+    for (const glm::vec3 &point : points) {
+        const glm::vec3 offset = point - centroid;
+        const float a = glm::dot(offset, e1);
+        const float b = glm::dot(offset, e2);
+        saa += a * a;
+        sab += a * b;
+        sbb += b * b;
+    }
+    const float angle = 0.5f * std::atan2(2.0f * sab, saa - sbb);
+    obstacle.axisU = e1 * std::cos(angle) + e2 * std::sin(angle);
+    obstacle.axisV = glm::cross(up, obstacle.axisU);
+
+    glm::vec3 minimum(std::numeric_limits<float>::max());
+    glm::vec3 maximum(std::numeric_limits<float>::lowest());
+    for (const glm::vec3 &point : points) {
+        const glm::vec3 local(glm::dot(point, obstacle.axisU), glm::dot(point, obstacle.axisV), glm::dot(point, up));
+        minimum = glm::min(minimum, local);
+        maximum = glm::max(maximum, local);
+    }
+    const glm::vec3 middle = 0.5f * (minimum + maximum);
+    obstacle.center = obstacle.axisU * middle.x + obstacle.axisV * middle.y + up * middle.z;
+    obstacle.halfExtent = 0.5f * (maximum - minimum);
+    return obstacle;
+}
+
+void ObstacleClusterer::associate(std::vector<DetectedObstacle> &obstacles)
+{
+    struct Candidate {
+        float distance;
+        uint32_t obstacle;
+        uint32_t track;
+    };
+
+    // Жадно от ближайших пар
+    std::vector<Candidate> candidates;
+    const float maxSquared = m_options.matchDistance * m_options.matchDistance;
+    for (uint32_t o = 0; o < obstacles.size(); ++o) {
+        for (uint32_t t = 0; t < m_tracks.size(); ++t) {
+            const glm::vec3 delta = obstacles[o].centroid - m_tracks[t].centroid;
+            const float squared = glm::dot(delta, delta);
+            if (squared <= maxSquared) {
+                candidates.push_back({squared, o, t});
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+        return a.distance < b.distance;
+    });
+
+    std::vector<uint8_t> obstacleMatched(obstacles.size(), 0);
+    std::vector<uint8_t> trackMatched(m_tracks.size(), 0);
+    for (const Candidate &candidate : candidates) {
+        if (obstacleMatched[candidate.obstacle] || trackMatched[candidate.track]) {
+            continue;
+        }
+        obstacleMatched[candidate.obstacle] = 1;
+        trackMatched[candidate.track] = 1;
+
+        Track &track = m_tracks[candidate.track];
+        DetectedObstacle &obstacle = obstacles[candidate.obstacle];
+        track.centroid = obstacle.centroid;
+        track.missed = 0;
+        ++track.age;
+        obstacle.trackId = track.id;
+        obstacle.age = track.age;
+    }
+
+    // Треки без пары стареют, новые кластеры открывают треки
+    size_t kept = 0;
+    for (size_t t = 0; t < m_tracks.size(); ++t) {
+        if (!trackMatched[t] && ++m_tracks[t].missed > m_options.maxMissedFrames) {
+            continue;
+        }
+        m_tracks[kept++] = m_tracks[t];
+    }
+    m_tracks.resize(kept);
+
+    for (size_t o = 0; o < obstacles.size(); ++o) {
+        if (obstacleMatched[o]) {
+            continue;
+        }
+        Track track;
+        track.id = m_nextTrackId++;
+        track.centroid = obstacles[o].centroid;
+        track.age = 1;
+        track.missed = 0;
+        m_tracks.push_back(track);
+        obstacles[o].trackId = track.id;
+        obstacles[o].age = track.age;
+    }
+}
+
+} // namespace LensEngine
@@ -0,0 +1,264 @@
+#include "OrganizedPointCloud.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace LensEngine {
+
+namespace {
+// Каналы интегрального изображения
+enum Channel {
+    kCount = 0,
+    kSumX, kSumY, kSumZ,
+    kSumXX, kSumXY, kSumXZ, kSumYY, kSumYZ, kSumZZ,
+    kEdges,
+    kChannels
+};
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Наименьшее собственное число и вектор симметричной 3x3 матрицы (тригонометрическая формула).
+// false - матрица вырождена (все собственные числа равны)
+bool smallestEigen(const double a[3][3], double &eigenvalue, glm::vec3 &eigenvector, double &trace)
+{
+    trace = a[0][0] + a[1][1] + a[2][2];
+    const double offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+    const double q = trace / 3.0;
+    const double d0 = a[0][0] - q;
+    const double d1 = a[1][1] - q;
+    const double d2 = a[2][2] - q;
+    const double p2 = d0 * d0 + d1 * d1 + d2 * d2 + 2.0 * offDiagonal;
+    if (p2 <= 1e-30) {
+        return false;
+    }
+
+    const double p = std::sqrt(p2 / 6.0);
+    const double b[3][3] = {
+        {d0 / p, a[0][1] / p, a[0][2] / p},
+        {a[1][0] / p, d1 / p, a[1][2] / p},
+        {a[2][0] / p, a[2][1] / p, d2 / p}
+    };
+    const double determinant = b[0][0] * (b[1][1] * b[2][2] - b[1][2] * b[2][1])
+                             - b[0][1] * (b[1][0] * b[2][2] - b[1][2] * b[2][0])
+                             + b[0][2] * (b[1][0] * b[2][1] - b[1][1] * b[2][0]);
+    const double r = std::min(1.0, std::max(-1.0, determinant / 2.0));
+    const double phi = std::acos(r) / 3.0;
+    eigenvalue = q + 2.0 * p * std::cos(phi + 2.0 * kPi / 3.0);
+
+    // Вектор ядра (A - lambda I): наибольшее векторное произведение пар строк
+    const double rows[3][3] = {
+        {a[0][0] - eigenvalue, a[0][1], a[0][2]},
+        {a[1][0], a[1][1] - eigenvalue, a[1][2]},
+        {a[2][0], a[2][1], a[2][2] - eigenvalue}
+    };
+    double best[3] = {0.0, 0.0, 0.0};
+    double bestLength = 0.0;
+    const int pairs[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+    for (const auto &pair : pairs) {
+        const double *r0 = rows[pair[0]];
+        const double *r1 = rows[pair[1]];
+        const double c[3] = {
+            r0[1] * r1[2] - r0[2] * r1[1],
+            r0[2] * r1[0] - r0[0] * r1[2],
+            r0[0] * r1[1] - r0[1] * r1[0]
+        };
+        const double length = c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+        if (length > bestLength) {
+            bestLength = length;
+            best[0] = c[0];
+            best[1] = c[1];
+            best[2] = c[2];
+        }
+    }
+    if (bestLength <= 1e-30) {
+        return false;
+    }
+
+    const double inverseLength = 1.0 / std::sqrt(bestLength);
+    eigenvector = glm::vec3(static_cast<float>(best[0] * inverseLength),
+                            static_cast<float>(best[1] * inverseLength),
+                            static_cast<float>(best[2] * inverseLength));
+    return true;
+}
+}
+
+// ============================================================================
+// OrganizedPointCloud
+// ============================================================================
+
+void OrganizedPointCloud::resize(uint32_t gridWidth, uint32_t gridHeight)
+{
+    width = gridWidth;
+    height = gridHeight;
+    const size_t cells = static_cast<size_t>(gridWidth) * gridHeight;
+    x.resize(cells);
+    y.resize(cells);
+    z.resize(cells);
+    weight.resize(cells);
+    valid.assign(cells, 0);
+    validCount = 0;
+    normals.clear();
+    curvature.clear();
+}
+
+void OrganizedPointCloud::gatherNormals(std::vector<glm::vec3> &output) const
+{
+    output.clear();
+    if (!hasNormals()) {
+        return;
+    }
+    output.reserve(validCount);
+    for (size_t i = 0; i < valid.size(); ++i) {
+        if (valid[i]) {
+            output.push_back(normals[i]);
+        }
+    }
+}
+
+// ============================================================================
+// IntegralNormalEstimator
+// ============================================================================
+
+IntegralNormalEstimator::IntegralNormalEstimator()
+    : IntegralNormalEstimator(Options())
+{
+}
+
+IntegralNormalEstimator::IntegralNormalEstimator(const Options &options)
+    : m_options(options)
+{
+}
+
+size_t IntegralNormalEstimator::compute(OrganizedPointCloud &cloud)
+{
+    LENSENGINE_TRACE_SCOPE("Normals::integral");
+
+    const uint32_t width = cloud.width;
+    const uint32_t height = cloud.height;
+    const size_t cells = static_cast<size_t>(width) * height;
+    cloud.normals.assign(cells, glm::vec3(0.0f));
+    cloud.curvature.assign(cells, 0.0f);
+    if (cells == 0) {
+        return 0;
+    }
+
+    // Интегральные изображения: узел (v, u) - сумма ячеек выше и левее
+    const size_t stride = static_cast<size_t>(width) + 1;
+    m_integral.assign(stride * (static_cast<size_t>(height) + 1) * kChannels, 0.0);
+    // Соседние ячейки отстоят на step пикселей карты
+    const float depthChange = m_options.maxDepthChange * static_cast<float>(std::max<uint32_t>(1, cloud.step));
+
+    for (uint32_t v = 0; v < height; ++v) {
+        double rowSum[kChannels] = {};
+        const double *above = &m_integral[(static_cast<size_t>(v) * stride + 1) * kChannels];
+        double *current = &m_integral[(static_cast<size_t>(v + 1) * stride + 1) * kChannels];
+
+        for (uint32_t u = 0; u < width; ++u) {
+            const size_t i = cloud.index(u, v);
+            if (cloud.valid[i]) {
+                const double px = cloud.x[i];
+                const double py = cloud.y[i];
+                const double pz = cloud.z[i];
+                rowSum[kCount] += 1.0;
+                rowSum[kSumX] += px;
+                rowSum[kSumY] += py;
+                rowSum[kSumZ] += pz;
+                rowSum[kSumXX] += px * px;
+                rowSum[kSumXY] += px * py;
+                rowSum[kSumXZ] += px * pz;
+                rowSum[kSumYY] += py * py;
+                rowSum[kSumYZ] += py * pz;
+                rowSum[kSumZZ] += pz * pz;
+
+                // Разрыв с правым или нижним соседом
+                const float limit = depthChange * cloud.z[i];
+                const bool rightEdge = u + 1 < width && cloud.valid[i + 1] &&
+                                       std::abs(cloud.z[i + 1] - cloud.z[i]) > limit;
+                const bool downEdge = v + 1 < height && cloud.valid[i + width] &&
+                                      std::abs(cloud.z[i + width] - cloud.z[i]) > limit;
+                if (rightEdge || downEdge) {
+                    rowSum[kEdges] += 1.0;
+                }
+            }
+
+            for (int c = 0; c < kChannels; ++c) {
+                current[u * kChannels + c] = above[u * kChannels + c] + rowSum[c];
+            }
+        }
+    }
+
+    auto node = [this, stride](uint32_t v, uint32_t u) {
+        return &m_integral[(static_cast<size_t>(v) * stride + u) * kChannels];
+    };
+
+    size_t found = 0;
+    const uint32_t maxRadius = std::max<uint32_t>(1, m_options.radius);
+    for (uint32_t v = 0; v < height; ++v) {
+        for (uint32_t u = 0; u < width; ++u) {
+            const size_t i = cloud.index(u, v);
+            if (!cloud.valid[i]) {
+                continue;
+            }
+
+            // Окно сжимается, пока пересекает разрыв глубины
+            for (uint32_t radius = maxRadius; radius >= 1; --radius) {
+                const uint32_t u0 = u > radius ? u - radius : 0;
+                const uint32_t v0 = v > radius ? v - radius : 0;
+                const uint32_t u1 = std::min(width, u + radius + 1);
+                const uint32_t v1 = std::min(height, v + radius + 1);
+                const double *a = node(v0, u0);
+                const double *b = node(v0, u1);
+                const double *c = node(v1, u0);
+                const double *d = node(v1, u1);
+
+                double sum[kChannels];
+                for (int k = 0; k < kChannels; ++k) {
+                    sum[k] = d[k] - b[k] - c[k] + a[k];
+                }
+                if (sum[kEdges] > 0.5) {
+                    continue;
+                }
+
+                const double n = sum[kCount];
+                const double area = static_cast<double>(u1 - u0) * static_cast<double>(v1 - v0);
+                if (n < 3.0 || n < m_options.minValidFraction * area) {
+                    continue;
+                }
+
+                const double mx = sum[kSumX] / n;
+                const double my = sum[kSumY] / n;
+                const double mz = sum[kSumZ] / n;
+                double covariance[3][3];
+                covariance[0][0] = sum[kSumXX] / n - mx * mx;
+                covariance[0][1] = sum[kSumXY] / n - mx * my;
+                covariance[0][2] = sum[kSumXZ] / n - mx * mz;
+                covariance[1][1] = sum[kSumYY] / n - my * my;
+                covariance[1][2] = sum[kSumYZ] / n - my * mz;
+                covariance[2][2] = sum[kSumZZ] / n - mz * mz;
+                covariance[1][0] = covariance[0][1];
+                covariance[2][0] = covariance[0][2];
+                covariance[2][1] = covariance[1][2];
+
+                double eigenvalue = 0.0;
+                double trace = 0.0;
+                glm::vec3 normal;
+                if (!smallestEigen(covariance, eigenvalue, normal, trace)) {
+                    break;
+                }
+
+                // Нормаль смотрит на камеру (начало координат)
+                if (glm::dot(normal, cloud.point(i)) > 0.0f) {
+                    normal = -normal;
+                }
+                cloud.normals[i] = normal;
+                cloud.curvature[i] = trace > 0.0 ? static_cast<float>(std::max(0.0, eigenvalue) / trace) : 0.0f;
+                ++found;
+                break;
+            }
+        }
+    }
+
+    return found;
+}
+
+} // namespace LensEngine
@@ -0,0 +1,470 @@
+#include "PlaneRansac.h"
+#include "Profiler.h"
+#include "SimdConfig.h"
+#include <algorithm>
+#include <cmath>
+
+namespace LensEngine {
+
+namespace {
+constexpr uint32_t kSampleAttempts = 8;
+
+struct PlaneScore {
+    size_t count = 0;
+    float weight = 0.0f;
+};
+
+// Число и суммарный вес точек с |dot(n, p) - d| < threshold
+template <bool Weighted>
+PlaneScore scorePlane(const PointCloudSoA &points, size_t count, const glm::vec3 &normal,
+                      float distance, float threshold)
+{
+    const float *xs = points.x.data();
+    const float *ys = points.y.data();
+    const float *zs = points.z.data();
+    const float *ws = Weighted ? points.weight.data() : nullptr;
+
+    PlaneScore score;
+    size_t i = 0;
+
+#if defined(LENSENGINE_SIMD_SSE2)
+    const __m128 nx = _mm_set1_ps(normal.x);
+    const __m128 ny = _mm_set1_ps(normal.y);
+    const __m128 nz = _mm_set1_ps(normal.z);
+    const __m128 offset = _mm_set1_ps(-distance);
+    const __m128 limit = _mm_set1_ps(threshold);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128i counts = _mm_setzero_si128();
+    __m128 weights = _mm_setzero_ps();
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 d = _mm_add_ps(_mm_mul_ps(nx, _mm_loadu_ps(xs + i)), offset);
+        d = _mm_add_ps(d, _mm_mul_ps(ny, _mm_loadu_ps(ys + i)));
+        d = _mm_add_ps(d, _mm_mul_ps(nz, _mm_loadu_ps(zs + i)));
+        const __m128 inside = _mm_cmplt_ps(_mm_and_ps(d, absMask), limit);
+        // Маска дорожки -1, вычитание дает +1 на inlier
+        counts = _mm_sub_epi32(counts, _mm_castps_si128(inside));
+        if (Weighted) {
+            weights = _mm_add_ps(weights, _mm_and_ps(inside, _mm_loadu_ps(ws + i)));
+        }
+    }
+
+    alignas(16) int32_t laneCounts[4];
+    alignas(16) float laneWeights[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(laneCounts), counts);
+    _mm_store_ps(laneWeights, weights);
+    for (int lane = 0; lane < 4; ++lane) {
+        score.count += static_cast<size_t>(laneCounts[lane]);
+        score.weight += laneWeights[lane];
+    }
+#elif defined(LENSENGINE_SIMD_NEON)
+    const float32x4_t nx = vdupq_n_f32(normal.x);
+    const float32x4_t ny = vdupq_n_f32(normal.y);
+    const float32x4_t nz = vdupq_n_f32(normal.z);
+    const float32x4_t offset = vdupq_n_f32(-distance);
+    const float32x4_t limit = vdupq_n_f32(threshold);
+    uint32x4_t counts = vdupq_n_u32(0);
+    float32x4_t weights = vdupq_n_f32(0.0f);
+
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t d = vmlaq_f32(offset, nx, vld1q_f32(xs + i));
+        d = vmlaq_f32(d, ny, vld1q_f32(ys + i));
+        d = vmlaq_f32(d, nz, vld1q_f32(zs + i));
+        const uint32x4_t inside = vcltq_f32(vabsq_f32(d), limit);
+        counts = vsubq_u32(counts, inside);
+        if (Weighted) {
+            const uint32x4_t masked = vandq_u32(inside, vreinterpretq_u32_f32(vld1q_f32(ws + i)));
+            weights = vaddq_f32(weights, vreinterpretq_f32_u32(masked));
+        }
+    }
+
+    uint32_t laneCounts[4];
+    float laneWeights[4];
+    vst1q_u32(laneCounts, counts);
+    vst1q_f32(laneWeights, weights);
+    for (int lane = 0; lane < 4; ++lane) {
+        score.count += laneCounts[lane];
+        score.weight += laneWeights[lane];
+    }
+#endif
+
+    for (; i < count; ++i) {
+        const float d = normal.x * xs[i] + normal.y * ys[i] + normal.z * zs[i] - distance;
+        if (std::abs(d) < threshold) {
+            ++score.count;
+            score.weight += Weighted ? ws[i] : 1.0f;
+        }
+    }
+
+    if (!Weighted) {
+        score.weight = static_cast<float>(score.count);
+    }
+    return score;
+}
+
+// Собственный вектор симметричной 3x3 матрицы с наименьшим собственным числом (метод Якоби)
+glm::vec3 smallestEigenvector(double a[3][3])
+{
+    double v[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+    for (int sweep = 0; sweep < 16; ++sweep) {
+        const double offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        if (offDiagonal < 1e-30) {
+            break;
+        }
+
+        for (int p = 0; p < 2; ++p) {
+            for (int q = p + 1; q < 3; ++q) {
+                if (std::abs(a[p][q]) < 1e-300) {
+                    continue;
+                }
+                const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                const double c = 1.0 / std::sqrt(t * t + 1.0);
+                const double s = t * c;
+
+                for (int k = 0; k < 3; ++k) {
+                    const double akp = a[k][p];
+                    const double akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    const double apk = a[p][k];
+                    const double aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    const double vkp = v[k][p];
+                    const double vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    int smallest = 0;
+    for (int k = 1; k < 3; ++k) {
+        if (a[k][k] < a[smallest][smallest]) {
+            smallest = k;
+        }
+    }
+    return glm::vec3(static_cast<float>(v[0][smallest]),
+                     static_cast<float>(v[1][smallest]),
+                     static_cast<float>(v[2][smallest]));
+}
+}
+
+PlaneRansac::PlaneRansac()
+    : PlaneRansac(Options())
+{
+}
+
+PlaneRansac::PlaneRansac(const Options &options)
+    : m_options(options)
+    , m_scheduler(nullptr)
+    , m_random(std::random_device{}())
+{
+}
+
+void PlaneRansac::setOptions(const Options &options)
+{
+    m_options = options;
+}
+
+void PlaneRansac::setTaskScheduler(TaskScheduler *scheduler)
+{
+    m_scheduler = scheduler;
+}
+
+void PlaneRansac::seed(uint32_t value)
+{
+    m_random.seed(value);
+}
+
+PlaneRansac::Result PlaneRansac::fit(const PointCloudSoA &points, const std::atomic<bool> *cancel)
+{
+    return fit(points, Model::Free, glm::vec3(0, 1, 0), cancel);
+}
+
+PlaneRansac::Result PlaneRansac::fit(const PointCloudSoA &points, Model model, const glm::vec3 &up,
+                                     const std::atomic<bool> *cancel)
+{
+    LENSENGINE_TRACE_SCOPE("Ransac::fit");
+
+    Result result;
+    const size_t count = points.count;
+    if (count < 3) {
+        return result;
+    }
+
+    const bool weighted = points.weight.size() >= count;
+    float totalWeight = static_cast<float>(count);
+    if (weighted) {
+        totalWeight = 0.0f;
+        for (size_t i = 0; i < count; ++i) {
+            totalWeight += points.weight[i];
+        }
+    }
+    if (totalWeight <= 0.0f) {
+        return result;
+    }
+
+    const uint32_t maxIterations = std::max<uint32_t>(1, m_options.maxIterations);
+    const uint32_t minIterations = std::min(std::max<uint32_t>(1, m_options.minIterations), maxIterations);
+    const uint32_t batchSize = std::max<uint32_t>(1, m_options.batchSize);
+    const double logFailure = std::log(1.0 - std::min(std::max(static_cast<double>(m_options.successProbability), 0.0), 0.9999));
+    const int sampleSize = model == Model::Free ? 3 : 2;
+
+    std::uniform_int_distribution<uint32_t> pick(0, static_cast<uint32_t>(count - 1));
+
+    Hypothesis best;
+    best.normal = glm::vec3(0, 1, 0);
+    best.distance = 0.0f;
+    best.count = 0;
+    best.weight = -1.0f;
+
+    uint32_t limit = minIterations;
+    uint32_t iterations = 0;
+    while (iterations < limit) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            return Result();
+        }
+
+        // Выборка в вызывающем потоке: последовательность гипотез детерминирована
+        const uint32_t batchCount = std::min(batchSize, limit - iterations);
+        m_batch.clear();
+        for (uint32_t b = 0; b < batchCount; ++b) {
+            Hypothesis hypothesis;
+            for (uint32_t attempt = 0; attempt < kSampleAttempts; ++attempt) {
+                if (sample(points, model, up, pick, hypothesis)) {
+                    m_batch.push_back(hypothesis);
+                    break;
+                }
+            }
+        }
+        iterations += batchCount;
+
+        evaluate(points, count, weighted, m_batch);
+        for (const Hypothesis &hypothesis : m_batch) {
+            if (hypothesis.weight > best.weight) {
+                best = hypothesis;
+            }
+        }
+
+        // Итераций достаточно, чтобы с вероятностью p хотя бы раз выбрать только inliers
+        if (best.count > 0) {
+            const double inlierRatio = static_cast<double>(best.count) / static_cast<double>(count);
+            const double sampleSuccess = std::pow(inlierRatio, sampleSize);
+            double needed = static_cast<double>(minIterations);
+            if (sampleSuccess < 1.0) {
+                needed = std::ceil(logFailure / std::log(1.0 - sampleSuccess));
+            }
+            needed = std::min(std::max(needed, static_cast<double>(minIterations)), static_cast<double>(maxIterations));
+            limit = static_cast<uint32_t>(needed);
+        }
+    }
+
+    result.iterations = iterations;
+    if (best.count < 3) {
+        return result;
+    }
+
+    for (uint32_t pass = 0; pass < m_options.refineIterations; ++pass) {
+        if (!refine(points, count, weighted, model, up, best)) {
+            break;
+        }
+    }
+
+    collectInliers(points, count, best.normal, best.distance, result.inliers);
+
+    double centroid[3] = {0.0, 0.0, 0.0};
+    double centroidWeight = 0.0;
+    for (uint32_t index : result.inliers) {
+        const double w = weighted ? points.weight[index] : 1.0;
+        centroid[0] += w * points.x[index];
+        centroid[1] += w * points.y[index];
+        centroid[2] += w * points.z[index];
+        centroidWeight += w;
+    }
+
+    result.valid = true;
+    result.normal = best.normal;
+    result.distance = best.distance;
+    result.centroid = best.normal * best.distance;
+    if (centroidWeight > 0.0) {
+        result.centroid = glm::vec3(static_cast<float>(centroid[0] / centroidWeight),
+                                    static_cast<float>(centroid[1] / centroidWeight),
+                                    static_cast<float>(centroid[2] / centroidWeight));
+    }
+    result.score = std::min(1.0f, best.weight / totalWeight);
+    return result;
+}
+
+bool PlaneRansac::sample(const PointCloudSoA &points, Model model, const glm::vec3 &up,
+                         std::uniform_int_distribution<uint32_t> &pick, Hypothesis &hypothesis)
+{
+    const uint32_t i1 = pick(m_random);
+    const uint32_t i2 = pick(m_random);
+    if (i1 == i2) {
+        return false;
+    }
+    const glm::vec3 p1 = points.point(i1);
+    const glm::vec3 p2 = points.point(i2);
+    const float threshold = m_options.distanceThreshold;
+
+    glm::vec3 normal;
+    switch (model) {
+    case Model::Horizontal: {
+        // Обе точки должны лежать на одной высоте
+        if (std::abs(glm::dot(up, p2 - p1)) >= threshold) {
+            return false;
+        }
+        hypothesis.normal = up;
+        hypothesis.distance = 0.5f * (glm::dot(up, p1) + glm::dot(up, p2));
+        hypothesis.count = 0;
+        hypothesis.weight = 0.0f;
+        return true;
+    }
+    case Model::Vertical:
+        // Нормаль горизонтальна и перпендикулярна отрезку между точками
+        normal = glm::cross(up, p2 - p1);
+        break;
+    case Model::Free: {
+        const uint32_t i3 = pick(m_random);
+        if (i3 == i1 || i3 == i2) {
+            return false;
+        }
+        normal = glm::cross(p2 - p1, points.point(i3) - p1);
+        break;
+    }
+    }
+
+    // Вырожденная выборка: коллинеарные точки или вертикальный отрезок
+    const float lengthSquared = glm::dot(normal, normal);
+    if (!(lengthSquared > 1e-12f) || (model == Model::Vertical && lengthSquared < 4.0f * threshold * threshold)) {
+        return false;
+    }
+
+    hypothesis.normal = normal / std::sqrt(lengthSquared);
+    hypothesis.distance = glm::dot(hypothesis.normal, p1);
+    hypothesis.count = 0;
+    hypothesis.weight = 0.0f;
+    return true;
+}
+
+void PlaneRansac::evaluate(const PointCloudSoA &points, size_t count, bool weighted, std::vector<Hypothesis> &batch)
+{
+    const float threshold = m_options.distanceThreshold;
+    auto scoreRange = [&points, &batch, count, weighted, threshold](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Hypothesis &hypothesis = batch[i];
+            const PlaneScore score = weighted
+                ? scorePlane<true>(points, count, hypothesis.normal, hypothesis.distance, threshold)
+                : scorePlane<false>(points, count, hypothesis.normal, hypothesis.distance, threshold);
+            hypothesis.count = score.count;
+            hypothesis.weight = score.weight;
+        }
+    };
+
+    if (m_scheduler && batch.size() > 1 && count >= m_options.parallelMinPoints) {
+        m_scheduler->parallelFor(0, batch.size(), 1, scoreRange, TaskScheduler::Priority::Normal);
+    } else {
+        scoreRange(0, batch.size());
+    }
+}
+
+bool PlaneRansac::refine(const PointCloudSoA &points, size_t count, bool weighted, Model model, const glm::vec3 &up,
+                         Hypothesis &hypothesis)
+{
+    collectInliers(points, count, hypothesis.normal, hypothesis.distance, m_inliers);
+    if (m_inliers.size() < 3) {
+        return false;
+    }
+
+    // Взвешенный МНК: плоскость через центр с нормалью наименьшего разброса
+    double centroid[3] = {0.0, 0.0, 0.0};
+    double totalWeight = 0.0;
+    for (uint32_t index : m_inliers) {
+        const double w = weighted ? points.weight[index] : 1.0;
+        centroid[0] += w * points.x[index];
+        centroid[1] += w * points.y[index];
+        centroid[2] += w * points.z[index];
+        totalWeight += w;
+    }
+    if (totalWeight <= 0.0) {
+        return false;
+    }
+    for (double &c : centroid) {
+        c /= totalWeight;
+    }
+
+    double covariance[3][3] = {};
+    for (uint32_t index : m_inliers) {
+        const double w = weighted ? points.weight[index] : 1.0;
+        const double dx = points.x[index] - centroid[0];
+        const double dy = points.y[index] - centroid[1];
+        const double dz = points.z[index] - centroid[2];
+        covariance[0][0] += w * dx * dx;
+        covariance[0][1] += w * dx * dy;
+        covariance[0][2] += w * dx * dz;
+        covariance[1][1] += w * dy * dy;
+        covariance[1][2] += w * dy * dz;
+        covariance[2][2] += w * dz * dz;
+    }
+    covariance[1][0] = covariance[0][1];
+    covariance[2][0] = covariance[0][2];
+    covariance[2][1] = covariance[1][2];
+
+    // Ограниченные модели сохраняют ориентацию относительно гравитации
+    glm::vec3 normal = up;
+    if (model != Model::Horizontal) {
+        normal = smallestEigenvector(covariance);
+        if (model == Model::Vertical) {
+            normal -= up * glm::dot(normal, up);
+        }
+        const float length = glm::length(normal);
+        if (!(length > 0.5f)) {
+            return false;
+        }
+        normal /= length;
+        if (glm::dot(normal, hypothesis.normal) < 0.0f) {
+            normal = -normal;
+        }
+    }
+
+    Hypothesis refined;
+    refined.normal = normal;
+    refined.distance = glm::dot(normal, glm::vec3(static_cast<float>(centroid[0]),
+                                                  static_cast<float>(centroid[1]),
+                                                  static_cast<float>(centroid[2])));
+    const PlaneScore score = weighted
+        ? scorePlane<true>(points, count, refined.normal, refined.distance, m_options.distanceThreshold)
+        : scorePlane<false>(points, count, refined.normal, refined.distance, m_options.distanceThreshold);
+    refined.count = score.count;
+    refined.weight = score.weight;
+
+    // Уточнение не должно терять поддержку модели
+    if (refined.weight < hypothesis.weight) {
+        return false;
+    }
+    hypothesis = refined;
+    return true;
+}
+
+void PlaneRansac::collectInliers(const PointCloudSoA &points, size_t count, const glm::vec3 &normal, float distance,
+                                 std::vector<uint32_t> &inliers) const
+{
+    inliers.clear();
+    const float threshold = m_options.distanceThreshold;
+    for (size_t i = 0; i < count; ++i) {
+        const float d = normal.x * points.x[i] + normal.y * points.y[i] + normal.z * points.z[i] - distance;
+        if (std::abs(d) < threshold) {
+            inliers.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+} // namespace LensEngine
@@ -0,0 +1,247 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+
+namespace LensEngine {
+
+namespace {
+thread_local uint64_t t_currentFrame = 0;
+
+double nsToMs(uint64_t ns)
+{
+    return static_cast<double>(ns) / 1.0e6;
+}
+
+// Имена стадий - литералы из кода, но кавычки и слеши все равно экранируем
+void appendJsonString(std::string& out, const char* text)
+{
+    out += '"';
+    for (const char* c = text; c && *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out += '\\';
+        }
+        out += *c;
+    }
+    out += '"';
+}
+}
+
+// Буфер пишет только его поток; поля атомарные, чтобы выгрузка могла читать без блокировок
+struct Profiler::ThreadBuffer {
+    struct Slot {
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> frame;
+        std::atomic<uint64_t> startNs;
+        std::atomic<uint64_t> durationNs;
+    };
+
+    explicit ThreadBuffer(uint32_t id)
+        : threadId(id)
+        , slots(kEventsPerThread)
+        , head(0)
+        , clearedBefore(0)
+    {
+    }
+
+    uint32_t threadId;
+    std::vector<Slot> slots;
+    std::atomic<uint64_t> head;            // Число записанных событий
+    std::atomic<uint64_t> clearedBefore;   // События до этого номера сброшены clear()
+};
+
+Profiler::Profiler()
+    : m_enabled(false)
+    , m_originNs(nowNs())
+{
+}
+
+Profiler& Profiler::instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t Profiler::nowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint64_t Profiler::currentFrame()
+{
+    return t_currentFrame;
+}
+
+void Profiler::setCurrentFrame(uint64_t frame)
+{
+    t_currentFrame = frame;
+}
+
+Profiler::ThreadBuffer& Profiler::threadBuffer()
+{
+    // Буфер живет и после завершения потока: его события еще нужны выгрузке
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(m_buffersMutex);
+        buffer = std::make_shared<ThreadBuffer>(static_cast<uint32_t>(m_buffers.size() + 1));
+        m_buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void Profiler::record(const char* name, uint64_t frame, uint64_t startNs, uint64_t endNs)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    const uint64_t index = buffer.head.load(std::memory_order_relaxed);
+    ThreadBuffer::Slot& slot = buffer.slots[index % kEventsPerThread];
+
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.frame.store(frame, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.durationNs.store(endNs > startNs ? endNs - startNs : 0, std::memory_order_relaxed);
+    buffer.head.store(index + 1, std::memory_order_release);
+}
+
+std::vector<Profiler::Event> Profiler::collectEvents() const
+{
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(m_buffersMutex);
+        buffers = m_buffers;
+    }
+
+    std::vector<Event> events;
+    for (const auto& buffer : buffers) {
+        const uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t first = head > kEventsPerThread ? head - kEventsPerThread : 0;
+        first = std::max(first, buffer->clearedBefore.load(std::memory_order_relaxed));
+
+        std::vector<Event> threadEvents;
+        threadEvents.reserve(static_cast<size_t>(head - first));
+        for (uint64_t i = first; i < head; ++i) {
+            const ThreadBuffer::Slot& slot = buffer->slots[i % kEventsPerThread];
+            Event event;
+            event.name = slot.name.load(std::memory_order_relaxed);
+            event.frame = slot.frame.load(std::memory_order_relaxed);
+            event.startNs = slot.startNs.load(std::memory_order_relaxed);
+            event.durationNs = slot.durationNs.load(std::memory_order_relaxed);
+            event.threadId = buffer->threadId;
+            threadEvents.push_back(event);
+        }
+
+        // Пока читали, поток мог перезаписать самые старые ячейки - их отбрасываем
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t headAfter = buffer->head.load(std::memory_order_relaxed);
+        const uint64_t firstValid = headAfter >= kEventsPerThread ? headAfter - kEventsPerThread + 1 : 0;
+        const size_t skip = firstValid > first ? static_cast<size_t>(std::min(firstValid - first, head - first)) : 0;
+
+        events.insert(events.end(), threadEvents.begin() + skip, threadEvents.end());
+    }
+
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.startNs < b.startNs;
+    });
+    return events;
+}
+
+std::string Profiler::exportChromeTrace() const
+{
+    const std::vector<Event> events = collectEvents();
+
+    std::string json;
+    json.reserve(events.size() * 128 + 64);
+    json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    char buffer[160];
+    bool first = true;
+    for (const Event& event : events) {
+        if (!first) {
+            json += ',';
+        }
+        first = false;
+
+        // Chrome trace ожидает микросекунды
+        const uint64_t relativeNs = event.startNs > m_originNs ? event.startNs - m_originNs : 0;
+        json += "{\"name\":";
+        appendJsonString(json, event.name);
+        std::snprintf(buffer, sizeof(buffer),
+                      ",\"cat\":\"LensEngine\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                      "\"args\":{\"frame\":%llu}}",
+                      event.threadId,
+                      static_cast<double>(relativeNs) / 1000.0,
+                      static_cast<double>(event.durationNs) / 1000.0,
+                      static_cast<unsigned long long>(event.frame));
+        json += buffer;
+    }
+
+    json += "]}";
+    return json;
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    const std::string json = exportChromeTrace();
+    file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    return static_cast<bool>(file);
+}
+
+std::vector<Profiler::StageSummary> Profiler::getStageSummaries() const
+{
+    std::map<std::string, std::vector<uint64_t>> durations;
+    for (const Event& event : collectEvents()) {
+        if (event.name) {
+            durations[event.name].push_back(event.durationNs);
+        }
+    }
+
+    std::vector<StageSummary> summaries;
+    summaries.reserve(durations.size());
+    for (auto& entry : durations) {
+        std::vector<uint64_t>& values = entry.second;
+        std::sort(values.begin(), values.end());
+
+        // Перцентиль по ближайшему рангу
+        auto percentile = [&values](double p) {
+            const size_t rank = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+            return nsToMs(values[std::min(rank, values.size() - 1)]);
+        };
+
+        uint64_t total = 0;
+        for (uint64_t value : values) {
+            total += value;
+        }
+
+        StageSummary summary;
+        summary.name = entry.first;
+        summary.count = values.size();
+        summary.meanMs = nsToMs(total) / static_cast<double>(values.size());
+        summary.p50Ms = percentile(0.50);
+        summary.p90Ms = percentile(0.90);
+        summary.p99Ms = percentile(0.99);
+        summary.maxMs = nsToMs(values.back());
+        summaries.push_back(std::move(summary));
+    }
+    return summaries;
+}
+
+void Profiler::clear()
+{
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    for (const auto& buffer : m_buffers) {
+        buffer->clearedBefore.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+} // namespace LensEngine
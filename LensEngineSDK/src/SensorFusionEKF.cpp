@@ -1,4 +1,5 @@
 #include "SensorFusionEKF.h"
+#include "Profiler.h"
 #include <cmath>
 #include <algorithm>
 #include <chrono>
@@ -18,6 +19,10 @@ SensorFusionEKF::SensorFusionEKF()
     , m_gravity(9.81)
     , m_initialized(false)
     , m_lastUpdateTime(0)
+    , m_useSensorTimestamps(false)
+    , m_hasOdometryAnchor(false)
+    , m_anchorPosition(0.0f)
+    , m_anchorRotation(1.0f, 0.0f, 0.0f, 0.0f)
 {
     initialize();
 }
@@ -62,6 +67,7 @@ void SensorFusionEKF::initialize()
 
     m_startTime = std::chrono::steady_clock::now();
     m_lastUpdateTime = 0;
+    m_hasOdometryAnchor = false;
     m_initialized = true;
 }
 
@@ -74,13 +80,19 @@ void SensorFusionEKF::reset()
 
 void SensorFusionEKF::updateIMU(const RawIMUData &imu)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_startTime);
-    uint64_t currentTime = elapsed.count();
+    LENSENGINE_TRACE_SCOPE("EKF::updateIMU");
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    uint64_t currentTime;
+    if (m_useSensorTimestamps) {
+        currentTime = imu.timestamp;
+    } else {
+        auto now = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_startTime);
+        currentTime = elapsed.count();
+    }
     
-    double dt = (currentTime - m_lastUpdateTime) / 1000.0;
+    double dt = (static_cast<double>(currentTime) - static_cast<double>(m_lastUpdateTime)) / 1000.0;
     m_lastUpdateTime = currentTime;
 
     if (dt <= 0 || dt > 0.1) dt = 0.016; // 60 FPS
@@ -93,10 +105,14 @@ void SensorFusionEKF::updateIMU(const RawIMUData &imu)
     m_currentPose.rotation = stateToQuaternion();
     m_currentPose.timestamp = imu.timestamp;
     m_currentPose.confidence = calculatePoseConfidence();
+    m_publishedPose.store(m_currentPose);
     
-    // Вызываем колбэк
-    if (m_poseCallback) {
-        m_poseCallback(m_currentPose);
+    // Вызываем колбэк вне блокировки фильтра
+    const CameraPose pose = m_currentPose;
+    PoseCallback callback = m_poseCallback;
+    lock.unlock();
+    if (callback) {
+        callback(pose);
     }
 }
 
@@ -107,20 +123,42 @@ void SensorFusionEKF::updateFeaturePoints(const std::vector<FeaturePoint> &featu
 
 void SensorFusionEKF::updateLidar(const std::vector<glm::vec3> &lidarPoints)
 {
+    LENSENGINE_TRACE_SCOPE("EKF::updateLidar");
     std::lock_guard<std::mutex> lock(m_mutex);
     updateLidarStep(lidarPoints);
 }
 
 void SensorFusionEKF::updateVisualOdometry(const glm::vec3 &visualPosition, const glm::quat &visualRotation)
 {
+    LENSENGINE_TRACE_SCOPE("EKF::updateVisual");
     std::lock_guard<std::mutex> lock(m_mutex);
     updateVisualStep(visualPosition, visualRotation);
 }
 
+void SensorFusionEKF::updateOdometry(const RelativePoseMeasurement &measurement)
+{
+    LENSENGINE_TRACE_SCOPE("EKF::updateOdometry");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    updateOdometryStep(measurement);
+
+    // Коррекция видна читателям сразу, а не со следующим IMU сэмплом.
+    // Время позы - последний IMU сэмпл: мера не сдвигает состояние по времени
+    m_currentPose.position = stateToPosition();
+    m_currentPose.rotation = stateToQuaternion();
+    m_currentPose.confidence = calculatePoseConfidence();
+    m_publishedPose.store(m_currentPose);
+
+    const CameraPose pose = m_currentPose;
+    PoseCallback callback = m_poseCallback;
+    lock.unlock();
+    if (callback) {
+        callback(pose);
+    }
+}
+
 CameraPose SensorFusionEKF::getCurrentPose() const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_currentPose;
+    return m_publishedPose.load();
 }
 
 float SensorFusionEKF::getStability() const
@@ -146,6 +184,13 @@ void SensorFusionEKF::setNoiseParameters(double gyroNoise, double accelNoise,
     m_lidarNoise = lidarNoise;
 }
 
+void SensorFusionEKF::setUseSensorTimestamps(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_useSensorTimestamps = enabled;
+    m_lastUpdateTime = 0;
+}
+
 void SensorFusionEKF::setPoseCallback(PoseCallback callback)
 {
     m_poseCallback = callback;
@@ -218,6 +263,11 @@ void SensorFusionEKF::predictSimple(double dt, const RawIMUData &imu)
     m_state[3] = velocity.x;
     m_state[4] = velocity.y;
     m_state[5] = velocity.z;
+
+    // Неопределенность растет между мерами одометрии (диагональное приближение, как в predictStep)
+    for (int i = 0; i < STATE_SIZE; ++i) {
+        m_covariance[i * STATE_SIZE + i] += m_processNoise[i * STATE_SIZE + i] * dt;
+    }
 }
 
 void SensorFusionEKF::predictStep(double dt)
@@ -303,6 +353,148 @@ void SensorFusionEKF::updateLidarStep(const std::vector<glm::vec3> &lidarPoints)
     }
 }
 
+void SensorFusionEKF::setOdometryAnchor()
+{
+    m_anchorPosition = stateToPosition();
+    m_anchorRotation = stateToQuaternion();
+    m_hasOdometryAnchor = true;
+}
+
+void SensorFusionEKF::updateOdometryStep(const RelativePoseMeasurement &measurement)
+{
+    // Мера без опорного кадра (первый кадр, сбой ICP) - только новый якорь
+    if (!measurement.valid || !m_hasOdometryAnchor) {
+        setOdometryAnchor();
+        return;
+    }
+
+    // Камера глубины: y вниз, z вперед; устройство: y вверх, z назад (S = diag(1, -1, -1))
+    const glm::quat deviceRotation(measurement.rotation.w, measurement.rotation.x,
+                                   -measurement.rotation.y, -measurement.rotation.z);
+    const glm::vec3 deviceTranslation(measurement.translation.x, -measurement.translation.y,
+                                      -measurement.translation.z);
+    const glm::vec3 measuredPosition = m_anchorPosition + m_anchorRotation * deviceTranslation;
+    const glm::quat measuredRotation = glm::normalize(m_anchorRotation * deviceRotation);
+
+    // Блоки ковариации меры в мировой системе: M * C * M^T, M = R_anchor * S
+    const glm::vec3 axes[3] = {
+        m_anchorRotation * glm::vec3(1.0f, 0.0f, 0.0f),
+        m_anchorRotation * glm::vec3(0.0f, -1.0f, 0.0f),
+        m_anchorRotation * glm::vec3(0.0f, 0.0f, -1.0f)
+    };
+    auto worldBlock = [&measurement, &axes](int offset, std::vector<double> &output) {
+        output.assign(9, 0.0);
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                double value = 0.0;
+                for (int a = 0; a < 3; ++a) {
+                    for (int b = 0; b < 3; ++b) {
+                        value += static_cast<double>(axes[a][r]) *
+                                 measurement.covariance[(offset + a) * 6 + offset + b] *
+                                 static_cast<double>(axes[b][c]);
+                    }
+                }
+                output[r * 3 + c] = value;
+            }
+        }
+    };
+    std::vector<double> rotationNoise;
+    std::vector<double> translationNoise;
+    worldBlock(0, rotationNoise);
+    worldBlock(3, translationNoise);
+
+    // matrixInvert3x3 отсекает по абсолютному детерминанту, а блоки здесь ~1e-6:
+    // обращаем матрицу, нормированную на средний диагональный элемент
+    auto invertScaled = [this](std::vector<double> matrix, std::vector<double> &output) {
+        const double scale = (matrix[0] + matrix[4] + matrix[8]) / 3.0;
+        if (!(scale > 0.0)) {
+            return false;
+        }
+        for (double &value : matrix) {
+            value /= scale;
+        }
+        if (!matrixInvert3x3(matrix, output)) {
+            return false;
+        }
+        for (double &value : output) {
+            value /= scale;
+        }
+        return true;
+    };
+
+    // Позиция: K = P[:, 0:3] * (P_pp + R)^-1
+    std::vector<double> innovation(9);
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            innovation[r * 3 + c] = m_covariance[r * STATE_SIZE + c] + translationNoise[r * 3 + c];
+        }
+    }
+    std::vector<double> inverse;
+    if (invertScaled(innovation, inverse)) {
+        const glm::vec3 residual = measuredPosition - stateToPosition();
+        std::vector<double> gain(STATE_SIZE * 3, 0.0);
+        for (int i = 0; i < STATE_SIZE; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                for (int k = 0; k < 3; ++k) {
+                    gain[i * 3 + c] += m_covariance[i * STATE_SIZE + k] * inverse[k * 3 + c];
+                }
+            }
+        }
+        // P -= K * P[0:3, :] (строки позиции копируются до изменения)
+        const std::vector<double> positionRows(m_covariance.begin(), m_covariance.begin() + 3 * STATE_SIZE);
+        for (int i = 0; i < STATE_SIZE; ++i) {
+            m_state[i] += gain[i * 3] * residual.x + gain[i * 3 + 1] * residual.y + gain[i * 3 + 2] * residual.z;
+            for (int j = 0; j < STATE_SIZE; ++j) {
+                m_covariance[i * STATE_SIZE + j] -= gain[i * 3] * positionRows[j] +
+                                                     gain[i * 3 + 1] * positionRows[STATE_SIZE + j] +
+                                                     gain[i * 3 + 2] * positionRows[2 * STATE_SIZE + j];
+            }
+        }
+    }
+
+    // Ориентация по малому углу: P_theta ~ 4 * P(qx..qz), ошибка - левое приращение в мире
+    glm::quat current = glm::normalize(stateToQuaternion());
+    std::vector<double> angleCovariance(9);
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            angleCovariance[r * 3 + c] = 4.0 * m_covariance[(r + 7) * STATE_SIZE + (c + 7)];
+            innovation[r * 3 + c] = angleCovariance[r * 3 + c] + rotationNoise[r * 3 + c];
+        }
+    }
+    if (invertScaled(innovation, inverse)) {
+        // q и -q - один поворот: берем кратчайший
+        const glm::quat error = measuredRotation * glm::conjugate(current);
+        const double scale = error.w < 0.0f ? -2.0 : 2.0;
+        const double angleError[3] = {scale * error.x, scale * error.y, scale * error.z};
+        double gain[9] = {};
+        double correction[3] = {};
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                for (int k = 0; k < 3; ++k) {
+                    gain[r * 3 + c] += angleCovariance[r * 3 + k] * inverse[k * 3 + c];
+                }
+                correction[r] += gain[r * 3 + c] * angleError[c];
+            }
+        }
+        const glm::quat delta(1.0f, 0.5f * static_cast<float>(correction[0]), 0.5f * static_cast<float>(correction[1]),
+                              0.5f * static_cast<float>(correction[2]));
+        quaternionToState(glm::normalize(glm::normalize(delta) * current));
+
+        // P_theta = (I - K) * P_theta
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                double value = angleCovariance[r * 3 + c];
+                for (int k = 0; k < 3; ++k) {
+                    value -= gain[r * 3 + k] * angleCovariance[k * 3 + c];
+                }
+                m_covariance[(r + 7) * STATE_SIZE + (c + 7)] = 0.25 * value;
+            }
+        }
+    }
+
+    setOdometryAnchor();
+}
+
 glm::quat SensorFusionEKF::stateToQuaternion() const
 {
     return glm::quat(static_cast<float>(m_state[6]), 
@@ -0,0 +1,283 @@
+#include "SensorRecording.h"
+#include <cstring>
+#include <vector>
+
+namespace LensEngine {
+
+namespace {
+const char kMagic[8] = {'L', 'E', 'N', 'S', 'R', 'E', 'C', '1'};
+constexpr size_t kImuValueCount = 12;
+
+// Полезная нагрузка не больше 256 МБ: защита от поврежденного размера
+constexpr uint32_t kMaxPayloadSize = 256u * 1024u * 1024u;
+}
+
+// ============================================================================
+// SensorRecordWriter
+// ============================================================================
+
+SensorRecordWriter::~SensorRecordWriter()
+{
+    close();
+}
+
+bool SensorRecordWriter::open(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        return false;
+    }
+
+    const uint32_t version = SensorRecording::kVersion;
+    writeBytes(kMagic, sizeof(kMagic));
+    writeBytes(&version, sizeof(version));
+    m_recordCount = 0;
+    return static_cast<bool>(m_file);
+}
+
+void SensorRecordWriter::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file.is_open()) {
+        m_file.flush();
+        m_file.close();
+    }
+}
+
+bool SensorRecordWriter::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_file.is_open();
+}
+
+uint64_t SensorRecordWriter::recordCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_recordCount;
+}
+
+void SensorRecordWriter::writeRGB(const SharedBuffer &image, uint32_t width, uint32_t height,
+                                  uint32_t stride, uint64_t timestamp)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file.is_open()) {
+        return;
+    }
+
+    const uint32_t dimensions[3] = {width, height, stride};
+    writeHeader(SensorRecording::RecordType::RGB, timestamp,
+                static_cast<uint32_t>(sizeof(dimensions) + image.size()));
+    writeBytes(dimensions, sizeof(dimensions));
+    writeBytes(image.data(), image.size());
+}
+
+void SensorRecordWriter::writeDepth(const SharedBuffer &depth, const SharedBuffer &confidence, uint64_t timestamp)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file.is_open()) {
+        return;
+    }
+
+    const uint32_t depthSize = static_cast<uint32_t>(depth.size());
+    writeHeader(SensorRecording::RecordType::Depth, timestamp,
+                static_cast<uint32_t>(sizeof(depthSize) + depth.size() + confidence.size()));
+    writeBytes(&depthSize, sizeof(depthSize));
+    writeBytes(depth.data(), depth.size());
+    writeBytes(confidence.data(), confidence.size());
+}
+
+void SensorRecordWriter::writeConfidence(const SharedBuffer &confidence, uint64_t timestamp)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file.is_open()) {
+        return;
+    }
+
+    writeHeader(SensorRecording::RecordType::Confidence, timestamp, static_cast<uint32_t>(confidence.size()));
+    writeBytes(confidence.data(), confidence.size());
+}
+
+void SensorRecordWriter::writeIMU(const RawIMUData &imu)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file.is_open()) {
+        return;
+    }
+
+    const double values[kImuValueCount] = {
+        imu.accelX, imu.accelY, imu.accelZ,
+        imu.gyroX, imu.gyroY, imu.gyroZ,
+        imu.gravityX, imu.gravityY, imu.gravityZ,
+        imu.magX, imu.magY, imu.magZ
+    };
+    writeHeader(SensorRecording::RecordType::IMU, imu.timestamp, static_cast<uint32_t>(sizeof(values)));
+    writeBytes(values, sizeof(values));
+}
+
+void SensorRecordWriter::writeHeader(SensorRecording::RecordType type, uint64_t timestamp, uint32_t payloadSize)
+{
+    const uint8_t typeValue = static_cast<uint8_t>(type);
+    writeBytes(&typeValue, sizeof(typeValue));
+    writeBytes(&timestamp, sizeof(timestamp));
+    writeBytes(&payloadSize, sizeof(payloadSize));
+    ++m_recordCount;
+}
+
+void SensorRecordWriter::writeBytes(const void *data, size_t size)
+{
+    if (size > 0) {
+        m_file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    }
+}
+
+// ============================================================================
+// SensorRecordReader
+// ============================================================================
+
+bool SensorRecordReader::open(const std::string &path)
+{
+    close();
+    m_error.clear();
+
+    m_file.open(path, std::ios::binary);
+    if (!m_file) {
+        return fail("Cannot open recording: " + path);
+    }
+
+    char magic[sizeof(kMagic)];
+    uint32_t version = 0;
+    if (!readBytes(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        return fail("Not a LensEngine sensor recording: " + path);
+    }
+    if (!readBytes(&version, sizeof(version)) || version != SensorRecording::kVersion) {
+        return fail("Unsupported recording version");
+    }
+    return true;
+}
+
+void SensorRecordReader::close()
+{
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+}
+
+bool SensorRecordReader::next(SensorRecording::Record &record)
+{
+    if (!m_file.is_open()) {
+        return false;
+    }
+
+    uint8_t typeValue = 0;
+    if (!m_file.read(reinterpret_cast<char*>(&typeValue), sizeof(typeValue))) {
+        return false; // Конец файла
+    }
+
+    uint32_t payloadSize = 0;
+    if (!readBytes(&record.timestamp, sizeof(record.timestamp)) ||
+        !readBytes(&payloadSize, sizeof(payloadSize))) {
+        return fail("Truncated record header");
+    }
+    if (payloadSize > kMaxPayloadSize) {
+        return fail("Corrupted record size");
+    }
+
+    record.type = static_cast<SensorRecording::RecordType>(typeValue);
+    record.width = 0;
+    record.height = 0;
+    record.stride = 0;
+    record.data = SharedBuffer();
+    record.confidence = SharedBuffer();
+
+    std::vector<uint8_t> payload(payloadSize);
+    if (!readBytes(payload.data(), payload.size())) {
+        return fail("Truncated record payload");
+    }
+
+    switch (record.type) {
+    case SensorRecording::RecordType::RGB: {
+        uint32_t dimensions[3];
+        if (payload.size() < sizeof(dimensions)) {
+            return fail("Invalid RGB record");
+        }
+        std::memcpy(dimensions, payload.data(), sizeof(dimensions));
+        // Размеры из файла не доверяем: кадр должен целиком помещаться в запись
+        const uint64_t imageBytes = static_cast<uint64_t>(dimensions[2]) * dimensions[1];
+        if (dimensions[0] == 0 || dimensions[1] == 0 ||
+            dimensions[2] < static_cast<uint64_t>(dimensions[0]) * 3 ||
+            imageBytes > payload.size() - sizeof(dimensions)) {
+            return fail("Invalid RGB record");
+        }
+        record.width = dimensions[0];
+        record.height = dimensions[1];
+        record.stride = dimensions[2];
+        record.data = SharedBuffer::adopt(std::move(payload)).slice(sizeof(dimensions), payloadSize);
+        break;
+    }
+    case SensorRecording::RecordType::Depth: {
+        uint32_t depthSize = 0;
+        if (payload.size() < sizeof(depthSize)) {
+            return fail("Invalid depth record");
+        }
+        std::memcpy(&depthSize, payload.data(), sizeof(depthSize));
+        if (depthSize > payload.size() - sizeof(depthSize)) {
+            return fail("Invalid depth record");
+        }
+        // Глубина и уверенность разделяют одно хранилище записи
+        const SharedBuffer storage = SharedBuffer::adopt(std::move(payload));
+        record.data = storage.slice(sizeof(depthSize), depthSize);
+        record.confidence = storage.slice(sizeof(depthSize) + depthSize, payloadSize);
+        break;
+    }
+    case SensorRecording::RecordType::Confidence:
+        record.data = SharedBuffer::adopt(std::move(payload));
+        break;
+    case SensorRecording::RecordType::IMU: {
+        double values[kImuValueCount];
+        if (payload.size() != sizeof(values)) {
+            return fail("Invalid IMU record");
+        }
+        std::memcpy(values, payload.data(), sizeof(values));
+        record.imu.timestamp = record.timestamp;
+        record.imu.accelX = values[0];
+        record.imu.accelY = values[1];
+        record.imu.accelZ = values[2];
+        record.imu.gyroX = values[3];
+        record.imu.gyroY = values[4];
+        record.imu.gyroZ = values[5];
+        record.imu.gravityX = values[6];
+        record.imu.gravityY = values[7];
+        record.imu.gravityZ = values[8];
+        record.imu.magX = values[9];
+        record.imu.magY = values[10];
+        record.imu.magZ = values[11];
+        break;
+    }
+    default:
+        return fail("Unknown record type");
+    }
+
+    return true;
+}
+
+bool SensorRecordReader::readBytes(void *data, size_t size)
+{
+    if (size == 0) {
+        return true;
+    }
+    return static_cast<bool>(m_file.read(static_cast<char*>(data), static_cast<std::streamsize>(size)));
+}
+
+bool SensorRecordReader::fail(const std::string &error)
+{
+    m_error = error;
+    close();
+    return false;
+}
+
+} // namespace LensEngine
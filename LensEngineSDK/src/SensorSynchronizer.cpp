@@ -0,0 +1,522 @@
+#include "SensorSynchronizer.h"
+#include <algorithm>
+#include <iterator>
+
+namespace LensEngine {
+
+SensorSynchronizer::SensorSynchronizer()
+    : SensorSynchronizer(Config())
+{
+}
+
+SensorSynchronizer::SensorSynchronizer(const Config &config)
+    : m_config(config)
+    , m_hasLateDepth(false)
+    , m_hasLateConfidence(false)
+    , m_latestTimestamp(0)
+    , m_lastEmittedTimestamp(0)
+    , m_lastDepthTimestamp(0)
+    , m_lastConfidenceTimestamp(0)
+    , m_hasEmitted(false)
+    , m_depthSeen(false)
+    , m_confidenceSeen(false)
+{
+}
+
+SensorSynchronizer::~SensorSynchronizer()
+{
+}
+
+void SensorSynchronizer::pushRGB(const ARFrame &frame)
+{
+    std::vector<ARFrame> ready;
+    FrameCallback callback;
+    DropCallback dropCallback;
+    std::vector<DroppedFrame> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        updateClock(frame.timestamp);
+
+        // Кадры храним в порядке времени захвата
+        auto pos = std::upper_bound(m_pendingFrames.begin(), m_pendingFrames.end(), frame.timestamp,
+                                    [](uint64_t ts, const ARFrame &f) { return ts < f.timestamp; });
+        m_pendingFrames.insert(pos, frame);
+
+        collectReadyFrames(ready, false);
+
+        // Переполнение: самые старые кадры выдаем с тем, что есть
+        while (m_pendingFrames.size() > m_config.maxBufferedFrames) {
+            ARFrame oldest = std::move(m_pendingFrames.front());
+            m_pendingFrames.pop_front();
+            if (resolveFrame(oldest)) {
+                ready.push_back(std::move(oldest));
+            }
+        }
+
+        pruneBuffers();
+        callback = m_frameCallback;
+        dropCallback = m_dropCallback;
+        dropped.swap(m_droppedFrames);
+    }
+
+    // Колбэк вызываем вне блокировки
+    if (dropCallback) {
+        for (const auto& droppedFrame : dropped) {
+            dropCallback(droppedFrame.sequenceNumber, droppedFrame.timestamp);
+        }
+    }
+    if (callback) {
+        for (const auto& readyFrame : ready) {
+            callback(readyFrame);
+        }
+    }
+}
+
+void SensorSynchronizer::pushDepth(const LidarData &lidar)
+{
+    std::vector<ARFrame> ready;
+    FrameCallback callback;
+    DropCallback dropCallback;
+    std::vector<DroppedFrame> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        updateClock(lidar.timestamp);
+
+        m_depthSeen = true;
+        m_lastDepthTimestamp = std::max(m_lastDepthTimestamp, lidar.timestamp);
+
+        bool late = isLate(lidar.timestamp);
+        if (late) {
+            ++m_stats.lateSamples;
+            if (m_config.lateDataPolicy == LateDataPolicy::UseAsFallback) {
+                m_lateDepth.data = lidar.depthMap;
+                m_lateDepth.sequenceNumber = lidar.sequenceNumber;
+                m_lateDepth.timestamp = lidar.timestamp;
+                m_hasLateDepth = true;
+            }
+        } else {
+            MapSample sample;
+            sample.data = lidar.depthMap;
+            sample.sequenceNumber = lidar.sequenceNumber;
+            sample.timestamp = lidar.timestamp;
+            insertSorted(m_depthBuffer, std::move(sample));
+        }
+
+        // Карта уверенности, пришедшая вместе с глубиной, идет в свой поток
+        if (!lidar.confidenceMap.empty()) {
+            m_confidenceSeen = true;
+            m_lastConfidenceTimestamp = std::max(m_lastConfidenceTimestamp, lidar.timestamp);
+            if (late) {
+                if (m_config.lateDataPolicy == LateDataPolicy::UseAsFallback) {
+                    m_lateConfidence.data = lidar.confidenceMap;
+                    m_lateConfidence.sequenceNumber = lidar.sequenceNumber;
+                    m_lateConfidence.timestamp = lidar.timestamp;
+                    m_hasLateConfidence = true;
+                }
+            } else {
+                MapSample sample;
+                sample.data = lidar.confidenceMap;
+                sample.sequenceNumber = lidar.sequenceNumber;
+                sample.timestamp = lidar.timestamp;
+                insertSorted(m_confidenceBuffer, std::move(sample));
+            }
+        }
+
+        collectReadyFrames(ready, false);
+        pruneBuffers();
+        callback = m_frameCallback;
+        dropCallback = m_dropCallback;
+        dropped.swap(m_droppedFrames);
+    }
+
+    if (dropCallback) {
+        for (const auto& droppedFrame : dropped) {
+            dropCallback(droppedFrame.sequenceNumber, droppedFrame.timestamp);
+        }
+    }
+    if (callback) {
+        for (const auto& readyFrame : ready) {
+            callback(readyFrame);
+        }
+    }
+}
+
+void SensorSynchronizer::pushConfidence(const SharedBuffer &confidenceMap, uint64_t sequenceNumber, uint64_t timestamp)
+{
+    std::vector<ARFrame> ready;
+    FrameCallback callback;
+    DropCallback dropCallback;
+    std::vector<DroppedFrame> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        updateClock(timestamp);
+
+        m_confidenceSeen = true;
+        m_lastConfidenceTimestamp = std::max(m_lastConfidenceTimestamp, timestamp);
+
+        if (isLate(timestamp)) {
+            ++m_stats.lateSamples;
+            if (m_config.lateDataPolicy == LateDataPolicy::UseAsFallback) {
+                m_lateConfidence.data = confidenceMap;
+                m_lateConfidence.sequenceNumber = sequenceNumber;
+                m_lateConfidence.timestamp = timestamp;
+                m_hasLateConfidence = true;
+            }
+        } else {
+            MapSample sample;
+            sample.data = confidenceMap;
+            sample.sequenceNumber = sequenceNumber;
+            sample.timestamp = timestamp;
+            insertSorted(m_confidenceBuffer, std::move(sample));
+        }
+
+        collectReadyFrames(ready, false);
+        pruneBuffers();
+        callback = m_frameCallback;
+        dropCallback = m_dropCallback;
+        dropped.swap(m_droppedFrames);
+    }
+
+    if (dropCallback) {
+        for (const auto& droppedFrame : dropped) {
+            dropCallback(droppedFrame.sequenceNumber, droppedFrame.timestamp);
+        }
+    }
+    if (callback) {
+        for (const auto& readyFrame : ready) {
+            callback(readyFrame);
+        }
+    }
+}
+
+void SensorSynchronizer::pushIMU(const RawIMUData &imu)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    updateClock(imu.timestamp);
+
+    // IMU старше последнего выданного кадра уже не попадет в свой интервал
+    if (m_hasEmitted && imu.timestamp <= m_lastEmittedTimestamp) {
+        ++m_stats.lateSamples;
+        if (m_config.lateDataPolicy == LateDataPolicy::UseAsFallback) {
+            m_lateImu.push_back(imu);
+        }
+        return;
+    }
+
+    if (m_imuBuffer.empty() || m_imuBuffer.back().timestamp <= imu.timestamp) {
+        m_imuBuffer.push_back(imu);
+    } else {
+        auto pos = std::upper_bound(m_imuBuffer.begin(), m_imuBuffer.end(), imu.timestamp,
+                                    [](uint64_t ts, const RawIMUData &s) { return ts < s.timestamp; });
+        m_imuBuffer.insert(pos, imu);
+    }
+
+    while (m_imuBuffer.size() > m_config.maxBufferedImuSamples) {
+        m_imuBuffer.pop_front();
+        ++m_stats.overflowedSamples;
+    }
+}
+
+void SensorSynchronizer::flush()
+{
+    std::vector<ARFrame> ready;
+    FrameCallback callback;
+    DropCallback dropCallback;
+    std::vector<DroppedFrame> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        collectReadyFrames(ready, true);
+        pruneBuffers();
+        callback = m_frameCallback;
+        dropCallback = m_dropCallback;
+        dropped.swap(m_droppedFrames);
+    }
+
+    if (dropCallback) {
+        for (const auto& droppedFrame : dropped) {
+            dropCallback(droppedFrame.sequenceNumber, droppedFrame.timestamp);
+        }
+    }
+    if (callback) {
+        for (const auto& readyFrame : ready) {
+            callback(readyFrame);
+        }
+    }
+}
+
+void SensorSynchronizer::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pendingFrames.clear();
+    m_droppedFrames.clear();
+    m_depthBuffer.clear();
+    m_confidenceBuffer.clear();
+    m_imuBuffer.clear();
+    m_lateImu.clear();
+    m_lastDepth = MapSample();
+    m_lastConfidence = MapSample();
+    m_lateDepth = MapSample();
+    m_lateConfidence = MapSample();
+    m_hasLateDepth = false;
+    m_hasLateConfidence = false;
+    m_latestTimestamp = 0;
+    m_lastEmittedTimestamp = 0;
+    m_lastDepthTimestamp = 0;
+    m_lastConfidenceTimestamp = 0;
+    m_hasEmitted = false;
+    m_depthSeen = false;
+    m_confidenceSeen = false;
+    m_stats = Statistics();
+}
+
+void SensorSynchronizer::setConfig(const Config &config)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_config = config;
+}
+
+SensorSynchronizer::Config SensorSynchronizer::getConfig() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_config;
+}
+
+SensorSynchronizer::Statistics SensorSynchronizer::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void SensorSynchronizer::setFrameCallback(FrameCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frameCallback = callback;
+}
+
+void SensorSynchronizer::setDropCallback(DropCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dropCallback = callback;
+}
+
+void SensorSynchronizer::collectReadyFrames(std::vector<ARFrame> &ready, bool force)
+{
+    while (!m_pendingFrames.empty() && isResolvable(m_pendingFrames.front(), force)) {
+        ARFrame frame = std::move(m_pendingFrames.front());
+        m_pendingFrames.pop_front();
+        if (resolveFrame(frame)) {
+            ready.push_back(std::move(frame));
+        }
+    }
+}
+
+bool SensorSynchronizer::isResolvable(const ARFrame &frame, bool force) const
+{
+    if (force) {
+        return true;
+    }
+
+    // Таймаут ожидания по общему времени потоков
+    if (m_latestTimestamp >= frame.timestamp + m_config.maxWait) {
+        return true;
+    }
+
+    // Лучшей пары уже не будет, если поток ушел дальше допуска (потоки упорядочены по времени)
+    const uint64_t horizon = frame.timestamp + m_config.matchTolerance;
+    bool depthReady = !isStreamActive(m_lastDepthTimestamp, m_depthSeen, frame.timestamp) ||
+                      m_lastDepthTimestamp >= horizon;
+    bool confidenceReady = !isStreamActive(m_lastConfidenceTimestamp, m_confidenceSeen, frame.timestamp) ||
+                           m_lastConfidenceTimestamp >= horizon;
+
+    return depthReady && confidenceReady;
+}
+
+bool SensorSynchronizer::isStreamActive(uint64_t lastTimestamp, bool seen, uint64_t frameTimestamp) const
+{
+    if (!seen) {
+        return false;
+    }
+    return lastTimestamp + m_config.streamTimeout >= frameTimestamp;
+}
+
+bool SensorSynchronizer::resolveFrame(ARFrame &frame)
+{
+    const bool depthActive = isStreamActive(m_lastDepthTimestamp, m_depthSeen, frame.timestamp);
+    const bool confidenceActive = isStreamActive(m_lastConfidenceTimestamp, m_confidenceSeen, frame.timestamp);
+
+    // Политика DropFrame применяется только к живым потокам
+    MissingDataPolicy depthPolicy = m_config.missingDepthPolicy;
+    if (!depthActive && depthPolicy == MissingDataPolicy::DropFrame) {
+        depthPolicy = MissingDataPolicy::EmitWithout;
+    }
+    MissingDataPolicy confidencePolicy = m_config.missingConfidencePolicy;
+    if (!confidenceActive && confidencePolicy == MissingDataPolicy::DropFrame) {
+        confidencePolicy = MissingDataPolicy::EmitWithout;
+    }
+
+    bool keep = attachMap(m_depthBuffer, frame.timestamp, depthPolicy, m_lastDepth,
+                          m_lateDepth, m_hasLateDepth, frame.lidar.depthMap, frame.lidar.sequenceNumber);
+    if (keep) {
+        uint64_t confidenceSequence = 0;
+        keep = attachMap(m_confidenceBuffer, frame.timestamp, confidencePolicy, m_lastConfidence,
+                         m_lateConfidence, m_hasLateConfidence, frame.lidar.confidenceMap, confidenceSequence);
+        if (frame.lidar.depthMap.empty()) {
+            frame.lidar.sequenceNumber = confidenceSequence;
+        }
+    }
+
+    // IMU интервал закрывается в любом случае, чтобы сэмплы не переехали в чужой кадр
+    attachIMU(frame);
+
+    m_lastEmittedTimestamp = std::max(m_lastEmittedTimestamp, frame.timestamp);
+    m_hasEmitted = true;
+
+    if (!keep) {
+        ++m_stats.framesDropped;
+        m_droppedFrames.push_back({frame.sequenceNumber, frame.timestamp});
+        return false;
+    }
+
+    frame.lidar.timestamp = frame.timestamp;
+    ++m_stats.framesEmitted;
+    if (!frame.lidar.depthMap.empty()) {
+        ++m_stats.framesWithDepth;
+    }
+    if (!frame.lidar.confidenceMap.empty()) {
+        ++m_stats.framesWithConfidence;
+    }
+    return true;
+}
+
+bool SensorSynchronizer::attachMap(const std::deque<MapSample> &buffer, uint64_t timestamp,
+                                   MissingDataPolicy policy, MapSample &lastMatched, MapSample &lateFallback,
+                                   bool &hasLateFallback, SharedBuffer &target, uint64_t &targetSequence)
+{
+    auto nearest = findNearest(buffer, timestamp);
+    if (nearest != buffer.end() && timeDistance(nearest->timestamp, timestamp) <= m_config.matchTolerance) {
+        target = nearest->data;
+        targetSequence = nearest->sequenceNumber;
+        lastMatched = *nearest;
+        hasLateFallback = false;
+        return true;
+    }
+
+    if (hasLateFallback) {
+        target = std::move(lateFallback.data);
+        targetSequence = lateFallback.sequenceNumber;
+        lateFallback = MapSample();
+        hasLateFallback = false;
+        return true;
+    }
+
+    switch (policy) {
+    case MissingDataPolicy::EmitWithout:
+        return true;
+    case MissingDataPolicy::ReuseLast:
+        if (!lastMatched.data.empty()) {
+            target = lastMatched.data;
+            targetSequence = lastMatched.sequenceNumber;
+        }
+        return true;
+    case MissingDataPolicy::DropFrame:
+        return false;
+    }
+    return true;
+}
+
+void SensorSynchronizer::attachIMU(ARFrame &frame)
+{
+    frame.imuSamples.clear();
+
+    if (!m_lateImu.empty()) {
+        frame.imuSamples.swap(m_lateImu);
+    }
+
+    while (!m_imuBuffer.empty() && m_imuBuffer.front().timestamp <= frame.timestamp) {
+        frame.imuSamples.push_back(m_imuBuffer.front());
+        m_imuBuffer.pop_front();
+    }
+
+    if (!frame.imuSamples.empty()) {
+        frame.imu = frame.imuSamples.back();
+    }
+}
+
+void SensorSynchronizer::insertSorted(std::deque<MapSample> &buffer, MapSample &&sample)
+{
+    if (buffer.empty() || buffer.back().timestamp <= sample.timestamp) {
+        buffer.push_back(std::move(sample));
+    } else {
+        auto pos = std::upper_bound(buffer.begin(), buffer.end(), sample.timestamp,
+                                    [](uint64_t ts, const MapSample &s) { return ts < s.timestamp; });
+        buffer.insert(pos, std::move(sample));
+    }
+
+    while (buffer.size() > m_config.maxBufferedFrames) {
+        buffer.pop_front();
+        ++m_stats.overflowedSamples;
+    }
+}
+
+void SensorSynchronizer::pruneBuffers()
+{
+    // Сэмплы, которые не могут стать парой ни одному будущему кадру
+    uint64_t oldestNeeded = m_pendingFrames.empty() ? m_lastEmittedTimestamp
+                                                    : m_pendingFrames.front().timestamp;
+    if (!m_hasEmitted && m_pendingFrames.empty()) {
+        return;
+    }
+
+    auto prune = [&](std::deque<MapSample> &buffer) {
+        // Оставляем последний сэмпл: он может оказаться ближайшим для следующего кадра
+        while (buffer.size() > 1 && buffer.front().timestamp + m_config.matchTolerance < oldestNeeded) {
+            buffer.pop_front();
+        }
+    };
+    prune(m_depthBuffer);
+    prune(m_confidenceBuffer);
+}
+
+void SensorSynchronizer::updateClock(uint64_t timestamp)
+{
+    m_latestTimestamp = std::max(m_latestTimestamp, timestamp);
+}
+
+bool SensorSynchronizer::isLate(uint64_t timestamp) const
+{
+    if (!m_hasEmitted) {
+        return false;
+    }
+    // Ожидающие кадры не старше последнего выданного, поэтому сравниваем с ним
+    return timestamp + m_config.matchTolerance < m_lastEmittedTimestamp &&
+           (m_pendingFrames.empty() ||
+            timestamp + m_config.matchTolerance < m_pendingFrames.front().timestamp);
+}
+
+std::deque<SensorSynchronizer::MapSample>::const_iterator
+SensorSynchronizer::findNearest(const std::deque<MapSample> &buffer, uint64_t timestamp)
+{
+    if (buffer.empty()) {
+        return buffer.end();
+    }
+
+    // Бинарный поиск вместо линейного перебора
+    auto it = std::lower_bound(buffer.begin(), buffer.end(), timestamp,
+                               [](const MapSample &s, uint64_t ts) { return s.timestamp < ts; });
+    if (it == buffer.begin()) {
+        return it;
+    }
+    if (it == buffer.end()) {
+        return std::prev(it);
+    }
+
+    auto prev = std::prev(it);
+    return timeDistance(prev->timestamp, timestamp) <= timeDistance(it->timestamp, timestamp) ? prev : it;
+}
+
+uint64_t SensorSynchronizer::timeDistance(uint64_t a, uint64_t b)
+{
+    return a > b ? a - b : b - a;
+}
+
+} // namespace LensEngine
@@ -0,0 +1,75 @@
+#include "SharedBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace LensEngine {
+
+SharedBuffer::SharedBuffer()
+    : m_data(nullptr)
+    , m_size(0)
+{
+}
+
+SharedBuffer::SharedBuffer(std::shared_ptr<const void> owner, const uint8_t* data, size_t size)
+    : m_owner(std::move(owner))
+    , m_data(data)
+    , m_size(size)
+{
+}
+
+SharedBuffer SharedBuffer::copy(const void* data, size_t size)
+{
+    if (!data || size == 0) {
+        return SharedBuffer();
+    }
+
+    std::vector<uint8_t> storage(size);
+    std::memcpy(storage.data(), data, size);
+    return adopt(std::move(storage));
+}
+
+SharedBuffer SharedBuffer::adopt(std::vector<uint8_t>&& data)
+{
+    if (data.empty()) {
+        return SharedBuffer();
+    }
+
+    auto storage = std::make_shared<const std::vector<uint8_t>>(std::move(data));
+    const uint8_t* bytes = storage->data();
+    const size_t size = storage->size();
+    return SharedBuffer(std::move(storage), bytes, size);
+}
+
+SharedBuffer SharedBuffer::wrap(const void* data, size_t size, ReleaseCallback release)
+{
+    if (!data || size == 0) {
+        if (release) {
+            release();
+        }
+        return SharedBuffer();
+    }
+
+    // Удалитель не освобождает память сам, а возвращает ее владельцу
+    std::shared_ptr<const void> owner(data, [release = std::move(release)](const void*) {
+        if (release) {
+            release();
+        }
+    });
+    return SharedBuffer(std::move(owner), static_cast<const uint8_t*>(data), size);
+}
+
+SharedBuffer SharedBuffer::slice(size_t offset, size_t length) const
+{
+    if (offset >= m_size) {
+        return SharedBuffer();
+    }
+    length = std::min(length, m_size - offset);
+    return SharedBuffer(m_owner, m_data + offset, length);
+}
+
+std::vector<uint8_t> SharedBuffer::toVector() const
+{
+    return std::vector<uint8_t>(begin(), end());
+}
+
+} // namespace LensEngine
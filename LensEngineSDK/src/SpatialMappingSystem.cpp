@@ -1,18 +1,32 @@
 #include "SpatialMappingSystem.h"
+#include "Profiler.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <algorithm>
 #include <limits>
 
 namespace LensEngine {
 
+namespace {
+// Углы бокса объекта чуть внутрь: луч к опорной точке не задевает поверхность, на которой стоит объект
+constexpr float kOcclusionSampleScale = 0.8f;
+constexpr float kOcclusionMargin = 0.03f;       // м до точки, где попадание еще не закрывает ее
+constexpr size_t kOcclusionSamples = 9;         // Центр и 8 углов
+}
+
 SpatialMappingSystem::SpatialMappingSystem()
-    : m_floorNormal(0.0f, 1.0f, 0.0f)
+    : m_meshVersion(0)
+    , m_hasPendingMeshOptions(false)
+    , m_meshBusy(false)
+    , m_meshJobGeneration(0)
+    , m_scheduler(nullptr)
+    , m_floorNormal(0.0f, 1.0f, 0.0f)
     , m_floorHeight(0.0f)
     , m_roomBoundsMin(0.0f)
     , m_roomBoundsMax(0.0f)
     , m_hasFloor(false)
     , m_cameraPosition(0.0f)
     , m_cameraRotation(1.0f, 0.0f, 0.0f, 0.0f)
+    , m_hasCameraPose(false)
     , m_occlusionEnabled(true)
     , m_meshGenerationEnabled(true)
 {
@@ -20,6 +34,13 @@ SpatialMappingSystem::SpatialMappingSystem()
 
 SpatialMappingSystem::~SpatialMappingSystem()
 {
+    // Задача разбора очереди ссылается на объект
+    TaskScheduler::TaskHandle task;
+    {
+        std::lock_guard<std::mutex> lock(m_meshMutex);
+        task = m_meshTask;
+    }
+    task.join();
 }
 
 void SpatialMappingSystem::initialize()
@@ -29,31 +50,119 @@ void SpatialMappingSystem::initialize()
 }
 
 void SpatialMappingSystem::updateFromLiDAR(const Lidar3DProcessor::SpatialAnalysisResult &analysis,
-                                           const std::vector<glm::vec3> &points)
+                                           const LidarData &lidar, const CameraPose &pose)
 {
-    std::lock_guard<std::mutex> lock(m_dataLock);
-    
-    m_hasFloor = analysis.hasFloor;
-    m_floorHeight = analysis.floorHeight;
-    m_floorNormal = analysis.floorNormal;
-    
-    fuseSpatialData(points);
-    
-    if (m_meshGenerationEnabled) {
-        generateSpatialMesh(points);
+    LENSENGINE_TRACE_SCOPE("Mapping::updateFromLiDAR");
+    MeshFrame frame;
+    {
+        std::lock_guard<std::mutex> lock(m_dataLock);
+        updateAnalysis(analysis);
+        if (pose.timestamp != 0) {
+            fuseSpatialData(lidar.points3D, lidar.pointNormals, lidar.pointWeights, pose);
+            m_cameraPosition = pose.position;
+            m_cameraRotation = pose.rotation;
+            m_hasCameraPose = true;
+        }
+        detectRoomBounds();
+        frame.intrinsics = m_depthIntrinsics;
+    }
+
+    // Объем и меш - без блокировки данных (интеграция делится между потоками пула)
+    if (m_meshGenerationEnabled && pose.timestamp != 0 && !lidar.depthMap.empty()) {
+        frame.depth = lidar.depthMap;
+        frame.confidence = lidar.confidenceMap;
+        frame.pose = pose;
+        frame.timestamp = lidar.timestamp;
+        submitMeshFrame(std::move(frame));
+    }
+
+    if (pose.timestamp != 0 && m_occlusionEnabled) {
+        updateOcclusion();
+    }
+}
+
+void SpatialMappingSystem::submitMeshFrame(MeshFrame frame)
+{
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_meshMutex);
+        // Объем не успевает за кадрами: самый старый пропускается
+        if (m_meshFrames.size() >= kMaxPendingMeshFrames) {
+            m_meshFrames.pop_front();
+        }
+        m_meshFrames.push_back(std::move(frame));
+        // Очередь уже разбирается (возможно, этим же потоком ниже по стеку parallelFor)
+        if (m_meshBusy) {
+            return;
+        }
+        m_meshBusy = true;
+        generation = ++m_meshJobGeneration;
+    }
+    startMeshJobs(generation);
+}
+
+void SpatialMappingSystem::startMeshJobs(uint64_t generation)
+{
+    // Объем и меш не задерживают кадр: очередь разбирает фоновая задача пула
+    TaskScheduler *scheduler = m_scheduler.load(std::memory_order_acquire);
+    TaskScheduler &pool = scheduler ? *scheduler : TaskScheduler::shared();
+    TaskScheduler::TaskHandle task = pool.submit([this]() {
+        runMeshJobs();
+    }, TaskScheduler::Priority::Low);
+
+    // Задача могла уже разобрать очередь, и следующую запустил другой поток: храним самую новую
+    std::lock_guard<std::mutex> lock(m_meshMutex);
+    if (generation == m_meshJobGeneration) {
+        m_meshTask = std::move(task);
+    }
+}
+
+void SpatialMappingSystem::runMeshJobs()
+{
+    for (;;) {
+        MeshFrame frame;
+        TsdfVolume::Options options;
+        bool resetVolume = false;
+        {
+            std::lock_guard<std::mutex> lock(m_meshMutex);
+            if (m_hasPendingMeshOptions) {
+                options = m_pendingMeshOptions;
+                m_hasPendingMeshOptions = false;
+                resetVolume = true;
+            } else if (!m_meshFrames.empty()) {
+                frame = std::move(m_meshFrames.front());
+                m_meshFrames.pop_front();
+            } else {
+                m_meshBusy = false;
+                return;
+            }
+        }
+
+        TaskScheduler *scheduler = m_scheduler.load(std::memory_order_acquire);
+        m_tsdf.setTaskScheduler(scheduler);
+        m_raycaster.setTaskScheduler(scheduler);
+        if (resetVolume) {
+            m_tsdf.setOptions(options);
+            // Очищенный объем сразу отдает пустые куски вместо старых
+            generateSpatialMesh(0);
+        } else {
+            m_tsdf.integrate(frame.depth, frame.confidence, frame.intrinsics, frame.pose);
+            generateSpatialMesh(frame.timestamp);
+        }
     }
-    
-    detectRoomBounds();
 }
 
 void SpatialMappingSystem::updateCameraPose(const glm::vec3 &position, const glm::quat &rotation)
 {
-    std::lock_guard<std::mutex> lock(m_dataLock);
-    m_cameraPosition = position;
-    m_cameraRotation = rotation;
-    
+    {
+        std::lock_guard<std::mutex> lock(m_dataLock);
+        m_cameraPosition = position;
+        m_cameraRotation = rotation;
+        m_hasCameraPose = true;
+    }
+
     if (m_occlusionEnabled) {
-        calculateOcclusion();
+        updateOcclusion();
     }
 }
 
@@ -95,19 +204,68 @@ void SpatialMappingSystem::updateVirtualObjectPosition(const std::string &id, co
 
 void SpatialMappingSystem::calculateOcclusion()
 {
+    updateOcclusion();
+}
+
+void SpatialMappingSystem::updateOcclusion()
+{
+    LENSENGINE_TRACE_SCOPE("Mapping::occlusion");
+    // Лучи всех объектов одним пакетом: собираются под блокировкой, проверяются
+    // по снимку меша без нее, результат записывается по id объекта
+    std::vector<std::string> ids;
+    std::vector<MeshRaycaster::Ray> rays;
+    {
+        std::lock_guard<std::mutex> lock(m_dataLock);
+        if (!m_hasCameraPose) {
+            for (auto& [id, obj] : m_virtualObjects) {
+                obj.occlusionFactor = 0.0f;
+                obj.isOccluded = false;
+            }
+            return;
+        }
+        ids.reserve(m_virtualObjects.size());
+        rays.reserve(m_virtualObjects.size() * kOcclusionSamples);
+        for (const auto& [id, obj] : m_virtualObjects) {
+            ids.push_back(id);
+            appendOcclusionRays(obj, rays);
+        }
+    }
+    if (ids.empty()) {
+        return;
+    }
+
+    std::vector<uint8_t> results(rays.size());
+    m_raycasts.load()->occluded(rays.data(), rays.size(), results.data());
+
     std::lock_guard<std::mutex> lock(m_dataLock);
-    
-    for (auto& [id, obj] : m_virtualObjects) {
-        obj.occlusionFactor = calculateOcclusionForObject(obj);
+    for (size_t i = 0; i < ids.size(); ++i) {
+        auto it = m_virtualObjects.find(ids[i]);
+        if (it == m_virtualObjects.end()) {
+            continue;
+        }
+        size_t occluded = 0;
+        for (size_t j = 0; j < kOcclusionSamples; ++j) {
+            occluded += results[i * kOcclusionSamples + j];
+        }
+        VirtualObject &obj = it->second;
+        obj.occlusionFactor = static_cast<float>(occluded) / static_cast<float>(kOcclusionSamples);
         obj.isOccluded = obj.occlusionFactor > 0.5f;
     }
 }
 
 bool SpatialMappingSystem::isPointVisible(const glm::vec3 &point) const
 {
-    std::lock_guard<std::mutex> lock(m_dataLock);
-    // TODO: Реализовать проверку видимости
-    return true;
+    MeshRaycaster::Ray ray;
+    {
+        std::lock_guard<std::mutex> lock(m_dataLock);
+        if (!m_hasCameraPose) {
+            return true;
+        }
+        ray.origin = m_cameraPosition;
+    }
+    ray.direction = point - ray.origin;
+    ray.maxDistance = glm::length(ray.direction) - kOcclusionMargin;
+    return ray.maxDistance <= 0.0f || !m_raycasts.load()->occluded(ray);
 }
 
 bool SpatialMappingSystem::isObjectVisible(const VirtualObject &object) const
@@ -118,7 +276,45 @@ bool SpatialMappingSystem::isObjectVisible(const VirtualObject &object) const
 std::vector<SpatialMappingSystem::SpatialMesh> SpatialMappingSystem::getSpatialMeshes() const
 {
     std::lock_guard<std::mutex> lock(m_dataLock);
-    return m_spatialMeshes;
+    std::vector<SpatialMesh> result;
+    for (const SpatialMesh &mesh : m_spatialMeshes) {
+        if (!mesh.indices.empty()) {
+            result.push_back(mesh);
+        }
+    }
+    return result;
+}
+
+std::vector<SpatialMappingSystem::SpatialMesh> SpatialMappingSystem::getSpatialMeshUpdates(uint64_t sinceVersion) const
+{
+    std::lock_guard<std::mutex> lock(m_dataLock);
+    std::vector<SpatialMesh> result;
+    for (const SpatialMesh &mesh : m_spatialMeshes) {
+        if (mesh.version > sinceVersion) {
+            result.push_back(mesh);
+        }
+    }
+    return result;
+}
+
+uint64_t SpatialMappingSystem::getMeshVersion() const
+{
+    std::lock_guard<std::mutex> lock(m_dataLock);
+    return m_meshVersion;
+}
+
+bool SpatialMappingSystem::raycast(const MeshRaycaster::Ray &ray, MeshRaycaster::Hit &hit) const
+{
+    return m_raycasts.load()->raycast(ray, hit);
+}
+
+void SpatialMappingSystem::raycast(const std::vector<MeshRaycaster::Ray> &rays,
+                                   std::vector<MeshRaycaster::Hit> &hits) const
+{
+    LENSENGINE_TRACE_SCOPE("Mapping::raycast");
+    // Снимок держится до конца пакета, обновление меша публикует следующий
+    hits.resize(rays.size());
+    m_raycasts.load()->raycast(rays.data(), rays.size(), hits.data());
 }
 
 std::vector<SpatialMappingSystem::VirtualObject> SpatialMappingSystem::getVirtualObjects() const
@@ -135,7 +331,9 @@ std::vector<glm::vec3> SpatialMappingSystem::getFloorPoints() const
 {
     std::lock_guard<std::mutex> lock(m_dataLock);
     // TODO: Фильтровать точки пола
-    return m_spatialPoints;
+    std::vector<glm::vec3> points;
+    m_worldMap.extractPoints(points);
+    return points;
 }
 
 std::vector<glm::vec3> SpatialMappingSystem::getWallPoints() const
@@ -145,6 +343,18 @@ std::vector<glm::vec3> SpatialMappingSystem::getWallPoints() const
     return std::vector<glm::vec3>();
 }
 
+bool SpatialMappingSystem::getRoomBounds(glm::vec3 &boundsMin, glm::vec3 &boundsMax) const
+{
+    std::lock_guard<std::mutex> lock(m_dataLock);
+    return m_worldMap.bounds(boundsMin, boundsMax);
+}
+
+size_t SpatialMappingSystem::getMapVoxelCount() const
+{
+    std::lock_guard<std::mutex> lock(m_dataLock);
+    return m_worldMap.voxelCount();
+}
+
 void SpatialMappingSystem::setOcclusionEnabled(bool enabled)
 {
     m_occlusionEnabled = enabled;
@@ -155,9 +365,75 @@ void SpatialMappingSystem::setMeshGenerationEnabled(bool enabled)
     m_meshGenerationEnabled = enabled;
 }
 
-void SpatialMappingSystem::generateSpatialMesh(const std::vector<glm::vec3> &points)
+void SpatialMappingSystem::setMapOptions(const WorldVoxelMap::Options &options)
+{
+    std::lock_guard<std::mutex> lock(m_dataLock);
+    m_worldMap.setOptions(options);
+    detectRoomBounds();
+}
+
+void SpatialMappingSystem::setMeshOptions(const TsdfVolume::Options &options)
 {
-    // TODO: Реализовать генерацию меша
+    // Применяет задача, разбирающая очередь кадров (сейчас или после текущего кадра)
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_meshMutex);
+        m_pendingMeshOptions = options;
+        m_hasPendingMeshOptions = true;
+        if (m_meshBusy) {
+            return;
+        }
+        m_meshBusy = true;
+        generation = ++m_meshJobGeneration;
+    }
+    startMeshJobs(generation);
+}
+
+void SpatialMappingSystem::setDepthIntrinsics(const DepthIntrinsics &intrinsics)
+{
+    std::lock_guard<std::mutex> lock(m_dataLock);
+    m_depthIntrinsics = intrinsics;
+}
+
+void SpatialMappingSystem::setTaskScheduler(TaskScheduler *scheduler)
+{
+    // Применяется при следующем обновлении меша (объем и снимок BVH)
+    m_scheduler.store(scheduler, std::memory_order_release);
+}
+
+void SpatialMappingSystem::generateSpatialMesh(uint64_t timestamp)
+{
+    // Только блоки, изменившиеся с прошлого вызова; кусок заменяется по ключу блока.
+    // Marching cubes и BVH - вне блокировки, под ней только подмена готовых кусков
+    if (m_tsdf.extractChangedMeshes(m_meshUpdates) == 0) {
+        return;
+    }
+    for (const TsdfVolume::MeshBlock &block : m_meshUpdates) {
+        m_raycaster.updateChunk(block.key, block.version, block.vertices, block.indices);
+    }
+    m_raycaster.commit();
+
+    std::lock_guard<std::mutex> lock(m_dataLock);
+    m_meshVersion = m_tsdf.meshVersion();
+    for (TsdfVolume::MeshBlock &block : m_meshUpdates) {
+        auto it = m_meshIndex.find(block.key);
+        if (it == m_meshIndex.end()) {
+            it = m_meshIndex.emplace(block.key, m_spatialMeshes.size()).first;
+            m_spatialMeshes.emplace_back();
+        }
+        SpatialMesh &mesh = m_spatialMeshes[it->second];
+        mesh.vertices = std::move(block.vertices);
+        mesh.normals = std::move(block.normals);
+        mesh.indices = std::move(block.indices);
+        mesh.boundsMin = block.boundsMin;
+        mesh.boundsMax = block.boundsMax;
+        mesh.confidence = block.confidence;
+        mesh.timestamp = timestamp;
+        mesh.blockKey = block.key;
+        mesh.version = block.version;
+    }
+    // Копия разделяет BVH кусков с m_raycaster
+    m_raycasts.store(m_raycaster);
 }
 
 void SpatialMappingSystem::updateVirtualObjectMatrices()
@@ -173,35 +449,71 @@ void SpatialMappingSystem::updateVirtualObjectMatrices()
 
 void SpatialMappingSystem::detectRoomBounds()
 {
-    if (m_spatialPoints.empty()) {
-        return;
-    }
-    
-    m_roomBoundsMin = m_roomBoundsMax = m_spatialPoints[0];
-    
-    for (const auto& point : m_spatialPoints) {
-        m_roomBoundsMin = glm::min(m_roomBoundsMin, point);
-        m_roomBoundsMax = glm::max(m_roomBoundsMax, point);
+    // Карта расширяет границы при подтверждении вокселя - без прохода по точкам
+    if (!m_worldMap.bounds(m_roomBoundsMin, m_roomBoundsMax)) {
+        m_roomBoundsMin = m_roomBoundsMax = glm::vec3(0.0f);
     }
 }
 
-void SpatialMappingSystem::fuseSpatialData(const std::vector<glm::vec3> &newPoints)
+void SpatialMappingSystem::fuseSpatialData(const std::vector<glm::vec3> &newPoints,
+                                           const std::vector<glm::vec3> &normals,
+                                           const std::vector<float> &weights, const CameraPose &pose)
+{
+    m_worldMap.integrate(newPoints, normals, weights, pose);
+}
+
+void SpatialMappingSystem::updateAnalysis(const Lidar3DProcessor::SpatialAnalysisResult &analysis)
 {
-    // TODO: Реализовать слияние данных
-    m_spatialPoints.insert(m_spatialPoints.end(), newPoints.begin(), newPoints.end());
+    m_hasFloor = analysis.hasFloor;
+    m_floorHeight = analysis.floorHeight;
+    m_floorNormal = analysis.floorNormal;
 }
 
 bool SpatialMappingSystem::rayIntersectsMesh(const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection,
                                              const SpatialMesh &mesh) const
 {
-    // TODO: Реализовать проверку пересечения луча с мешем
-    return false;
+    // BVH куска строится при обновлении меша; кусок старой версии уже заменен
+    MeshRaycaster::Ray ray;
+    ray.origin = rayOrigin;
+    ray.direction = rayDirection;
+    MeshRaycaster::Hit hit;
+    return m_raycasts.load()->raycastChunk(mesh.blockKey, ray, hit);
 }
 
 float SpatialMappingSystem::calculateOcclusionForObject(const VirtualObject &object) const
 {
-    // TODO: Реализовать расчет окклюзии
-    return 0.0f;
+    if (!m_hasCameraPose) {
+        return 0.0f;
+    }
+    // Вызывается под m_dataLock: лучи по одному, без пакета на пуле
+    std::vector<MeshRaycaster::Ray> rays;
+    appendOcclusionRays(object, rays);
+    const SnapshotStore<MeshRaycaster>::Snapshot raycaster = m_raycasts.load();
+    size_t occluded = 0;
+    for (const MeshRaycaster::Ray &ray : rays) {
+        occluded += raycaster->occluded(ray) ? 1 : 0;
+    }
+    return static_cast<float>(occluded) / static_cast<float>(rays.size());
+}
+
+void SpatialMappingSystem::appendOcclusionRays(const VirtualObject &object, std::vector<MeshRaycaster::Ray> &rays) const
+{
+    // Единичный куб объекта в worldMatrix: центр и углы, сдвинутые к центру
+    const float half = 0.5f * kOcclusionSampleScale;
+    for (size_t i = 0; i < kOcclusionSamples; ++i) {
+        glm::vec4 local(0.0f, 0.0f, 0.0f, 1.0f);
+        if (i > 0) {
+            const size_t corner = i - 1;
+            local = glm::vec4(corner & 1 ? half : -half, corner & 2 ? half : -half, corner & 4 ? half : -half, 1.0f);
+        }
+        const glm::vec4 world = object.worldMatrix * local;
+        MeshRaycaster::Ray ray;
+        ray.origin = m_cameraPosition;
+        ray.direction = glm::vec3(world.x, world.y, world.z) - m_cameraPosition;
+        // Точка у самой камеры видна; 0 - луч без проверки
+        ray.maxDistance = std::max(glm::length(ray.direction) - kOcclusionMargin, 0.0f);
+        rays.push_back(ray);
+    }
 }
 
 glm::vec3 SpatialMappingSystem::projectPointToFloor(const glm::vec3 &point) const
@@ -0,0 +1,472 @@
+#include "TaskScheduler.h"
+#include <algorithm>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace LensEngine {
+
+namespace {
+// Рабочий поток знает свой пул и индекс, чтобы ставить задачи в свою очередь
+thread_local TaskScheduler *t_scheduler = nullptr;
+thread_local int t_workerIndex = -1;
+}
+
+struct TaskScheduler::TaskState {
+    std::function<void()> function;
+    Priority priority = Priority::Normal;
+    CancellationToken token;
+
+    std::mutex mutex;
+    std::condition_variable finishedCondition;
+    bool finished = false;
+    bool cancelled = false;
+    std::exception_ptr error;       // Исключение задачи, пробрасывается из wait()
+    std::vector<std::shared_ptr<TaskState>> continuations;
+};
+
+// ============================================================================
+// CancellationToken
+// ============================================================================
+
+TaskScheduler::CancellationToken::CancellationToken()
+    : m_cancelled(std::make_shared<std::atomic<bool>>(false))
+{
+}
+
+void TaskScheduler::CancellationToken::cancel()
+{
+    m_cancelled->store(true, std::memory_order_release);
+}
+
+bool TaskScheduler::CancellationToken::isCancelled() const
+{
+    return m_cancelled->load(std::memory_order_acquire);
+}
+
+// ============================================================================
+// TaskHandle
+// ============================================================================
+
+bool TaskScheduler::TaskHandle::isDone() const
+{
+    if (!m_state) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->finished;
+}
+
+bool TaskScheduler::TaskHandle::isCancelled() const
+{
+    if (!m_state) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->cancelled;
+}
+
+void TaskScheduler::TaskHandle::wait() const
+{
+    join();
+
+    std::exception_ptr error;
+    if (m_state) {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        error = m_state->error;
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void TaskScheduler::TaskHandle::join() const
+{
+    if (!m_state) {
+        return;
+    }
+
+    // В рабочем потоке помогаем пулу, иначе ожидание может занять все потоки
+    if (t_scheduler == m_scheduler) {
+        while (!isDone()) {
+            if (!m_scheduler->tryRunOne(t_workerIndex)) {
+                std::this_thread::yield();
+            }
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_state->mutex);
+    m_state->finishedCondition.wait(lock, [this]() { return m_state->finished; });
+}
+
+void TaskScheduler::TaskHandle::cancel()
+{
+    if (m_state) {
+        m_state->token.cancel();
+    }
+}
+
+TaskScheduler::TaskHandle TaskScheduler::TaskHandle::then(std::function<void()> continuation, Priority priority)
+{
+    if (!m_state || !m_scheduler) {
+        return TaskHandle();
+    }
+
+    auto child = std::make_shared<TaskState>();
+    child->function = std::move(continuation);
+    child->priority = priority;
+    child->token = m_state->token;
+
+    m_scheduler->m_activeTasks.fetch_add(1, std::memory_order_acq_rel);
+    m_scheduler->addContinuation(m_state, child);
+    return TaskHandle(m_scheduler, child);
+}
+
+// ============================================================================
+// TaskScheduler
+// ============================================================================
+
+TaskScheduler::TaskScheduler()
+    : TaskScheduler(Config())
+{
+}
+
+TaskScheduler::TaskScheduler(const Config &config)
+    : m_nextWorker(0)
+    , m_stopping(false)
+    , m_queuedTasks(0)
+    , m_activeTasks(0)
+    , m_tasksExecuted(0)
+    , m_tasksStolen(0)
+    , m_tasksCancelled(0)
+{
+    size_t threadCount = config.threadCount;
+    if (threadCount == 0) {
+        const unsigned hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    m_workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+
+    // Потоки запускаем после создания всех очередей: любой поток может перехватывать у любого
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_workers[i]->thread = std::thread(&TaskScheduler::workerLoop, this, i);
+        if (!config.coreAffinity.empty()) {
+            applyAffinity(m_workers[i]->thread, config.coreAffinity[i % config.coreAffinity.size()]);
+        }
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    // Поставленные задачи дорабатываются, новые выполняются в вызывающем потоке
+    m_stopping.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+    }
+    m_wakeCondition.notify_all();
+
+    for (auto &worker : m_workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+TaskScheduler &TaskScheduler::shared()
+{
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+TaskScheduler::TaskHandle TaskScheduler::submit(std::function<void()> task, Priority priority,
+                                                const CancellationToken &token)
+{
+    auto state = std::make_shared<TaskState>();
+    state->function = std::move(task);
+    state->priority = priority;
+    state->token = token;
+
+    m_activeTasks.fetch_add(1, std::memory_order_acq_rel);
+    enqueue(state);
+    return TaskHandle(this, state);
+}
+
+void TaskScheduler::parallelFor(size_t begin, size_t end, size_t grain,
+                                const std::function<void(size_t, size_t)> &body,
+                                Priority priority)
+{
+    if (end <= begin) {
+        return;
+    }
+
+    grain = std::max<size_t>(1, grain);
+    const size_t chunkCount = (end - begin + grain - 1) / grain;
+    if (chunkCount == 1 || m_workers.empty()) {
+        body(begin, end);
+        return;
+    }
+
+    struct Progress {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::atomic<bool> failed{false};
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+    auto progress = std::make_shared<Progress>();
+    const std::function<void(size_t, size_t)> *bodyPtr = &body;
+
+    // Части разбираются динамически: опоздавший помощник просто не найдет работы.
+    // Часть считается выполненной и при исключении, иначе вызывающий ждал бы вечно
+    auto runChunks = [progress, bodyPtr, begin, end, grain, chunkCount]() {
+        for (;;) {
+            const size_t chunk = progress->next.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= chunkCount) {
+                return;
+            }
+            if (!progress->failed.load(std::memory_order_relaxed)) {
+                const size_t chunkBegin = begin + chunk * grain;
+                const size_t chunkEnd = std::min(end, chunkBegin + grain);
+                try {
+                    (*bodyPtr)(chunkBegin, chunkEnd);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(progress->errorMutex);
+                    if (!progress->error) {
+                        progress->error = std::current_exception();
+                    }
+                    progress->failed.store(true, std::memory_order_relaxed);
+                }
+            }
+            progress->done.fetch_add(1, std::memory_order_release);
+        }
+    };
+
+    const size_t helpers = std::min(chunkCount - 1, m_workers.size());
+    for (size_t i = 0; i < helpers; ++i) {
+        submit(runChunks, priority);
+    }
+
+    runChunks();
+
+    const int workerIndex = (t_scheduler == this) ? t_workerIndex : -1;
+    while (progress->done.load(std::memory_order_acquire) < chunkCount) {
+        if (!tryRunOne(workerIndex)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Все части отработали: body больше никто не держит, можно раскручивать стек
+    if (progress->error) {
+        std::rethrow_exception(progress->error);
+    }
+}
+
+void TaskScheduler::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_idleMutex);
+    m_idleCondition.wait(lock, [this]() { return m_activeTasks.load(std::memory_order_acquire) == 0; });
+}
+
+TaskScheduler::Statistics TaskScheduler::getStatistics() const
+{
+    Statistics stats;
+    stats.tasksExecuted = m_tasksExecuted.load(std::memory_order_relaxed);
+    stats.tasksStolen = m_tasksStolen.load(std::memory_order_relaxed);
+    stats.tasksCancelled = m_tasksCancelled.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void TaskScheduler::enqueue(const std::shared_ptr<TaskState> &task)
+{
+    // После начала остановки рабочие потоки могут уже выйти: поздняя задача
+    // выполняется в вызывающем потоке, иначе она потерялась бы и wait() завис
+    if (m_stopping.load(std::memory_order_acquire)) {
+        execute(task);
+        return;
+    }
+
+    // Задача из рабочего потока идет в его очередь, внешние - по кругу
+    size_t index;
+    if (t_scheduler == this && t_workerIndex >= 0) {
+        index = static_cast<size_t>(t_workerIndex);
+    } else {
+        index = m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+    }
+
+    {
+        Worker &worker = *m_workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queues[static_cast<int>(task->priority)].push_back(task);
+    }
+
+    m_queuedTasks.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+    }
+    m_wakeCondition.notify_one();
+}
+
+void TaskScheduler::workerLoop(size_t index)
+{
+    t_scheduler = this;
+    t_workerIndex = static_cast<int>(index);
+
+    for (;;) {
+        if (tryRunOne(static_cast<int>(index))) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wakeCondition.wait(lock, [this]() {
+            return m_stopping.load(std::memory_order_acquire) ||
+                   m_queuedTasks.load(std::memory_order_acquire) > 0;
+        });
+        if (m_stopping.load(std::memory_order_acquire) &&
+            m_queuedTasks.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+bool TaskScheduler::tryRunOne(int workerIndex)
+{
+    std::shared_ptr<TaskState> task;
+    if (workerIndex >= 0) {
+        task = popLocal(static_cast<size_t>(workerIndex));
+    }
+    if (!task) {
+        task = steal(workerIndex);
+    }
+    if (!task) {
+        return false;
+    }
+
+    execute(task);
+    return true;
+}
+
+std::shared_ptr<TaskScheduler::TaskState> TaskScheduler::popLocal(size_t index)
+{
+    Worker &worker = *m_workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    for (auto &queue : worker.queues) {
+        if (!queue.empty()) {
+            std::shared_ptr<TaskState> task = std::move(queue.back());
+            queue.pop_back();
+            m_queuedTasks.fetch_sub(1, std::memory_order_acq_rel);
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<TaskScheduler::TaskState> TaskScheduler::steal(int thiefIndex)
+{
+    const size_t workerCount = m_workers.size();
+    const size_t start = thiefIndex >= 0 ? static_cast<size_t>(thiefIndex) + 1 : 0;
+
+    // Сначала задачи высокого приоритета у всех потоков, затем ниже
+    for (int priority = 0; priority < kPriorityCount; ++priority) {
+        for (size_t offset = 0; offset < workerCount; ++offset) {
+            const size_t victim = (start + offset) % workerCount;
+            if (thiefIndex >= 0 && victim == static_cast<size_t>(thiefIndex)) {
+                continue;
+            }
+
+            Worker &worker = *m_workers[victim];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto &queue = worker.queues[priority];
+            if (!queue.empty()) {
+                std::shared_ptr<TaskState> task = std::move(queue.front());
+                queue.pop_front();
+                m_queuedTasks.fetch_sub(1, std::memory_order_acq_rel);
+                if (thiefIndex >= 0) {
+                    m_tasksStolen.fetch_add(1, std::memory_order_relaxed);
+                }
+                return task;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void TaskScheduler::execute(const std::shared_ptr<TaskState> &task)
+{
+    const bool cancelled = task->token.isCancelled();
+    std::exception_ptr error;
+    if (!cancelled) {
+        // Исключение не должно останавливать рабочий поток: сохраняем его для wait()
+        try {
+            task->function();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        m_tasksExecuted.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_tasksCancelled.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::vector<std::shared_ptr<TaskState>> continuations;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->finished = true;
+        task->cancelled = cancelled;
+        task->error = error;
+        task->function = nullptr;   // Освобождаем захваченные данные сразу
+        continuations.swap(task->continuations);
+    }
+    task->finishedCondition.notify_all();
+
+    for (const auto &continuation : continuations) {
+        enqueue(continuation);
+    }
+
+    // Продолжения уже учтены в m_activeTasks, поэтому простой не наступит раньше времени
+    if (m_activeTasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_idleCondition.notify_all();
+    }
+}
+
+void TaskScheduler::addContinuation(const std::shared_ptr<TaskState> &parent, const std::shared_ptr<TaskState> &child)
+{
+    {
+        std::lock_guard<std::mutex> lock(parent->mutex);
+        if (!parent->finished) {
+            parent->continuations.push_back(child);
+            return;
+        }
+    }
+    enqueue(child);
+}
+
+void TaskScheduler::applyAffinity(std::thread &thread, int core)
+{
+    if (core < 0) {
+        return;
+    }
+#if defined(_WIN32)
+    SetThreadAffinityMask(thread.native_handle(), static_cast<DWORD_PTR>(1) << core);
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(core, &cpuSet);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(cpuSet), &cpuSet);
+#else
+    (void)thread;
+#endif
+}
+
+} // namespace LensEngine
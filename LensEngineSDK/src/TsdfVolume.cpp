@@ -0,0 +1,933 @@
+#include "TsdfVolume.h"
+#include "Profiler.h"
+#include "SimdConfig.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace LensEngine {
+
+namespace {
+constexpr float kMinVoxelSize = 0.005f;
+constexpr int32_t kGridSide = TsdfVolume::kBlockSide + 3;       // Воксели -1..9: ячейки и центральные разности
+constexpr size_t kGridVoxels = static_cast<size_t>(kGridSide) * kGridSide * kGridSide;
+constexpr int32_t kCacheSide = TsdfVolume::kBlockSide + 1;      // Нижние вершины ребер 0..8
+constexpr size_t kCacheEntries = static_cast<size_t>(kCacheSide) * kCacheSide * kCacheSide * 3;
+
+inline size_t gridIndex(int32_t x, int32_t y, int32_t z)
+{
+    return (static_cast<size_t>(z + 1) * kGridSide + static_cast<size_t>(y + 1)) * kGridSide + static_cast<size_t>(x + 1);
+}
+
+// Вершины и ребра куба в нумерации Bourke: ребро e соединяет kEdgeCorners[e][0] и [1]
+const int32_t kCornerOffset[8][3] = {
+    {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}
+};
+const uint8_t kEdgeCorners[12][2] = {
+    {0, 1}, {1, 2}, {2, 3}, {3, 0}, {4, 5}, {5, 6}, {6, 7}, {7, 4}, {0, 4}, {1, 5}, {2, 6}, {3, 7}
+};
+// Ось ребра и вершина с меньшей координатой по ней (ключ общего кэша вершин)
+const uint8_t kEdgeAxis[12] = {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2};
+const uint8_t kEdgeLower[12] = {0, 1, 3, 0, 4, 5, 7, 4, 0, 1, 2, 3};
+
+// Бит вершины - SDF < 0 (за поверхностью). Таблицы построены обходом граней куба:
+// на неоднозначной грани внутренние вершины отделены друг от друга, поэтому
+// соседние кубы режут общую грань одинаково и меш между ячейками и блоками
+// без дыр. Треугольники - против часовой стрелки со стороны SDF > 0
+const uint16_t kEdgeTable[256] = {
+    0x000, 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
+    0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
+    0x190, 0x099, 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c,
+    0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
+    0x230, 0x339, 0x033, 0x13a, 0x636, 0x73f, 0x435, 0x53c,
+    0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
+    0x3a0, 0x2a9, 0x1a3, 0x0aa, 0x7a6, 0x6af, 0x5a5, 0x4ac,
+    0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
+    0x460, 0x569, 0x663, 0x76a, 0x066, 0x16f, 0x265, 0x36c,
+    0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
+    0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0x0ff, 0x3f5, 0x2fc,
+    0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
+    0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x055, 0x15c,
+    0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
+    0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0x0cc,
+    0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
+    0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc,
+    0x0cc, 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
+    0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c,
+    0x15c, 0x055, 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
+    0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc,
+    0x2fc, 0x3f5, 0x0ff, 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
+    0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c,
+    0x36c, 0x265, 0x16f, 0x066, 0x76a, 0x663, 0x569, 0x460,
+    0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac,
+    0x4ac, 0x5a5, 0x6af, 0x7a6, 0x0aa, 0x1a3, 0x2a9, 0x3a0,
+    0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c,
+    0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x033, 0x339, 0x230,
+    0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c,
+    0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x099, 0x190,
+    0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c,
+    0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x000,
+};
+
+const int8_t kTriangleTable[256][16] = {
+    {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 8, 1, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 1, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 10, 0, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {2, 3, 8, 2, 8, 9, 2, 9, 10, -1, -1, -1, -1, -1, -1, -1},
+    {2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 2, 11, 0, 11, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 11, 1, 11, 8, 1, 8, 9, -1, -1, -1, -1, -1, -1, -1},
+    {1, 10, 11, 1, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 10, 0, 10, 11, 0, 11, 8, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 10, 0, 10, 11, 0, 11, 3, -1, -1, -1, -1, -1, -1, -1},
+    {8, 9, 10, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 7, 0, 7, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 7, 1, 7, 4, 1, 4, 9, -1, -1, -1, -1, -1, -1, -1},
+    {1, 10, 2, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 7, 0, 7, 4, 1, 10, 2, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 10, 0, 10, 2, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1},
+    {2, 3, 7, 2, 7, 4, 2, 4, 9, 2, 9, 10, -1, -1, -1, -1},
+    {2, 11, 3, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 2, 11, 0, 11, 7, 0, 7, 4, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, 2, 11, 3, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 11, 1, 11, 7, 1, 7, 4, 1, 4, 9, -1, -1, -1, -1},
+    {1, 10, 11, 1, 11, 3, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 10, 0, 10, 11, 0, 11, 7, 0, 7, 4, -1, -1, -1, -1},
+    {0, 9, 10, 0, 10, 11, 0, 11, 3, 4, 8, 7, -1, -1, -1, -1},
+    {4, 9, 10, 4, 10, 11, 4, 11, 7, -1, -1, -1, -1, -1, -1, -1},
+    {4, 5, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 4, 5, 0, 5, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 8, 1, 8, 4, 1, 4, 5, -1, -1, -1, -1, -1, -1, -1},
+    {1, 10, 2, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 1, 10, 2, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1},
+    {0, 4, 5, 0, 5, 10, 0, 10, 2, -1, -1, -1, -1, -1, -1, -1},
+    {2, 3, 8, 2, 8, 4, 2, 4, 5, 2, 5, 10, -1, -1, -1, -1},
+    {2, 11, 3, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 2, 11, 0, 11, 8, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1},
+    {0, 4, 5, 0, 5, 1, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 11, 1, 11, 8, 1, 8, 4, 1, 4, 5, -1, -1, -1, -1},
+    {1, 10, 11, 1, 11, 3, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 10, 0, 10, 11, 0, 11, 8, 4, 5, 9, -1, -1, -1, -1},
+    {0, 4, 5, 0, 5, 10, 0, 10, 11, 0, 11, 3, -1, -1, -1, -1},
+    {4, 5, 10, 4, 10, 11, 4, 11, 8, -1, -1, -1, -1, -1, -1, -1},
+    {5, 9, 8, 5, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 7, 0, 7, 5, 0, 5, 9, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 7, 0, 7, 5, 0, 5, 1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 7, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 10, 2, 5, 9, 8, 5, 8, 7, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 7, 0, 7, 5, 0, 5, 9, 1, 10, 2, -1, -1, -1, -1},
+    {0, 8, 7, 0, 7, 5, 0, 5, 10, 0, 10, 2, -1, -1, -1, -1},
+    {2, 3, 7, 2, 7, 5, 2, 5, 10, -1, -1, -1, -1, -1, -1, -1},
+    {2, 11, 3, 5, 9, 8, 5, 8, 7, -1, -1, -1, -1, -1, -1, -1},
+    {0, 2, 11, 0, 11, 7, 0, 7, 5, 0, 5, 9, -1, -1, -1, -1},
+    {0, 8, 7, 0, 7, 5, 0, 5, 1, 2, 11, 3, -1, -1, -1, -1},
+    {1, 2, 11, 1, 11, 7, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1},
+    {1, 10, 11, 1, 11, 3, 5, 9, 8, 5, 8, 7, -1, -1, -1, -1},
+    {0, 1, 10, 0, 10, 11, 0, 11, 7, 0, 7, 5, 0, 5, 9, -1},
+    {0, 8, 7, 0, 7, 5, 0, 5, 10, 0, 10, 11, 0, 11, 3, -1},
+    {5, 10, 11, 5, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 8, 1, 8, 9, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1},
+    {1, 5, 6, 1, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 1, 5, 6, 1, 6, 2, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 5, 0, 5, 6, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1},
+    {2, 3, 8, 2, 8, 9, 2, 9, 5, 2, 5, 6, -1, -1, -1, -1},
+    {2, 11, 3, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 2, 11, 0, 11, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, 2, 11, 3, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 11, 1, 11, 8, 1, 8, 9, 5, 6, 10, -1, -1, -1, -1},
+    {1, 5, 6, 1, 6, 11, 1, 11, 3, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 5, 0, 5, 6, 0, 6, 11, 0, 11, 8, -1, -1, -1, -1},
+    {0, 9, 5, 0, 5, 6, 0, 6, 11, 0, 11, 3, -1, -1, -1, -1},
+    {5, 6, 11, 5, 11, 8, 5, 8, 9, -1, -1, -1, -1, -1, -1, -1},
+    {4, 8, 7, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 7, 0, 7, 4, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, 4, 8, 7, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 7, 1, 7, 4, 1, 4, 9, 5, 6, 10, -1, -1, -1, -1},
+    {1, 5, 6, 1, 6, 2, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 7, 0, 7, 4, 1, 5, 6, 1, 6, 2, -1, -1, -1, -1},
+    {0, 9, 5, 0, 5, 6, 0, 6, 2, 4, 8, 7, -1, -1, -1, -1},
+    {2, 3, 7, 2, 7, 4, 2, 4, 9, 2, 9, 5, 2, 5, 6, -1},
+    {2, 11, 3, 4, 8, 7, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1},
+    {0, 2, 11, 0, 11, 7, 0, 7, 4, 5, 6, 10, -1, -1, -1, -1},
+    {0, 9, 1, 2, 11, 3, 4, 8, 7, 5, 6, 10, -1, -1, -1, -1},
+    {1, 2, 11, 1, 11, 7, 1, 7, 4, 1, 4, 9, 5, 6, 10, -1},
+    {1, 5, 6, 1, 6, 11, 1, 11, 3, 4, 8, 7, -1, -1, -1, -1},
+    {0, 1, 5, 0, 5, 6, 0, 6, 11, 0, 11, 7, 0, 7, 4, -1},
+    {0, 9, 5, 0, 5, 6, 0, 6, 11, 0, 11, 3, 4, 8, 7, -1},
+    {4, 9, 5, 4, 5, 6, 4, 6, 11, 4, 11, 7, -1, -1, -1, -1},
+    {4, 6, 10, 4, 10, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 4, 6, 10, 4, 10, 9, -1, -1, -1, -1, -1, -1, -1},
+    {0, 4, 6, 0, 6, 10, 0, 10, 1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 8, 1, 8, 4, 1, 4, 6, 1, 6, 10, -1, -1, -1, -1},
+    {1, 9, 4, 1, 4, 6, 1, 6, 2, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 1, 9, 4, 1, 4, 6, 1, 6, 2, -1, -1, -1, -1},
+    {0, 4, 6, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {2, 3, 8, 2, 8, 4, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1},
+    {2, 11, 3, 4, 6, 10, 4, 10, 9, -1, -1, -1, -1, -1, -1, -1},
+    {0, 2, 11, 0, 11, 8, 4, 6, 10, 4, 10, 9, -1, -1, -1, -1},
+    {0, 4, 6, 0, 6, 10, 0, 10, 1, 2, 11, 3, -1, -1, -1, -1},
+    {1, 2, 11, 1, 11, 8, 1, 8, 4, 1, 4, 6, 1, 6, 10, -1},
+    {1, 9, 4, 1, 4, 6, 1, 6, 11, 1, 11, 3, -1, -1, -1, -1},
+    {0, 1, 9, 0, 9, 4, 0, 4, 6, 0, 6, 11, 0, 11, 8, -1},
+    {0, 4, 6, 0, 6, 11, 0, 11, 3, -1, -1, -1, -1, -1, -1, -1},
+    {4, 6, 11, 4, 11, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {6, 10, 9, 6, 9, 8, 6, 8, 7, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 7, 0, 7, 6, 0, 6, 10, 0, 10, 9, -1, -1, -1, -1},
+    {0, 8, 7, 0, 7, 6, 0, 6, 10, 0, 10, 1, -1, -1, -1, -1},
+    {1, 3, 7, 1, 7, 6, 1, 6, 10, -1, -1, -1, -1, -1, -1, -1},
+    {1, 9, 8, 1, 8, 7, 1, 7, 6, 1, 6, 2, -1, -1, -1, -1},
+    {0, 3, 7, 0, 7, 6, 0, 6, 2, 0, 2, 1, 0, 1, 9, -1},
+    {0, 8, 7, 0, 7, 6, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1},
+    {2, 3, 7, 2, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {2, 11, 3, 6, 10, 9, 6, 9, 8, 6, 8, 7, -1, -1, -1, -1},
+    {0, 2, 11, 0, 11, 7, 0, 7, 6, 0, 6, 10, 0, 10, 9, -1},
+    {0, 8, 7, 0, 7, 6, 0, 6, 10, 0, 10, 1, 2, 11, 3, -1},
+    {1, 2, 11, 1, 11, 7, 1, 7, 6, 1, 6, 10, -1, -1, -1, -1},
+    {1, 9, 8, 1, 8, 7, 1, 7, 6, 1, 6, 11, 1, 11, 3, -1},
+    {0, 1, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 7, 0, 7, 6, 0, 6, 11, 0, 11, 3, -1, -1, -1, -1},
+    {6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {6, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 8, 1, 8, 9, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1},
+    {1, 10, 2, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 1, 10, 2, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 10, 0, 10, 2, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1},
+    {2, 3, 8, 2, 8, 9, 2, 9, 10, 6, 7, 11, -1, -1, -1, -1},
+    {2, 6, 7, 2, 7, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 2, 6, 0, 6, 7, 0, 7, 8, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, 2, 6, 7, 2, 7, 3, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 6, 1, 6, 7, 1, 7, 8, 1, 8, 9, -1, -1, -1, -1},
+    {1, 10, 6, 1, 6, 7, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 10, 0, 10, 6, 0, 6, 7, 0, 7, 8, -1, -1, -1, -1},
+    {0, 9, 10, 0, 10, 6, 0, 6, 7, 0, 7, 3, -1, -1, -1, -1},
+    {6, 7, 8, 6, 8, 9, 6, 9, 10, -1, -1, -1, -1, -1, -1, -1},
+    {4, 8, 11, 4, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 11, 0, 11, 6, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, 4, 8, 11, 4, 11, 6, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 11, 1, 11, 6, 1, 6, 4, 1, 4, 9, -1, -1, -1, -1},
+    {1, 10, 2, 4, 8, 11, 4, 11, 6, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 11, 0, 11, 6, 0, 6, 4, 1, 10, 2, -1, -1, -1, -1},
+    {0, 9, 10, 0, 10, 2, 4, 8, 11, 4, 11, 6, -1, -1, -1, -1},
+    {2, 3, 11, 2, 11, 6, 2, 6, 4, 2, 4, 9, 2, 9, 10, -1},
+    {2, 6, 4, 2, 4, 8, 2, 8, 3, -1, -1, -1, -1, -1, -1, -1},
+    {0, 2, 6, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, 2, 6, 4, 2, 4, 8, 2, 8, 3, -1, -1, -1, -1},
+    {1, 2, 6, 1, 6, 4, 1, 4, 9, -1, -1, -1, -1, -1, -1, -1},
+    {1, 10, 6, 1, 6, 4, 1, 4, 8, 1, 8, 3, -1, -1, -1, -1},
+    {0, 1, 10, 0, 10, 6, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 10, 0, 10, 6, 0, 6, 4, 0, 4, 8, 0, 8, 3, -1},
+    {4, 9, 10, 4, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 5, 9, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 4, 5, 9, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1},
+    {0, 4, 5, 0, 5, 1, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 8, 1, 8, 4, 1, 4, 5, 6, 7, 11, -1, -1, -1, -1},
+    {1, 10, 2, 4, 5, 9, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 1, 10, 2, 4, 5, 9, 6, 7, 11, -1, -1, -1, -1},
+    {0, 4, 5, 0, 5, 10, 0, 10, 2, 6, 7, 11, -1, -1, -1, -1},
+    {2, 3, 8, 2, 8, 4, 2, 4, 5, 2, 5, 10, 6, 7, 11, -1},
+    {2, 6, 7, 2, 7, 3, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1},
+    {0, 2, 6, 0, 6, 7, 0, 7, 8, 4, 5, 9, -1, -1, -1, -1},
+    {0, 4, 5, 0, 5, 1, 2, 6, 7, 2, 7, 3, -1, -1, -1, -1},
+    {1, 2, 6, 1, 6, 7, 1, 7, 8, 1, 8, 4, 1, 4, 5, -1},
+    {1, 10, 6, 1, 6, 7, 1, 7, 3, 4, 5, 9, -1, -1, -1, -1},
+    {0, 1, 10, 0, 10, 6, 0, 6, 7, 0, 7, 8, 4, 5, 9, -1},
+    {0, 4, 5, 0, 5, 10, 0, 10, 6, 0, 6, 7, 0, 7, 3, -1},
+    {4, 5, 10, 4, 10, 6, 4, 6, 7, 4, 7, 8, -1, -1, -1, -1},
+    {5, 9, 8, 5, 8, 11, 5, 11, 6, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 11, 0, 11, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1},
+    {0, 8, 11, 0, 11, 6, 0, 6, 5, 0, 5, 1, -1, -1, -1, -1},
+    {1, 3, 11, 1, 11, 6, 1, 6, 5, -1, -1, -1, -1, -1, -1, -1},
+    {1, 10, 2, 5, 9, 8, 5, 8, 11, 5, 11, 6, -1, -1, -1, -1},
+    {0, 3, 11, 0, 11, 6, 0, 6, 5, 0, 5, 9, 1, 10, 2, -1},
+    {0, 8, 11, 0, 11, 6, 0, 6, 5, 0, 5, 10, 0, 10, 2, -1},
+    {2, 3, 11, 2, 11, 6, 2, 6, 5, 2, 5, 10, -1, -1, -1, -1},
+    {2, 6, 5, 2, 5, 9, 2, 9, 8, 2, 8, 3, -1, -1, -1, -1},
+    {0, 2, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 3, 0, 3, 2, 0, 2, 6, 0, 6, 5, 0, 5, 1, -1},
+    {1, 2, 6, 1, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 10, 6, 1, 6, 5, 1, 5, 9, 1, 9, 8, 1, 8, 3, -1},
+    {0, 1, 10, 0, 10, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1},
+    {0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {5, 7, 11, 5, 11, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 5, 7, 11, 5, 11, 10, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, 5, 7, 11, 5, 11, 10, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 8, 1, 8, 9, 5, 7, 11, 5, 11, 10, -1, -1, -1, -1},
+    {1, 5, 7, 1, 7, 11, 1, 11, 2, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 1, 5, 7, 1, 7, 11, 1, 11, 2, -1, -1, -1, -1},
+    {0, 9, 5, 0, 5, 7, 0, 7, 11, 0, 11, 2, -1, -1, -1, -1},
+    {2, 3, 8, 2, 8, 9, 2, 9, 5, 2, 5, 7, 2, 7, 11, -1},
+    {2, 10, 5, 2, 5, 7, 2, 7, 3, -1, -1, -1, -1, -1, -1, -1},
+    {0, 2, 10, 0, 10, 5, 0, 5, 7, 0, 7, 8, -1, -1, -1, -1},
+    {0, 9, 1, 2, 10, 5, 2, 5, 7, 2, 7, 3, -1, -1, -1, -1},
+    {1, 2, 10, 1, 10, 5, 1, 5, 7, 1, 7, 8, 1, 8, 9, -1},
+    {1, 5, 7, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 5, 0, 5, 7, 0, 7, 8, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 5, 0, 5, 7, 0, 7, 3, -1, -1, -1, -1, -1, -1, -1},
+    {5, 7, 8, 5, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 8, 11, 4, 11, 10, 4, 10, 5, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 11, 0, 11, 10, 0, 10, 5, 0, 5, 4, -1, -1, -1, -1},
+    {0, 9, 1, 4, 8, 11, 4, 11, 10, 4, 10, 5, -1, -1, -1, -1},
+    {1, 3, 11, 1, 11, 10, 1, 10, 5, 1, 5, 4, 1, 4, 9, -1},
+    {1, 5, 4, 1, 4, 8, 1, 8, 11, 1, 11, 2, -1, -1, -1, -1},
+    {0, 3, 11, 0, 11, 2, 0, 2, 1, 0, 1, 5, 0, 5, 4, -1},
+    {0, 9, 5, 0, 5, 4, 0, 4, 8, 0, 8, 11, 0, 11, 2, -1},
+    {2, 3, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {2, 10, 5, 2, 5, 4, 2, 4, 8, 2, 8, 3, -1, -1, -1, -1},
+    {0, 2, 10, 0, 10, 5, 0, 5, 4, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, 2, 10, 5, 2, 5, 4, 2, 4, 8, 2, 8, 3, -1},
+    {1, 2, 10, 1, 10, 5, 1, 5, 4, 1, 4, 9, -1, -1, -1, -1},
+    {1, 5, 4, 1, 4, 8, 1, 8, 3, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 5, 0, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 5, 0, 5, 4, 0, 4, 8, 0, 8, 3, -1, -1, -1, -1},
+    {4, 9, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 7, 11, 4, 11, 10, 4, 10, 9, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, 4, 7, 11, 4, 11, 10, 4, 10, 9, -1, -1, -1, -1},
+    {0, 4, 7, 0, 7, 11, 0, 11, 10, 0, 10, 1, -1, -1, -1, -1},
+    {1, 3, 8, 1, 8, 4, 1, 4, 7, 1, 7, 11, 1, 11, 10, -1},
+    {1, 9, 4, 1, 4, 7, 1, 7, 11, 1, 11, 2, -1, -1, -1, -1},
+    {0, 3, 8, 1, 9, 4, 1, 4, 7, 1, 7, 11, 1, 11, 2, -1},
+    {0, 4, 7, 0, 7, 11, 0, 11, 2, -1, -1, -1, -1, -1, -1, -1},
+    {2, 3, 8, 2, 8, 4, 2, 4, 7, 2, 7, 11, -1, -1, -1, -1},
+    {2, 10, 9, 2, 9, 4, 2, 4, 7, 2, 7, 3, -1, -1, -1, -1},
+    {0, 2, 10, 0, 10, 9, 0, 9, 4, 0, 4, 7, 0, 7, 8, -1},
+    {0, 4, 7, 0, 7, 3, 0, 3, 2, 0, 2, 10, 0, 10, 1, -1},
+    {1, 2, 10, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 9, 4, 1, 4, 7, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 9, 0, 9, 4, 0, 4, 7, 0, 7, 8, -1, -1, -1, -1},
+    {0, 4, 7, 0, 7, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {8, 11, 10, 8, 10, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 11, 0, 11, 10, 0, 10, 9, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 11, 0, 11, 10, 0, 10, 1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 11, 1, 11, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 9, 8, 1, 8, 11, 1, 11, 2, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 11, 0, 11, 2, 0, 2, 1, 0, 1, 9, -1, -1, -1, -1},
+    {0, 8, 11, 0, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {2, 10, 9, 2, 9, 8, 2, 8, 3, -1, -1, -1, -1, -1, -1, -1},
+    {0, 2, 10, 0, 10, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 3, 0, 3, 2, 0, 2, 10, 0, 10, 1, -1, -1, -1, -1},
+    {1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 9, 8, 1, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+};
+
+#if defined(LENSENGINE_SIMD_NEON)
+// 1 / x: оценка и два шага Ньютона (vdivq_f32 есть только на AArch64)
+inline float32x4_t reciprocal(float32x4_t x)
+{
+    float32x4_t estimate = vrecpeq_f32(x);
+    estimate = vmulq_f32(vrecpsq_f32(x, estimate), estimate);
+    return vmulq_f32(vrecpsq_f32(x, estimate), estimate);
+}
+#endif
+
+// Проекция камеры глубины и параметры слияния для одного блока
+struct Projection {
+    float fx, fy, cx, cy;               // cx, cy со сдвигом 0.5: округление до ближайшего пикселя
+    float width, height;
+    uint32_t stride;
+    float minDepth;
+    float truncation;
+    float inverseTruncation;
+    float maxWeight;
+};
+
+// Слияние одного вокселя; camera - центр вокселя в системе камеры глубины
+inline bool integrateVoxel(const Projection &p, const float *depth, const glm::vec3 &camera,
+                           float &sdf, float &weight)
+{
+    if (!(camera.z >= p.minDepth)) {
+        return false;
+    }
+    const float inverseZ = 1.0f / camera.z;
+    const float u = p.fx * camera.x * inverseZ + p.cx;
+    const float v = p.fy * camera.y * inverseZ + p.cy;
+    if (!(u >= 0.0f && u < p.width && v >= 0.0f && v < p.height)) {
+        return false;
+    }
+    const float d = depth[static_cast<size_t>(v) * p.stride + static_cast<size_t>(u)];
+    const float distance = d - camera.z;
+    if (!(d > 0.0f) || distance < -p.truncation) {
+        return false;
+    }
+    const float observed = std::min(1.0f, distance * p.inverseTruncation);
+    const float updated = weight + 1.0f;
+    sdf = (sdf * weight + observed) / updated;
+    weight = std::min(updated, p.maxWeight);
+    return true;
+}
+} // namespace
+
+TsdfVolume::TsdfVolume()
+    : TsdfVolume(Options())
+{
+}
+
+TsdfVolume::TsdfVolume(const Options &options)
+    : m_options(options)
+    , m_scheduler(nullptr)
+    , m_frame(0)
+    , m_meshVersion(0)
+{
+    m_options.voxelSize = std::max(m_options.voxelSize, kMinVoxelSize);
+    m_index.setVoxelSize(blockSize());
+}
+
+void TsdfVolume::setOptions(const Options &options)
+{
+    const float voxelSize = std::max(options.voxelSize, kMinVoxelSize);
+    const bool reset = voxelSize != m_options.voxelSize ||
+                       options.truncationDistance != m_options.truncationDistance;
+    m_options = options;
+    m_options.voxelSize = voxelSize;
+    if (reset) {
+        clear();
+        m_index.setVoxelSize(blockSize());
+    }
+}
+
+void TsdfVolume::clear()
+{
+    // Потребителю уходят пустые куски вместо мешей удаленных блоков
+    for (size_t i = 0; i < m_blocks.size(); ++i) {
+        if (m_blocks[i].hasMesh) {
+            m_removed.push_back(m_index.voxels()[i].key);
+        }
+    }
+    m_index.clear();
+    m_blocks.clear();
+    m_visible.clear();
+    m_updated.clear();
+}
+
+size_t TsdfVolume::integrate(const SharedBuffer &depth, const SharedBuffer &confidence,
+                             const DepthIntrinsics &intrinsics, const CameraPose &pose)
+{
+    LENSENGINE_TRACE_SCOPE("Mapping::tsdfIntegrate");
+
+    const size_t pixels = static_cast<size_t>(intrinsics.width) * intrinsics.height;
+    if (pixels == 0 || depth.count<float>() != pixels) {
+        return 0;
+    }
+
+    // Отбор пикселей один раз на кадр: дальше глубина читается без проверок
+    const float *source = depth.as<float>();
+    const uint8_t *levels = confidence.size() == pixels ? confidence.data() : nullptr;
+    m_depth.resize(pixels);
+    for (size_t i = 0; i < pixels; ++i) {
+        const float d = source[i];
+        const bool valid = d >= m_options.minDepth && d <= m_options.maxDepth &&
+                           (!levels || levels[i] >= m_options.minConfidence);
+        m_depth[i] = valid ? d : 0.0f;
+    }
+
+    ++m_frame;
+    allocateBlocks(intrinsics, pose);
+    if (m_visible.empty()) {
+        return 0;
+    }
+
+    m_updated.assign(m_visible.size(), 0);
+    TaskScheduler &scheduler = m_scheduler ? *m_scheduler : TaskScheduler::shared();
+    scheduler.parallelFor(0, m_visible.size(), 8, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t index = m_visible[i];
+            m_updated[i] = integrateBlock(m_blocks[index], m_index.voxels()[index].key, intrinsics, pose) ? 1 : 0;
+        }
+    }, TaskScheduler::Priority::Low);
+
+    // Ячейки на границе блока читают воксели соседей с большими координатами:
+    // их меш тоже устарел
+    size_t updated = 0;
+    for (size_t i = 0; i < m_visible.size(); ++i) {
+        if (!m_updated[i]) {
+            continue;
+        }
+        ++updated;
+        const uint32_t index = m_visible[i];
+        int32_t x;
+        int32_t y;
+        int32_t z;
+        VoxelHashMap::unpackKey(m_index.voxels()[index].key, x, y, z);
+        m_blocks[index].meshDirty = true;
+        for (int32_t dz = 0; dz <= 1; ++dz) {
+            for (int32_t dy = 0; dy <= 1; ++dy) {
+                for (int32_t dx = 0; dx <= 1; ++dx) {
+                    if (dx == 0 && dy == 0 && dz == 0) {
+                        continue;
+                    }
+                    const uint32_t neighbor = m_index.find(x - dx, y - dy, z - dz);
+                    if (neighbor != VoxelHashMap::kNotFound) {
+                        m_blocks[neighbor].meshDirty = true;
+                    }
+                }
+            }
+        }
+    }
+    return updated;
+}
+
+void TsdfVolume::allocateBlocks(const DepthIntrinsics &intrinsics, const CameraPose &pose)
+{
+    m_visible.clear();
+
+    const float truncation = m_options.truncationDistance;
+    const float stepLength = std::max(std::min(truncation, blockSize() * 0.5f), m_options.voxelSize);
+    const uint32_t step = std::max<uint32_t>(1, m_options.allocationStep);
+    const float inverseFx = 1.0f / intrinsics.focalLengthX;
+    const float inverseFy = 1.0f / intrinsics.focalLengthY;
+
+    // Камера глубины: y вниз, z вперед; устройство: y вверх, z назад (S = diag(1, -1, -1))
+    const glm::vec3 axisX = pose.rotation * glm::vec3(1.0f, 0.0f, 0.0f);
+    const glm::vec3 axisY = pose.rotation * glm::vec3(0.0f, -1.0f, 0.0f);
+    const glm::vec3 axisZ = pose.rotation * glm::vec3(0.0f, 0.0f, -1.0f);
+
+    auto markVisible = [this](uint32_t index) {
+        if (index == m_blocks.size()) {
+            m_blocks.emplace_back();
+            Block &created = m_blocks.back();
+            std::fill(created.sdf, created.sdf + kBlockVoxels, 1.0f);
+            std::fill(created.weight, created.weight + kBlockVoxels, 0.0f);
+        }
+        Block &block = m_blocks[index];
+        if (block.frame != m_frame) {
+            block.frame = m_frame;
+            m_visible.push_back(index);
+        }
+    };
+
+    for (uint32_t v = 0; v < intrinsics.height; v += step) {
+        const float *row = m_depth.data() + static_cast<size_t>(v) * intrinsics.width;
+        const glm::vec3 rowRay = axisZ + axisY * ((static_cast<float>(v) - intrinsics.principalPointY) * inverseFy);
+        for (uint32_t u = 0; u < intrinsics.width; u += step) {
+            const float d = row[u];
+            if (d <= 0.0f) {
+                continue;
+            }
+            // Мировой луч на единицу глубины; блоки - вдоль полосы усечения вокруг точки
+            const glm::vec3 ray = rowRay + axisX * ((static_cast<float>(u) - intrinsics.principalPointX) * inverseFx);
+            const float far = d + truncation;
+            for (float t = std::max(d - truncation, 0.0f);; t += stepLength) {
+                const float depthAlong = std::min(t, far);
+                const glm::vec3 sample = pose.position + ray * depthAlong;
+                // Ячейка у грани блока читает воксель соседа: у грани выделяются оба блока
+                int32_t minX;
+                int32_t minY;
+                int32_t minZ;
+                int32_t maxX;
+                int32_t maxY;
+                int32_t maxZ;
+                m_index.cellOf(sample - glm::vec3(m_options.voxelSize), minX, minY, minZ);
+                m_index.cellOf(sample + glm::vec3(m_options.voxelSize), maxX, maxY, maxZ);
+                for (int32_t z = minZ; z <= maxZ; ++z) {
+                    for (int32_t y = minY; y <= maxY; ++y) {
+                        for (int32_t x = minX; x <= maxX; ++x) {
+                            markVisible(m_index.insert((glm::vec3(static_cast<float>(x), static_cast<float>(y),
+                                                                  static_cast<float>(z)) + glm::vec3(0.5f)) * blockSize()));
+                        }
+                    }
+                }
+                if (depthAlong >= far) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool TsdfVolume::integrateBlock(Block &block, uint64_t key, const DepthIntrinsics &intrinsics,
+                                const CameraPose &pose) const
+{
+    int32_t blockX;
+    int32_t blockY;
+    int32_t blockZ;
+    VoxelHashMap::unpackKey(key, blockX, blockY, blockZ);
+
+    const float voxelSize = m_options.voxelSize;
+    const glm::vec3 axisX = pose.rotation * glm::vec3(1.0f, 0.0f, 0.0f);
+    const glm::vec3 axisY = pose.rotation * glm::vec3(0.0f, -1.0f, 0.0f);
+    const glm::vec3 axisZ = pose.rotation * glm::vec3(0.0f, 0.0f, -1.0f);
+
+    // Центр вокселя (0, 0, 0) блока и шаги по мировым осям в системе камеры:
+    // координаты вокселя в камере линейны по индексам
+    const glm::vec3 origin = glm::vec3(static_cast<float>(blockX), static_cast<float>(blockY),
+                                       static_cast<float>(blockZ)) * blockSize() + glm::vec3(0.5f * voxelSize);
+    const glm::vec3 relative = origin - pose.position;
+    const glm::vec3 base(glm::dot(axisX, relative), glm::dot(axisY, relative), glm::dot(axisZ, relative));
+    const glm::vec3 stepX = glm::vec3(axisX.x, axisY.x, axisZ.x) * voxelSize;
+    const glm::vec3 stepY = glm::vec3(axisX.y, axisY.y, axisZ.y) * voxelSize;
+    const glm::vec3 stepZ = glm::vec3(axisX.z, axisY.z, axisZ.z) * voxelSize;
+
+    Projection p;
+    p.fx = intrinsics.focalLengthX;
+    p.fy = intrinsics.focalLengthY;
+    p.cx = intrinsics.principalPointX + 0.5f;
+    p.cy = intrinsics.principalPointY + 0.5f;
+    p.width = static_cast<float>(intrinsics.width);
+    p.height = static_cast<float>(intrinsics.height);
+    p.stride = intrinsics.width;
+    p.minDepth = m_options.minDepth;
+    p.truncation = m_options.truncationDistance;
+    p.inverseTruncation = 1.0f / m_options.truncationDistance;
+    p.maxWeight = std::max(m_options.maxWeight, 1.0f);
+    const float *depth = m_depth.data();
+
+    bool changed = false;
+    for (int32_t z = 0; z < kBlockSide; ++z) {
+        for (int32_t y = 0; y < kBlockSide; ++y) {
+            const glm::vec3 row = base + stepY * static_cast<float>(y) + stepZ * static_cast<float>(z);
+            float *sdf = block.sdf + (z * kBlockSide + y) * kBlockSide;
+            float *weight = block.weight + (z * kBlockSide + y) * kBlockSide;
+#if defined(LENSENGINE_SIMD_SSE2)
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            for (int32_t x = 0; x < kBlockSide; x += 4) {
+                const __m128 lane = _mm_set_ps(static_cast<float>(x + 3), static_cast<float>(x + 2),
+                                               static_cast<float>(x + 1), static_cast<float>(x));
+                const __m128 cameraX = _mm_add_ps(_mm_set1_ps(row.x), _mm_mul_ps(lane, _mm_set1_ps(stepX.x)));
+                const __m128 cameraY = _mm_add_ps(_mm_set1_ps(row.y), _mm_mul_ps(lane, _mm_set1_ps(stepX.y)));
+                const __m128 cameraZ = _mm_add_ps(_mm_set1_ps(row.z), _mm_mul_ps(lane, _mm_set1_ps(stepX.z)));
+                const __m128 front = _mm_cmpge_ps(cameraZ, _mm_set1_ps(p.minDepth));
+                // За камерой деление дает мусор, но такие дорожки уже отброшены маской
+                const __m128 inverseZ = _mm_div_ps(one, _mm_or_ps(_mm_and_ps(front, cameraZ), _mm_andnot_ps(front, one)));
+                const __m128 u = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cameraX, inverseZ), _mm_set1_ps(p.fx)), _mm_set1_ps(p.cx));
+                const __m128 v = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cameraY, inverseZ), _mm_set1_ps(p.fy)), _mm_set1_ps(p.cy));
+                const __m128 inside = _mm_and_ps(
+                    _mm_and_ps(front, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmplt_ps(u, _mm_set1_ps(p.width)))),
+                    _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmplt_ps(v, _mm_set1_ps(p.height))));
+                const int mask = _mm_movemask_ps(inside);
+                if (mask == 0) {
+                    continue;
+                }
+
+                // Выборка глубины по пикселям (gather в SSE2 нет)
+                alignas(16) float lanesU[4];
+                alignas(16) float lanesV[4];
+                alignas(16) float lanesDepth[4];
+                _mm_store_ps(lanesU, u);
+                _mm_store_ps(lanesV, v);
+                for (int lane = 0; lane < 4; ++lane) {
+                    lanesDepth[lane] = (mask >> lane) & 1
+                        ? depth[static_cast<size_t>(lanesV[lane]) * p.stride + static_cast<size_t>(lanesU[lane])]
+                        : 0.0f;
+                }
+                const __m128 d = _mm_load_ps(lanesDepth);
+                const __m128 distance = _mm_sub_ps(d, cameraZ);
+                const __m128 update = _mm_and_ps(_mm_cmpgt_ps(d, zero),
+                                                 _mm_cmpge_ps(distance, _mm_set1_ps(-p.truncation)));
+                if (_mm_movemask_ps(update) == 0) {
+                    continue;
+                }
+                const __m128 observed = _mm_min_ps(one, _mm_mul_ps(distance, _mm_set1_ps(p.inverseTruncation)));
+                const __m128 oldSdf = _mm_loadu_ps(sdf + x);
+                const __m128 oldWeight = _mm_loadu_ps(weight + x);
+                const __m128 newWeight = _mm_add_ps(oldWeight, one);
+                const __m128 newSdf = _mm_div_ps(_mm_add_ps(_mm_mul_ps(oldSdf, oldWeight), observed), newWeight);
+                const __m128 cappedWeight = _mm_min_ps(newWeight, _mm_set1_ps(p.maxWeight));
+                _mm_storeu_ps(sdf + x, _mm_or_ps(_mm_and_ps(update, newSdf), _mm_andnot_ps(update, oldSdf)));
+                _mm_storeu_ps(weight + x, _mm_or_ps(_mm_and_ps(update, cappedWeight), _mm_andnot_ps(update, oldWeight)));
+                changed = true;
+            }
+#elif defined(LENSENGINE_SIMD_NEON)
+            const float32x4_t zero = vdupq_n_f32(0.0f);
+            const float32x4_t one = vdupq_n_f32(1.0f);
+            const float laneOffsets[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+            for (int32_t x = 0; x < kBlockSide; x += 4) {
+                const float32x4_t lane = vaddq_f32(vld1q_f32(laneOffsets), vdupq_n_f32(static_cast<float>(x)));
+                const float32x4_t cameraX = vmlaq_f32(vdupq_n_f32(row.x), lane, vdupq_n_f32(stepX.x));
+                const float32x4_t cameraY = vmlaq_f32(vdupq_n_f32(row.y), lane, vdupq_n_f32(stepX.y));
+                const float32x4_t cameraZ = vmlaq_f32(vdupq_n_f32(row.z), lane, vdupq_n_f32(stepX.z));
+                const uint32x4_t front = vcgeq_f32(cameraZ, vdupq_n_f32(p.minDepth));
+                const float32x4_t inverseZ = reciprocal(vbslq_f32(front, cameraZ, one));
+                const float32x4_t u = vmlaq_f32(vdupq_n_f32(p.cx), vmulq_f32(cameraX, inverseZ), vdupq_n_f32(p.fx));
+                const float32x4_t v = vmlaq_f32(vdupq_n_f32(p.cy), vmulq_f32(cameraY, inverseZ), vdupq_n_f32(p.fy));
+                const uint32x4_t inside = vandq_u32(
+                    vandq_u32(front, vandq_u32(vcgeq_f32(u, zero), vcltq_f32(u, vdupq_n_f32(p.width)))),
+                    vandq_u32(vcgeq_f32(v, zero), vcltq_f32(v, vdupq_n_f32(p.height))));
+
+                uint32_t lanesInside[4];
+                float lanesU[4];
+                float lanesV[4];
+                float lanesDepth[4];
+                vst1q_u32(lanesInside, inside);
+                if ((lanesInside[0] | lanesInside[1] | lanesInside[2] | lanesInside[3]) == 0) {
+                    continue;
+                }
+                vst1q_f32(lanesU, u);
+                vst1q_f32(lanesV, v);
+                for (int lane = 0; lane < 4; ++lane) {
+                    lanesDepth[lane] = lanesInside[lane]
+                        ? depth[static_cast<size_t>(lanesV[lane]) * p.stride + static_cast<size_t>(lanesU[lane])]
+                        : 0.0f;
+                }
+                const float32x4_t d = vld1q_f32(lanesDepth);
+                const float32x4_t distance = vsubq_f32(d, cameraZ);
+                const uint32x4_t update = vandq_u32(vcgtq_f32(d, zero),
+                                                    vcgeq_f32(distance, vdupq_n_f32(-p.truncation)));
+                uint32_t lanesUpdate[4];
+                vst1q_u32(lanesUpdate, update);
+                if ((lanesUpdate[0] | lanesUpdate[1] | lanesUpdate[2] | lanesUpdate[3]) == 0) {
+                    continue;
+                }
+                const float32x4_t observed = vminq_f32(one, vmulq_f32(distance, vdupq_n_f32(p.inverseTruncation)));
+                const float32x4_t oldSdf = vld1q_f32(sdf + x);
+                const float32x4_t oldWeight = vld1q_f32(weight + x);
+                const float32x4_t newWeight = vaddq_f32(oldWeight, one);
+                const float32x4_t newSdf = vmulq_f32(vmlaq_f32(observed, oldSdf, oldWeight), reciprocal(newWeight));
+                const float32x4_t cappedWeight = vminq_f32(newWeight, vdupq_n_f32(p.maxWeight));
+                vst1q_f32(sdf + x, vbslq_f32(update, newSdf, oldSdf));
+                vst1q_f32(weight + x, vbslq_f32(update, cappedWeight, oldWeight));
+                changed = true;
+            }
+#else
+            for (int32_t x = 0; x < kBlockSide; ++x) {
+                changed |= integrateVoxel(p, depth, row + stepX * static_cast<float>(x), sdf[x], weight[x]);
+            }
+#endif
+        }
+    }
+    return changed;
+}
+
+size_t TsdfVolume::extractChangedMeshes(std::vector<MeshBlock> &output)
+{
+    LENSENGINE_TRACE_SCOPE("Mapping::tsdfMesh");
+    output.clear();
+
+    std::vector<uint32_t> dirty;
+    for (uint32_t i = 0; i < m_blocks.size(); ++i) {
+        if (m_blocks[i].meshDirty) {
+            dirty.push_back(i);
+        }
+    }
+    if (dirty.empty() && m_removed.empty()) {
+        return 0;
+    }
+
+    // Удаленные блоки идут первыми: новый меш того же ключа их перекрывает
+    const uint64_t version = m_meshVersion + 1;
+    for (uint64_t key : m_removed) {
+        MeshBlock removed;
+        removed.key = key;
+        removed.version = version;
+        output.push_back(std::move(removed));
+    }
+    m_removed.clear();
+
+    const size_t first = output.size();
+    output.resize(first + dirty.size());
+    TaskScheduler &scheduler = m_scheduler ? *m_scheduler : TaskScheduler::shared();
+    scheduler.parallelFor(0, dirty.size(), 4, [&](size_t begin, size_t end) {
+        std::vector<float> grid;
+        std::vector<float> gridWeight;
+        std::vector<int32_t> vertexCache;
+        for (size_t i = begin; i < end; ++i) {
+            meshBlock(dirty[i], grid, gridWeight, vertexCache, output[first + i]);
+        }
+    }, TaskScheduler::Priority::Low);
+
+    // Блок без поверхности, у которого меша и не было, потребителю не нужен
+    size_t count = first;
+    for (size_t i = 0; i < dirty.size(); ++i) {
+        Block &block = m_blocks[dirty[i]];
+        MeshBlock &mesh = output[first + i];
+        block.meshDirty = false;
+        const bool hasMesh = !mesh.indices.empty();
+        if (!hasMesh && !block.hasMesh) {
+            continue;
+        }
+        block.hasMesh = hasMesh;
+        mesh.key = m_index.voxels()[dirty[i]].key;
+        mesh.version = version;
+        if (count != first + i) {
+            output[count] = std::move(mesh);
+        }
+        ++count;
+    }
+    output.resize(count);
+
+    if (count > 0) {
+        m_meshVersion = version;
+    }
+    return count;
+}
+
+void TsdfVolume::meshBlock(uint32_t index, std::vector<float> &grid, std::vector<float> &gridWeight,
+                           std::vector<int32_t> &vertexCache, MeshBlock &mesh) const
+{
+    int32_t blockX;
+    int32_t blockY;
+    int32_t blockZ;
+    VoxelHashMap::unpackKey(m_index.voxels()[index].key, blockX, blockY, blockZ);
+
+    // Воксели -1..9 по каждой оси из блока и 26 соседей (отсутствующие - без наблюдений)
+    const Block *neighbors[27];
+    for (int32_t dz = -1; dz <= 1; ++dz) {
+        for (int32_t dy = -1; dy <= 1; ++dy) {
+            for (int32_t dx = -1; dx <= 1; ++dx) {
+                const uint32_t neighbor = dx == 0 && dy == 0 && dz == 0
+                    ? index : m_index.find(blockX + dx, blockY + dy, blockZ + dz);
+                neighbors[(dz + 1) * 9 + (dy + 1) * 3 + (dx + 1)] =
+                    neighbor != VoxelHashMap::kNotFound ? &m_blocks[neighbor] : nullptr;
+            }
+        }
+    }
+    grid.resize(kGridVoxels);
+    gridWeight.resize(kGridVoxels);
+    auto split = [](int32_t local, int32_t &block) {
+        block = local < 0 ? -1 : (local >= kBlockSide ? 1 : 0);
+        return local - block * kBlockSide;
+    };
+    for (int32_t z = -1; z < kGridSide - 1; ++z) {
+        int32_t bz;
+        const int32_t iz = split(z, bz);
+        for (int32_t y = -1; y < kGridSide - 1; ++y) {
+            int32_t by;
+            const int32_t iy = split(y, by);
+            for (int32_t x = -1; x < kGridSide - 1; ++x) {
+                int32_t bx;
+                const int32_t ix = split(x, bx);
+                const Block *block = neighbors[(bz + 1) * 9 + (by + 1) * 3 + (bx + 1)];
+                const size_t g = gridIndex(x, y, z);
+                if (block) {
+                    const size_t voxel = static_cast<size_t>((iz * kBlockSide + iy) * kBlockSide + ix);
+                    grid[g] = block->sdf[voxel];
+                    gridWeight[g] = block->weight[voxel];
+                } else {
+                    grid[g] = 1.0f;
+                    gridWeight[g] = 0.0f;
+                }
+            }
+        }
+    }
+
+    const float minWeight = std::max(m_options.minMeshWeight, std::numeric_limits<float>::min());
+    const float voxelSize = m_options.voxelSize;
+    const glm::vec3 origin = glm::vec3(static_cast<float>(blockX), static_cast<float>(blockY),
+                                       static_cast<float>(blockZ)) * blockSize() + glm::vec3(0.5f * voxelSize);
+
+    // Градиент SDF: центральная разность, у края наблюдений - односторонняя
+    auto gradient = [&](int32_t x, int32_t y, int32_t z) {
+        const int32_t position[3] = {x, y, z};
+        const float center = grid[gridIndex(x, y, z)];
+        glm::vec3 result(0.0f);
+        for (int axis = 0; axis < 3; ++axis) {
+            int32_t next[3] = {x, y, z};
+            int32_t previous[3] = {x, y, z};
+            next[axis] = position[axis] + 1;
+            previous[axis] = position[axis] - 1;
+            const size_t n = gridIndex(next[0], next[1], next[2]);
+            const size_t p = gridIndex(previous[0], previous[1], previous[2]);
+            const bool hasNext = gridWeight[n] >= minWeight;
+            const bool hasPrevious = gridWeight[p] >= minWeight;
+            if (hasNext && hasPrevious) {
+                result[axis] = 0.5f * (grid[n] - grid[p]);
+            } else if (hasNext) {
+                result[axis] = grid[n] - center;
+            } else if (hasPrevious) {
+                result[axis] = center - grid[p];
+            }
+        }
+        return result;
+    };
+
+    vertexCache.assign(kCacheEntries, -1);
+    mesh.vertices.clear();
+    mesh.normals.clear();
+    mesh.indices.clear();
+    float weightSum = 0.0f;
+
+    for (int32_t z = 0; z < kBlockSide; ++z) {
+        for (int32_t y = 0; y < kBlockSide; ++y) {
+            for (int32_t x = 0; x < kBlockSide; ++x) {
+                float values[8];
+                float weights[8];
+                unsigned cube = 0;
+                bool observed = true;
+                for (int corner = 0; corner < 8 && observed; ++corner) {
+                    const size_t g = gridIndex(x + kCornerOffset[corner][0], y + kCornerOffset[corner][1],
+                                               z + kCornerOffset[corner][2]);
+                    values[corner] = grid[g];
+                    weights[corner] = gridWeight[g];
+                    observed = weights[corner] >= minWeight;
+                    cube |= values[corner] < 0.0f ? 1u << corner : 0u;
+                }
+                if (!observed || kEdgeTable[cube] == 0) {
+                    continue;
+                }
+
+                // Вершины на ребрах общие для соседних ячеек блока
+                uint32_t edgeVertex[12];
+                for (int edge = 0; edge < 12; ++edge) {
+                    if (!(kEdgeTable[cube] & (1u << edge))) {
+                        continue;
+                    }
+                    const int lower = kEdgeLower[edge];
+                    const size_t slot = ((static_cast<size_t>(z + kCornerOffset[lower][2]) * kCacheSide +
+                                          static_cast<size_t>(y + kCornerOffset[lower][1])) * kCacheSide +
+                                         static_cast<size_t>(x + kCornerOffset[lower][0])) * 3 + kEdgeAxis[edge];
+                    if (vertexCache[slot] < 0) {
+                        const int a = kEdgeCorners[edge][0];
+                        const int b = kEdgeCorners[edge][1];
+                        const float t = values[a] / (values[a] - values[b]);
+                        const glm::vec3 cornerA(static_cast<float>(x + kCornerOffset[a][0]),
+                                                static_cast<float>(y + kCornerOffset[a][1]),
+                                                static_cast<float>(z + kCornerOffset[a][2]));
+                        const glm::vec3 cornerB(static_cast<float>(x + kCornerOffset[b][0]),
+                                                static_cast<float>(y + kCornerOffset[b][1]),
+                                                static_cast<float>(z + kCornerOffset[b][2]));
+                        const glm::vec3 gradientA = gradient(x + kCornerOffset[a][0], y + kCornerOffset[a][1],
+                                                             z + kCornerOffset[a][2]);
+                        const glm::vec3 gradientB = gradient(x + kCornerOffset[b][0], y + kCornerOffset[b][1],
+                                                             z + kCornerOffset[b][2]);
+                        const glm::vec3 normal = gradientA + (gradientB - gradientA) * t;
+                        const float length = glm::length(normal);
+
+                        vertexCache[slot] = static_cast<int32_t>(mesh.vertices.size());
+                        mesh.vertices.push_back(origin + (cornerA + (cornerB - cornerA) * t) * voxelSize);
+                        mesh.normals.push_back(length > 1e-6f ? normal / length : glm::vec3(0.0f));
+                        weightSum += std::min(weights[a], weights[b]);
+                    }
+                    edgeVertex[edge] = static_cast<uint32_t>(vertexCache[slot]);
+                }
+
+                for (int i = 0; kTriangleTable[cube][i] >= 0; i += 3) {
+                    mesh.indices.push_back(edgeVertex[kTriangleTable[cube][i]]);
+                    mesh.indices.push_back(edgeVertex[kTriangleTable[cube][i + 1]]);
+                    mesh.indices.push_back(edgeVertex[kTriangleTable[cube][i + 2]]);
+                }
+            }
+        }
+    }
+
+    if (mesh.vertices.empty()) {
+        mesh.boundsMin = mesh.boundsMax = glm::vec3(0.0f);
+        mesh.confidence = 0.0f;
+        return;
+    }
+    mesh.boundsMin = mesh.boundsMax = mesh.vertices.front();
+    for (const glm::vec3 &vertex : mesh.vertices) {
+        mesh.boundsMin = glm::min(mesh.boundsMin, vertex);
+        mesh.boundsMax = glm::max(mesh.boundsMax, vertex);
+    }
+    mesh.confidence = weightSum / (static_cast<float>(mesh.vertices.size()) * std::max(m_options.maxWeight, 1.0f));
+}
+
+} // namespace LensEngine
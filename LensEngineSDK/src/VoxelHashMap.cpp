@@ -0,0 +1,288 @@
+#include "VoxelHashMap.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace LensEngine {
+
+namespace {
+constexpr uint64_t kAxisMask = (1ull << 21) - 1;
+constexpr int32_t kAxisSign = 1 << 20;
+constexpr size_t kMinSlots = 64;
+constexpr float kMinVoxelSize = 0.001f;
+}
+
+// ============================================================================
+// VoxelHashMap
+// ============================================================================
+
+VoxelHashMap::VoxelHashMap(float voxelSize)
+    : m_voxelSize(0.0f)
+    , m_inverseVoxelSize(0.0f)
+    , m_shift(64)
+{
+    setVoxelSize(voxelSize);
+    rehash(kMinSlots);
+}
+
+void VoxelHashMap::setVoxelSize(float voxelSize)
+{
+    m_voxelSize = std::max(voxelSize, kMinVoxelSize);
+    m_inverseVoxelSize = 1.0f / m_voxelSize;
+    clear();
+}
+
+void VoxelHashMap::clear()
+{
+    m_voxels.clear();
+    for (Slot &slot : m_slots) {
+        slot.index = kNotFound;
+    }
+}
+
+void VoxelHashMap::reserve(size_t voxels)
+{
+    // Заполнение не выше половины: короткие цепочки пробирования
+    size_t slotCount = kMinSlots;
+    while (slotCount < voxels * 2) {
+        slotCount *= 2;
+    }
+    if (slotCount > m_slots.size()) {
+        rehash(slotCount);
+    }
+    m_voxels.reserve(voxels);
+}
+
+uint64_t VoxelHashMap::packKey(int32_t x, int32_t y, int32_t z)
+{
+    return ((static_cast<uint64_t>(static_cast<uint32_t>(x)) & kAxisMask) << 42) |
+           ((static_cast<uint64_t>(static_cast<uint32_t>(y)) & kAxisMask) << 21) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(z)) & kAxisMask);
+}
+
+void VoxelHashMap::unpackKey(uint64_t key, int32_t &x, int32_t &y, int32_t &z)
+{
+    // Восстановление знака 21-битных координат
+    auto axis = [](uint64_t value) {
+        return static_cast<int32_t>(value & kAxisMask) - ((value & kAxisMask) >= static_cast<uint64_t>(kAxisSign) ? 2 * kAxisSign : 0);
+    };
+    x = axis(key >> 42);
+    y = axis(key >> 21);
+    z = axis(key);
+}
+
+size_t VoxelHashMap::slotOf(uint64_t key) const
+{
+    // Мультипликативный хеш Фибоначчи: старшие биты произведения
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> m_shift);
+}
+
+void VoxelHashMap::cellOf(const glm::vec3 &point, int32_t &x, int32_t &y, int32_t &z) const
+{
+    x = static_cast<int32_t>(std::floor(point.x * m_inverseVoxelSize));
+    y = static_cast<int32_t>(std::floor(point.y * m_inverseVoxelSize));
+    z = static_cast<int32_t>(std::floor(point.z * m_inverseVoxelSize));
+}
+
+uint32_t VoxelHashMap::insert(const glm::vec3 &point)
+{
+    int32_t x;
+    int32_t y;
+    int32_t z;
+    cellOf(point, x, y, z);
+    const uint64_t key = packKey(x, y, z);
+
+    const size_t mask = m_slots.size() - 1;
+    for (size_t slot = slotOf(key);; slot = (slot + 1) & mask) {
+        Slot &entry = m_slots[slot];
+        if (entry.index == kNotFound) {
+            const uint32_t index = static_cast<uint32_t>(m_voxels.size());
+            entry.key = key;
+            entry.index = index;
+            Voxel voxel;
+            voxel.key = key;
+            m_voxels.push_back(voxel);
+
+            if (m_voxels.size() * 2 > m_slots.size()) {
+                rehash(m_slots.size() * 2);
+            }
+            return index;
+        }
+        if (entry.key == key) {
+            return entry.index;
+        }
+    }
+}
+
+uint32_t VoxelHashMap::find(int32_t x, int32_t y, int32_t z) const
+{
+    const uint64_t key = packKey(x, y, z);
+    const size_t mask = m_slots.size() - 1;
+    for (size_t slot = slotOf(key);; slot = (slot + 1) & mask) {
+        const Slot &entry = m_slots[slot];
+        if (entry.index == kNotFound) {
+            return kNotFound;
+        }
+        if (entry.key == key) {
+            return entry.index;
+        }
+    }
+}
+
+void VoxelHashMap::rehash(size_t slotCount)
+{
+    unsigned bits = 0;
+    while ((static_cast<size_t>(1) << bits) < slotCount) {
+        ++bits;
+    }
+    m_shift = 64 - bits;
+
+    Slot empty;
+    empty.key = 0;
+    empty.index = kNotFound;
+    m_slots.assign(static_cast<size_t>(1) << bits, empty);
+
+    const size_t mask = m_slots.size() - 1;
+    for (uint32_t index = 0; index < m_voxels.size(); ++index) {
+        const uint64_t key = m_voxels[index].key;
+        size_t slot = slotOf(key);
+        while (m_slots[slot].index != kNotFound) {
+            slot = (slot + 1) & mask;
+        }
+        m_slots[slot].key = key;
+        m_slots[slot].index = index;
+    }
+}
+
+// ============================================================================
+// VoxelGridFilter
+// ============================================================================
+
+VoxelGridFilter::VoxelGridFilter()
+    : VoxelGridFilter(Options())
+{
+}
+
+VoxelGridFilter::VoxelGridFilter(const Options &options)
+    : m_options(options)
+    , m_map(options.voxelSize)
+{
+}
+
+void VoxelGridFilter::setOptions(const Options &options)
+{
+    m_options = options;
+    if (std::max(options.voxelSize, kMinVoxelSize) != m_map.voxelSize()) {
+        m_map.setVoxelSize(options.voxelSize);
+    }
+}
+
+VoxelGridFilter::Statistics VoxelGridFilter::filter(const PointCloudSoA &input, PointCloudSoA &output,
+                                                    const std::vector<glm::vec3> *normals,
+                                                    std::vector<glm::vec3> *outputNormals)
+{
+    LENSENGINE_TRACE_SCOPE("Voxel::filter");
+
+    Statistics statistics;
+    statistics.inputPoints = input.count;
+    const bool hasWeights = input.weight.size() >= input.count;
+    const bool hasNormals = normals && normals->size() == input.count;
+
+    if (!m_options.enabled) {
+        output = input;
+        if (outputNormals) {
+            *outputNormals = hasNormals ? *normals : std::vector<glm::vec3>();
+        }
+        statistics.outputPoints = input.count;
+        return statistics;
+    }
+
+    // Раскладка по вокселям
+    m_map.clear();
+    m_map.reserve(input.count);
+    std::vector<VoxelHashMap::Voxel> &voxels = m_map.voxels();
+    for (size_t i = 0; i < input.count; ++i) {
+        const glm::vec3 point = input.point(i);
+        if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z)) {
+            continue;
+        }
+        VoxelHashMap::Voxel &voxel = voxels[m_map.insert(point)];
+        ++voxel.count;
+        voxel.sum += point;
+        voxel.weightSum += hasWeights ? input.weight[i] : 1.0f;
+        if (hasNormals) {
+            voxel.normalSum += (*normals)[i];
+        }
+    }
+    statistics.voxels = voxels.size();
+
+    // Опора вокселя: точки в нем и 26 соседях
+    m_support.resize(voxels.size());
+    double supportSum = 0.0;
+    double supportSquares = 0.0;
+    if (m_options.outlierMode != OutlierMode::None) {
+        for (size_t v = 0; v < voxels.size(); ++v) {
+            int32_t cx;
+            int32_t cy;
+            int32_t cz;
+            VoxelHashMap::unpackKey(voxels[v].key, cx, cy, cz);
+            uint32_t support = 0;
+            for (int32_t dz = -1; dz <= 1; ++dz) {
+                for (int32_t dy = -1; dy <= 1; ++dy) {
+                    for (int32_t dx = -1; dx <= 1; ++dx) {
+                        const uint32_t neighbor = m_map.find(cx + dx, cy + dy, cz + dz);
+                        if (neighbor != VoxelHashMap::kNotFound) {
+                            support += voxels[neighbor].count;
+                        }
+                    }
+                }
+            }
+            m_support[v] = support;
+            supportSum += support;
+            supportSquares += static_cast<double>(support) * support;
+        }
+    }
+
+    double minSupport = 0.0;
+    if (m_options.outlierMode == OutlierMode::Radius) {
+        minSupport = m_options.minNeighbors;
+    } else if (m_options.outlierMode == OutlierMode::Statistical && !voxels.empty()) {
+        const double mean = supportSum / static_cast<double>(voxels.size());
+        const double variance = std::max(0.0, supportSquares / static_cast<double>(voxels.size()) - mean * mean);
+        minSupport = mean - m_options.stddevMultiplier * std::sqrt(variance);
+    }
+
+    output.reserve(voxels.size());
+    output.count = 0;
+    if (outputNormals) {
+        outputNormals->clear();
+        outputNormals->reserve(voxels.size());
+    }
+
+    for (size_t v = 0; v < voxels.size(); ++v) {
+        const VoxelHashMap::Voxel &voxel = voxels[v];
+        if (m_options.outlierMode != OutlierMode::None && static_cast<double>(m_support[v]) < minSupport) {
+            ++statistics.outlierVoxels;
+            statistics.outlierPoints += voxel.count;
+            continue;
+        }
+
+        const float inverseCount = 1.0f / static_cast<float>(voxel.count);
+        const glm::vec3 center = voxel.sum * inverseCount;
+        output.x[output.count] = center.x;
+        output.y[output.count] = center.y;
+        output.z[output.count] = center.z;
+        output.weight[output.count] = voxel.weightSum * inverseCount;
+        ++output.count;
+
+        if (outputNormals) {
+            const float length = glm::length(voxel.normalSum);
+            outputNormals->push_back(length > 1e-6f ? voxel.normalSum / length : glm::vec3(0.0f));
+        }
+    }
+
+    statistics.outputPoints = output.count;
+    return statistics;
+}
+
+} // namespace LensEngine
@@ -0,0 +1,128 @@
+#include "WorldVoxelMap.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace LensEngine {
+
+WorldVoxelMap::WorldVoxelMap()
+    : WorldVoxelMap(Options())
+{
+}
+
+WorldVoxelMap::WorldVoxelMap(const Options &options)
+    : m_options(options)
+    , m_map(options.voxelSize)
+    , m_confirmed(0)
+    , m_boundsMin(0.0f)
+    , m_boundsMax(0.0f)
+{
+}
+
+void WorldVoxelMap::setOptions(const Options &options)
+{
+    const bool resize = options.voxelSize != m_options.voxelSize;
+    const bool reconfirm = options.minObservations != m_options.minObservations;
+    m_options = options;
+    if (resize) {
+        m_map.setVoxelSize(options.voxelSize);
+    }
+    if (resize || reconfirm) {
+        clear();
+    }
+}
+
+void WorldVoxelMap::clear()
+{
+    m_map.clear();
+    m_confirmed = 0;
+    m_boundsMin = glm::vec3(0.0f);
+    m_boundsMax = glm::vec3(0.0f);
+}
+
+void WorldVoxelMap::integrate(const std::vector<glm::vec3> &points, const std::vector<glm::vec3> &normals,
+                              const std::vector<float> &weights, const CameraPose &pose)
+{
+    LENSENGINE_TRACE_SCOPE("Mapping::integrate");
+
+    const bool hasNormals = normals.size() == points.size();
+    const bool hasWeights = weights.size() == points.size();
+    const float maxWeight = std::max(m_options.maxWeight, 1.0f);
+    const uint32_t minObservations = std::max<uint32_t>(1, m_options.minObservations);
+
+    // Камера глубины: y вниз, z вперед; устройство: y вверх, z назад (S = diag(1, -1, -1))
+    const glm::vec3 axisX = pose.rotation * glm::vec3(1.0f, 0.0f, 0.0f);
+    const glm::vec3 axisY = pose.rotation * glm::vec3(0.0f, -1.0f, 0.0f);
+    const glm::vec3 axisZ = pose.rotation * glm::vec3(0.0f, 0.0f, -1.0f);
+
+    for (size_t i = 0; i < points.size(); ++i) {
+        const glm::vec3 &p = points[i];
+        const float weight = hasWeights ? weights[i] : 1.0f;
+        if (!(weight > 0.0f)) {
+            continue;
+        }
+        const glm::vec3 world = pose.position + axisX * p.x + axisY * p.y + axisZ * p.z;
+        VoxelHashMap::Voxel &voxel = m_map.voxels()[m_map.insert(world)];
+
+        // Вес упирается в предел: прошлое сжимается, новое наблюдение входит с прежней долей
+        if (voxel.weightSum + weight > maxWeight) {
+            const float scale = std::max(0.0f, maxWeight - weight) / voxel.weightSum;
+            voxel.sum *= scale;
+            voxel.normalSum *= scale;
+            voxel.weightSum *= scale;
+        }
+        voxel.sum += world * weight;
+        voxel.weightSum += weight;
+        if (hasNormals) {
+            const glm::vec3 &n = normals[i];
+            voxel.normalSum += (axisX * n.x + axisY * n.y + axisZ * n.z) * weight;
+        }
+
+        if (voxel.count < 0xFFFFFFFFu) {
+            ++voxel.count;
+        }
+        if (voxel.count == minObservations) {
+            const glm::vec3 mean = voxel.sum / voxel.weightSum;
+            if (m_confirmed == 0) {
+                m_boundsMin = m_boundsMax = mean;
+            } else {
+                m_boundsMin = glm::min(m_boundsMin, mean);
+                m_boundsMax = glm::max(m_boundsMax, mean);
+            }
+            ++m_confirmed;
+        }
+    }
+}
+
+void WorldVoxelMap::extractPoints(std::vector<glm::vec3> &points, std::vector<glm::vec3> *normals) const
+{
+    points.clear();
+    points.reserve(m_confirmed);
+    if (normals) {
+        normals->clear();
+        normals->reserve(m_confirmed);
+    }
+    const uint32_t minObservations = std::max<uint32_t>(1, m_options.minObservations);
+    for (const VoxelHashMap::Voxel &voxel : m_map.voxels()) {
+        if (voxel.count < minObservations) {
+            continue;
+        }
+        points.push_back(voxel.sum / voxel.weightSum);
+        if (normals) {
+            const float length = glm::length(voxel.normalSum);
+            normals->push_back(length > 1e-6f ? voxel.normalSum / length : glm::vec3(0.0f));
+        }
+    }
+}
+
+bool WorldVoxelMap::bounds(glm::vec3 &min, glm::vec3 &max) const
+{
+    if (m_confirmed == 0) {
+        return false;
+    }
+    min = m_boundsMin;
+    max = m_boundsMax;
+    return true;
+}
+
+} // namespace LensEngine
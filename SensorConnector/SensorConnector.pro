@@ -51,6 +51,13 @@ unix:!macx {
     LIBS += -lavcodec -lavformat -lavutil -lswscale -lswresample
 }
 
+# 🔹 SIMD: по умолчанию ядра визуализации глубины собираются под SSE2.
+# Для AVX2 добавьте CONFIG += sensor_avx2 (процессор должен поддерживать AVX2)
+sensor_avx2 {
+    msvc: QMAKE_CXXFLAGS += /arch:AVX2
+    else: QMAKE_CXXFLAGS += -mavx2
+}
+
 # SOURCES - только файлы для SensorConnector
 SOURCES += \
     src/SensorConnector.cpp \
@@ -60,7 +67,12 @@ SOURCES += \
     src/TcpServer.cpp \
     src/TurboJPEGDecoder.cpp \
     src/FFmpegDecoder.cpp \
-    src/FastJPEGDecoder.cpp
+    src/FastJPEGDecoder.cpp \
+    src/FramePresenter.cpp \
+    src/DepthVisualizer.cpp \
+    src/PointCloudBuffer.cpp \
+    src/SensorPipeline.cpp \
+    src/SensorIngestPipeline.cpp
 
 HEADERS += \
     include/SensorConnector.h \
@@ -71,7 +83,12 @@ HEADERS += \
     include/TcpServer.h \
     include/TurboJPEGDecoder.h \
     include/FFmpegDecoder.h \
-    include/FastJPEGDecoder.h
+    include/FastJPEGDecoder.h \
+    include/FramePresenter.h \
+    include/DepthVisualizer.h \
+    include/PointCloudBuffer.h \
+    include/SensorPipeline.h \
+    include/SensorIngestPipeline.h
 
 # 🔹 КОПИРУЕМ DLL В ПАПКУ СБОРКИ
 win32 {
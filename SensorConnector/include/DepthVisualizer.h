@@ -0,0 +1,78 @@
+#ifndef DEPTHVISUALIZER_H
+#define DEPTHVISUALIZER_H
+
+#include <QImage>
+#include <QVector>
+
+namespace SensorConnector {
+
+/**
+ * @brief Визуализация карты глубины LiDAR для предпросмотра
+ *
+ * Поиск диапазона (с пропуском NaN и невалидных значений), нормализация
+ * и палитра выполняются векторными ядрами (AVX2/SSE2, скалярный вариант
+ * как запасной). Выходное изображение берется из небольшого кольца
+ * буферов и переиспользуется, как только потребитель его отпустил.
+ */
+class DepthVisualizer
+{
+public:
+    enum Colormap {
+        Grayscale,          // Ближе - темнее
+        InvertedGrayscale,  // Ближе - светлее
+        Turbo               // Цветная палитра Turbo (RGB32)
+    };
+
+    struct Range {
+        float minDepth = 0.0f;
+        float maxDepth = 0.0f;
+        int validPixels = 0;
+    };
+
+    DepthVisualizer();
+
+    void setColormap(Colormap colormap);
+    Colormap colormap() const { return m_colormap; }
+
+    // Значения вне (0, maxRange) считаются невалидными
+    void setMaxRange(float meters);
+    float maxRange() const { return m_maxRange; }
+
+    // Фиксированный диапазон нормализации вместо поиска по кадру
+    void setFixedRange(float minDepth, float maxDepth);
+    void setAutoRange(bool enabled) { m_autoRange = enabled; }
+    bool autoRange() const { return m_autoRange; }
+
+    // Преобразовать кадр глубины width x height в изображение
+    QImage visualize(const float *depth, int width, int height);
+
+    Range lastRange() const { return m_lastRange; }
+
+    static Range computeRange(const float *depth, int count, float maxRange);
+
+    // Набор инструкций, с которым собраны ядра ("AVX2", "SSE2" или "Scalar")
+    static const char *simdPath();
+
+private:
+    static constexpr int kBufferCount = 3;
+
+    void rebuildLut();
+    QImage &acquireBuffer(int width, int height);
+
+    Colormap m_colormap;
+    float m_maxRange;
+    float m_fixedMin;
+    float m_fixedMax;
+    bool m_autoRange;
+    Range m_lastRange;
+
+    // Палитра: 256 уровней + цвет невалидных пикселей
+    QVector<quint32> m_lut;
+
+    QImage m_buffers[kBufferCount];
+    int m_nextBuffer;
+};
+
+} // namespace SensorConnector
+
+#endif // DEPTHVISUALIZER_H
@@ -0,0 +1,99 @@
+#ifndef FRAMEPRESENTER_H
+#define FRAMEPRESENTER_H
+
+#include <QObject>
+#include <QImage>
+#include <QTimer>
+#include <QElapsedTimer>
+
+namespace SensorConnector {
+
+/**
+ * @brief Доставка декодированных кадров на отображение по событию
+ *
+ * Каждый новый кадр выдается ровно один раз сразу после декодирования,
+ * без опроса по таймеру. В режиме VsyncCoalesced, когда дисплей медленнее
+ * камеры, кадры между обновлениями дисплея схлопываются до последнего.
+ * Метка времени приема пакета проходит с кадром без изменений.
+ */
+class FramePresenter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum PresentMode {
+        Immediate,       // Выдать кадр сразу после декодирования
+        VsyncCoalesced   // Выдать последний кадр к ближайшему обновлению дисплея
+    };
+    Q_ENUM(PresentMode)
+
+    struct Statistics {
+        quint64 presentedFrames = 0;   // Выдано на отображение
+        quint64 coalescedFrames = 0;   // Заменены более новым до показа
+        quint64 staleFrames = 0;       // Пришли позже более нового кадра
+    };
+
+    explicit FramePresenter(QObject *parent = nullptr);
+    ~FramePresenter();
+
+    void setPresentMode(PresentMode mode);
+    PresentMode presentMode() const { return m_mode; }
+
+    // Частота дисплея для режима VsyncCoalesced без внешнего источника vsync
+    void setDisplayRefreshRate(qreal hz);
+    qreal displayRefreshRate() const { return m_refreshRate; }
+
+    // Внешний vsync (например, после swapBuffers рендерера) отключает внутренний таймер
+    void setExternalVsync(bool enabled);
+
+    Statistics statistics() const;
+    void reset();
+
+    // Новый поток кадров (переподключение клиента, смена источника): номера
+    // начинаются заново, следующий кадр каждого канала принимается
+    void restartSequences();
+
+public slots:
+    void submitFrame(const QImage &frame, quint64 sequenceNumber, quint64 timestamp = 0);
+    void submitLidarFrame(const QImage &frame, quint64 sequenceNumber, quint64 timestamp = 0);
+    void notifyVsync();
+
+signals:
+    void framePresented(const QImage &frame, quint64 sequenceNumber, quint64 timestamp);
+    void lidarFramePresented(const QImage &frame, quint64 sequenceNumber, quint64 timestamp);
+
+private:
+    // Откат номера дальше окна перестановок пула декодеров - это новый поток
+    static constexpr quint64 kMaxReorder = 64;
+
+    struct Channel {
+        QImage pending;
+        quint64 pendingSequence = 0;
+        quint64 pendingTimestamp = 0;  // Прием пакета кадра, мс
+        quint64 lastSequence = 0;      // Самый новый принятый кадр
+        bool hasPending = false;
+        bool hasAccepted = false;
+    };
+
+    bool acceptFrame(Channel &channel, const QImage &frame, quint64 sequenceNumber, quint64 timestamp);
+    void presentPending();
+    void scheduleVsync();
+    void onVsyncTimer();
+
+    PresentMode m_mode;
+    qreal m_refreshRate;
+    bool m_externalVsync;
+
+    Channel m_rgbChannel;
+    Channel m_lidarChannel;
+    Statistics m_stats;
+
+    // Таймер взводится только при наличии ожидающего кадра
+    QTimer *m_vsyncTimer;
+    QElapsedTimer m_vsyncClock;
+    qint64 m_lastVsyncNs;
+};
+
+} // namespace SensorConnector
+
+#endif // FRAMEPRESENTER_H
@@ -13,9 +13,10 @@
 #include <QtEndian>
 #include <QThread>
 #include "UsbManager.h"
-#include "TurboJPEGDecoder.h"
 #include "ffmpegdecoder.h"
 #include "Lidar3DProcessor.h"
+#include "SensorIngestPipeline.h"
+#include "PointCloudBuffer.h"
 #include <QVector3D>
 #include "ARCameraController.h"
 #include "ardataprocessor.h"
@@ -63,8 +64,10 @@ public:
         pose["rotation"] = rot;
         return pose;
     }
-    Q_INVOKABLE QVariantList getLastFeaturePoints() const { return m_lastFeaturePoints; }
-    Q_INVOKABLE QVariantList getLastLidarPoints() const { return m_lastLidarPoints; }
+    // Списки для QML строятся только при вызове (и кэшируются в буфере)
+    Q_INVOKABLE QVariantList getLastFeaturePoints() const { return m_lastFeaturePoints.toVariantList(); }
+    Q_INVOKABLE QVariantList getLastLidarPoints() const { return m_lastLidarPoints.toVariantList(); }
+    Q_INVOKABLE SensorConnector::PointCloudBuffer lastLidarPointBuffer() const { return m_lastLidarPoints; }
 
 signals:
     void statusChanged(const QString &status);
@@ -74,15 +77,15 @@ signals:
     void debugUpdate(int fps, double kbps, const QString &type);
     void lidarDebugUpdate(int fps, double kbps);
 
-    void lidarPointsUpdated(const QVariantList &points);
-    void objectsDetected(const QVariantList &objectPositions);
+    void lidarPointsUpdated(const SensorConnector::PointCloudBuffer &points);
+    void objectsDetected(const SensorConnector::PointCloudBuffer &objectPositions);
     void lidarStatisticsUpdated(float avgDepth, float maxDepth, int pointCount, int objectCount);
 
     void sensorDataUpdated(float pitch, float yaw, float roll,
                            float accelX, float accelY, float accelZ);
     void cameraPoseUpdated(const QVector3D &position, const QQuaternion &rotation);
 
-    void featurePointsUpdated(const QVariantList &points);
+    void featurePointsUpdated(const SensorConnector::PointCloudBuffer &points);
     void cameraIntrinsicsUpdated(const QVariantMap &intrinsics);
     void lightEstimationUpdated(const QVariantMap &light);
     void fusionStabilityUpdated(float stability);
@@ -111,13 +114,10 @@ private slots:
     void handleUsbRawLidarPointCloud(const QByteArray &data, quint64 sequenceNumber);
     void handleUsbLidarConfidenceMap(const QByteArray &data, quint64 sequenceNumber);
 
-    // 🔹 ОБРАБОТКА ДАННЫХ
-    void handleTurboImageDecoded(const QImage &image, int dataSize, quint64 sequenceNumber);
-    void updateDisplay();
-    void cleanupBuffers();
+    // 🔹 ПАКЕТ ПРИНЯТ КОНВЕЙЕРОМ (маршрутизация по типу)
+    void handlePacketReceived(const SensorConnector::SensorData &data);
 
     // 🔹 ОБРАБОТКА РАЗНЫХ ТИПОВ ДАННЫХ
-    void processRGBData(const QByteArray &data, quint64 sequenceNumber);
     void processLidarDepthData(const QByteArray &data, quint64 sequenceNumber);
     void processRawIMUData(const QByteArray &data, quint64 sequenceNumber);
     void processRawLidarPointCloud(const QByteArray &data, quint64 sequenceNumber);
@@ -147,25 +147,15 @@ private:
     static constexpr int LIDAR_DATA_SIZE = LIDAR_WIDTH * LIDAR_HEIGHT * sizeof(float);
 
     // 🔹 ОСНОВНЫЕ МЕТОДЫ ОБРАБОТКИ
-    void processLidarFrame(const QByteArray &data, quint64 sequenceNumber);
     void deliverFrame(const QImage &img, int dataSize);
 
     // 🔹 СТАТИСТИКА
     void updateStatistics(int dataSize);
     void updateStatisticsFast(int dataSize);
     void updateLidarStatistics(int dataSize);
-    void cleanupExcessFrames(QMap<quint64, QImage> &frameBuffer,
-                             QHash<quint64, qint64> &timestamps, // Меняем на QHash
-                             int maxFrames);
-    // 🔹 LiDAR МЕТОДЫ
-    float findMaxDepthFast(const float* depthData);
-    void convertDepthToImageFast(const float* depthData, QImage &image, float scale);
-    void initLookupTables();
-
     // 🔹 ВСПОМОГАТЕЛЬНЫЕ МЕТОДЫ
     bool isLikelyJpegData(const QByteArray &data);
     void createErrorFrame(const QByteArray &data, const QString &error);
-    quint64 findBestLidarMatch(quint64 rgbSequence);
 
     // Серверы и сокеты
     QTcpServer *tcpServer;
@@ -177,7 +167,6 @@ private:
 
     // Менеджеры и декодеры
     UsbManager *m_usbManager;
-    TurboJPEGDecoder *m_turboDecoder;
     FFmpegDecoder *m_ffmpegDecoder;
 
     // Состояние
@@ -200,24 +189,10 @@ private:
     QElapsedTimer fpsTimer;
 
     // 🔹 БУФЕРЫ ДЛЯ ИЗОБРАЖЕНИЙ
-    QImage lidarDepthImage;
     QImage lidarFallbackImage;
-    QMap<quint64, QImage> rgbFrameBuffer;
-    QMap<quint64, QImage> lidarFrameBuffer;
-    QHash<quint64, qint64> rgbFrameTimestamps; // Меняем на QHash
-    QHash<quint64, qint64> lidarFrameTimestamps; // Меняем на QHash
-
-    quint64 lastRgbSequence = 0;
-    quint64 lastLidarSequence = 0;
-
-    // 🔹 ТАЙМЕРЫ
-    QTimer *displayTimer;
-    QTimer *cleanupTimer;
 
-    // 🔹 ПРЕДВАРИТЕЛЬНО ВЫЧИСЛЕННЫЕ ТАБЛИЦЫ ДЛЯ LiDAR
-    QVector<int> srcXTable;
-    QVector<int> srcYTable;
-    QVector<int> srcIndexTable;
+    // 🔹 ОБЩИЙ КОНВЕЙЕР ПРИЕМА: разбор, декодирование, предпросмотр глубины, доставка кадров
+    SensorConnector::SensorIngestPipeline *m_ingest;
 
     // 🔹 ОСНОВНЫЕ КОМПОНЕНТЫ AR
     Lidar3DProcessor* m_lidar3DProcessor;
@@ -235,8 +210,8 @@ private:
     // 🔹 КЭШ ПОСЛЕДНИХ ДАННЫХ
     QVector3D m_lastCameraPosition;
     QQuaternion m_lastCameraRotation;
-    QVariantList m_lastFeaturePoints;
-    QVariantList m_lastLidarPoints;
+    SensorConnector::PointCloudBuffer m_lastFeaturePoints;
+    SensorConnector::PointCloudBuffer m_lastLidarPoints;
 
 
 };
@@ -13,8 +13,8 @@
 #include <QtEndian>
 #include "SensorDataTypes.h"
 #include "UsbManager.h"
-#include "TurboJPEGDecoder.h"
 #include "FFmpegDecoder.h"
+#include "SensorIngestPipeline.h"
 
 namespace SensorConnector {
 
@@ -37,6 +37,16 @@ public:
 
     int clientsCount() const { return m_clientsCount; }
     QString serverStatus() const { return m_serverStatus; }
+    
+    // Конвейер приема (стадии, метрики, доставка кадров)
+    SensorIngestPipeline *ingest() const { return m_ingest; }
+    
+    // Доставка кадров на отображение (режим, частота дисплея, внешний vsync)
+    FramePresenter *framePresenter() const { return m_ingest->framePresenter(); }
+    
+    // Предпросмотр глубины LiDAR на CPU (отключите, если глубина раскрашивается на GPU)
+    void setLidarPreviewEnabled(bool enabled) { m_ingest->setLidarPreviewEnabled(enabled); }
+    bool isLidarPreviewEnabled() const { return m_ingest->isLidarPreviewEnabled(); }
 
 signals:
     // Статус и статистика
@@ -47,8 +57,8 @@ signals:
     void rawDataReceived(SensorConnector::DataType type, const QByteArray &data, quint64 sequenceNumber);
     
     // Декодированные изображения (для предпросмотра)
-    void frameDecoded(const QImage &frame, quint64 sequenceNumber);
-    void lidarFrameDecoded(const QImage &frame, quint64 sequenceNumber);
+    void frameDecoded(const QImage &frame, quint64 sequenceNumber, quint64 timestamp);
+    void lidarFrameDecoded(const QImage &frame, quint64 sequenceNumber, quint64 timestamp);
 
 private slots:
     // Сетевые слоты
@@ -64,13 +74,10 @@ private slots:
     void handleUsbRawLidarPointCloud(const QByteArray &data, quint64 sequenceNumber);
     void handleUsbLidarConfidenceMap(const QByteArray &data, quint64 sequenceNumber);
     
-    // Декодеры
-    void handleTurboImageDecoded(const QImage &image, int dataSize, quint64 sequenceNumber);
+    // Пакет принят конвейером
+    void handlePacketReceived(const SensorConnector::SensorData &data);
 
 private:
-    // Протокол обработки данных
-    void processRawData(SensorConnector::DataType type, const QByteArray &data, quint64 sequenceNumber);
-    void parseDataPacket(const QByteArray &packet, SensorConnector::DataType &type, QByteArray &payload, quint64 &sequenceNumber);
     
     // TCP/UDP серверы
     QTcpServer *m_tcpServer;
@@ -82,9 +89,11 @@ private:
     UsbManager *m_usbManager;
     
     // Декодеры
-    TurboJPEGDecoder *m_turboDecoder;
     FFmpegDecoder *m_ffmpegDecoder;
     
+    // Разбор пакетов, декодирование, предпросмотр глубины и доставка кадров
+    SensorIngestPipeline *m_ingest;
+    
     // Состояние
     QString m_serverStatus;
     int m_clientsCount;
@@ -0,0 +1,99 @@
+#ifndef POINTCLOUDBUFFER_H
+#define POINTCLOUDBUFFER_H
+
+#include <QMetaType>
+#include <QMutex>
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QVariantList>
+#include <QVector>
+#include <QVector3D>
+
+namespace SensorConnector {
+
+/**
+ * @brief Упакованное облако точек с неявным разделением данных
+ *
+ * Координаты хранятся подряд (x, y, z, x, y, z, ...), необязательные
+ * атрибуты (уверенность, идентификатор) - отдельными массивами той же
+ * длины. Копирование буфера (в том числе через queued сигналы) не копирует
+ * точки. Представление для QML (список {x, y, z, ...}) строится только
+ * при первом чтении и кэшируется в общем блоке под мьютексом: копии
+ * одного буфера можно читать из разных потоков.
+ */
+class PointCloudBuffer
+{
+    Q_GADGET
+    Q_PROPERTY(int count READ size)
+    Q_PROPERTY(QVariantList points READ toVariantList)
+
+public:
+    enum Attribute {
+        NoAttributes = 0x0,
+        Confidence = 0x1,   // float на точку
+        Id = 0x2            // quint64 на точку (например, trackId)
+    };
+    Q_DECLARE_FLAGS(Attributes, Attribute)
+    Q_FLAG(Attributes)
+
+    PointCloudBuffer();
+    explicit PointCloudBuffer(Attributes attributes, int reserveCount = 0);
+
+    static PointCloudBuffer fromPoints(const QVector<QVector3D> &points);
+
+    Attributes attributes() const;
+    bool hasAttribute(Attribute attribute) const { return attributes().testFlag(attribute); }
+
+    int size() const;
+    bool isEmpty() const { return size() == 0; }
+
+    void reserve(int count);
+    void clear();
+
+    void append(const QVector3D &point);
+    void append(float x, float y, float z);
+    void append(float x, float y, float z, float confidence, quint64 id = 0);
+
+    // Прямой доступ к упакованным координатам (3 * size() значений)
+    const float *constData() const;
+
+    QVector3D point(int index) const;
+    float confidence(int index) const;
+    quint64 id(int index) const;
+
+    // Ленивое преобразование для QML
+    QVariantList toVariantList() const;
+
+private:
+    struct Data : public QSharedData {
+        Data() = default;
+        // Отделение копии (copy-on-write) не переносит кэш и мьютекс
+        Data(const Data &other)
+            : QSharedData(other)
+            , attributes(other.attributes)
+            , xyz(other.xyz)
+            , confidence(other.confidence)
+            , ids(other.ids)
+        {
+        }
+
+        Attributes attributes = NoAttributes;
+        QVector<float> xyz;
+        QVector<float> confidence;
+        QVector<quint64> ids;
+
+        // Кэш QML представления (общий для всех копий, читается из любого потока)
+        mutable QMutex variantMutex;
+        mutable QVariantList variantCache;
+        mutable bool variantValid = false;
+    };
+
+    QSharedDataPointer<Data> d;
+};
+
+} // namespace SensorConnector
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(SensorConnector::PointCloudBuffer::Attributes)
+Q_DECLARE_METATYPE(SensorConnector::PointCloudBuffer)
+
+#endif // POINTCLOUDBUFFER_H
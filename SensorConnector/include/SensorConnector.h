@@ -39,13 +39,17 @@ public:
     // Проверка статуса
     bool isUsbConnected() const;
     bool isWiFiConnected() const;
+    
+    // Предпросмотр глубины LiDAR на CPU (по умолчанию включен)
+    void setLidarPreviewEnabled(bool enabled);
 
 signals:
     // Данные получены
     void dataReceived(const SensorData &data);
     
-    // Декодированные RGB кадры с камеры (для AR рендеринга)
-    void frameDecoded(const QImage &frame, quint64 sequenceNumber);
+    // Декодированные RGB кадры с камеры (для AR рендеринга); timestamp - время приема
+    // пакета в той же шкале, что SensorData::timestamp у глубины и IMU
+    void frameDecoded(const QImage &frame, quint64 sequenceNumber, quint64 timestamp);
     
     // Статистика обновлена
     void statisticsUpdated(const ConnectionStats &stats);
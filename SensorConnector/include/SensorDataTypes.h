@@ -15,7 +15,9 @@ enum DataType {
     RAW_IMU = 0x03,              // Сенсорные данные (IMU)
     FEATURE_POINTS = 0x04,       // Feature Points
     CAMERA_INTRINSICS = 0x05,    // Camera Intrinsics
-    LIGHT_ESTIMATION = 0x06      // Light Estimation
+    LIGHT_ESTIMATION = 0x06,     // Light Estimation
+    LIDAR_POINT_CLOUD = 0x08,    // Сырое облако точек LiDAR
+    LIDAR_CONFIDENCE = 0x09      // Карта уверенности LiDAR
 };
 
 // Структура для передачи данных
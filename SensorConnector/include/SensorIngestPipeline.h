@@ -0,0 +1,88 @@
+#ifndef SENSORINGESTPIPELINE_H
+#define SENSORINGESTPIPELINE_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QImage>
+#include <QMutex>
+#include <QAtomicInt>
+#include "SensorDataTypes.h"
+#include "SensorPipeline.h"
+#include "FramePresenter.h"
+#include "DepthVisualizer.h"
+
+namespace SensorConnector {
+
+/**
+ * @brief Общий путь приема данных сенсоров: ingest → decode → publish
+ *
+ * Разбирает пакеты протокола [type:1][seq:8 BE][size:4 BE][payload],
+ * отдает каждый пакет подписчикам, декодирует JPEG и строит предпросмотр
+ * глубины на пулах стадий и доставляет кадры через FramePresenter.
+ * Используется обоими сетевыми серверами; дополнительные стадии
+ * (например, анализ кадров) подключаются к pipeline().
+ */
+class SensorIngestPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Имена стадий стандартного графа
+    static const QString IngestStage;
+    static const QString DecodeStage;
+    static const QString DepthPreviewStage;
+    static const QString PublishStage;
+
+    explicit SensorIngestPipeline(QObject *parent = nullptr);
+    ~SensorIngestPipeline();
+
+    // Поток TCP: извлекает все полные пакеты, неполный остаток остается в buffer.
+    // Возвращает число принятых пакетов
+    int consumeStream(QByteArray &buffer);
+
+    // Одна UDP датаграмма с заголовком
+    bool consumeDatagram(const QByteArray &datagram);
+
+    // Пакет без заголовка (USB уже разделяет пакеты по типам)
+    void submit(DataType type, const QByteArray &payload, quint64 sequenceNumber);
+
+    // Предпросмотр глубины на CPU (отключите, если глубина раскрашивается на GPU)
+    void setLidarPreviewEnabled(bool enabled);
+    bool isLidarPreviewEnabled() const;
+    void setDepthColormap(DepthVisualizer::Colormap colormap);
+
+    SensorPipeline *pipeline() const { return m_pipeline; }
+    FramePresenter *framePresenter() const { return m_framePresenter; }
+
+    // Сбросить очереди стадий и ожидающие кадры
+    void reset();
+    // Клиент подключился или отключился: номера кадров начнутся заново
+    void restartStreams();
+
+signals:
+    // Каждый принятый пакет (в потоке владельца, до декодирования)
+    void packetReceived(const SensorConnector::SensorData &data);
+
+    // Кадры для отображения (через FramePresenter). timestamp - время приема
+    // пакета кадра (мс, как SensorData::timestamp), а не окончания декодирования
+    void frameDecoded(const QImage &frame, quint64 sequenceNumber, quint64 timestamp);
+    void lidarFrameDecoded(const QImage &frame, quint64 sequenceNumber, quint64 timestamp);
+
+private:
+    static constexpr int kHeaderSize = 13;                    // 1 + 8 + 4
+    static constexpr quint32 kMaxPayloadSize = 16 * 1024 * 1024;
+
+    void buildGraph();
+
+    SensorPipeline *m_pipeline;
+    FramePresenter *m_framePresenter;
+
+    // Стадия предпросмотра однопоточная; мьютекс - только для смены палитры
+    DepthVisualizer m_depthVisualizer;
+    QMutex m_visualizerMutex;
+    QAtomicInt m_lidarPreviewEnabled;
+};
+
+} // namespace SensorConnector
+
+#endif // SENSORINGESTPIPELINE_H
@@ -0,0 +1,143 @@
+#ifndef SENSORPIPELINE_H
+#define SENSORPIPELINE_H
+
+#include <QObject>
+#include <QImage>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QThread>
+#include <QThreadPool>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "SensorDataTypes.h"
+
+namespace SensorConnector {
+
+// Пакет, проходящий через стадии конвейера
+struct SensorPacket {
+    SensorData data;     // Сырые данные и временная метка приема
+    QImage image;        // Результат декодирования или визуализации
+};
+
+/**
+ * @brief Конвейер обработки данных сенсоров из объявленных стадий
+ *
+ * Каждая стадия объявляется с очередью (емкость и политика переполнения),
+ * степенью параллелизма, приоритетом потоков и исполнителем: собственный
+ * пул потоков, поток владельца конвейера или синхронный вызов. Стадия
+ * передает пакет дальше через Output. По каждой стадии собираются
+ * пропускная способность, задержка (ожидание в очереди + обработка)
+ * и глубина очереди.
+ */
+class SensorPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum DropPolicy {
+        DropOldest,   // Вытеснить самый старый пакет (актуальность важнее полноты)
+        DropNewest,   // Отклонить входящий пакет
+        KeepAll       // Без ограничения очереди
+    };
+    Q_ENUM(DropPolicy)
+
+    enum Executor {
+        ThreadPool,   // Собственный пул на concurrency потоков
+        OwnerThread,  // Поток, в котором живет конвейер (для Qt объектов и сигналов)
+        Inline        // Синхронно в потоке вызывающего, без очереди
+    };
+    Q_ENUM(Executor)
+
+    struct StageConfig {
+        QString name;
+        Executor executor = ThreadPool;
+        int concurrency = 1;
+        int queueCapacity = 4;
+        DropPolicy dropPolicy = DropOldest;
+        QThread::Priority priority = QThread::NormalPriority;
+    };
+
+    struct StageMetrics {
+        QString name;
+        quint64 processed = 0;        // Всего обработано
+        quint64 dropped = 0;          // Всего отброшено политикой очереди
+        int queueDepth = 0;           // Текущая глубина очереди
+        int maxQueueDepth = 0;        // Максимум за последний интервал
+        double throughput = 0.0;      // Пакетов в секунду за последний интервал
+        double avgLatencyMs = 0.0;    // Ожидание + обработка, среднее за интервал
+        double maxLatencyMs = 0.0;
+        double avgProcessingMs = 0.0;
+    };
+
+private:
+    struct Stage;
+
+public:
+    // Передача пакета следующим стадиям
+    class Output {
+    public:
+        // Всем стадиям, подключенным через connectStages()
+        void operator()(const SensorPacket &packet) const;
+        // Конкретной стадии по имени
+        void to(const QString &stageName, const SensorPacket &packet) const;
+
+    private:
+        friend class SensorPipeline;
+        Output(SensorPipeline *pipeline, const Stage *stage) : m_pipeline(pipeline), m_stage(stage) {}
+
+        SensorPipeline *m_pipeline;
+        const Stage *m_stage;
+    };
+
+    using Handler = std::function<void(SensorPacket &packet, const Output &out)>;
+
+    explicit SensorPipeline(QObject *parent = nullptr);
+    ~SensorPipeline();
+
+    // Построение графа (до начала подачи данных)
+    bool addStage(const StageConfig &config, Handler handler);
+    bool connectStages(const QString &from, const QString &to);
+    bool hasStage(const QString &name) const { return m_stageIndex.contains(name); }
+
+    // Подать пакет на вход стадии. Возвращает false, если пакет отброшен
+    bool submit(const QString &stageName, const SensorPacket &packet);
+
+    // Очистить очереди и дождаться завершения текущих задач
+    void drain();
+
+    QVector<StageMetrics> metrics() const;
+
+    // Интервал пересчета метрик (по умолчанию 1 с)
+    void setMetricsInterval(int ms);
+
+signals:
+    void metricsUpdated();
+
+private:
+    bool enqueue(Stage *stage, const SensorPacket &packet);
+    void clearQueues();
+    void schedule(Stage *stage);
+    void runStage(Stage *stage);
+    void process(Stage *stage, SensorPacket &packet, qint64 enqueuedNs);
+    void updateMetrics();
+    Stage *findStage(const QString &name) const;
+
+    std::vector<std::unique_ptr<Stage>> m_stages;
+    QHash<QString, Stage *> m_stageIndex;
+
+    QElapsedTimer m_clock;
+    QTimer *m_metricsTimer;
+    qint64 m_lastMetricsNs;
+};
+
+} // namespace SensorConnector
+
+Q_DECLARE_METATYPE(SensorConnector::SensorPacket)
+
+#endif // SENSORPIPELINE_H
@@ -18,6 +18,10 @@ public:
 
     void decodeJPEGAsync(const QByteArray &jpegData, quint64 sequenceNumber);
 
+    // Синхронное декодирование в текущем потоке (для стадий конвейера).
+    // Декомпрессор TurboJPEG создается один раз на поток и переиспользуется
+    static QImage decodeJPEG(const QByteArray &jpegData);
+
 signals:
     void imageDecoded(const QImage &image, int dataSize, quint64 sequenceNumber); // 🔹 ИЗМЕНИЛОСЬ: добавлен sequenceNumber
 
@@ -0,0 +1,352 @@
+#include "DepthVisualizer.h"
+#include <QColor>
+#include <algorithm>
+#include <limits>
+
+// Ядра выбираются на этапе компиляции: AVX2 при сборке с -mavx2 (/arch:AVX2),
+// иначе SSE2 (базовый набор x86-64), иначе скалярный вариант
+#if defined(__AVX2__)
+#define DEPTH_VISUALIZER_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DEPTH_VISUALIZER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace SensorConnector {
+
+namespace {
+
+constexpr int kInvalidIndex = 256;
+
+// Сравнения с NaN ложны, поэтому NaN попадает в невалидные
+inline bool isValidDepth(float depth, float maxRange)
+{
+    return depth > 0.0f && depth < maxRange;
+}
+
+inline int depthIndex(float depth, float minDepth, float scale, float maxRange)
+{
+    if (!isValidDepth(depth, maxRange)) {
+        return kInvalidIndex;
+    }
+    const float t = std::min(std::max((depth - minDepth) * scale, 0.0f), 255.0f);
+    return static_cast<int>(t + 0.5f);
+}
+
+#if defined(DEPTH_VISUALIZER_AVX2)
+
+inline __m256 validMask(__m256 v, __m256 limit)
+{
+    return _mm256_and_ps(_mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GT_OQ),
+                         _mm256_cmp_ps(v, limit, _CMP_LT_OQ));
+}
+
+inline __m256i depthIndices(__m256 v, __m256 minV, __m256 scaleV, __m256 limit)
+{
+    const __m256 valid = validMask(v, limit);
+    __m256 t = _mm256_mul_ps(_mm256_sub_ps(v, minV), scaleV);
+    t = _mm256_min_ps(_mm256_max_ps(t, _mm256_setzero_ps()), _mm256_set1_ps(255.0f));
+    const __m256i idx = _mm256_cvttps_epi32(_mm256_add_ps(t, _mm256_set1_ps(0.5f)));
+    return _mm256_blendv_epi8(_mm256_set1_epi32(kInvalidIndex), idx, _mm256_castps_si256(valid));
+}
+
+#elif defined(DEPTH_VISUALIZER_SSE2)
+
+inline __m128 validMask(__m128 v, __m128 limit)
+{
+    return _mm_and_ps(_mm_cmpgt_ps(v, _mm_setzero_ps()), _mm_cmplt_ps(v, limit));
+}
+
+inline __m128i depthIndices(__m128 v, __m128 minV, __m128 scaleV, __m128 limit)
+{
+    const __m128i valid = _mm_castps_si128(validMask(v, limit));
+    __m128 t = _mm_mul_ps(_mm_sub_ps(v, minV), scaleV);
+    t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    const __m128i idx = _mm_cvttps_epi32(_mm_add_ps(t, _mm_set1_ps(0.5f)));
+    return _mm_or_si128(_mm_and_si128(valid, idx),
+                        _mm_andnot_si128(valid, _mm_set1_epi32(kInvalidIndex)));
+}
+
+#endif
+
+// Строка глубины -> RGB32 через палитру
+void mapRowRgb32(const float *src, int count, float minDepth, float scale, float maxRange,
+                 const quint32 *lut, quint32 *dst)
+{
+    int i = 0;
+#if defined(DEPTH_VISUALIZER_AVX2)
+    const __m256 minV = _mm256_set1_ps(minDepth);
+    const __m256 scaleV = _mm256_set1_ps(scale);
+    const __m256 limit = _mm256_set1_ps(maxRange);
+    for (; i + 8 <= count; i += 8) {
+        const __m256i idx = depthIndices(_mm256_loadu_ps(src + i), minV, scaleV, limit);
+        const __m256i colors = _mm256_i32gather_epi32(reinterpret_cast<const int *>(lut), idx, 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), colors);
+    }
+#elif defined(DEPTH_VISUALIZER_SSE2)
+    const __m128 minV = _mm_set1_ps(minDepth);
+    const __m128 scaleV = _mm_set1_ps(scale);
+    const __m128 limit = _mm_set1_ps(maxRange);
+    alignas(16) int idx[4];
+    for (; i + 4 <= count; i += 4) {
+        _mm_store_si128(reinterpret_cast<__m128i *>(idx),
+                        depthIndices(_mm_loadu_ps(src + i), minV, scaleV, limit));
+        dst[i] = lut[idx[0]];
+        dst[i + 1] = lut[idx[1]];
+        dst[i + 2] = lut[idx[2]];
+        dst[i + 3] = lut[idx[3]];
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = lut[depthIndex(src[i], minDepth, scale, maxRange)];
+    }
+}
+
+// Строка глубины -> Grayscale8 (уровень серого берется из младшего байта палитры)
+void mapRowGray8(const float *src, int count, float minDepth, float scale, float maxRange,
+                 const quint32 *lut, uchar *dst)
+{
+    int i = 0;
+#if defined(DEPTH_VISUALIZER_AVX2)
+    const __m256 minV = _mm256_set1_ps(minDepth);
+    const __m256 scaleV = _mm256_set1_ps(scale);
+    const __m256 limit = _mm256_set1_ps(maxRange);
+    const __m256i lowByte = _mm256_set1_epi32(0xFF);
+    for (; i + 8 <= count; i += 8) {
+        const __m256i idx = depthIndices(_mm256_loadu_ps(src + i), minV, scaleV, limit);
+        const __m256i gray = _mm256_and_si256(
+            _mm256_i32gather_epi32(reinterpret_cast<const int *>(lut), idx, 4), lowByte);
+        const __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(gray),
+                                               _mm256_extracti128_si256(gray, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(words, words));
+    }
+#elif defined(DEPTH_VISUALIZER_SSE2)
+    const __m128 minV = _mm_set1_ps(minDepth);
+    const __m128 scaleV = _mm_set1_ps(scale);
+    const __m128 limit = _mm_set1_ps(maxRange);
+    alignas(16) int idx[4];
+    for (; i + 4 <= count; i += 4) {
+        _mm_store_si128(reinterpret_cast<__m128i *>(idx),
+                        depthIndices(_mm_loadu_ps(src + i), minV, scaleV, limit));
+        dst[i] = static_cast<uchar>(lut[idx[0]]);
+        dst[i + 1] = static_cast<uchar>(lut[idx[1]]);
+        dst[i + 2] = static_cast<uchar>(lut[idx[2]]);
+        dst[i + 3] = static_cast<uchar>(lut[idx[3]]);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = static_cast<uchar>(lut[depthIndex(src[i], minDepth, scale, maxRange)]);
+    }
+}
+
+// Полиномиальная аппроксимация палитры Turbo, x в [0, 1]
+QRgb turboColor(float x)
+{
+    const float r = 0.13572138f + x * (4.61539260f + x * (-42.66032258f + x * (132.13108234f + x * (-152.94239396f + x * 59.28637943f))));
+    const float g = 0.09140261f + x * (2.19418839f + x * (4.84296658f + x * (-14.18503333f + x * (4.27729857f + x * 2.82956604f))));
+    const float b = 0.10667330f + x * (12.64194608f + x * (-60.58204836f + x * (110.36276771f + x * (-89.90310912f + x * 27.34824973f))));
+    auto channel = [](float c) {
+        return static_cast<int>(std::min(std::max(c, 0.0f), 1.0f) * 255.0f + 0.5f);
+    };
+    return qRgb(channel(r), channel(g), channel(b));
+}
+
+} // namespace
+
+DepthVisualizer::DepthVisualizer()
+    : m_colormap(Grayscale)
+    , m_maxRange(10.0f)
+    , m_fixedMin(0.0f)
+    , m_fixedMax(5.0f)
+    , m_autoRange(true)
+    , m_nextBuffer(0)
+{
+    rebuildLut();
+}
+
+void DepthVisualizer::setColormap(Colormap colormap)
+{
+    if (m_colormap == colormap) {
+        return;
+    }
+    m_colormap = colormap;
+    rebuildLut();
+}
+
+void DepthVisualizer::setMaxRange(float meters)
+{
+    m_maxRange = std::max(meters, 0.01f);
+}
+
+void DepthVisualizer::setFixedRange(float minDepth, float maxDepth)
+{
+    m_fixedMin = std::min(minDepth, maxDepth);
+    m_fixedMax = std::max(minDepth, maxDepth);
+    m_autoRange = false;
+}
+
+QImage DepthVisualizer::visualize(const float *depth, int width, int height)
+{
+    if (!depth || width <= 0 || height <= 0) {
+        return QImage();
+    }
+
+    m_lastRange = computeRange(depth, width * height, m_maxRange);
+    if (!m_autoRange) {
+        m_lastRange.minDepth = m_fixedMin;
+        m_lastRange.maxDepth = m_fixedMax;
+    }
+
+    const float span = m_lastRange.maxDepth - m_lastRange.minDepth;
+    const float scale = span > 1e-6f ? 255.0f / span : 0.0f;
+    const float minDepth = m_lastRange.minDepth;
+    const quint32 *lut = m_lut.constData();
+
+    QImage &image = acquireBuffer(width, height);
+    for (int y = 0; y < height; ++y) {
+        const float *row = depth + static_cast<size_t>(y) * width;
+        if (m_colormap == Turbo) {
+            mapRowRgb32(row, width, minDepth, scale, m_maxRange, lut,
+                        reinterpret_cast<quint32 *>(image.scanLine(y)));
+        } else {
+            mapRowGray8(row, width, minDepth, scale, m_maxRange, lut, image.scanLine(y));
+        }
+    }
+
+    return image;
+}
+
+DepthVisualizer::Range DepthVisualizer::computeRange(const float *depth, int count, float maxRange)
+{
+    Range range;
+    if (!depth || count <= 0) {
+        return range;
+    }
+
+    float minDepth = std::numeric_limits<float>::max();
+    float maxDepth = 0.0f;
+    int valid = 0;
+    int i = 0;
+
+#if defined(DEPTH_VISUALIZER_AVX2)
+    const __m256 limit = _mm256_set1_ps(maxRange);
+    const __m256 big = _mm256_set1_ps(std::numeric_limits<float>::max());
+    __m256 vmin = big;
+    __m256 vmax = _mm256_setzero_ps();
+    __m256i vcount = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8) {
+        const __m256 v = _mm256_loadu_ps(depth + i);
+        const __m256 mask = validMask(v, limit);
+        vmin = _mm256_min_ps(vmin, _mm256_blendv_ps(big, v, mask));
+        vmax = _mm256_max_ps(vmax, _mm256_and_ps(v, mask));
+        vcount = _mm256_sub_epi32(vcount, _mm256_castps_si256(mask));
+    }
+    alignas(32) float mins[8];
+    alignas(32) float maxs[8];
+    alignas(32) int counts[8];
+    _mm256_store_ps(mins, vmin);
+    _mm256_store_ps(maxs, vmax);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(counts), vcount);
+    for (int lane = 0; lane < 8; ++lane) {
+        minDepth = std::min(minDepth, mins[lane]);
+        maxDepth = std::max(maxDepth, maxs[lane]);
+        valid += counts[lane];
+    }
+#elif defined(DEPTH_VISUALIZER_SSE2)
+    const __m128 limit = _mm_set1_ps(maxRange);
+    const __m128 big = _mm_set1_ps(std::numeric_limits<float>::max());
+    __m128 vmin = big;
+    __m128 vmax = _mm_setzero_ps();
+    __m128i vcount = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        const __m128 v = _mm_loadu_ps(depth + i);
+        const __m128 mask = validMask(v, limit);
+        vmin = _mm_min_ps(vmin, _mm_or_ps(_mm_and_ps(mask, v), _mm_andnot_ps(mask, big)));
+        vmax = _mm_max_ps(vmax, _mm_and_ps(mask, v));
+        vcount = _mm_sub_epi32(vcount, _mm_castps_si128(mask));
+    }
+    alignas(16) float mins[4];
+    alignas(16) float maxs[4];
+    alignas(16) int counts[4];
+    _mm_store_ps(mins, vmin);
+    _mm_store_ps(maxs, vmax);
+    _mm_store_si128(reinterpret_cast<__m128i *>(counts), vcount);
+    for (int lane = 0; lane < 4; ++lane) {
+        minDepth = std::min(minDepth, mins[lane]);
+        maxDepth = std::max(maxDepth, maxs[lane]);
+        valid += counts[lane];
+    }
+#endif
+
+    for (; i < count; ++i) {
+        const float d = depth[i];
+        if (isValidDepth(d, maxRange)) {
+            minDepth = std::min(minDepth, d);
+            maxDepth = std::max(maxDepth, d);
+            ++valid;
+        }
+    }
+
+    if (valid > 0) {
+        range.minDepth = minDepth;
+        range.maxDepth = maxDepth;
+        range.validPixels = valid;
+    }
+    return range;
+}
+
+const char *DepthVisualizer::simdPath()
+{
+#if defined(DEPTH_VISUALIZER_AVX2)
+    return "AVX2";
+#elif defined(DEPTH_VISUALIZER_SSE2)
+    return "SSE2";
+#else
+    return "Scalar";
+#endif
+}
+
+void DepthVisualizer::rebuildLut()
+{
+    m_lut.resize(kInvalidIndex + 1);
+    for (int i = 0; i < kInvalidIndex; ++i) {
+        switch (m_colormap) {
+        case Grayscale:
+            m_lut[i] = qRgb(i, i, i);
+            break;
+        case InvertedGrayscale:
+            m_lut[i] = qRgb(255 - i, 255 - i, 255 - i);
+            break;
+        case Turbo:
+            m_lut[i] = turboColor(i / 255.0f);
+            break;
+        }
+    }
+    m_lut[kInvalidIndex] = qRgb(0, 0, 0);
+}
+
+QImage &DepthVisualizer::acquireBuffer(int width, int height)
+{
+    const QImage::Format format = (m_colormap == Turbo) ? QImage::Format_RGB32 : QImage::Format_Grayscale8;
+
+    // Берем буфер, который потребитель уже отпустил (иначе запись вызвала бы копию)
+    for (int attempt = 0; attempt < kBufferCount; ++attempt) {
+        const int index = (m_nextBuffer + attempt) % kBufferCount;
+        QImage &candidate = m_buffers[index];
+        if (!candidate.isNull() && candidate.isDetached() &&
+            candidate.width() == width && candidate.height() == height &&
+            candidate.format() == format) {
+            m_nextBuffer = (index + 1) % kBufferCount;
+            return candidate;
+        }
+    }
+
+    // Все буферы еще у потребителей или изменился формат: заменяем очередной
+    QImage &slot = m_buffers[m_nextBuffer];
+    slot = QImage(width, height, format);
+    m_nextBuffer = (m_nextBuffer + 1) % kBufferCount;
+    return slot;
+}
+
+} // namespace SensorConnector
@@ -0,0 +1,180 @@
+#include "FramePresenter.h"
+
+namespace SensorConnector {
+
+FramePresenter::FramePresenter(QObject *parent)
+    : QObject(parent)
+    , m_mode(Immediate)
+    , m_refreshRate(60.0)
+    , m_externalVsync(false)
+    , m_vsyncTimer(new QTimer(this))
+    , m_lastVsyncNs(0)
+{
+    m_vsyncTimer->setSingleShot(true);
+    m_vsyncTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_vsyncTimer, &QTimer::timeout, this, &FramePresenter::onVsyncTimer);
+
+    m_vsyncClock.start();
+}
+
+FramePresenter::~FramePresenter()
+{
+}
+
+void FramePresenter::setPresentMode(PresentMode mode)
+{
+    if (m_mode == mode) {
+        return;
+    }
+
+    m_mode = mode;
+
+    // При переходе в Immediate отдаем то, что ждало vsync
+    if (m_mode == Immediate) {
+        m_vsyncTimer->stop();
+        presentPending();
+    }
+}
+
+void FramePresenter::setDisplayRefreshRate(qreal hz)
+{
+    m_refreshRate = qMax<qreal>(1.0, hz);
+}
+
+void FramePresenter::setExternalVsync(bool enabled)
+{
+    m_externalVsync = enabled;
+    if (m_externalVsync) {
+        m_vsyncTimer->stop();
+    } else {
+        scheduleVsync();
+    }
+}
+
+FramePresenter::Statistics FramePresenter::statistics() const
+{
+    return m_stats;
+}
+
+void FramePresenter::reset()
+{
+    m_vsyncTimer->stop();
+    m_rgbChannel = Channel();
+    m_lidarChannel = Channel();
+    m_stats = Statistics();
+}
+
+void FramePresenter::restartSequences()
+{
+    m_rgbChannel.hasAccepted = false;
+    m_lidarChannel.hasAccepted = false;
+}
+
+void FramePresenter::submitFrame(const QImage &frame, quint64 sequenceNumber, quint64 timestamp)
+{
+    if (!acceptFrame(m_rgbChannel, frame, sequenceNumber, timestamp)) {
+        return;
+    }
+
+    if (m_mode == Immediate) {
+        m_rgbChannel.hasPending = false;
+        m_rgbChannel.pending = QImage();
+        ++m_stats.presentedFrames;
+        emit framePresented(frame, sequenceNumber, timestamp);
+    } else {
+        scheduleVsync();
+    }
+}
+
+void FramePresenter::submitLidarFrame(const QImage &frame, quint64 sequenceNumber, quint64 timestamp)
+{
+    if (!acceptFrame(m_lidarChannel, frame, sequenceNumber, timestamp)) {
+        return;
+    }
+
+    if (m_mode == Immediate) {
+        m_lidarChannel.hasPending = false;
+        m_lidarChannel.pending = QImage();
+        ++m_stats.presentedFrames;
+        emit lidarFramePresented(frame, sequenceNumber, timestamp);
+    } else {
+        scheduleVsync();
+    }
+}
+
+void FramePresenter::notifyVsync()
+{
+    m_lastVsyncNs = m_vsyncClock.nsecsElapsed();
+    presentPending();
+}
+
+bool FramePresenter::acceptFrame(Channel &channel, const QImage &frame, quint64 sequenceNumber, quint64 timestamp)
+{
+    if (frame.isNull()) {
+        return false;
+    }
+
+    // Кадры из пула декодеров могут прийти не по порядку: старый кадр не показываем.
+    // Большой откат назад - перезапуск клиента или другой источник, а не опоздание
+    if (channel.hasAccepted && sequenceNumber <= channel.lastSequence &&
+        channel.lastSequence - sequenceNumber <= kMaxReorder) {
+        ++m_stats.staleFrames;
+        return false;
+    }
+
+    if (channel.hasPending) {
+        ++m_stats.coalescedFrames;
+    }
+
+    channel.pending = frame;
+    channel.pendingSequence = sequenceNumber;
+    channel.pendingTimestamp = timestamp;
+    channel.hasPending = true;
+    channel.lastSequence = sequenceNumber;
+    channel.hasAccepted = true;
+    return true;
+}
+
+void FramePresenter::presentPending()
+{
+    if (m_rgbChannel.hasPending) {
+        QImage frame = m_rgbChannel.pending;
+        m_rgbChannel.pending = QImage();
+        m_rgbChannel.hasPending = false;
+        ++m_stats.presentedFrames;
+        emit framePresented(frame, m_rgbChannel.pendingSequence, m_rgbChannel.pendingTimestamp);
+    }
+
+    if (m_lidarChannel.hasPending) {
+        QImage frame = m_lidarChannel.pending;
+        m_lidarChannel.pending = QImage();
+        m_lidarChannel.hasPending = false;
+        ++m_stats.presentedFrames;
+        emit lidarFramePresented(frame, m_lidarChannel.pendingSequence, m_lidarChannel.pendingTimestamp);
+    }
+}
+
+void FramePresenter::scheduleVsync()
+{
+    if (m_mode != VsyncCoalesced || m_externalVsync || m_vsyncTimer->isActive()) {
+        return;
+    }
+    if (!m_rgbChannel.hasPending && !m_lidarChannel.hasPending) {
+        return;
+    }
+
+    // Ближайшая граница периода обновления дисплея
+    const qint64 periodNs = static_cast<qint64>(1e9 / m_refreshRate);
+    const qint64 nowNs = m_vsyncClock.nsecsElapsed();
+    const qint64 sinceLast = nowNs - m_lastVsyncNs;
+    qint64 waitNs = sinceLast >= periodNs ? 0 : periodNs - sinceLast;
+
+    m_vsyncTimer->start(static_cast<int>(waitNs / 1000000));
+}
+
+void FramePresenter::onVsyncTimer()
+{
+    notifyVsync();
+}
+
+} // namespace SensorConnector
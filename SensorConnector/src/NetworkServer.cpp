@@ -6,11 +6,9 @@
 #include <QNetworkInterface>
 #include <QNetworkDatagram>
 #include <QPainter>
-#include <QThreadPool>
-#include <QtConcurrent>
 
-// 🔹 ДОБАВЛЯЕМ ГЛОБАЛЬНЫЙ THREAD POOL ДЛЯ ОБРАБОТКИ
-static QThreadPool* arThreadPool = nullptr;
+// 🔹 СТАДИЯ AR АНАЛИЗА ДЕКОДИРОВАННЫХ КАДРОВ (после decode в общем конвейере)
+static const QString AnalyzeStage = QStringLiteral("analyze");
 
 NetworkServer::NetworkServer(QObject *parent)
     : QObject(parent)
@@ -28,18 +26,11 @@ NetworkServer::NetworkServer(QObject *parent)
     , lidarTotalBytes(0)
     , framesCount(0)
     , lidarFramesCount(0)
-    , lastRgbSequence(0)
-    , lastLidarSequence(0)
+    , m_ingest(new SensorConnector::SensorIngestPipeline(this))
 {
-    // 🔹 ИНИЦИАЛИЗАЦИЯ THREAD POOL
-    if (!arThreadPool) {
-        arThreadPool = new QThreadPool(this);
-        arThreadPool->setMaxThreadCount(8); // Оптимально для AR обработки
-        qDebug() << "🎯 AR Thread Pool initialized with" << arThreadPool->maxThreadCount() << "threads";
-    }
+    qRegisterMetaType<SensorConnector::PointCloudBuffer>("SensorConnector::PointCloudBuffer");
 
     // 🔹 ИНИЦИАЛИЗАЦИЯ ИЗОБРАЖЕНИЙ ДЛЯ LiDAR
-    lidarDepthImage = QImage(LIDAR_TARGET_WIDTH, LIDAR_TARGET_HEIGHT, QImage::Format_Grayscale8);
     lidarFallbackImage = QImage(LIDAR_TARGET_WIDTH, LIDAR_TARGET_HEIGHT, QImage::Format_RGB888);
     lidarFallbackImage.fill(QColor(0, 50, 100));
 
@@ -93,11 +84,29 @@ NetworkServer::NetworkServer(QObject *parent)
     connect(m_arDataProcessor, &ARDataProcessor::sensorDataUpdated,
             this, &NetworkServer::onSensorDataUpdated, Qt::QueuedConnection);
 
-    // 🔹 ИНИЦИАЛИЗАЦИЯ ДЕКОДЕРОВ
-    m_turboDecoder = new TurboJPEGDecoder(this);
-    connect(m_turboDecoder, &TurboJPEGDecoder::imageDecoded,
-            this, &NetworkServer::handleTurboImageDecoded, Qt::QueuedConnection);
+    // 🔹 AR АНАЛИЗ: декодированный кадр уходит в ARDataProcessor, устаревшие кадры вытесняются
+    SensorConnector::SensorPipeline::StageConfig analyze;
+    analyze.name = AnalyzeStage;
+    analyze.concurrency = 2;
+    analyze.queueCapacity = 2;
+    analyze.dropPolicy = SensorConnector::SensorPipeline::DropOldest;
+    m_ingest->pipeline()->addStage(analyze, [this](SensorConnector::SensorPacket &packet,
+                                                   const SensorConnector::SensorPipeline::Output &) {
+        if (packet.data.type != SensorConnector::RGB_CAMERA) {
+            return;
+        }
+        LensEngine::ARFrame rgbFrame;
+        rgbFrame.rgbImage = packet.image;
+        rgbFrame.sequenceNumber = packet.data.sequenceNumber;
+        rgbFrame.timestamp = packet.data.timestamp;
+        m_arDataProcessor->processFrameAsync(rgbFrame);
+    });
+    m_ingest->pipeline()->connectStages(SensorConnector::SensorIngestPipeline::DecodeStage, AnalyzeStage);
+
+    connect(m_ingest, &SensorConnector::SensorIngestPipeline::packetReceived,
+            this, &NetworkServer::handlePacketReceived);
 
+    // 🔹 ИНИЦИАЛИЗАЦИЯ ДЕКОДЕРОВ
     m_ffmpegDecoder = new FFmpegDecoder(this);
     connect(m_ffmpegDecoder, &FFmpegDecoder::frameDecoded,
             this, &NetworkServer::frameReceived, Qt::QueuedConnection);
@@ -130,17 +139,11 @@ NetworkServer::NetworkServer(QObject *parent)
     connect(udpSocket, &QUdpSocket::readyRead,
             this, &NetworkServer::processUdpData);
 
-    // 🔹 ИНИЦИАЛИЗАЦИЯ ТАЙМЕРОВ
-    displayTimer = new QTimer(this);
-    connect(displayTimer, &QTimer::timeout, this, &NetworkServer::updateDisplay);
-    displayTimer->start(16); // ~60 FPS
-
-    cleanupTimer = new QTimer(this);
-    connect(cleanupTimer, &QTimer::timeout, this, &NetworkServer::cleanupBuffers);
-    cleanupTimer->start(1000);
-
-    // 🔹 ИНИЦИАЛИЗАЦИЯ ТАБЛИЦ ПРЕОБРАЗОВАНИЯ ДЛЯ LiDAR
-    initLookupTables();
+    // 🔹 ДОСТАВКА КАДРОВ: каждый новый кадр выдается один раз сразу после декодирования
+    connect(m_ingest, &SensorConnector::SensorIngestPipeline::frameDecoded,
+            this, [this](const QImage &frame, quint64) { emit frameReceived(frame); });
+    connect(m_ingest, &SensorConnector::SensorIngestPipeline::lidarFrameDecoded,
+            this, [this](const QImage &frame, quint64) { emit lidarFrameReceived(frame); });
 
     qDebug() << "🎯 NetworkServer initialized with multi-threaded architecture";
 }
@@ -148,6 +151,9 @@ NetworkServer::NetworkServer(QObject *parent)
 
 NetworkServer::~NetworkServer()
 {
+    // 🔹 СНАЧАЛА ДОЖИДАЕМСЯ СТАДИЙ КОНВЕЙЕРА (analyze обращается к ARDataProcessor)
+    m_ingest->reset();
+
     // 🔹 КОРРЕКТНОЕ ЗАВЕРШЕНИЕ ПОТОКОВ
     if (m_imuThread) {
         m_imuThread->quit();
@@ -241,11 +247,8 @@ void NetworkServer::stopServers() {
     framesCount = 0;
     totalBytes = 0;
 
-    // 🔹 ОЧИСТКА БУФЕРОВ ПРИ ОСТАНОВКЕ
-    rgbFrameBuffer.clear();
-    lidarFrameBuffer.clear();
-    rgbFrameTimestamps.clear();
-    lidarFrameTimestamps.clear();
+    // 🔹 СБРОС ОЧЕРЕДЕЙ КОНВЕЙЕРА И ОЖИДАЮЩИХ КАДРОВ ПРИ ОСТАНОВКЕ
+    m_ingest->reset();
 
     QImage emptyImage;
     emit frameReceived(emptyImage);
@@ -257,130 +260,34 @@ void NetworkServer::stopServers() {
 
 
 
-// 🔹 ОПТИМИЗИРОВАННЫЙ МЕТОД ОБНОВЛЕНИЯ ДИСПЛЕЯ
-void NetworkServer::updateDisplay()
-{
-    static quint64 lastProcessedRgb = 0;
-    static quint64 lastProcessedLidar = 0;
-
-    // 🔹 ОБРАБОТКА RGB - ПРИОРИТЕТ ВЫСОКИЙ
-    if (!rgbFrameBuffer.isEmpty()) {
-        quint64 latestRgb = rgbFrameBuffer.keys().last();
-        if (latestRgb > lastProcessedRgb) {
-            QImage rgbFrame = rgbFrameBuffer[latestRgb];
-            if (!rgbFrame.isNull()) {
-                emit frameReceived(rgbFrame);
-                lastRgbSequence = latestRgb;
-                lastProcessedRgb = latestRgb;
-            }
-        }
-    }
-
-    // 🔹 ОБРАБОТКА LiDAR - ПРИОРИТЕТ НИЖЕ
-    if (!lidarFrameBuffer.isEmpty()) {
-        quint64 latestLidar = lidarFrameBuffer.keys().last();
-        if (latestLidar > lastProcessedLidar) {
-            QImage lidarFrame = lidarFrameBuffer[latestLidar];
-            if (!lidarFrame.isNull()) {
-                emit lidarFrameReceived(lidarFrame);
-                lastLidarSequence = latestLidar;
-                lastProcessedLidar = latestLidar;
-            }
-        }
-    }
-
-    // 🔹 ОЧИСТКА БУФЕРОВ (сохраняем только последние 3 кадра для экономии памяти)
-    cleanupExcessFrames(rgbFrameBuffer, rgbFrameTimestamps, 3);
-    cleanupExcessFrames(lidarFrameBuffer, lidarFrameTimestamps, 3);
-}
-// 🔹 ВСПОМОГАТЕЛЬНЫЙ МЕТОД ДЛЯ ОЧИСТКИ БУФЕРОВ (ИСПРАВЛЕННАЯ СИГНАТУРА)
-void NetworkServer::cleanupExcessFrames(QMap<quint64, QImage> &frameBuffer,
-                                        QHash<quint64, qint64> &timestamps,
-                                        int maxFrames)
-{
-    if (frameBuffer.size() > maxFrames) {
-        auto keys = frameBuffer.keys();
-        while (keys.size() > maxFrames) {
-            frameBuffer.remove(keys.first());
-            timestamps.remove(keys.first());
-            keys.removeFirst();
-        }
-    }
-}
-
-// 🔹 ПОИСК БЛИЖАЙШЕГО LiDAR КАДРА К КАДРУ КАМЕРЫ
-quint64 NetworkServer::findBestLidarMatch(quint64 rgbSequence)
-{
-    if (lidarFrameBuffer.isEmpty()) return 0;
-
-    QList<quint64> lidarKeys = lidarFrameBuffer.keys();
-    quint64 bestMatch = 0;
-    quint64 minDiff = ULLONG_MAX;
-
-    for (quint64 lidarSeq : lidarKeys) {
-        quint64 diff = (lidarSeq > rgbSequence) ? (lidarSeq - rgbSequence) : (rgbSequence - lidarSeq);
-        if (diff < minDiff && diff <= 5) { // 🔹 ДОПУСТИМАЯ РАЗНИЦА В 5 КАДРОВ
-            minDiff = diff;
-            bestMatch = lidarSeq;
-        }
-    }
-
-    return bestMatch;
-}
-
-// 🔹 ОЧИСТКА БУФЕРОВ ОТ СТАРЫХ КАДРОВ
-void NetworkServer::cleanupBuffers()
+void NetworkServer::handlePacketReceived(const SensorConnector::SensorData &data)
 {
-    qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-
-    // 🔹 ОЧИСТКА RGB БУФЕРА (кадры старше 3 секунд)
-    QList<quint64> rgbKeys = rgbFrameBuffer.keys();
-    for (quint64 key : rgbKeys) {
-        if (currentTime - rgbFrameTimestamps[key] > 3000) {
-            rgbFrameBuffer.remove(key);
-            rgbFrameTimestamps.remove(key);
-        }
-    }
-
-    // 🔹 ОЧИСТКА LiDAR БУФЕРА (кадры старше 3 секунд)
-    QList<quint64> lidarKeys = lidarFrameBuffer.keys();
-    for (quint64 key : lidarKeys) {
-        if (currentTime - lidarFrameTimestamps[key] > 3000) {
-            lidarFrameBuffer.remove(key);
-            lidarFrameTimestamps.remove(key);
-        }
-    }
+    // 🔹 RGB декодируется и анализируется стадиями конвейера, здесь только остальные типы
+    switch (data.type) {
+    case SensorConnector::RGB_CAMERA:
+        updateStatisticsFast(data.payload.size());
+        break;
 
-}
+    case SensorConnector::LIDAR_DEPTH:
+        processLidarDepthData(data.payload, data.sequenceNumber);
+        updateLidarStatistics(data.payload.size());
+        break;
 
+    case SensorConnector::RAW_IMU:
+        processRawIMUData(data.payload, data.sequenceNumber);
+        break;
 
+    case SensorConnector::LIDAR_POINT_CLOUD:
+        processRawLidarPointCloud(data.payload, data.sequenceNumber);
+        break;
 
-void NetworkServer::handleTurboImageDecoded(const QImage &image, int dataSize, quint64 sequenceNumber)
-{
-    if (!image.isNull()) {
-        // 🔹 СОХРАНЯЕМ В БУФЕР КАМЕРЫ
-        rgbFrameBuffer[sequenceNumber] = image;
-        rgbFrameTimestamps[sequenceNumber] = QDateTime::currentMSecsSinceEpoch();
+    case SensorConnector::LIDAR_CONFIDENCE:
+        processLidarConfidenceMap(data.payload, data.sequenceNumber);
+        break;
 
-        // 🔹 СОЗДАЕМ ПОЛНЫЙ ARFrame С RGB ИЗОБРАЖЕНИЕМ
-        LensEngine::ARFrame rgbFrame;
-        rgbFrame.rgbImage = image;
-        rgbFrame.sequenceNumber = sequenceNumber;
-        rgbFrame.timestamp = QDateTime::currentMSecsSinceEpoch();
-
-        // 🔹 ЗАПУСКАЕМ AR ОБРАБОТКУ ДЛЯ RGB КАДРА
-        QtConcurrent::run(arThreadPool, [this, rgbFrame]() {
-            m_arDataProcessor->processFrameAsync(rgbFrame);
-        });
-
-        // 🔹 ЭМИТИМ СИГНАЛ ДЛЯ НЕМЕДЛЕННОГО ОБНОВЛЕНИЯ
-        emit frameReceived(image);
-        updateStatisticsFast(dataSize);
-
-        static int rgbDecodedCounter = 0;
-        if (rgbDecodedCounter++ % 60 == 0) {
-            qDebug() << "🎯 [RGB] Frame decoded and sent to AR processor - Seq:" << sequenceNumber;
-        }
+    default:
+        qWarning() << "❌ Unknown data type:" << static_cast<int>(data.type);
+        break;
     }
 }
 
@@ -429,6 +336,9 @@ void NetworkServer::handleTcpConnection() {
 
     connect(socket, &QTcpSocket::readyRead, this, &NetworkServer::processTcpData);
     connect(socket, &QTcpSocket::disconnected, this, &NetworkServer::handleTcpDisconnection);
+
+    // 🔹 НОВЫЙ КЛИЕНТ НАЧИНАЕТ НОМЕРА КАДРОВ ЗАНОВО
+    m_ingest->restartStreams();
 }
 
 void NetworkServer::handleTcpDisconnection() {
@@ -441,6 +351,7 @@ void NetworkServer::handleTcpDisconnection() {
         m_clientsCount = tcpClients.size();
         emit clientsCountChanged(m_clientsCount);
         socket->deleteLater();
+        m_ingest->restartStreams();
     }
 }
 
@@ -448,99 +359,17 @@ void NetworkServer::processTcpData() {
     QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
     if (!socket) return;
 
+    // 🔹 [type:1][sequence:8][size:4][payload] - разбор в общем конвейере
     QByteArray &buffer = tcpBuffers[socket];
     buffer.append(socket->readAll());
-
-    while (buffer.size() >= 13) { // 🔹 1 (type) + 8 (sequence) + 4 (size)
-        uchar dataType = static_cast<uchar>(buffer[0]);
-        quint64 sequenceNumber = qFromBigEndian(*reinterpret_cast<const quint64*>(buffer.constData() + 1));
-        quint32 dataSize = qFromBigEndian(*reinterpret_cast<const quint32*>(buffer.constData() + 9));
-
-        if (dataSize > 1000000) {
-            qWarning() << "❌ Suspicious data size:" << dataSize;
-                                                            buffer.clear();
-            return;
-        }
-
-        if (buffer.size() < 13 + (int)dataSize) {
-            return;
-        }
-
-        QByteArray payload = QByteArray::fromRawData(buffer.constData() + 13, dataSize);
-
-        // 🔹 ОБРАБОТКА РАЗНЫХ ТИПОВ ДАННЫХ
-        switch (dataType) {
-        case 0x01: // 🔹 Основной RGB
-            processRGBData(payload, sequenceNumber);
-            break;
-
-        case 0x02: // 🔹 LiDAR Depth
-            processLidarDepthData(payload, sequenceNumber);
-            break;
-
-        case 0x03: // 🔹 Raw IMU
-            processRawIMUData(payload, sequenceNumber);
-            break;
-
-        case 0x08: // 🔹 Raw LiDAR Point Cloud
-            processRawLidarPointCloud(payload, sequenceNumber);
-            break;
-
-        case 0x09: // 🔹 LiDAR Confidence Map
-            processLidarConfidenceMap(payload, sequenceNumber);
-            break;
-
-        default:
-            qWarning() << "❌ Unknown data type:" << dataType;
-                break;
-        }
-
-        buffer.remove(0, 13 + dataSize);
-    }
+    m_ingest->consumeStream(buffer);
 }
 
 // 🔹 ОБРАБОТКА UDP ДАННЫХ (ВСЕ ТИПЫ ДАННЫХ ЧЕРЕЗ ОДИН ПОРТ)
 void NetworkServer::processUdpData() {
     while (udpSocket->hasPendingDatagrams()) {
         QNetworkDatagram datagram = udpSocket->receiveDatagram();
-        QByteArray data = datagram.data();
-
-        if (data.size() < 13) continue; // 🔹 1 (type) + 8 (sequence) + 4 (size)
-
-        uchar dataType = static_cast<uchar>(data[0]);
-        quint64 sequenceNumber = qFromBigEndian(*reinterpret_cast<const quint64*>(data.constData() + 1));
-        quint32 dataSize = qFromBigEndian(*reinterpret_cast<const quint32*>(data.constData() + 9));
-
-        if (data.size() >= 13 + (int)dataSize) {
-            QByteArray payload = QByteArray::fromRawData(data.constData() + 13, dataSize);
-
-            // 🔹 ОБРАБОТКА РАЗНЫХ ТИПОВ ДАННЫХ
-            switch (dataType) {
-            case 0x01: // 🔹 Основной RGB
-                    processRGBData(payload, sequenceNumber);
-                    break;
-
-            case 0x02: // 🔹 LiDAR Depth
-                    processLidarDepthData(payload, sequenceNumber);
-                    break;
-
-            case 0x03: // 🔹 Raw IMU
-                    processRawIMUData(payload, sequenceNumber);
-                    break;
-
-            case 0x08: // 🔹 Raw LiDAR Point Cloud
-                    processRawLidarPointCloud(payload, sequenceNumber);
-                    break;
-
-            case 0x09: // 🔹 LiDAR Confidence Map
-                    processLidarConfidenceMap(payload, sequenceNumber);
-                    break;
-
-            default:
-                    qWarning() << "❌ Unknown data type:" << dataType;
-                        break;
-            }
-        }
+        m_ingest->consumeDatagram(datagram.data());
     }
 }
 
@@ -565,57 +394,6 @@ void NetworkServer::updateStatistics(int dataSize)
 
 
 
-// 🔹 ОПТИМИЗИРОВАННЫЙ ПОИСК МАКСИМАЛЬНОЙ ГЛУБИНЫ
-float NetworkServer::findMaxDepthFast(const float* depthData)
-{
-    float maxDepth = 0.0f;
-    const int totalPixels = LIDAR_WIDTH * LIDAR_HEIGHT;
-
-    // 🔹 ИСПОЛЬЗУЕМ SIMD-ПОДОБНЫЙ ПОДХОД
-    const float* end = depthData + totalPixels;
-    const float* ptr = depthData;
-
-    while (ptr < end - 8) {
-            // Обрабатываем 8 значений за раз
-            float max1 = qMax(qMax(ptr[0], ptr[1]), qMax(ptr[2], ptr[3]));
-            float max2 = qMax(qMax(ptr[4], ptr[5]), qMax(ptr[6], ptr[7]));
-            float batchMax = qMax(max1, max2);
-
-            if (batchMax > maxDepth && batchMax < 10.0f) {
-            maxDepth = batchMax;
-            }
-            ptr += 8;
-    }
-
-    // Обрабатываем оставшиеся значения
-    while (ptr < end) {
-            if (*ptr > maxDepth && *ptr < 10.0f) {
-            maxDepth = *ptr;
-            }
-            ptr++;
-    }
-
-    return maxDepth;
-}
-
-// 🔹 СУПЕР-ОПТИМИЗИРОВАННОЕ ПРЕОБРАЗОВАНИЕ В ИЗОБРАЖЕНИЕ
-void NetworkServer::convertDepthToImageFast(const float* depthData, QImage &image, float scale)
-{
-    uchar* bits = image.bits();
-    const int totalPixels = LIDAR_TARGET_WIDTH * LIDAR_TARGET_HEIGHT;
-
-    // 🔹 ИСПОЛЬЗУЕМ ПРЕДВАРИТЕЛЬНО ВЫЧИСЛЕННЫЕ ИНДЕКСЫ
-    for (int i = 0; i < totalPixels; i++) {
-            const int srcIndex = srcIndexTable[i];
-            const float depth = depthData[srcIndex];
-
-            bits[i] = (depth > 0 && depth < 10.0f)
-                          ? (255 - static_cast<uchar>(depth * scale))
-                          : 0;
-    }
-}
-
-
 void NetworkServer::updateLidarStatistics(int dataSize)
 {
     lidarTotalBytes += dataSize;
@@ -707,6 +485,7 @@ void NetworkServer::handleUsbClientConnected()
 {
     qInfo() << "🔌 USB client connected";
     emit statusChanged("USB client connected");
+    m_ingest->restartStreams();
 
     // Обновляем счетчик клиентов для USB режима
     if (currentConnectionType == USB) {
@@ -719,6 +498,7 @@ void NetworkServer::handleUsbClientDisconnected()
 {
     qInfo() << "🔌 USB client disconnected";
     emit statusChanged("USB client disconnected");
+    m_ingest->restartStreams();
 
     // Обновляем счетчик клиентов для USB режима
     if (currentConnectionType == USB) {
@@ -768,63 +548,7 @@ bool NetworkServer::isLikelyJpegData(const QByteArray &data)
 }
 
 
-// 🔹 ИНИЦИАЛИЗАЦИЯ ТАБЛИЦ ПРЕОБРАЗОВАНИЯ ДЛЯ УСКОРЕНИЯ
-void NetworkServer::initLookupTables()
-{
-    srcXTable.resize(LIDAR_TARGET_WIDTH);
-    srcYTable.resize(LIDAR_TARGET_HEIGHT);
-    srcIndexTable.resize(LIDAR_TARGET_WIDTH * LIDAR_TARGET_HEIGHT);
-
-    // Предварительно вычисляем координаты для масштабирования
-    for (int y = 0; y < LIDAR_TARGET_HEIGHT; y++) {
-        srcYTable[y] = (y * LIDAR_HEIGHT) / LIDAR_TARGET_HEIGHT;
-    }
-
-    for (int x = 0; x < LIDAR_TARGET_WIDTH; x++) {
-        srcXTable[x] = (x * LIDAR_WIDTH) / LIDAR_TARGET_WIDTH;
-    }
-
-    // Предварительно вычисляем индексы
-    for (int y = 0; y < LIDAR_TARGET_HEIGHT; y++) {
-        const int srcY = srcYTable[y];
-        const int srcRowStart = srcY * LIDAR_WIDTH;
-
-        for (int x = 0; x < LIDAR_TARGET_WIDTH; x++) {
-            const int srcX = srcXTable[x];
-            srcIndexTable[y * LIDAR_TARGET_WIDTH + x] = srcRowStart + srcX;
-        }
-    }
-}
-
-
-
-
-
-
-
-// 🔹 БЫСТРАЯ ОБРАБОТКА RGB (0x01) - основной поток
-void NetworkServer::processRGBData(const QByteArray &data, quint64 sequenceNumber)
-{
-    static int rgbLogCounter = 0;
-    if (rgbLogCounter++ % 60 == 0) {
-        qDebug() << "🎯 [RGB] Processing RGB data - Seq:" << sequenceNumber;
-    }
-
-                                                                   // 🔹 ДЕКОДИРУЕМ JPEG АСИНХРОННО
-                                                                   m_turboDecoder->decodeJPEGAsync(data, sequenceNumber);
-
-    // 🔹 СОЗДАЕМ ARFrame ДЛЯ RGB ДАННЫХ
-    // (изображение будет добавлено в handleTurboImageDecoded)
-    LensEngine::ARFrame rgbFrame;
-    rgbFrame.sequenceNumber = sequenceNumber;
-    rgbFrame.timestamp = QDateTime::currentMSecsSinceEpoch();
-
-    // 🔹 ЗАПУСКАЕМ AR ОБРАБОТКУ ДЛЯ RGB (когда изображение будет готово)
-    // Обработка продолжится в handleTurboImageDecoded
-}
-
-
-// 🔹 ПЕРЕРАБОТАННАЯ ОБРАБОТКА LIDAR - БЕЗ БЛОКИРОВКИ
+// 🔹 LIDAR: 2D ПРЕДПРОСМОТР СТРОИТ КОНВЕЙЕР, ЗДЕСЬ ТОЛЬКО 3D ОБРАБОТКА
 void NetworkServer::processLidarDepthData(const QByteArray &data, quint64 sequenceNumber)
 {
     static int lidarLogCounter = 0;
@@ -832,10 +556,7 @@ void NetworkServer::processLidarDepthData(const QByteArray &data, quint64 sequen
         qDebug() << "🎯 [LIDAR] processLidarDepthData START - Size:" << data.size() << "Seq:" << sequenceNumber;
     }
 
-                // 🔹 1. МГНОВЕННАЯ 2D ВИЗУАЛИЗАЦИЯ
-                processLidarFrame(data, sequenceNumber);
-
-    // 🔹 2. ТЯЖЕЛАЯ 3D ОБРАБОТКА - В ОТДЕЛЬНОМ ПОТОКЕ LIDAR
+    // 🔹 ТЯЖЕЛАЯ 3D ОБРАБОТКА - В ОТДЕЛЬНОМ ПОТОКЕ LIDAR
     QMetaObject::invokeMethod(m_lidar3DProcessor, [this, data, sequenceNumber]() {
             auto points3D = m_lidar3DProcessor->processDepthDataFast(data);
 
@@ -851,9 +572,7 @@ void NetworkServer::processLidarDepthData(const QByteArray &data, quint64 sequen
                     lidarFrame.timestamp = QDateTime::currentMSecsSinceEpoch();
 
                     // 🔹 ЗАПУСКАЕМ AR ОБРАБОТКУ ДЛЯ LiDAR ДАННЫХ
-                    QtConcurrent::run(arThreadPool, [this, lidarFrame]() {
-                        m_arDataProcessor->processFrameAsync(lidarFrame);
-                    });
+                    m_arDataProcessor->processFrameAsync(lidarFrame);
 
                     // 🔹 СИГНАЛ ДЛЯ QML
                     emit lidarDataUpdated(points3D);
@@ -940,8 +659,8 @@ void NetworkServer::processRawLidarPointCloud(const QByteArray &data, quint64 se
 {
     qDebug() << "🔦 [LiDAR PC] Processing raw point cloud - Seq:" << sequenceNumber;
 
-                // 🔹 СОЗДАЕМ ARFrame ДЛЯ POINT CLOUD
-                LensEngine::ARFrame pointCloudFrame;
+    // 🔹 СОЗДАЕМ ARFrame ДЛЯ POINT CLOUD
+    LensEngine::ARFrame pointCloudFrame;
     pointCloudFrame.lidar.pointCloud = data;
     pointCloudFrame.lidar.sequenceNumber = sequenceNumber;
     pointCloudFrame.lidar.timestamp = QDateTime::currentMSecsSinceEpoch();
@@ -949,17 +668,15 @@ void NetworkServer::processRawLidarPointCloud(const QByteArray &data, quint64 se
     pointCloudFrame.timestamp = QDateTime::currentMSecsSinceEpoch();
 
     // 🔹 ЗАПУСКАЕМ AR ОБРАБОТКУ
-    QtConcurrent::run(arThreadPool, [this, pointCloudFrame]() {
-        m_arDataProcessor->processFrameAsync(pointCloudFrame);
-    });
+    m_arDataProcessor->processFrameAsync(pointCloudFrame);
 }
 
 void NetworkServer::processLidarConfidenceMap(const QByteArray &data, quint64 sequenceNumber)
 {
     qDebug() << "🎯 [LiDAR CONF] Processing confidence map - Seq:" << sequenceNumber;
 
-                // 🔹 СОЗДАЕМ ARFrame ДЛЯ CONFIDENCE MAP
-                LensEngine::ARFrame confidenceFrame;
+    // 🔹 СОЗДАЕМ ARFrame ДЛЯ CONFIDENCE MAP
+    LensEngine::ARFrame confidenceFrame;
     confidenceFrame.lidar.confidenceMap = data;
     confidenceFrame.lidar.sequenceNumber = sequenceNumber;
     confidenceFrame.lidar.timestamp = QDateTime::currentMSecsSinceEpoch();
@@ -967,9 +684,7 @@ void NetworkServer::processLidarConfidenceMap(const QByteArray &data, quint64 se
     confidenceFrame.timestamp = QDateTime::currentMSecsSinceEpoch();
 
     // 🔹 ЗАПУСКАЕМ AR ОБРАБОТКУ
-    QtConcurrent::run(arThreadPool, [this, confidenceFrame]() {
-        m_arDataProcessor->processFrameAsync(confidenceFrame);
-    });
+    m_arDataProcessor->processFrameAsync(confidenceFrame);
 }
 
 // 🔹 ОБРАБОТЧИКИ ОТ ARDataProcessor
@@ -984,20 +699,17 @@ void NetworkServer::onFrameProcessed(const LensEngine::ARFrame &processedFrame)
 
 void NetworkServer::onFeaturePointsUpdated(const QVector<LensEngine::FeaturePoint> &features)
 {
-    QVariantList featuresList;
-    for (const auto &feature : features) {
-        QVariantMap featureMap;
-        featureMap["x"] = feature.position.x();
-        featureMap["y"] = feature.position.y();
-        featureMap["z"] = feature.position.z();
-        featureMap["confidence"] = feature.confidence;
-        featuresList.append(featureMap);
+    // 🔹 ПОЗИЦИИ + УВЕРЕННОСТЬ + trackId В ОДНОМ БУФЕРЕ
+    SensorConnector::PointCloudBuffer buffer(SensorConnector::PointCloudBuffer::Confidence |
+                                             SensorConnector::PointCloudBuffer::Id,
+                                             features.size());
+    for (const LensEngine::FeaturePoint &feature : features) {
+        buffer.append(feature.position.x(), feature.position.y(), feature.position.z(),
+                      feature.confidence, feature.trackId);
     }
 
-    // 🔹 КЭШИРУЕМ
-    m_lastFeaturePoints = featuresList;
-
-    emit featurePointsUpdated(featuresList);
+    m_lastFeaturePoints = buffer;
+    emit featurePointsUpdated(buffer);
 }
 
 void NetworkServer::onCameraIntrinsicsUpdated(const LensEngine::CameraIntrinsics &intrinsics)
@@ -1047,75 +759,31 @@ void NetworkServer::onSensorDataUpdated(float pitch, float yaw, float roll,
     emit sensorDataUpdated(pitch, yaw, roll, accelX, accelY, accelZ);
 }
 
-// 🔹 ОБРАБОТКА USB RGB ДАННЫХ (0x01)
+// 🔹 USB ДАННЫЕ ИДУТ В ТОТ ЖЕ КОНВЕЙЕР, ЧТО И TCP/UDP
 void NetworkServer::handleUsbData(const QByteArray &data, quint64 sequenceNumber)
 {
-    processRGBData(data, sequenceNumber);
+    m_ingest->submit(SensorConnector::RGB_CAMERA, data, sequenceNumber);
 }
 
-// 🔹 ОБРАБОТКА USB LIDAR DEPTH (0x02)
 void NetworkServer::handleUsbLidarData(const QByteArray &data, quint64 sequenceNumber)
 {
-    processLidarDepthData(data, sequenceNumber);
+    m_ingest->submit(SensorConnector::LIDAR_DEPTH, data, sequenceNumber);
 }
 
-// 🔹 ОБРАБОТКА USB RAW IMU (0x03)
 void NetworkServer::handleUsbSensorData(const QByteArray &data, quint64 sequenceNumber)
 {
-    processRawIMUData(data, sequenceNumber);
+    m_ingest->submit(SensorConnector::RAW_IMU, data, sequenceNumber);
 }
 
-// 🔹 ОБРАБОТКА USB RAW LIDAR POINT CLOUD (0x08)
 void NetworkServer::handleUsbRawLidarPointCloud(const QByteArray &data, quint64 sequenceNumber)
 {
-    processRawLidarPointCloud(data, sequenceNumber);
+    m_ingest->submit(SensorConnector::LIDAR_POINT_CLOUD, data, sequenceNumber);
 }
 
 // 🔹 ОБРАБОТКА USB LIDAR CONFIDENCE MAP (0x09)
 void NetworkServer::handleUsbLidarConfidenceMap(const QByteArray &data, quint64 sequenceNumber)
 {
-    processLidarConfidenceMap(data, sequenceNumber);
-}
-
-void NetworkServer::processLidarFrame(const QByteArray &data, quint64 sequenceNumber)
-{
-    // 🔹 УПРОЩЕННАЯ ОБРАБОТКА ДЛЯ 2D ВИЗУАЛИЗАЦИИ (не блокирует)
-    const float* depthData = reinterpret_cast<const float*>(data.constData());
-    int dataSize = data.size() / sizeof(float);
-
-    // Быстрое создание изображения глубины
-    QImage depthImage(256, 192, QImage::Format_Grayscale8);
-
-    // 🔹 БЫСТРЫЙ ПОИСК МАКСИМАЛЬНОЙ ГЛУБИНЫ
-    float maxDepth = 0.0f;
-    for (int i = 0; i < qMin(dataSize, 256*192); ++i) {
-        if (depthData[i] > maxDepth && depthData[i] < 10.0f)
-            maxDepth = depthData[i];
-    }
-    if (maxDepth < 0.1f) maxDepth = 1.0f;
-
-    float scale = 255.0f / maxDepth;
-
-    // 🔹 БЫСТРОЕ ПРЕОБРАЗОВАНИЕ
-    for (int y = 0; y < 192; ++y) {
-        uchar* scanline = depthImage.scanLine(y);
-        for (int x = 0; x < 256; ++x) {
-            int idx = y * 256 + x;
-            if (idx < dataSize) {
-                        float depth = depthData[idx];
-                        scanline[x] = (depth > 0 && depth < 10.0f)
-                                          ? static_cast<uchar>(depth * scale)
-                                          : 0;
-            }
-        }
-    }
-
-    // 🔹 СОХРАНЯЕМ ДЛЯ ОТОБРАЖЕНИЯ
-    lidarFrameBuffer[sequenceNumber] = depthImage;
-    lidarFrameTimestamps[sequenceNumber] = QDateTime::currentMSecsSinceEpoch();
-
-    emit lidarFrameReceived(depthImage);
-    updateLidarStatistics(data.size());
+    m_ingest->submit(SensorConnector::LIDAR_CONFIDENCE, data, sequenceNumber);
 }
 
 
@@ -1134,36 +802,23 @@ void NetworkServer::onLidarSpatialAnalysisCompleted(const Lidar3DProcessor::Spat
         m_arDataProcessor->updateSpatialMapping(analysis, points);
     }
 
-    // 🔹 ОТПРАВЛЯЕМ ДАННЫЕ В QML ДЛЯ ВИЗУАЛИЗАЦИИ
-    QVariantList obstaclesList;
-    for (const QVector3D &obstacle : analysis.obstacles) {
-        QVariantMap obstacleMap;
-        obstacleMap["x"] = obstacle.x();
-        obstacleMap["y"] = obstacle.y();
-        obstacleMap["z"] = obstacle.z();
-        obstaclesList.append(obstacleMap);
+    // 🔹 ОДНА ЗАПИСЬ НА ПРЕПЯТСТВИЕ: ЦЕНТР БОКСА + trackId (вместо всех точек над полом)
+    SensorConnector::PointCloudBuffer buffer(SensorConnector::PointCloudBuffer::Id,
+                                             static_cast<int>(analysis.obstacles.size()));
+    for (const LensEngine::DetectedObstacle &obstacle : analysis.obstacles) {
+        buffer.append(obstacle.center.x, obstacle.center.y, obstacle.center.z, 0.0f, obstacle.trackId);
     }
-    emit objectsDetected(obstaclesList);
+    emit objectsDetected(buffer);
 }
 
 void NetworkServer::onLidarPointsProcessed(const QVector<QVector3D> &points)
 {
     qDebug() << "📊 LiDAR points processed:" << points.size() << "points";
 
-    // 🔹 КОНВЕРТИРУЕМ ДЛЯ QML
-    QVariantList pointsList;
-    for (const QVector3D &point : points) {
-        QVariantMap pointMap;
-        pointMap["x"] = point.x();
-        pointMap["y"] = point.y();
-        pointMap["z"] = point.z();
-        pointsList.append(pointMap);
-    }
-
-    // 🔹 КЭШИРУЕМ
-    m_lastLidarPoints = pointsList;
+    // 🔹 УПАКОВЫВАЕМ ОДНИМ БЛОКОМ; КЭШ И СИГНАЛ РАЗДЕЛЯЮТ ОДНИ ДАННЫЕ
+    m_lastLidarPoints = SensorConnector::PointCloudBuffer::fromPoints(points);
 
-    emit lidarPointsUpdated(pointsList);
+    emit lidarPointsUpdated(m_lastLidarPoints);
 }
 
 void NetworkServer::onFloorDetected(const QVector3D &normal, float height)
@@ -1177,14 +832,6 @@ void NetworkServer::onObstaclesDetected(const QVector<QVector3D> &obstacles)
 {
     qDebug() << "🚧 Obstacles detected:" << obstacles.size() << "obstacles";
 
-    // 🔹 ОТПРАВЛЯЕМ ДАННЫЕ В QML
-    QVariantList obstaclesList;
-    for (const QVector3D &obstacle : obstacles) {
-        QVariantMap obstacleMap;
-        obstacleMap["x"] = obstacle.x();
-        obstacleMap["y"] = obstacle.y();
-        obstacleMap["z"] = obstacle.z();
-        obstaclesList.append(obstacleMap);
-    }
-    emit objectsDetected(obstaclesList);
+    // 🔹 ОТПРАВЛЯЕМ ДАННЫЕ (упакованный буфер, QML читает лениво)
+    emit objectsDetected(SensorConnector::PointCloudBuffer::fromPoints(obstacles));
 }
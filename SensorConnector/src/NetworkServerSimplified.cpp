@@ -12,8 +12,8 @@ NetworkServerSimplified::NetworkServerSimplified(QObject *parent)
     , m_tcpServer(new QTcpServer(this))
     , m_udpSocket(new QUdpSocket(this))
     , m_usbManager(nullptr)
-    , m_turboDecoder(nullptr)
     , m_ffmpegDecoder(nullptr)
+    , m_ingest(new SensorIngestPipeline(this))
     , m_serverStatus("Stopped")
     , m_clientsCount(0)
     , m_serversRunning(false)
@@ -21,13 +21,17 @@ NetworkServerSimplified::NetworkServerSimplified(QObject *parent)
     , m_totalBytes(0)
 {
     // Инициализация декодеров
-    m_turboDecoder = new TurboJPEGDecoder(this);
-    connect(m_turboDecoder, &TurboJPEGDecoder::imageDecoded,
-            this, &NetworkServerSimplified::handleTurboImageDecoded, Qt::QueuedConnection);
-    
     m_ffmpegDecoder = new FFmpegDecoder(this);
     m_ffmpegDecoder->initialize();
     
+    // Все пакеты проходят через общий конвейер: ingest → decode → publish
+    connect(m_ingest, &SensorIngestPipeline::packetReceived,
+            this, &NetworkServerSimplified::handlePacketReceived);
+    connect(m_ingest, &SensorIngestPipeline::frameDecoded,
+            this, &NetworkServerSimplified::frameDecoded);
+    connect(m_ingest, &SensorIngestPipeline::lidarFrameDecoded,
+            this, &NetworkServerSimplified::lidarFrameDecoded);
+    
     // Подключение сетевых сигналов
     connect(m_tcpServer, &QTcpServer::newConnection,
             this, &NetworkServerSimplified::handleTcpConnection);
@@ -46,6 +50,10 @@ NetworkServerSimplified::NetworkServerSimplified(QObject *parent)
             this, &NetworkServerSimplified::handleUsbRawLidarPointCloud, Qt::QueuedConnection);
     connect(m_usbManager, &UsbManager::usbLidarConfidenceMapReceived,
             this, &NetworkServerSimplified::handleUsbLidarConfidenceMap, Qt::QueuedConnection);
+    connect(m_usbManager, &UsbManager::usbClientConnected,
+            m_ingest, &SensorIngestPipeline::restartStreams, Qt::QueuedConnection);
+    connect(m_usbManager, &UsbManager::usbClientDisconnected,
+            m_ingest, &SensorIngestPipeline::restartStreams, Qt::QueuedConnection);
     
     m_statsTimer.start();
     
@@ -134,6 +142,8 @@ void NetworkServerSimplified::stopServers()
         m_usbManager->stopUsbServer();
     }
     
+    m_ingest->reset();
+    
     m_serversRunning = false;
     m_serverStatus = "Stopped";
     m_clientsCount = 0;
@@ -153,6 +163,9 @@ void NetworkServerSimplified::handleTcpConnection()
     m_clientsCount = m_tcpClients.size();
     emit clientsCountChanged(m_clientsCount);
     
+    // Новый клиент начинает номера кадров заново
+    m_ingest->restartStreams();
+    
     connect(client, &QTcpSocket::readyRead, this, [this, client]() {
         processTcpData();
     });
@@ -163,6 +176,7 @@ void NetworkServerSimplified::handleTcpConnection()
         client->deleteLater();
         m_clientsCount = m_tcpClients.size();
         emit clientsCountChanged(m_clientsCount);
+        m_ingest->restartStreams();
     });
     
     qDebug() << "📡 New TCP client connected. Total clients:" << m_clientsCount;
@@ -180,42 +194,10 @@ void NetworkServerSimplified::processTcpData()
             continue;
         }
         
+        // Пакеты: [Header: 1 byte type][Sequence: 8 bytes][Size: 4 bytes][Data: N bytes]
         QByteArray &buffer = m_tcpBuffers[client];
         buffer.append(client->readAll());
-        
-        // Парсинг пакетов: [Header: 1 byte type][Sequence: 8 bytes][Size: 4 bytes][Data: N bytes]
-        while (buffer.size() >= 13) { // Минимум: 1 + 8 + 4 = 13 байт
-            quint8 dataType = static_cast<quint8>(buffer[0]);
-            quint64 sequenceNumber = 0;
-            quint32 dataSize = 0;
-            
-            // Читаем sequence number (8 bytes, big-endian)
-            memcpy(&sequenceNumber, buffer.constData() + 1, 8);
-            sequenceNumber = qFromBigEndian(sequenceNumber);
-            
-            // Читаем размер данных (4 bytes, big-endian)
-            memcpy(&dataSize, buffer.constData() + 9, 4);
-            dataSize = qFromBigEndian(dataSize);
-            
-            // Проверяем, что весь пакет получен
-            if (buffer.size() < 13 + static_cast<int>(dataSize)) {
-                break; // Ждем еще данных
-            }
-            
-            // Извлекаем данные
-            QByteArray payload = buffer.mid(13, dataSize);
-            buffer.remove(0, 13 + dataSize);
-            
-            // Определяем тип данных
-            SensorConnector::DataType type = static_cast<SensorConnector::DataType>(dataType);
-            
-            // Обрабатываем данные
-            processRawData(type, payload, sequenceNumber);
-            
-            // Статистика
-            m_totalBytes += payload.size();
-            m_framesCount++;
-        }
+        m_ingest->consumeStream(buffer);
     }
 }
 
@@ -223,96 +205,45 @@ void NetworkServerSimplified::processUdpData()
 {
     while (m_udpSocket->hasPendingDatagrams()) {
         QNetworkDatagram datagram = m_udpSocket->receiveDatagram();
-        QByteArray data = datagram.data();
-        
-        if (data.size() < 13) {
-            continue;
-        }
-        
-        // Парсинг пакета (тот же формат, что и TCP)
-        quint8 dataType = static_cast<quint8>(data[0]);
-        quint64 sequenceNumber = 0;
-        quint32 dataSize = 0;
-        
-        memcpy(&sequenceNumber, data.constData() + 1, 8);
-        sequenceNumber = qFromBigEndian(sequenceNumber);
-        
-        memcpy(&dataSize, data.constData() + 9, 4);
-        dataSize = qFromBigEndian(dataSize);
-        
-        if (data.size() < 13 + static_cast<int>(dataSize)) {
-            continue;
-        }
-        
-        QByteArray payload = data.mid(13, dataSize);
-        SensorConnector::DataType type = static_cast<SensorConnector::DataType>(dataType);
-        
-        processRawData(type, payload, sequenceNumber);
-        
-        // Статистика
-        m_totalBytes += payload.size();
-        m_framesCount++;
+        m_ingest->consumeDatagram(datagram.data());
     }
 }
 
 void NetworkServerSimplified::handleUsbData(const QByteArray &data, quint64 sequenceNumber)
 {
-    processRawData(SensorConnector::RGB_CAMERA, data, sequenceNumber);
+    m_ingest->submit(SensorConnector::RGB_CAMERA, data, sequenceNumber);
 }
 
 void NetworkServerSimplified::handleUsbLidarData(const QByteArray &data, quint64 sequenceNumber)
 {
-    processRawData(SensorConnector::LIDAR_DEPTH, data, sequenceNumber);
+    m_ingest->submit(SensorConnector::LIDAR_DEPTH, data, sequenceNumber);
 }
 
 void NetworkServerSimplified::handleUsbSensorData(const QByteArray &data, quint64 sequenceNumber)
 {
-    processRawData(SensorConnector::RAW_IMU, data, sequenceNumber);
+    m_ingest->submit(SensorConnector::RAW_IMU, data, sequenceNumber);
 }
 
 void NetworkServerSimplified::handleUsbRawLidarPointCloud(const QByteArray &data, quint64 sequenceNumber)
 {
     // Тип 0x08 - Raw LiDAR Point Cloud
-    processRawData(SensorConnector::LIDAR_DEPTH, data, sequenceNumber); // Используем LIDAR_DEPTH как базовый тип
+    m_ingest->submit(SensorConnector::LIDAR_POINT_CLOUD, data, sequenceNumber);
 }
 
 void NetworkServerSimplified::handleUsbLidarConfidenceMap(const QByteArray &data, quint64 sequenceNumber)
 {
-    // Тип 0x09 - LiDAR Confidence Map
-    processRawData(SensorConnector::LIDAR_DEPTH, data, sequenceNumber); // Используем LIDAR_DEPTH как базовый тип
+    // Тип 0x09 - LiDAR Confidence Map (сопоставляется с глубиной по номеру кадра в LensEngineSDK)
+    m_ingest->submit(SensorConnector::LIDAR_CONFIDENCE, data, sequenceNumber);
 }
 
-void NetworkServerSimplified::handleTurboImageDecoded(const QImage &image, int dataSize, quint64 sequenceNumber)
-{
-    (void)dataSize; // unused parameter
-    if (!image.isNull()) {
-        emit frameDecoded(image, sequenceNumber);
-    }
-}
-
-void NetworkServerSimplified::processRawData(SensorConnector::DataType type, const QByteArray &data, quint64 sequenceNumber)
+void NetworkServerSimplified::handlePacketReceived(const SensorConnector::SensorData &data)
 {
     // Отправляем сырые данные для обработки в LensEngineSDK
-    emit rawDataReceived(type, data, sequenceNumber);
-    
-    // Для RGB данных также декодируем для предпросмотра
-    if (type == SensorConnector::RGB_CAMERA) {
-        // Проверяем, что это JPEG
-        if (data.size() >= 2 && static_cast<uchar>(data[0]) == 0xFF && static_cast<uchar>(data[1]) == 0xD8) {
-            if (m_turboDecoder) {
-                m_turboDecoder->decodeJPEGAsync(data, sequenceNumber);
-            }
-        }
-    }
+    emit rawDataReceived(data.type, data.payload, data.sequenceNumber);
     
-    // Для LiDAR данных также декодируем для предпросмотра
-    if (type == SensorConnector::LIDAR_DEPTH) {
-        // LiDAR данные уже в формате глубины (float array)
-        // Можно создать визуализацию для предпросмотра
-        if (data.size() >= 256 * 192 * 4) { // 256x192 float
-            // TODO: Создать QImage для визуализации глубины
-        }
-    }
+    // Статистика
+    m_totalBytes += data.payload.size();
+    m_framesCount++;
 }
 
 } // namespace SensorConnector
@@ -0,0 +1,144 @@
+#include "PointCloudBuffer.h"
+#include <QVariantMap>
+#include <QMutexLocker>
+#include <cstring>
+
+namespace SensorConnector {
+
+PointCloudBuffer::PointCloudBuffer()
+    : d(new Data)
+{
+}
+
+PointCloudBuffer::PointCloudBuffer(Attributes attributes, int reserveCount)
+    : d(new Data)
+{
+    d->attributes = attributes;
+    reserve(reserveCount);
+}
+
+PointCloudBuffer PointCloudBuffer::fromPoints(const QVector<QVector3D> &points)
+{
+    static_assert(sizeof(QVector3D) == 3 * sizeof(float), "QVector3D must be three packed floats");
+
+    PointCloudBuffer buffer;
+    buffer.d->xyz.resize(points.size() * 3);
+    if (!points.isEmpty()) {
+        std::memcpy(buffer.d->xyz.data(), points.constData(), points.size() * sizeof(QVector3D));
+    }
+    return buffer;
+}
+
+PointCloudBuffer::Attributes PointCloudBuffer::attributes() const
+{
+    return d->attributes;
+}
+
+int PointCloudBuffer::size() const
+{
+    return d->xyz.size() / 3;
+}
+
+void PointCloudBuffer::reserve(int count)
+{
+    if (count <= 0) {
+        return;
+    }
+    d->xyz.reserve(count * 3);
+    if (d->attributes.testFlag(Confidence)) {
+        d->confidence.reserve(count);
+    }
+    if (d->attributes.testFlag(Id)) {
+        d->ids.reserve(count);
+    }
+}
+
+void PointCloudBuffer::clear()
+{
+    d->xyz.clear();
+    d->confidence.clear();
+    d->ids.clear();
+    d->variantCache.clear();
+    d->variantValid = false;
+}
+
+void PointCloudBuffer::append(const QVector3D &point)
+{
+    append(point.x(), point.y(), point.z());
+}
+
+void PointCloudBuffer::append(float x, float y, float z)
+{
+    append(x, y, z, 0.0f, 0);
+}
+
+void PointCloudBuffer::append(float x, float y, float z, float confidence, quint64 id)
+{
+    Data *data = d.data();
+    data->xyz.append(x);
+    data->xyz.append(y);
+    data->xyz.append(z);
+    if (data->attributes.testFlag(Confidence)) {
+        data->confidence.append(confidence);
+    }
+    if (data->attributes.testFlag(Id)) {
+        data->ids.append(id);
+    }
+    data->variantValid = false;
+}
+
+const float *PointCloudBuffer::constData() const
+{
+    return d->xyz.constData();
+}
+
+QVector3D PointCloudBuffer::point(int index) const
+{
+    const float *p = d->xyz.constData() + index * 3;
+    return QVector3D(p[0], p[1], p[2]);
+}
+
+float PointCloudBuffer::confidence(int index) const
+{
+    return d->attributes.testFlag(Confidence) ? d->confidence.at(index) : 0.0f;
+}
+
+quint64 PointCloudBuffer::id(int index) const
+{
+    return d->attributes.testFlag(Id) ? d->ids.at(index) : 0;
+}
+
+QVariantList PointCloudBuffer::toVariantList() const
+{
+    QMutexLocker locker(&d->variantMutex);
+    if (d->variantValid) {
+        return d->variantCache;
+    }
+
+    const int count = size();
+    const float *p = d->xyz.constData();
+    const bool withConfidence = d->attributes.testFlag(Confidence);
+    const bool withId = d->attributes.testFlag(Id);
+
+    QVariantList list;
+    list.reserve(count);
+    for (int i = 0; i < count; ++i, p += 3) {
+        QVariantMap pointMap;
+        pointMap["x"] = p[0];
+        pointMap["y"] = p[1];
+        pointMap["z"] = p[2];
+        if (withConfidence) {
+            pointMap["confidence"] = d->confidence.at(i);
+        }
+        if (withId) {
+            pointMap["id"] = d->ids.at(i);
+        }
+        list.append(pointMap);
+    }
+
+    d->variantCache = list;
+    d->variantValid = true;
+    return list;
+}
+
+} // namespace SensorConnector
@@ -93,6 +93,13 @@ bool SensorConnectorCore::isWiFiConnected() const
     return m_networkServer ? (m_networkServer->clientsCount() > 0) : false;
 }
 
+void SensorConnectorCore::setLidarPreviewEnabled(bool enabled)
+{
+    if (m_networkServer) {
+        m_networkServer->setLidarPreviewEnabled(enabled);
+    }
+}
+
 void SensorConnectorCore::updateStatistics()
 {
     // Обновляем статистику из NetworkServer
@@ -0,0 +1,215 @@
+#include "SensorIngestPipeline.h"
+#include "TurboJPEGDecoder.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <cstring>
+
+namespace SensorConnector {
+
+const QString SensorIngestPipeline::IngestStage = QStringLiteral("ingest");
+const QString SensorIngestPipeline::DecodeStage = QStringLiteral("decode");
+const QString SensorIngestPipeline::DepthPreviewStage = QStringLiteral("depthPreview");
+const QString SensorIngestPipeline::PublishStage = QStringLiteral("publish");
+
+namespace {
+constexpr int kLidarWidth = 256;
+constexpr int kLidarHeight = 192;
+constexpr int kLidarDepthBytes = kLidarWidth * kLidarHeight * static_cast<int>(sizeof(float));
+
+bool isJpeg(const QByteArray &data)
+{
+    return data.size() >= 2 &&
+           static_cast<uchar>(data[0]) == 0xFF &&
+           static_cast<uchar>(data[1]) == 0xD8;
+}
+}
+
+SensorIngestPipeline::SensorIngestPipeline(QObject *parent)
+    : QObject(parent)
+    , m_pipeline(new SensorPipeline(this))
+    , m_framePresenter(new FramePresenter(this))
+    , m_lidarPreviewEnabled(1)
+{
+    qRegisterMetaType<SensorConnector::SensorData>("SensorConnector::SensorData");
+
+    connect(m_framePresenter, &FramePresenter::framePresented,
+            this, &SensorIngestPipeline::frameDecoded);
+    connect(m_framePresenter, &FramePresenter::lidarFramePresented,
+            this, &SensorIngestPipeline::lidarFrameDecoded);
+
+    buildGraph();
+}
+
+SensorIngestPipeline::~SensorIngestPipeline()
+{
+    // Стадии ссылаются на члены этого объекта: дожидаемся их до разрушения
+    m_pipeline->drain();
+}
+
+void SensorIngestPipeline::buildGraph()
+{
+    // ingest: синхронно в потоке сокетов - метка времени, подписчики, маршрутизация
+    SensorPipeline::StageConfig ingest;
+    ingest.name = IngestStage;
+    ingest.executor = SensorPipeline::Inline;
+    m_pipeline->addStage(ingest, [this](SensorPacket &packet, const SensorPipeline::Output &out) {
+        packet.data.timestamp = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch());
+        emit packetReceived(packet.data);
+
+        if (packet.data.type == RGB_CAMERA && isJpeg(packet.data.payload)) {
+            out.to(DecodeStage, packet);
+        } else if (packet.data.type == LIDAR_DEPTH && m_lidarPreviewEnabled.loadAcquire() &&
+                   packet.data.payload.size() >= kLidarDepthBytes) {
+            out.to(DepthPreviewStage, packet);
+        }
+    });
+
+    // decode: JPEG -> QImage; кадр старше очереди не нужен, поэтому DropOldest
+    SensorPipeline::StageConfig decode;
+    decode.name = DecodeStage;
+    decode.concurrency = 4;
+    decode.queueCapacity = 4;
+    decode.dropPolicy = SensorPipeline::DropOldest;
+    decode.priority = QThread::HighPriority;
+    m_pipeline->addStage(decode, [](SensorPacket &packet, const SensorPipeline::Output &out) {
+        packet.image = TurboJPEGDecoder::decodeJPEG(packet.data.payload);
+        if (packet.image.isNull()) {
+            qWarning() << "❌ TurboJPEG decode failed for frame #" << packet.data.sequenceNumber;
+            return;
+        }
+        out(packet);
+    });
+
+    // depthPreview: визуализация глубины, важен только последний кадр
+    SensorPipeline::StageConfig depthPreview;
+    depthPreview.name = DepthPreviewStage;
+    depthPreview.concurrency = 1;
+    depthPreview.queueCapacity = 1;
+    depthPreview.dropPolicy = SensorPipeline::DropOldest;
+    depthPreview.priority = QThread::LowPriority;
+    m_pipeline->addStage(depthPreview, [this](SensorPacket &packet, const SensorPipeline::Output &out) {
+        const float *depth = reinterpret_cast<const float *>(packet.data.payload.constData());
+        {
+            QMutexLocker locker(&m_visualizerMutex);
+            packet.image = m_depthVisualizer.visualize(depth, kLidarWidth, kLidarHeight);
+        }
+        out(packet);
+    });
+
+    // publish: в потоке владельца - доставка кадров на отображение
+    SensorPipeline::StageConfig publish;
+    publish.name = PublishStage;
+    publish.executor = SensorPipeline::OwnerThread;
+    publish.queueCapacity = 8;
+    publish.dropPolicy = SensorPipeline::DropOldest;
+    m_pipeline->addStage(publish, [this](SensorPacket &packet, const SensorPipeline::Output &) {
+        if (packet.data.type == RGB_CAMERA) {
+            m_framePresenter->submitFrame(packet.image, packet.data.sequenceNumber, packet.data.timestamp);
+        } else if (packet.data.type == LIDAR_DEPTH) {
+            m_framePresenter->submitLidarFrame(packet.image, packet.data.sequenceNumber, packet.data.timestamp);
+        }
+    });
+
+    m_pipeline->connectStages(DecodeStage, PublishStage);
+    m_pipeline->connectStages(DepthPreviewStage, PublishStage);
+}
+
+int SensorIngestPipeline::consumeStream(QByteArray &buffer)
+{
+    int consumed = 0;
+    int offset = 0;
+
+    while (buffer.size() - offset >= kHeaderSize) {
+        const char *header = buffer.constData() + offset;
+        quint64 sequenceNumber = 0;
+        quint32 dataSize = 0;
+        std::memcpy(&sequenceNumber, header + 1, 8);
+        std::memcpy(&dataSize, header + 9, 4);
+        sequenceNumber = qFromBigEndian(sequenceNumber);
+        dataSize = qFromBigEndian(dataSize);
+
+        // Поврежденный заголовок: синхронизация потока потеряна
+        if (dataSize > kMaxPayloadSize) {
+            qWarning() << "❌ Suspicious data size:" << dataSize;
+            buffer.clear();
+            return consumed;
+        }
+
+        if (buffer.size() - offset < kHeaderSize + static_cast<int>(dataSize)) {
+            break; // Ждем еще данных
+        }
+
+        submit(static_cast<DataType>(static_cast<quint8>(header[0])),
+               buffer.mid(offset + kHeaderSize, static_cast<int>(dataSize)), sequenceNumber);
+        offset += kHeaderSize + static_cast<int>(dataSize);
+        ++consumed;
+    }
+
+    // Один сдвиг буфера на весь пакет данных сокета
+    if (offset > 0) {
+        buffer.remove(0, offset);
+    }
+    return consumed;
+}
+
+bool SensorIngestPipeline::consumeDatagram(const QByteArray &datagram)
+{
+    if (datagram.size() < kHeaderSize) {
+        return false;
+    }
+
+    quint64 sequenceNumber = 0;
+    quint32 dataSize = 0;
+    std::memcpy(&sequenceNumber, datagram.constData() + 1, 8);
+    std::memcpy(&dataSize, datagram.constData() + 9, 4);
+    sequenceNumber = qFromBigEndian(sequenceNumber);
+    dataSize = qFromBigEndian(dataSize);
+
+    if (dataSize > kMaxPayloadSize || datagram.size() < kHeaderSize + static_cast<int>(dataSize)) {
+        return false;
+    }
+
+    submit(static_cast<DataType>(static_cast<quint8>(datagram[0])),
+           datagram.mid(kHeaderSize, static_cast<int>(dataSize)), sequenceNumber);
+    return true;
+}
+
+void SensorIngestPipeline::submit(DataType type, const QByteArray &payload, quint64 sequenceNumber)
+{
+    SensorPacket packet;
+    packet.data.type = type;
+    packet.data.payload = payload;
+    packet.data.sequenceNumber = sequenceNumber;
+    m_pipeline->submit(IngestStage, packet);
+}
+
+void SensorIngestPipeline::setLidarPreviewEnabled(bool enabled)
+{
+    m_lidarPreviewEnabled.storeRelease(enabled ? 1 : 0);
+}
+
+bool SensorIngestPipeline::isLidarPreviewEnabled() const
+{
+    return m_lidarPreviewEnabled.loadAcquire() != 0;
+}
+
+void SensorIngestPipeline::setDepthColormap(DepthVisualizer::Colormap colormap)
+{
+    QMutexLocker locker(&m_visualizerMutex);
+    m_depthVisualizer.setColormap(colormap);
+}
+
+void SensorIngestPipeline::reset()
+{
+    m_pipeline->drain();
+    m_framePresenter->reset();
+}
+
+void SensorIngestPipeline::restartStreams()
+{
+    m_framePresenter->restartSequences();
+}
+
+} // namespace SensorConnector
@@ -0,0 +1,271 @@
+#include "SensorPipeline.h"
+#include <QMutexLocker>
+#include <QDebug>
+#include <algorithm>
+
+namespace SensorConnector {
+
+struct SensorPipeline::Stage {
+    StageConfig config;
+    Handler handler;
+    QVector<Stage *> downstream;
+    QThreadPool pool;
+
+    struct Queued {
+        SensorPacket packet;
+        qint64 enqueuedNs;
+    };
+
+    mutable QMutex mutex;
+    std::deque<Queued> queue;
+    int running = 0;
+
+    // Накопительные счетчики
+    quint64 processed = 0;
+    quint64 dropped = 0;
+
+    // Окно текущего интервала метрик
+    quint64 windowProcessed = 0;
+    int windowMaxDepth = 0;
+    double windowLatencyMs = 0.0;
+    double windowMaxLatencyMs = 0.0;
+    double windowProcessingMs = 0.0;
+
+    // Снимок последнего завершенного интервала
+    StageMetrics snapshot;
+};
+
+void SensorPipeline::Output::operator()(const SensorPacket &packet) const
+{
+    for (Stage *next : m_stage->downstream) {
+        m_pipeline->enqueue(next, packet);
+    }
+}
+
+void SensorPipeline::Output::to(const QString &stageName, const SensorPacket &packet) const
+{
+    Stage *next = m_pipeline->findStage(stageName);
+    if (next) {
+        m_pipeline->enqueue(next, packet);
+    }
+}
+
+SensorPipeline::SensorPipeline(QObject *parent)
+    : QObject(parent)
+    , m_metricsTimer(new QTimer(this))
+    , m_lastMetricsNs(0)
+{
+    qRegisterMetaType<SensorConnector::SensorPacket>("SensorConnector::SensorPacket");
+
+    m_clock.start();
+    connect(m_metricsTimer, &QTimer::timeout, this, &SensorPipeline::updateMetrics);
+    m_metricsTimer->start(1000);
+}
+
+SensorPipeline::~SensorPipeline()
+{
+    drain();
+}
+
+bool SensorPipeline::addStage(const StageConfig &config, Handler handler)
+{
+    if (config.name.isEmpty() || m_stageIndex.contains(config.name) || !handler) {
+        qWarning() << "❌ SensorPipeline: invalid or duplicate stage" << config.name;
+        return false;
+    }
+
+    std::unique_ptr<Stage> stage(new Stage);
+    stage->config = config;
+    stage->handler = std::move(handler);
+    stage->snapshot.name = config.name;
+
+    // В потоке владельца задачи стадии выполняются строго по одной
+    if (stage->config.executor != ThreadPool) {
+        stage->config.concurrency = 1;
+    }
+    stage->config.concurrency = qMax(1, stage->config.concurrency);
+    if (stage->config.executor == ThreadPool) {
+        stage->pool.setMaxThreadCount(stage->config.concurrency);
+    }
+
+    m_stageIndex.insert(config.name, stage.get());
+    m_stages.push_back(std::move(stage));
+    return true;
+}
+
+bool SensorPipeline::connectStages(const QString &from, const QString &to)
+{
+    Stage *source = findStage(from);
+    Stage *target = findStage(to);
+    if (!source || !target) {
+        qWarning() << "❌ SensorPipeline: cannot connect" << from << "->" << to;
+        return false;
+    }
+    if (!source->downstream.contains(target)) {
+        source->downstream.append(target);
+    }
+    return true;
+}
+
+bool SensorPipeline::submit(const QString &stageName, const SensorPacket &packet)
+{
+    Stage *stage = findStage(stageName);
+    return stage ? enqueue(stage, packet) : false;
+}
+
+void SensorPipeline::drain()
+{
+    // Сначала очереди - пулы не берут новых пакетов, пока ждем текущие задачи
+    clearQueues();
+    for (const auto &stage : m_stages) {
+        if (stage->config.executor == ThreadPool) {
+            stage->pool.waitForDone();
+        }
+    }
+    // Задачи, завершившиеся во время ожидания, успели передать пакеты дальше
+    clearQueues();
+}
+
+void SensorPipeline::clearQueues()
+{
+    for (const auto &stage : m_stages) {
+        QMutexLocker locker(&stage->mutex);
+        stage->queue.clear();
+    }
+}
+
+QVector<SensorPipeline::StageMetrics> SensorPipeline::metrics() const
+{
+    QVector<StageMetrics> result;
+    result.reserve(static_cast<int>(m_stages.size()));
+    for (const auto &stage : m_stages) {
+        QMutexLocker locker(&stage->mutex);
+        StageMetrics metrics = stage->snapshot;
+        metrics.processed = stage->processed;
+        metrics.dropped = stage->dropped;
+        metrics.queueDepth = static_cast<int>(stage->queue.size());
+        result.append(metrics);
+    }
+    return result;
+}
+
+void SensorPipeline::setMetricsInterval(int ms)
+{
+    m_metricsTimer->start(qMax(100, ms));
+}
+
+bool SensorPipeline::enqueue(Stage *stage, const SensorPacket &packet)
+{
+    const qint64 now = m_clock.nsecsElapsed();
+
+    // Синхронная стадия: без очереди, сразу в потоке вызывающего
+    if (stage->config.executor == Inline) {
+        SensorPacket local = packet;
+        process(stage, local, now);
+        return true;
+    }
+
+    {
+        QMutexLocker locker(&stage->mutex);
+        const int capacity = stage->config.queueCapacity;
+        if (stage->config.dropPolicy != KeepAll && capacity > 0 &&
+            static_cast<int>(stage->queue.size()) >= capacity) {
+            ++stage->dropped;
+            if (stage->config.dropPolicy == DropNewest) {
+                return false;
+            }
+            stage->queue.pop_front();
+        }
+
+        stage->queue.push_back({packet, now});
+        stage->windowMaxDepth = qMax(stage->windowMaxDepth, static_cast<int>(stage->queue.size()));
+
+        if (stage->running >= stage->config.concurrency) {
+            return true;
+        }
+        ++stage->running;
+    }
+
+    schedule(stage);
+    return true;
+}
+
+void SensorPipeline::schedule(Stage *stage)
+{
+    if (stage->config.executor == ThreadPool) {
+        stage->pool.start([this, stage]() {
+            QThread::currentThread()->setPriority(stage->config.priority);
+            runStage(stage);
+        });
+    } else {
+        QMetaObject::invokeMethod(this, [this, stage]() { runStage(stage); }, Qt::QueuedConnection);
+    }
+}
+
+void SensorPipeline::runStage(Stage *stage)
+{
+    forever {
+        Stage::Queued item;
+        {
+            QMutexLocker locker(&stage->mutex);
+            if (stage->queue.empty()) {
+                --stage->running;
+                return;
+            }
+            item = std::move(stage->queue.front());
+            stage->queue.pop_front();
+        }
+        process(stage, item.packet, item.enqueuedNs);
+    }
+}
+
+void SensorPipeline::process(Stage *stage, SensorPacket &packet, qint64 enqueuedNs)
+{
+    const qint64 startNs = m_clock.nsecsElapsed();
+    stage->handler(packet, Output(this, stage));
+    const qint64 endNs = m_clock.nsecsElapsed();
+
+    const double latencyMs = (endNs - enqueuedNs) / 1e6;
+    const double processingMs = (endNs - startNs) / 1e6;
+
+    QMutexLocker locker(&stage->mutex);
+    ++stage->processed;
+    ++stage->windowProcessed;
+    stage->windowLatencyMs += latencyMs;
+    stage->windowMaxLatencyMs = std::max(stage->windowMaxLatencyMs, latencyMs);
+    stage->windowProcessingMs += processingMs;
+}
+
+void SensorPipeline::updateMetrics()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    const double intervalSec = qMax<qint64>(1, now - m_lastMetricsNs) / 1e9;
+    m_lastMetricsNs = now;
+
+    for (const auto &stage : m_stages) {
+        QMutexLocker locker(&stage->mutex);
+        StageMetrics &snapshot = stage->snapshot;
+        const quint64 count = stage->windowProcessed;
+
+        snapshot.throughput = count / intervalSec;
+        snapshot.avgLatencyMs = count ? stage->windowLatencyMs / count : 0.0;
+        snapshot.maxLatencyMs = stage->windowMaxLatencyMs;
+        snapshot.avgProcessingMs = count ? stage->windowProcessingMs / count : 0.0;
+        snapshot.maxQueueDepth = stage->windowMaxDepth;
+
+        stage->windowProcessed = 0;
+        stage->windowLatencyMs = 0.0;
+        stage->windowMaxLatencyMs = 0.0;
+        stage->windowProcessingMs = 0.0;
+        stage->windowMaxDepth = static_cast<int>(stage->queue.size());
+    }
+
+    emit metricsUpdated();
+}
+
+SensorPipeline::Stage *SensorPipeline::findStage(const QString &name) const
+{
+    return m_stageIndex.value(name, nullptr);
+}
+
+} // namespace SensorConnector
@@ -13,42 +13,9 @@ public:
     }
 
     void run() override {
-        // 🔹 СОЗДАЕМ ОТДЕЛЬНЫЙ ДЕКОДЕР ДЛЯ КАЖДОГО ПОТОКА
-        tjhandle turboHandle = tjInitDecompress();
-        if (!turboHandle) {
-            qWarning() << "❌ Failed to create TurboJPEG decoder in thread";
-            return;
-        }
-
-        const unsigned char* jpegBuf = reinterpret_cast<const unsigned char*>(m_data.constData());
-        unsigned long jpegSize = m_data.size();
-
-        int width, height, jpegSubsamp, jpegColorspace;
-
-        // 🔹 ПОЛУЧАЕМ РАЗМЕРЫ ИЗОБРАЖЕНИЯ
-        if (tjDecompressHeader3(turboHandle, jpegBuf, jpegSize,
-                               &width, &height, &jpegSubsamp, &jpegColorspace) != 0) {
-            qWarning() << "❌ JPEG header error:" << tjGetErrorStr2(turboHandle);
-            tjDestroy(turboHandle);
-            return;
-        }
-
-        // 🔹 СОЗДАЕМ ИЗОБРАЖЕНИЕ
-        QImage image(width, height, QImage::Format_RGB888);
-        if (image.isNull()) {
-            qWarning() << "❌ Failed to create image buffer" << width << "x" << height;
-            tjDestroy(turboHandle);
-            return;
-        }
-
-        // 🔹 ДЕКОДИРУЕМ
-        int result = tjDecompress2(turboHandle, jpegBuf, jpegSize,
-                                  image.bits(), width, 0, height, TJPF_RGB,
-                                  TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE);
-
-        tjDestroy(turboHandle); // 🔹 ВАЖНО: уничтожаем декодер
+        QImage image = TurboJPEGDecoder::decodeJPEG(m_data);
 
-        if (result == 0 && !image.isNull()) {
+        if (!image.isNull()) {
             // 🔹 ПЕРЕДАЕМ sequenceNumber В КОЛБЭК
             QMetaObject::invokeMethod(m_decoder, "handleDecodeResult",
                 Qt::QueuedConnection,
@@ -66,6 +33,62 @@ private:
     quint64 m_sequenceNumber; // 🔹 ДОБАВЛЕНО: хранение номера кадра
 };
 
+// 🔹 ДЕКОМПРЕССОР НА ПОТОК: создается при первом кадре, живет до завершения потока
+namespace {
+struct ThreadDecompressor {
+    tjhandle handle = tjInitDecompress();
+    ~ThreadDecompressor() {
+        if (handle) {
+            tjDestroy(handle);
+        }
+    }
+};
+}
+
+QImage TurboJPEGDecoder::decodeJPEG(const QByteArray &jpegData)
+{
+    if (jpegData.size() < 2 ||
+        static_cast<uchar>(jpegData[0]) != 0xFF ||
+        static_cast<uchar>(jpegData[1]) != 0xD8) {
+        return QImage();
+    }
+
+    thread_local ThreadDecompressor decompressor;
+    tjhandle turboHandle = decompressor.handle;
+    if (!turboHandle) {
+        qWarning() << "❌ Failed to create TurboJPEG decoder in thread";
+        return QImage();
+    }
+
+    const unsigned char* jpegBuf = reinterpret_cast<const unsigned char*>(jpegData.constData());
+    unsigned long jpegSize = jpegData.size();
+
+    int width, height, jpegSubsamp, jpegColorspace;
+
+    // 🔹 ПОЛУЧАЕМ РАЗМЕРЫ ИЗОБРАЖЕНИЯ
+    if (tjDecompressHeader3(turboHandle, jpegBuf, jpegSize,
+                           &width, &height, &jpegSubsamp, &jpegColorspace) != 0) {
+        qWarning() << "❌ JPEG header error:" << tjGetErrorStr2(turboHandle);
+        return QImage();
+    }
+
+    // 🔹 СОЗДАЕМ ИЗОБРАЖЕНИЕ
+    QImage image(width, height, QImage::Format_RGB888);
+    if (image.isNull()) {
+        qWarning() << "❌ Failed to create image buffer" << width << "x" << height;
+        return QImage();
+    }
+
+    // 🔹 ДЕКОДИРУЕМ (bytesPerLine учитывает выравнивание строк QImage)
+    if (tjDecompress2(turboHandle, jpegBuf, jpegSize,
+                      image.bits(), width, image.bytesPerLine(), height, TJPF_RGB,
+                      TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE) != 0) {
+        return QImage();
+    }
+
+    return image;
+}
+
 TurboJPEGDecoder::TurboJPEGDecoder(QObject *parent)
     : QObject(parent)
 {